@@ -27,6 +27,8 @@
 #include "kernel/fmt.h"
 #include "kernel/scopeinfo.h"
 
+#include <queue>
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
@@ -738,6 +740,9 @@ struct CxxrtlWorker {
 	bool debug_alias = false;
 	bool debug_eval = false;
 
+	int parallel_partitions = 0;
+	int parallel_min_cost = 1024;
+
 	std::ostringstream f;
 	std::string indent;
 	int temporary = 0;
@@ -753,6 +758,12 @@ struct CxxrtlWorker {
 	dict<RTLIL::SigBit, bool> bit_has_state;
 	dict<const RTLIL::Module*, pool<std::string>> blackbox_specializations;
 	dict<const RTLIL::Module*, bool> eval_converges;
+	dict<const RTLIL::Module*, std::vector<int>> schedule_components;
+	dict<const RTLIL::Wire*, int> wire_components;
+	dict<const RTLIL::Module*, size_t> eval_costs;
+	dict<const RTLIL::Module*, std::vector<std::vector<FlowGraph::Node>>> eval_partitions;
+	dict<const RTLIL::Wire*, int> wire_partitions;
+	dict<const RTLIL::Module*, bool> module_effects;
 
 	void inc_indent() {
 		indent += "\t";
@@ -2164,59 +2175,101 @@ struct CxxrtlWorker {
 		dec_indent();
 	}
 
-	void dump_eval_method(RTLIL::Module *module)
+	void dump_edge_detectors(RTLIL::Module *module)
 	{
-		inc_indent();
-			f << indent << "bool converged = " << (eval_converges.at(module) ? "true" : "false") << ";\n";
-			if (!module->get_bool_attribute(ID(cxxrtl_blackbox))) {
-				for (auto wire : module->wires()) {
-					if (edge_wires[wire]) {
-						for (auto edge_type : edge_types) {
-							if (edge_type.first.wire == wire) {
-								if (edge_type.second != RTLIL::STn) {
-									f << indent << "bool posedge_" << mangle(edge_type.first) << " = ";
-									f << "this->posedge_" << mangle(edge_type.first) << "();\n";
-								}
-								if (edge_type.second != RTLIL::STp) {
-									f << indent << "bool negedge_" << mangle(edge_type.first) << " = ";
-									f << "this->negedge_" << mangle(edge_type.first) << "();\n";
-								}
-							}
+		for (auto wire : module->wires()) {
+			if (edge_wires[wire]) {
+				for (auto edge_type : edge_types) {
+					if (edge_type.first.wire == wire) {
+						if (edge_type.second != RTLIL::STn) {
+							f << indent << "bool posedge_" << mangle(edge_type.first) << " = ";
+							f << "this->posedge_" << mangle(edge_type.first) << "();\n";
+						}
+						if (edge_type.second != RTLIL::STp) {
+							f << indent << "bool negedge_" << mangle(edge_type.first) << " = ";
+							f << "this->negedge_" << mangle(edge_type.first) << "();\n";
 						}
 					}
 				}
-				for (auto wire : module->wires())
-					dump_wire(wire, /*is_local=*/true);
-				for (auto node : schedule[module]) {
-					switch (node.type) {
-						case FlowGraph::Node::Type::CONNECT:
-							dump_connect(node.connect);
-							break;
-						case FlowGraph::Node::Type::CELL_SYNC:
-							dump_cell_sync(node.cell);
-							break;
-						case FlowGraph::Node::Type::CELL_EVAL:
-							dump_cell_eval(node.cell);
-							break;
-						case FlowGraph::Node::Type::EFFECT_SYNC:
-							dump_cell_effect_sync(node.cells);
-							break;
-						case FlowGraph::Node::Type::PROCESS_CASE:
-							dump_process_case(node.process);
-							break;
-						case FlowGraph::Node::Type::PROCESS_SYNC:
-							dump_process_syncs(node.process);
-							break;
-						case FlowGraph::Node::Type::MEM_RDPORT:
-							dump_mem_rdport(node.mem, node.portidx);
-							break;
-						case FlowGraph::Node::Type::MEM_WRPORTS:
-							dump_mem_wrports(node.mem);
-							break;
+			}
+		}
+	}
+
+	void dump_eval_nodes(const std::vector<FlowGraph::Node> &nodes)
+	{
+		for (auto node : nodes) {
+			switch (node.type) {
+				case FlowGraph::Node::Type::CONNECT:
+					dump_connect(node.connect);
+					break;
+				case FlowGraph::Node::Type::CELL_SYNC:
+					dump_cell_sync(node.cell);
+					break;
+				case FlowGraph::Node::Type::CELL_EVAL:
+					dump_cell_eval(node.cell);
+					break;
+				case FlowGraph::Node::Type::EFFECT_SYNC:
+					dump_cell_effect_sync(node.cells);
+					break;
+				case FlowGraph::Node::Type::PROCESS_CASE:
+					dump_process_case(node.process);
+					break;
+				case FlowGraph::Node::Type::PROCESS_SYNC:
+					dump_process_syncs(node.process);
+					break;
+				case FlowGraph::Node::Type::MEM_RDPORT:
+					dump_mem_rdport(node.mem, node.portidx);
+					break;
+				case FlowGraph::Node::Type::MEM_WRPORTS:
+					dump_mem_wrports(node.mem);
+					break;
+			}
+		}
+	}
+
+	void dump_eval_method(RTLIL::Module *module)
+	{
+		inc_indent();
+			if (eval_partitions.count(module)) {
+				// Edge detectors are sampled before any of the partitions can update the wires they observe.
+				const auto &partitions = eval_partitions.at(module);
+				dump_edge_detectors(module);
+				f << indent << "bool partition_converged[" << partitions.size() << "];\n";
+				f << indent << "cxxrtl::thread_pool::global().run(" << partitions.size() << ", [&](size_t partition) {\n";
+				inc_indent();
+					f << indent << "bool converged = " << (eval_converges.at(module) ? "true" : "false") << ";\n";
+					f << indent << "switch (partition) {\n";
+					for (size_t index = 0; index < partitions.size(); index++) {
+						f << indent << "case " << index << ": {\n";
+						inc_indent();
+							for (auto wire : module->wires()) {
+								auto it = wire_partitions.find(wire);
+								if (it == wire_partitions.end() || it->second == (int)index)
+									dump_wire(wire, /*is_local=*/true);
+							}
+							dump_eval_nodes(partitions[index]);
+							f << indent << "break;\n";
+						dec_indent();
+						f << indent << "}\n";
 					}
+					f << indent << "}\n";
+					f << indent << "partition_converged[partition] = converged;\n";
+				dec_indent();
+				f << indent << "});\n";
+				f << indent << "return ";
+				for (size_t index = 0; index < partitions.size(); index++)
+					f << (index > 0 ? " && " : "") << "partition_converged[" << index << "]";
+				f << ";\n";
+			} else {
+				f << indent << "bool converged = " << (eval_converges.at(module) ? "true" : "false") << ";\n";
+				if (!module->get_bool_attribute(ID(cxxrtl_blackbox))) {
+					dump_edge_detectors(module);
+					for (auto wire : module->wires())
+						dump_wire(wire, /*is_local=*/true);
+					dump_eval_nodes(schedule[module]);
 				}
+				f << indent << "return converged;\n";
 			}
-			f << indent << "return converged;\n";
 		dec_indent();
 	}
 
@@ -2797,6 +2850,11 @@ struct CxxrtlWorker {
 		log_assert(no_loops);
 		modules.insert(modules.end(), topo_design.sorted.begin(), topo_design.sorted.end());
 
+		if (parallel_partitions > 1)
+			for (auto module : modules)
+				if (!module->get_bool_attribute(ID(cxxrtl_blackbox)))
+					partition_eval(module);
+
 		if (split_intf) {
 			// The only thing more depraved than include guards, is mangling filenames to turn them into include guards.
 			std::string include_guard = design_ns + "_header";
@@ -2844,6 +2902,8 @@ struct CxxrtlWorker {
 			f << "#include \"" << basename(intf_filename) << "\"\n";
 		else
 			f << "#include <cxxrtl/cxxrtl.h>\n";
+		if (!eval_partitions.empty())
+			f << "#include <cxxrtl/cxxrtl_parallel.h>\n";
 		f << "\n";
 		f << "#if defined(CXXRTL_INCLUDE_CAPI_IMPL) || \\\n";
 		f << "    defined(CXXRTL_INCLUDE_VCD_CAPI_IMPL)\n";
@@ -2905,6 +2965,160 @@ struct CxxrtlWorker {
 		edge_wires.insert(sigbit.wire);
 	}
 
+	bool module_has_effects(RTLIL::Module *module)
+	{
+		auto it = module_effects.find(module);
+		if (it != module_effects.end())
+			return it->second;
+		bool has_effects = false;
+		for (auto cell : module->cells()) {
+			if (is_effectful_cell(cell->type))
+				has_effects = true;
+			else if (!is_internal_cell(cell->type))
+				has_effects = is_cxxrtl_blackbox_cell(cell) || module_has_effects(module->design->module(cell->type));
+			if (has_effects)
+				break;
+		}
+		return module_effects[module] = has_effects;
+	}
+
+	// Nodes that belong to different components of eval() touch disjoint parts of the simulation state during a delta
+	// cycle, and may be evaluated concurrently. Flip-flops are the natural boundary between components: they update
+	// the next value of a wire, while the nodes reading that wire use its current value.
+	void find_eval_components(RTLIL::Module *module, FlowGraph &flow, const std::vector<FlowGraph::Node*> &scheduled_nodes)
+	{
+		mfp<FlowGraph::Node*, hash_ptr_ops> components;
+		for (auto node : flow.nodes)
+			components(node);
+
+		// Combinatorially driven wires are written and read within the same delta cycle. Inlined nodes are included,
+		// which accounts for the wires they read on behalf of the nodes they are inlined into.
+		for (auto &it : flow.wire_comb_defs) {
+			if (it.second.empty())
+				continue;
+			FlowGraph::Node *def_node = *it.second.begin();
+			for (auto node : it.second)
+				components.merge(def_node, node);
+			if (flow.wire_uses.count(it.first))
+				for (auto node : flow.wire_uses.at(it.first))
+					components.merge(def_node, node);
+			if (flow.wire_sync_defs.count(it.first))
+				for (auto node : flow.wire_sync_defs.at(it.first))
+					components.merge(def_node, node);
+		}
+		// Flip-flops that drive parts of the same wire update the same value.
+		for (auto &it : flow.wire_sync_defs) {
+			if (it.second.empty())
+				continue;
+			FlowGraph::Node *def_node = *it.second.begin();
+			for (auto node : it.second)
+				components.merge(def_node, node);
+		}
+
+		// Memories, cells with several nodes, and side effects (whose order must be preserved) are also shared state.
+		dict<RTLIL::IdString, FlowGraph::Node*> memory_nodes;
+		dict<const RTLIL::Cell*, FlowGraph::Node*> cell_nodes;
+		FlowGraph::Node *effect_node = nullptr;
+		auto merge_into = [&](FlowGraph::Node *&first, FlowGraph::Node *node) {
+			if (first == nullptr)
+				first = node;
+			else
+				components.merge(first, node);
+		};
+		for (auto node : flow.nodes) {
+			switch (node->type) {
+				case FlowGraph::Node::Type::MEM_RDPORT:
+				case FlowGraph::Node::Type::MEM_WRPORTS:
+					merge_into(memory_nodes[node->mem->memid], node);
+					break;
+				case FlowGraph::Node::Type::PROCESS_SYNC:
+					for (auto sync : node->process->syncs)
+						for (auto &memwr : sync->mem_write_actions)
+							merge_into(memory_nodes[memwr.memid], node);
+					break;
+				case FlowGraph::Node::Type::EFFECT_SYNC:
+					merge_into(effect_node, node);
+					break;
+				case FlowGraph::Node::Type::CELL_SYNC:
+				case FlowGraph::Node::Type::CELL_EVAL:
+					merge_into(cell_nodes[node->cell], node);
+					if (is_effectful_cell(node->cell->type) ||
+							(!is_internal_cell(node->cell->type) && (is_cxxrtl_blackbox_cell(node->cell) ||
+							                                        module_has_effects(module->design->module(node->cell->type)))))
+						merge_into(effect_node, node);
+					break;
+				default:
+					break;
+			}
+		}
+
+		auto &node_components = schedule_components[module];
+		for (auto node : scheduled_nodes)
+			node_components.push_back(components.lookup(node));
+		for (auto &it : flow.wire_comb_defs)
+			if (!it.second.empty())
+				wire_components[it.first] = components.lookup(*it.second.begin());
+	}
+
+	// Assigns the components of eval() to partitions, balancing the amount of work in each of them. The work is
+	// estimated as the number of scheduled nodes, including those of submodules, and a partition has to have at least
+	// `parallel_min_cost` of it to outweigh the cost of handing it to another thread.
+	void partition_eval(RTLIL::Module *module)
+	{
+		const auto &nodes = schedule[module];
+		const auto &node_components = schedule_components[module];
+		log_assert(nodes.size() == node_components.size());
+
+		dict<int, size_t> component_costs;
+		size_t module_cost = 0;
+		for (size_t index = 0; index < nodes.size(); index++) {
+			const FlowGraph::Node &node = nodes[index];
+			size_t cost = 1;
+			if (node.type == FlowGraph::Node::Type::CELL_EVAL &&
+					!is_internal_cell(node.cell->type) && !is_cxxrtl_blackbox_cell(node.cell))
+				cost = eval_costs.at(module->design->module(node.cell->type));
+			component_costs[node_components[index]] += cost;
+			module_cost += cost;
+		}
+		eval_costs[module] = std::max<size_t>(module_cost, 1);
+		size_t partition_count = std::min<size_t>({(size_t)parallel_partitions, component_costs.size(),
+		                                           module_cost / parallel_min_cost});
+		if (partition_count < 2)
+			return;
+
+		// Largest components first, each into the partition with the least work so far.
+		std::vector<std::pair<size_t, int>> sorted_components;
+		for (auto &it : component_costs)
+			sorted_components.push_back({it.second, it.first});
+		std::sort(sorted_components.begin(), sorted_components.end(), std::greater<std::pair<size_t, int>>());
+		std::priority_queue<std::pair<size_t, int>, std::vector<std::pair<size_t, int>>,
+		                    std::greater<std::pair<size_t, int>>> loads;
+		for (size_t index = 0; index < partition_count; index++)
+			loads.push({0, index});
+		dict<int, int> component_partitions;
+		size_t max_load = 0;
+		for (auto &it : sorted_components) {
+			auto load = loads.top();
+			loads.pop();
+			component_partitions[it.second] = load.second;
+			load.first += it.first;
+			max_load = std::max(max_load, load.first);
+			loads.push(load);
+		}
+
+		auto &partitions = eval_partitions[module];
+		partitions.resize(partition_count);
+		for (size_t index = 0; index < nodes.size(); index++)
+			partitions[component_partitions.at(node_components[index])].push_back(nodes[index]);
+		for (auto wire : module->wires()) {
+			auto it = wire_components.find(wire);
+			if (it != wire_components.end() && component_partitions.count(it->second))
+				wire_partitions[wire] = component_partitions.at(it->second);
+		}
+		log("Module `%s' evaluates in %zu partitions from %zu independent components; the largest partition holds %.1f%% of the work.\n",
+		    log_id(module), partition_count, sorted_components.size(), 100.0 * max_load / module_cost);
+	}
+
 	void analyze_design(RTLIL::Design *design)
 	{
 		bool has_feedback_arcs = false;
@@ -3205,6 +3419,7 @@ struct CxxrtlWorker {
 			// Emit reachable nodes in eval().
 			// Accumulate sync effectful cells per trigger condition.
 			dict<std::pair<RTLIL::SigSpec, RTLIL::Const>, std::vector<const RTLIL::Cell*>> effect_sync_cells;
+			std::vector<FlowGraph::Node*> scheduled_nodes;
 			for (auto node : node_order)
 				if (live_nodes[node]) {
 					if (node->type == FlowGraph::Node::Type::CELL_EVAL &&
@@ -3213,14 +3428,19 @@ struct CxxrtlWorker {
 							node->cell->getParam(ID::TRG_WIDTH).as_int() != 0)
 						effect_sync_cells[make_pair(node->cell->getPort(ID::TRG), node->cell->getParam(ID::TRG_POLARITY))].push_back(node->cell);
 					else
-						schedule[module].push_back(*node);
+						scheduled_nodes.push_back(node);
 				}
 
 			for (auto &it : effect_sync_cells) {
 				auto node = flow.add_effect_sync_node(it.second);
-				schedule[module].push_back(*node);
+				scheduled_nodes.push_back(node);
 			}
 
+			for (auto node : scheduled_nodes)
+				schedule[module].push_back(*node);
+			if (parallel_partitions > 1)
+				find_eval_components(module, flow, scheduled_nodes);
+
 			// For maximum performance, the state of the simulation (which is the same as the set of its double buffered
 			// wires, since using a singly buffered wire for any kind of state introduces a race condition) should contain
 			// no wires attached to combinatorial outputs. Feedback wires, by definition, make that impossible. However,
@@ -3687,6 +3907,18 @@ struct CxxrtlBackend : public Backend {
 		log("    -O6\n");
 		log("        like -O5, and inline public wires not marked (*keep*) if possible.\n");
 		log("\n");
+		log("    -parallel <partitions>\n");
+		log("        split eval() of every module into at most <partitions> parts that touch\n");
+		log("        disjoint state, and evaluate them concurrently. the parts are found by\n");
+		log("        cutting the design at flip-flops and grouping the remaining logic into\n");
+		log("        independent clusters, which are balanced between the partitions; cells\n");
+		log("        with side effects stay in one partition. the generated code uses the\n");
+		log("        thread pool from <cxxrtl/cxxrtl_parallel.h>, which has as many threads\n");
+		log("        as the `CXXRTL_THREADS' environment variable, or as the host has hardware\n");
+		log("        threads if it is unset, and must be linked with `-pthread'.\n");
+		log("        a module is only split if each part would evaluate at least 1024 nodes\n");
+		log("        (this can be changed with `scratchpad -set cxxrtl.parallel_min_cost <n>').\n");
+		log("\n");
 		log("    -g <level>\n");
 		log("        set the debug level. the default is -g%d. higher debug levels provide\n", DEFAULT_DEBUG_LEVEL);
 		log("        more visibility and generate more code, but do not pessimize evaluation.\n");
@@ -3779,6 +4011,10 @@ struct CxxrtlBackend : public Backend {
 				worker.split_intf = true;
 				continue;
 			}
+			if (args[argidx] == "-parallel" && argidx+1 < args.size()) {
+				worker.parallel_partitions = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			if (args[argidx] == "-namespace" && argidx+1 < args.size()) {
 				worker.design_ns = args[++argidx];
 				continue;
@@ -3860,6 +4096,8 @@ struct CxxrtlBackend : public Backend {
 		}
 		worker.impl_f = f;
 
+		worker.parallel_min_cost = std::max(1, design->scratchpad_get_int("cxxrtl.parallel_min_cost", worker.parallel_min_cost));
+
 		worker.prepare_design(design);
 		worker.dump_design(design);
 	}
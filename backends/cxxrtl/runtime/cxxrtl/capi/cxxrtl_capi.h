@@ -28,6 +28,23 @@
 #include <stdint.h>
 #include <assert.h>
 
+// Width of the chunks that the bits of simulated objects are stored in.
+//
+// The default is 32. Defining `CXXRTL_CHUNK_BITS` as 64 processes wide values twice as fast on 64-bit
+// platforms, but requires a compiler that provides `unsigned __int128`. The same value must be used
+// when compiling the generated code, the C API, and all code that accesses `curr` or `next`.
+#ifndef CXXRTL_CHUNK_BITS
+#define CXXRTL_CHUNK_BITS 32
+#endif
+
+#if CXXRTL_CHUNK_BITS == 32
+typedef uint32_t cxxrtl_chunk_t;
+#elif CXXRTL_CHUNK_BITS == 64
+typedef uint64_t cxxrtl_chunk_t;
+#else
+#error "CXXRTL_CHUNK_BITS must be 32 or 64"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -229,12 +246,12 @@ struct cxxrtl_object {
 	// Index of the first word. Only meaningful for memories; for other objects, always 0;
 	size_t zero_at;
 
-	// Bits stored in the object, as 32-bit chunks, least significant bits first.
+	// Bits stored in the object, as `CXXRTL_CHUNK_BITS`-bit chunks, least significant bits first.
 	//
-	// The width is rounded up to a multiple of 32; the padding bits are always set to 0 by
+	// The width is rounded up to a multiple of the chunk width; the padding bits are always set to 0 by
 	// the simulation code, and must be always written as 0 when modified by user code.
 	// In memories, every element is stored contiguously. Therefore, the total number of chunks
-	// in any object is `((width + 31) / 32) * depth`.
+	// in any object is `((width + CXXRTL_CHUNK_BITS - 1) / CXXRTL_CHUNK_BITS) * depth`.
 	//
 	// To allow the simulation to be partitioned into multiple independent units communicating
 	// through wires, the bits are double buffered. To avoid race conditions, user code should
@@ -245,8 +262,8 @@ struct cxxrtl_object {
 	// there is a 1-to-1 correspondence between simulation objects and `curr` pointers, regardless
 	// of whether they have storage or not. (Aliases' `curr` pointer equals that of some other
 	// simulated object.)
-	uint32_t *curr;
-	uint32_t *next;
+	cxxrtl_chunk_t *curr;
+	cxxrtl_chunk_t *next;
 
 	// Opaque reference to an outline. Only meaningful for outline objects.
 	//
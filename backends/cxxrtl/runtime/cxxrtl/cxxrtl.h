@@ -94,8 +94,20 @@ namespace cxxrtl {
 // invisible to the compiler, (b) we often operate on non-power-of-2 values and have to clear the high bits anyway.
 // Therefore, using relatively wide chunks and clearing the high bits explicitly and only when we know they may be
 // clobbered results in simpler generated code.
+//
+// The chunk width is selected with `CXXRTL_CHUNK_BITS` (see `cxxrtl_capi.h`). Wide chunks are used for
+// the intermediate results of multiplication and must hold the product of two chunks.
+#if CXXRTL_CHUNK_BITS == 64
+#if !defined(__SIZEOF_INT128__)
+#error "64-bit chunks require a compiler that provides unsigned __int128"
+#endif
+typedef uint64_t chunk_t;
+__extension__ typedef unsigned __int128 wide_chunk_t;
+#else
 typedef uint32_t chunk_t;
 typedef uint64_t wide_chunk_t;
+#endif
+static_assert(std::is_same<chunk_t, cxxrtl_chunk_t>::value, "chunk type must match the C API");
 
 template<typename T>
 struct chunk_traits {
@@ -109,6 +121,47 @@ struct chunk_traits {
 template<class T>
 struct expr_base;
 
+#if CXXRTL_CHUNK_BITS != 32
+// Helpers for assembling chunks from the 32-bit words that values are initialized with. C++11 has neither
+// std::index_sequence nor loops in constexpr functions, so the chunks are built by a pack expansion.
+template<size_t... Indices>
+struct index_sequence {};
+
+template<class First, class Second>
+struct concat_index_sequence;
+
+template<size_t... First, size_t... Second>
+struct concat_index_sequence<index_sequence<First...>, index_sequence<Second...>> {
+	using type = index_sequence<First..., (sizeof...(First) + Second)...>;
+};
+
+template<size_t Count>
+struct make_index_sequence {
+	using type = typename concat_index_sequence<typename make_index_sequence<Count / 2>::type,
+	                                            typename make_index_sequence<Count - Count / 2>::type>::type;
+};
+
+template<>
+struct make_index_sequence<0> { using type = index_sequence<>; };
+
+template<>
+struct make_index_sequence<1> { using type = index_sequence<0>; };
+
+template<size_t Words>
+struct init_words {
+	static constexpr size_t words_per_chunk = std::numeric_limits<chunk_t>::digits / 32;
+	uint32_t word[Words];
+
+	constexpr chunk_t part(size_t index, size_t shift) const {
+		return index < Words ? chunk_t(word[index]) << shift : 0;
+	}
+
+	constexpr chunk_t chunk(size_t index) const {
+		return part(index * words_per_chunk, 0) | part(index * words_per_chunk + 1, 32);
+	}
+};
+#endif
+
 template<size_t Bits>
 struct value : public expr_base<value<Bits>> {
 	static constexpr size_t bits = Bits;
@@ -121,8 +174,22 @@ struct value : public expr_base<value<Bits>> {
 	chunk::type data[chunks] = {};
 
 	value() = default;
+#if CXXRTL_CHUNK_BITS == 32
 	template<typename... Init>
 	explicit constexpr value(Init ...init) : data{init...} {}
+#else
+	// Values are always initialized with 32-bit words, least significant first, so that constants in generated
+	// code and in user code do not depend on the chunk width.
+	template<typename... Init>
+	explicit constexpr value(Init ...init)
+		: value(init_words<sizeof...(Init)>{{uint32_t(init)...}}, typename make_index_sequence<chunks>::type()) {
+		static_assert(sizeof...(Init) <= chunks * init_words<sizeof...(Init)>::words_per_chunk,
+		              "too many initializers for value<Bits>");
+	}
+
+	template<size_t Words, size_t... Indices>
+	constexpr value(const init_words<Words> &init, index_sequence<Indices...>) : data{init.chunk(Indices)...} {}
+#endif
 
 	value(const value<Bits> &) = default;
 	value<Bits> &operator=(const value<Bits> &) = default;
@@ -349,36 +416,37 @@ struct value : public expr_base<value<Bits>> {
 	//
 	// These operations are used for computations.
 	bool bit(size_t offset) const {
-		return data[offset / chunk::bits] & (1 << (offset % chunk::bits));
+		return data[offset / chunk::bits] & (chunk::type(1) << (offset % chunk::bits));
 	}
 
 	void set_bit(size_t offset, bool value = true) {
 		size_t offset_chunks = offset / chunk::bits;
 		size_t offset_bits = offset % chunk::bits;
-		data[offset_chunks] &= ~(1 << offset_bits);
-		data[offset_chunks] |= value ? 1 << offset_bits : 0;
+		data[offset_chunks] &= ~(chunk::type(1) << offset_bits);
+		data[offset_chunks] |= value ? chunk::type(1) << offset_bits : 0;
 	}
 
 	explicit operator bool() const {
 		return !is_zero();
 	}
 
+	// The reductions below have no early exit, so that wide values compile to vector code.
 	bool is_zero() const {
+		chunk::type acc = 0;
 		for (size_t n = 0; n < chunks; n++)
-			if (data[n] != 0)
-				return false;
-		return true;
+			acc |= data[n];
+		return acc == 0;
 	}
 
 	bool is_neg() const {
-		return data[chunks - 1] & (1 << ((Bits - 1) % chunk::bits));
+		return data[chunks - 1] & (chunk::type(1) << ((Bits - 1) % chunk::bits));
 	}
 
 	bool operator ==(const value<Bits> &other) const {
+		chunk::type acc = 0;
 		for (size_t n = 0; n < chunks; n++)
-			if (data[n] != other.data[n])
-				return false;
-		return true;
+			acc |= data[n] ^ other.data[n];
+		return acc == 0;
 	}
 
 	bool operator !=(const value<Bits> &other) const {
@@ -432,11 +500,15 @@ struct value : public expr_base<value<Bits>> {
 		if (shift_chunks >= chunks)
 			return {};
 		value<Bits> result;
-		chunk::type carry = 0;
-		for (size_t n = 0; n < chunks - shift_chunks; n++) {
-			result.data[shift_chunks + n] = (data[n] << shift_bits) | carry;
-			carry = (shift_bits == 0) ? 0
-				: data[n] >> (chunk::bits - shift_bits);
+		// Each result chunk is computed from two source chunks rather than a loop-carried value.
+		if (shift_bits == 0) {
+			for (size_t n = 0; n < chunks - shift_chunks; n++)
+				result.data[shift_chunks + n] = data[n];
+		} else {
+			result.data[shift_chunks] = data[0] << shift_bits;
+			for (size_t n = 1; n < chunks - shift_chunks; n++)
+				result.data[shift_chunks + n] = (data[n] << shift_bits) |
+					(data[n - 1] >> (chunk::bits - shift_bits));
 		}
 		result.data[result.chunks - 1] &= result.msb_mask;
 		return result;
@@ -456,11 +528,14 @@ struct value : public expr_base<value<Bits>> {
 		if (shift_chunks >= chunks)
 			return (Signed && is_neg()) ? value<Bits>().bit_not() : value<Bits>();
 		value<Bits> result;
-		chunk::type carry = 0;
-		for (size_t n = 0; n < chunks - shift_chunks; n++) {
-			result.data[chunks - shift_chunks - 1 - n] = carry | (data[chunks - 1 - n] >> shift_bits);
-			carry = (shift_bits == 0) ? 0
-				: data[chunks - 1 - n] << (chunk::bits - shift_bits);
+		if (shift_bits == 0) {
+			for (size_t n = 0; n < chunks - shift_chunks; n++)
+				result.data[n] = data[shift_chunks + n];
+		} else {
+			for (size_t n = 0; n < chunks - shift_chunks - 1; n++)
+				result.data[n] = (data[shift_chunks + n] >> shift_bits) |
+					(data[shift_chunks + n + 1] << (chunk::bits - shift_bits));
+			result.data[chunks - shift_chunks - 1] = data[chunks - 1] >> shift_bits;
 		}
 		if (Signed && is_neg()) {
 			size_t top_chunk_idx  = amount.data[0] > Bits ? 0 : (Bits - amount.data[0]) / chunk::bits;
@@ -570,17 +645,18 @@ struct value : public expr_base<value<Bits>> {
 	}
 
 	bool ucmp(const value<Bits> &other) const {
-		bool carry;
-		std::tie(std::ignore, carry) = alu</*Invert=*/true, /*CarryIn=*/true>(other);
-		return !carry; // a.ucmp(b) ≡ a u< b
+		// The most significant differing chunk decides; this avoids the carry chain of a full subtraction.
+		for (size_t n = chunks; n-- > 0;)
+			if (data[n] != other.data[n])
+				return data[n] < other.data[n];
+		return false; // a.ucmp(b) ≡ a u< b
 	}
 
 	bool scmp(const value<Bits> &other) const {
-		value<Bits> result;
-		bool carry;
-		std::tie(result, carry) = alu</*Invert=*/true, /*CarryIn=*/true>(other);
-		bool overflow = (is_neg() == !other.is_neg()) && (is_neg() != result.is_neg());
-		return result.is_neg() ^ overflow; // a.scmp(b) ≡ a s< b
+		// Values of the same sign are ordered the same way whether signed or unsigned.
+		if (is_neg() != other.is_neg())
+			return is_neg();
+		return ucmp(other); // a.scmp(b) ≡ a s< b
 	}
 
 	template<size_t ResultBits>
@@ -0,0 +1,160 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2020  whitequark <whitequark@whitequark.org>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// This file writes FST waveforms using the FST library shipped with Yosys in `libs/fst`. Designs that include it must
+// have `libs/fst` in the include path, and must be linked with `fstapi.cc`, `fastlz.cc`, `lz4.cc` from that directory
+// and with zlib.
+
+#ifndef CXXRTL_FST_H
+#define CXXRTL_FST_H
+
+#include <fstapi.h>
+
+#include <cxxrtl/cxxrtl.h>
+#include <cxxrtl/cxxrtl_waveform.h>
+
+namespace cxxrtl {
+
+class fst_writer : public waveform_writer {
+	void *context;
+	std::vector<std::string> current_scope;
+	std::vector<fstHandle> handles; // by variable ident; 0 for variables that are not written
+	bool streaming = false;
+
+	void emit_scope(const std::vector<std::string> &scope) override {
+		assert(!streaming);
+		size_t same_scope_count = 0;
+		while ((same_scope_count < current_scope.size()) &&
+			   (same_scope_count < scope.size()) &&
+			   (current_scope[same_scope_count] == scope[same_scope_count])) {
+			same_scope_count++;
+		}
+		while (current_scope.size() > same_scope_count) {
+			fstWriterSetUpscope(context);
+			current_scope.pop_back();
+		}
+		while (current_scope.size() < scope.size()) {
+			fstWriterSetScope(context, FST_ST_VCD_MODULE, scope[current_scope.size()].c_str(), nullptr);
+			current_scope.push_back(scope[current_scope.size()]);
+		}
+	}
+
+	void emit_var(const variable &var, const std::string &type, const std::string &name,
+	              size_t lsb_at, bool multipart) override {
+		assert(!streaming);
+		// A variable with a length of zero has a variable length in FST, which is not what is meant here.
+		if (var.width == 0)
+			return;
+		std::string full_name = name;
+		if (multipart || name.back() == ']' || lsb_at != 0) {
+			if (var.width == 1)
+				full_name += " [" + std::to_string(lsb_at) + "]";
+			else
+				full_name += " [" + std::to_string(lsb_at + var.width - 1) + ":" + std::to_string(lsb_at) + "]";
+		}
+		if (handles.size() <= var.ident)
+			handles.resize(var.ident + 1);
+		fstHandle handle = fstWriterCreateVar(context, type == "reg" ? FST_VT_VCD_REG : FST_VT_VCD_WIRE,
+		                                      FST_VD_IMPLICIT, var.width, full_name.c_str(), handles[var.ident]);
+		if (handles[var.ident] == 0)
+			handles[var.ident] = handle;
+	}
+
+	// The value changes are passed as binary, in 32-bit words. `fstWriterEmitValueChangeVec64()` cannot be used for
+	// 64-bit chunks, as it truncates every chunk to 32 bits, and `fstWriterEmitValueChangeVec32()` reads the word
+	// after the most significant one when the width is a multiple of 32, so such values are copied to `words` first.
+	std::vector<uint32_t> words;
+
+	void emit_value(fstHandle handle, size_t width, const uint32_t *chunks) {
+		if (width > 32 && width % 32 == 0) {
+			words.assign(&chunks[0], &chunks[width / 32]);
+			words.push_back(0);
+			chunks = words.data();
+		}
+		fstWriterEmitValueChangeVec32(context, handle, width, chunks);
+	}
+
+	void emit_value(fstHandle handle, size_t width, const uint64_t *chunks) {
+		size_t count = (width + 31) / 32;
+		words.resize(count + 1);
+		for (size_t index = 0; index < count; index++)
+			words[index] = uint32_t(chunks[index / 2] >> (32 * (index % 2)));
+		words[count] = 0;
+		fstWriterEmitValueChangeVec32(context, handle, width, words.data());
+	}
+
+public:
+	// If `parallel` is true, blocks of value changes are compressed and written out on a background thread. This
+	// requires `fstapi.cc` to be built with `-DYOSYS_ENABLE_THREADS` (see `libs/fst/config.h`), and the design to be
+	// linked with the threading library of the platform.
+	explicit fst_writer(const std::string &filename, bool parallel = false)
+			: context(fstWriterCreate(filename.c_str(), /*use_compressed_hier=*/1)) {
+		assert(context != nullptr);
+		fstWriterSetPackType(context, FST_WR_PT_FASTLZ);
+		fstWriterSetRepackOnClose(context, 1);
+		if (parallel)
+			fstWriterSetParallelMode(context, 1);
+	}
+
+	~fst_writer() override {
+		fstWriterClose(context);
+	}
+
+	void timescale(unsigned number, const std::string &unit) {
+		assert(!streaming);
+		assert(number == 1 || number == 10 || number == 100);
+		int exponent = (number == 100) ? 2 : (number == 10) ? 1 : 0;
+		if (unit == "s")
+			exponent += 0;
+		else if (unit == "ms")
+			exponent -= 3;
+		else if (unit == "us")
+			exponent -= 6;
+		else if (unit == "ns")
+			exponent -= 9;
+		else if (unit == "ps")
+			exponent -= 12;
+		else if (unit == "fs")
+			exponent -= 15;
+		else
+			assert(false && "Unknown timescale unit");
+		fstWriterSetTimescale(context, exponent);
+	}
+
+	void sample(uint64_t timestamp) {
+		bool first_sample = !streaming;
+		if (first_sample) {
+			emit_scope({});
+			streaming = true;
+		}
+		fstWriterEmitTimeChange(context, timestamp);
+		sample_variables(first_sample, [this](const variable &var) {
+			if (var.ident < handles.size() && handles[var.ident] != 0)
+				emit_value(handles[var.ident], var.width, var.curr);
+		});
+	}
+
+	// Writes out the value changes collected so far.
+	void flush() {
+		fstWriterFlushContext(context);
+	}
+};
+
+}
+
+#endif
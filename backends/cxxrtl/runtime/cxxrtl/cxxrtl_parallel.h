@@ -0,0 +1,152 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2023  Catherine <whitequark@whitequark.org>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// This file is included by the designs generated with `write_cxxrtl -parallel <N>`. It provides the thread pool that
+// evaluates independent partitions of a module concurrently. Such designs must be linked with the threading library
+// of the platform (e.g. `-pthread`).
+
+#ifndef CXXRTL_PARALLEL_H
+#define CXXRTL_PARALLEL_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cxxrtl {
+
+// A fixed set of worker threads that runs batches of tasks. The thread calling `run()` takes part in the batch, and
+// `run()` returns only once every task in the batch has finished, so consecutive batches (e.g. the `eval()` calls of
+// consecutive delta cycles) are separated by a barrier.
+class thread_pool {
+	std::vector<std::thread> workers;
+
+	// Serializes batches submitted by unrelated threads, e.g. when several simulations run side by side.
+	std::mutex run_mutex;
+
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	uint64_t generation = 0;
+	bool stopping = false;
+	size_t active = 0;
+
+	const std::function<void(size_t)> *task = nullptr;
+	size_t count = 0;
+	std::atomic<size_t> next_index { 0 };
+
+	static bool &in_batch() {
+		static thread_local bool flag = false;
+		return flag;
+	}
+
+	void work() {
+		for (size_t index; (index = next_index.fetch_add(1)) < count;)
+			(*task)(index);
+	}
+
+	void worker() {
+		in_batch() = true;
+		uint64_t seen_generation = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stopping || generation != seen_generation; });
+				if (stopping)
+					return;
+				seen_generation = generation;
+			}
+			work();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--active == 0)
+					done.notify_one();
+			}
+		}
+	}
+
+public:
+	// Creates a pool that runs batches on `threads` threads in total, including the one calling `run()`.
+	explicit thread_pool(size_t threads) {
+		for (size_t n = 1; n < threads; n++)
+			workers.emplace_back(&thread_pool::worker, this);
+	}
+
+	~thread_pool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto &thread : workers)
+			thread.join();
+	}
+
+	thread_pool(const thread_pool &) = delete;
+	thread_pool &operator=(const thread_pool &) = delete;
+
+	size_t size() const {
+		return workers.size() + 1;
+	}
+
+	// Calls `fn(index)` for every `index < n` and waits for all of the calls to return. A batch submitted from within
+	// another batch, or while another thread is running one, is run on the calling thread alone.
+	void run(size_t n, const std::function<void(size_t)> &fn) {
+		std::unique_lock<std::mutex> run_lock(run_mutex, std::defer_lock);
+		if (n <= 1 || workers.empty() || in_batch() || !run_lock.try_lock()) {
+			for (size_t index = 0; index < n; index++)
+				fn(index);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			task = &fn;
+			count = n;
+			next_index = 0;
+			active = workers.size();
+			generation++;
+		}
+		wake.notify_all();
+		in_batch() = true;
+		work();
+		in_batch() = false;
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return active == 0; });
+		task = nullptr;
+	}
+
+	// The pool used by generated code. Its size is taken from the `CXXRTL_THREADS` environment variable if it is set,
+	// and is the number of hardware threads otherwise.
+	static thread_pool &global() {
+		static thread_pool pool([] {
+			const char *threads = getenv("CXXRTL_THREADS");
+			if (threads != nullptr && atoi(threads) > 0)
+				return (size_t)atoi(threads);
+			return (size_t)std::max(1u, std::thread::hardware_concurrency());
+		}());
+		return pool;
+	}
+};
+
+} // namespace cxxrtl
+
+#endif
@@ -32,6 +32,10 @@
 #include <atomic>
 #include <unordered_map>
 
+#if defined(CXXRTL_REPLAY_LZ4)
+#include <lz4.h>
+#endif
+
 #include <cxxrtl/cxxrtl.h>
 #include <cxxrtl/cxxrtl_time.h>
 
@@ -46,14 +50,19 @@
 // degree of detail see the source code. The format is considered fully internal to CXXRTL and is subject to change
 // without notice.
 //
-// <file>           ::= <file-header> <definitions> <sample>+
-// <file-header>    ::= 0x52585843 0x00004c54
+// <file>           ::= <file-header> <block>+
+// <file-header>    ::= 0x52585843 0x05004c54
+// <block>          ::= <block-header> <block-data>
+// <block-header>   ::= 0xc0000100 <flags> <size> <stored-size> <pointer> <time>
+// <block-data>     ::= (<size> words of <stream>, compressed into <stored-size> bytes if <flags> & 2)
+// <stream>         ::= <definitions> <sample>+
 // <definitions>    ::= <packet-define>* <packet-end>
 // <sample>         ::= <packet-sample> (<packet-change> | <packet-diag>)* <packet-end>
 // <packet-define>  ::= 0xc0000000 ...
 // <packet-sample>  ::= 0xc0000001 ...
 // <packet-change>  ::= 0x0??????? <chunk>+ | 0x1??????? <index> <chunk>+ | 0x2??????? | 0x3???????
 // <chunk>, <index> ::= 0x????????
+//
 // <packet-diag>    ::= <packet-break> | <packet-print> | <packet-assert> | <packet-assume>
 // <packet-break>   ::= 0xc0000010 <message> <source-location>
 // <packet-print>   ::= 0xc0000011 <message> <source-location>
@@ -61,6 +70,17 @@
 // <packet-assume>  ::= 0xc0000013 <message> <source-location>
 // <packet-end>     ::= 0xFFFFFFFF
 //
+// Chunks wider than 32 bits (see `CXXRTL_CHUNK_BITS`) are stored as several 32-bit words, least significant first,
+// and the size in a <packet-define> counts these words. A log can be read with a different chunk width than it was
+// written with only if every debug item has the same storage size in both.
+//
+// The stream of packets is cut into blocks, which are compressed with LZ4 if the recording application is built with
+// `CXXRTL_REPLAY_LZ4` defined (this requires `lz4.h` in the include path and `lz4.cc`, both from `libs/fst`). A block
+// ends wherever the writer is flushed, so packets may be split between blocks. Every complete sample begins a new
+// block, which is marked as a checkpoint (<flags> & 1) and has the pointer and time of that sample in its header.
+// The headers of all blocks form a chain, which the player follows to index the checkpoints without reading any
+// samples.
+//
 // The replay log contains sample data, however, it does not cover the entire design. Rather, it only contains sample
 // data for the subset of debug items containing _design state_: inputs and registers/latches. This keeps its size to
 // a minimum, and recording speed to a maximum. The player samples any missing data by setting the design state items
@@ -98,9 +118,11 @@
 // During initialization, the player establishes the mapping between debug item names and their 28-bit identifiers in
 // the log. It is done once.
 //
-// During rewinding, the player begins reading at the latest non-incremental sample that still lies before the requested
-// sample time. It continues reading incremental samples after that point until it reaches the requested sample time.
-// This process is very cheap as the design is not evaluated; it is essentially a (convoluted) memory copy operation.
+// During rewinding, the player looks up the latest checkpoint that still lies before the requested sample time, and
+// begins reading at it. It continues reading incremental samples after that point until it reaches the requested sample
+// time. This process is very cheap as the design is not evaluated; it is essentially a (convoluted) memory copy
+// operation. The amount of data read is bounded by the distance between checkpoints, which the recorder limits by
+// periodically writing a complete sample in place of an incremental one.
 //
 // During replaying, the player evaluates the design at the current time, which causes all debug items to assume
 // the values they had before recording. This process is expensive. Once done, the player advances to the next state
@@ -154,7 +176,7 @@ public:
 	// Numeric identifier assigned to a debug item within a replay log. Range limited to [1, MAXIMUM_IDENT].
 	typedef uint32_t ident_t;
 
-	static constexpr uint16_t VERSION = 0x0400;
+	static constexpr uint16_t VERSION = 0x0500;
 
 	static constexpr uint64_t HEADER_MAGIC = 0x00004c5452585843;
 	static constexpr uint64_t VERSION_MASK = 0xffff000000000000;
@@ -180,26 +202,34 @@ public:
 
 	static constexpr uint32_t PACKET_END     = 0xffffffff;
 
+	static constexpr uint32_t BLOCK_HEADER   = 0xc0000100;
+	enum block_flag : uint32_t {
+		CHECKPOINT  = 1,
+		LZ4         = 2,
+	};
+	static constexpr size_t BLOCK_HEADER_WORDS = 8;
+
+	static constexpr size_t WORDS_PER_CHUNK = sizeof(chunk_t) / sizeof(uint32_t);
+
 	// Writing spools.
 
 	class writer {
 		int fd;
 		size_t position;
 		std::vector<uint32_t> buffer;
+		uint32_t block_flags = 0;
+		pointer_t block_pointer = 0;
+		time block_timestamp;
+		std::vector<char> block_data;
 
 		// These functions aren't overloaded because of implicit numeric conversions.
 
 		void emit_word(uint32_t word) {
-			if (position + 1 == buffer.size())
+			if (position == buffer.size())
 				flush();
 			buffer[position++] = word;
 		}
 
-		void emit_dword(uint64_t dword) {
-			emit_word(dword >>  0);
-			emit_word(dword >> 32);
-		}
-
 		void emit_ident(ident_t ident) {
 			assert(ident <= MAXIMUM_IDENT);
 			emit_word(ident);
@@ -210,6 +240,11 @@ public:
 			emit_word(size);
 		}
 
+		void emit_chunk(chunk_t chunk) {
+			for (size_t word = 0; word < WORDS_PER_CHUNK; word++)
+				emit_word(uint32_t(chunk >> (32 * word)));
+		}
+
 		// Same implementation as `emit_size()`, different declared intent.
 		void emit_index(size_t index) {
 			assert(index <= std::numeric_limits<uint32_t>::max());
@@ -226,20 +261,26 @@ public:
 			}
 		}
 
-		void emit_time(const time &timestamp) {
+		static void split_time(const time &timestamp, uint32_t *words) {
 			const value<time::bits> &raw_timestamp(timestamp);
-			emit_word(raw_timestamp.data[0]);
-			emit_word(raw_timestamp.data[1]);
-			emit_word(raw_timestamp.data[2]);
+			words[0] = raw_timestamp.slice<31, 0>().val().get<uint32_t>();
+			words[1] = raw_timestamp.slice<63, 32>().val().get<uint32_t>();
+			words[2] = raw_timestamp.slice<95, 64>().val().get<uint32_t>();
+		}
+
+		void emit_time(const time &timestamp) {
+			uint32_t words[3];
+			split_time(timestamp, words);
+			for (uint32_t word : words)
+				emit_word(word);
 		}
 
 	public:
 		// Creates a writer, and transfers ownership of `fd`, which must be open for appending.
 		//
-		// The buffer size is currently fixed to a "reasonably large" size, determined empirically by measuring writer
-		// performance on a representative design; large but not so large it would e.g. cause address space exhaustion
-		// on 32-bit platforms.
-		writer(spool &spool) : fd(spool.take_write()), position(0), buffer(32 * 1024 * 1024) {
+		// The buffer size bounds the size of a block. It is large enough for the per-block overhead to be negligible, and
+		// small enough that a block which is read in full to reach a single sample does not take long to decompress.
+		writer(spool &spool) : fd(spool.take_write()), position(0), buffer(1024 * 1024) {
 			assert(fd != -1);
 #if !defined(WIN32)
 			int result = ftruncate(fd, 0);
@@ -249,7 +290,9 @@ public:
 			assert(result == 0);
 		}
 
-		writer(writer &&moved) : fd(moved.fd), position(moved.position), buffer(moved.buffer) {
+		writer(writer &&moved) : fd(moved.fd), position(moved.position), buffer(moved.buffer),
+		                         block_flags(moved.block_flags), block_pointer(moved.block_pointer),
+		                         block_timestamp(moved.block_timestamp) {
 			moved.fd = -1;
 			moved.position = 0;
 		}
@@ -258,13 +301,39 @@ public:
 		writer &operator=(const writer &) = delete;
 
 		// Both write() calls and fwrite() calls are too expensive to perform implicitly. The API consumer must determine
-		// the optimal time to flush the writer and do that explicitly for best performance.
+		// the optimal time to flush the writer and do that explicitly for best performance. (Besides that, the writer is
+		// flushed when its buffer is full, and before each complete sample.) Each flush writes out one block.
 		void flush() {
 			assert(fd != -1);
+			if (position == 0)
+				return;
+			const size_t header_size = BLOCK_HEADER_WORDS * sizeof(uint32_t);
 			size_t data_size = position * sizeof(uint32_t);
-			size_t data_written = write(fd, buffer.data(), data_size);
-			assert(data_size == data_written);
+			size_t stored_size = 0;
+			uint32_t flags = block_flags;
+#if defined(CXXRTL_REPLAY_LZ4)
+			block_data.resize(header_size + LZ4_compressBound(data_size));
+			stored_size = LZ4_compress_default((const char *)buffer.data(), &block_data[header_size],
+			                                   data_size, block_data.size() - header_size);
+			if (stored_size != 0 && stored_size < data_size)
+				flags |= block_flag::LZ4;
+#endif
+			if (!(flags & block_flag::LZ4)) {
+				block_data.resize(header_size + data_size);
+				memcpy(&block_data[header_size], buffer.data(), data_size);
+				stored_size = data_size;
+			}
+			uint32_t header[BLOCK_HEADER_WORDS] = { BLOCK_HEADER, flags, (uint32_t)position, (uint32_t)stored_size,
+			                                        block_pointer };
+			split_time(block_timestamp, &header[5]);
+			memcpy(&block_data[0], header, header_size);
+			size_t block_size = header_size + stored_size;
+			size_t data_written = write(fd, block_data.data(), block_size);
+			assert(block_size == data_written);
 			position = 0;
+			block_flags = 0;
+			block_pointer = 0;
+			block_timestamp = time();
 		}
 
 		~writer() {
@@ -276,8 +345,12 @@ public:
 
 		void write_magic() {
 			// `CXXRTL` followed by version in binary. This header will read backwards on big-endian machines, which allows
-			// detection of this case, both visually and programmatically.
-			emit_dword(((uint64_t)VERSION << 48) | HEADER_MAGIC);
+			// detection of this case, both visually and programmatically. It precedes the first block.
+			assert(position == 0);
+			uint64_t magic = ((uint64_t)VERSION << 48) | HEADER_MAGIC;
+			uint32_t words[2] = { uint32_t(magic >> 0), uint32_t(magic >> 32) };
+			size_t data_written = write(fd, words, sizeof(words));
+			assert(data_written == sizeof(words));
 		}
 
 		void write_define(ident_t ident, const std::string &name, size_t part_index, size_t chunks, size_t depth) {
@@ -285,11 +358,17 @@ public:
 			emit_ident(ident);
 			emit_string(name);
 			emit_index(part_index);
-			emit_size(chunks);
+			emit_size(chunks * WORDS_PER_CHUNK);
 			emit_size(depth);
 		}
 
 		void write_sample(bool incremental, pointer_t pointer, const time &timestamp) {
+			if (!incremental) {
+				flush();
+				block_flags = block_flag::CHECKPOINT;
+				block_pointer = pointer;
+				block_timestamp = timestamp;
+			}
 			uint32_t flags = (incremental ? sample_flag::INCREMENTAL : 0);
 			emit_word(PACKET_SAMPLE);
 			emit_word(flags);
@@ -307,7 +386,7 @@ public:
 			} else {
 				emit_word(PACKET_CHANGE | ident);
 				for (size_t offset = 0; offset < chunks; offset++)
-					emit_word(data[offset]);
+					emit_chunk(data[offset]);
 			}
 		}
 
@@ -317,7 +396,7 @@ public:
 			emit_word(PACKET_CHANGEI | ident);
 			emit_index(index);
 			for (size_t offset = 0; offset < chunks; offset++)
-				emit_word(data[offset]);
+				emit_chunk(data[offset]);
 		}
 
 		void write_diagnostic(const diagnostic &diagnostic) {
@@ -335,18 +414,57 @@ public:
 
 	class reader {
 		FILE *f;
+		std::vector<uint32_t> block;
+		size_t block_position = 0; // in words
+		uint64_t block_offset = 0; // of the block in `block`, in bytes
+		uint64_t next_block_offset = 0;
+		uint64_t scan_offset = 0; // of the first block not yet seen by `read_checkpoint()`
+		std::vector<char> block_data;
+
+		bool read_block_header(uint64_t offset, uint32_t (&header)[BLOCK_HEADER_WORDS]) {
+			fseek(f, offset, SEEK_SET);
+			if (fread(header, sizeof(header), 1, f) != 1)
+				return false;
+			assert(header[0] == BLOCK_HEADER);
+			return true;
+		}
 
-		uint32_t absorb_word() {
-			// If we're at end of file, `fread` will not write to `word`, and `PACKET_END` will be returned.
-			uint32_t word = PACKET_END;
-			fread(&word, sizeof(word), 1, f);
-			return word;
+		// Fails without changing anything if the block has not been completely written yet.
+		bool load_block(uint64_t offset) {
+			uint32_t header[BLOCK_HEADER_WORDS];
+			if (!read_block_header(offset, header))
+				return false;
+			uint32_t flags = header[1];
+			size_t words = header[2];
+			size_t stored_size = header[3];
+			block_data.resize(stored_size);
+			if (fread(block_data.data(), stored_size, 1, f) != 1)
+				return false;
+			block.resize(words);
+			if (flags & block_flag::LZ4) {
+#if defined(CXXRTL_REPLAY_LZ4)
+				int data_size = LZ4_decompress_safe(block_data.data(), (char *)block.data(),
+				                                    stored_size, words * sizeof(uint32_t));
+				assert(data_size == (int)(words * sizeof(uint32_t)));
+#else
+				assert(false && "Replay log is compressed; define `CXXRTL_REPLAY_LZ4` to read it");
+#endif
+			} else {
+				assert(stored_size == words * sizeof(uint32_t));
+				memcpy(block.data(), block_data.data(), stored_size);
+			}
+			block_position = 0;
+			block_offset = offset;
+			next_block_offset = offset + sizeof(header) + stored_size;
+			return true;
 		}
 
-		uint64_t absorb_dword() {
-			uint32_t lo = absorb_word();
-			uint32_t hi = absorb_word();
-			return ((uint64_t)hi << 32) | lo;
+		uint32_t absorb_word() {
+			// If we're at end of the data written so far, `PACKET_END` will be returned.
+			while (block_position == block.size())
+				if (!load_block(next_block_offset))
+					return PACKET_END;
+			return block[block_position++];
 		}
 
 		ident_t absorb_ident() {
@@ -359,6 +477,13 @@ public:
 			return absorb_word();
 		}
 
+		chunk_t absorb_chunk() {
+			chunk_t chunk = 0;
+			for (size_t word = 0; word < WORDS_PER_CHUNK; word++)
+				chunk |= chunk_t(absorb_word()) << (32 * word);
+			return chunk;
+		}
+
 		size_t absorb_index() {
 			return absorb_word();
 		}
@@ -375,23 +500,32 @@ public:
 			return str.substr(0, str.find('\0'));
 		}
 
+		static time join_time(uint32_t word0, uint32_t word1, uint32_t word2) {
+			return time(value<time::bits> { word0, word1, word2 });
+		}
+
 		time absorb_time() {
-			value<time::bits> raw_timestamp;
-			raw_timestamp.data[0] = absorb_word();
-			raw_timestamp.data[1] = absorb_word();
-			raw_timestamp.data[2] = absorb_word();
-			return time(raw_timestamp);
+			uint32_t word0 = absorb_word();
+			uint32_t word1 = absorb_word();
+			uint32_t word2 = absorb_word();
+			return join_time(word0, word1, word2);
 		}
 
 	public:
-		typedef uint64_t pos_t;
+		// A position within the stream of packets.
+		struct pos_t {
+			uint64_t block_offset;
+			size_t block_position;
+		};
 
 		// Creates a reader, and transfers ownership of `fd`, which must be open for reading.
-		reader(spool &spool) : f(fdopen(spool.take_read(), "r")) {
+		reader(spool &spool) : f(fdopen(spool.take_read(), "rb")) {
 			assert(f != nullptr);
 		}
 
-		reader(reader &&moved) : f(moved.f) {
+		reader(reader &&moved) : f(moved.f), block(std::move(moved.block)), block_position(moved.block_position),
+		                         block_offset(moved.block_offset), next_block_offset(moved.next_block_offset),
+		                         scan_offset(moved.scan_offset) {
 			moved.f = nullptr;
 		}
 
@@ -404,17 +538,51 @@ public:
 		}
 
 		pos_t position() {
-			return ftell(f);
+			return pos_t { block_offset, block_position };
 		}
 
 		void rewind(pos_t position) {
-			fseek(f, position, SEEK_SET);
+			if (position.block_offset != block_offset && !load_block(position.block_offset)) {
+				// The block has not been written yet; it will be loaded once it is.
+				assert(position.block_position == 0);
+				block.clear();
+				block_offset = next_block_offset = position.block_offset;
+			}
+			block_position = position.block_position;
 		}
 
 		void read_magic() {
-			uint64_t magic = absorb_dword();
+			uint32_t words[2] = { PACKET_END, PACKET_END };
+			fseek(f, 0, SEEK_SET);
+			fread(words, sizeof(words), 1, f);
+			uint64_t magic = ((uint64_t)words[1] << 32) | words[0];
 			assert((magic & ~VERSION_MASK) == HEADER_MAGIC);
 			assert((magic >> 48) == VERSION);
+			block.clear();
+			block_position = 0;
+			block_offset = next_block_offset = scan_offset = sizeof(words);
+		}
+
+		// Finds the next block, among the ones written since the last call, that begins with a complete sample. This only
+		// reads block headers, so all of the checkpoints in a log can be found quickly.
+		bool read_checkpoint(pos_t &position, pointer_t &pointer, time &timestamp) {
+			uint32_t header[BLOCK_HEADER_WORDS];
+			fseek(f, 0, SEEK_END);
+			uint64_t end_offset = ftell(f);
+			while (scan_offset + sizeof(header) <= end_offset && read_block_header(scan_offset, header)) {
+				uint64_t offset = scan_offset;
+				uint64_t next_offset = offset + sizeof(header) + header[3];
+				if (next_offset > end_offset)
+					break;
+				scan_offset = next_offset;
+				if (header[1] & block_flag::CHECKPOINT) {
+					position = pos_t { offset, 0 };
+					pointer = header[4];
+					timestamp = join_time(header[5], header[6], header[7]);
+					return true;
+				}
+			}
+			return false;
 		}
 
 		bool read_define(ident_t &ident, std::string &name, size_t &part_index, size_t &chunks, size_t &depth) {
@@ -425,7 +593,9 @@ public:
 			ident = absorb_ident();
 			name = absorb_string();
 			part_index = absorb_index();
-			chunks = absorb_size();
+			size_t words = absorb_size();
+			assert(words % WORDS_PER_CHUNK == 0 && "Replay log was written with a different chunk width");
+			chunks = words / WORDS_PER_CHUNK;
 			depth = absorb_size();
 			return true;
 		}
@@ -475,7 +645,7 @@ public:
 					assert(false && "Unrecognized change packet");
 			}
 			for (size_t offset = 0; offset < chunks; offset++)
-				data[chunks * index + offset] = absorb_word();
+				data[chunks * index + offset] = absorb_chunk();
 		}
 
 		bool read_diagnostic(uint32_t header, diagnostic &diagnostic) {
@@ -549,11 +719,20 @@ class recorder {
 	bool streaming = false; // whether variable definitions have been written
 	spool::pointer_t pointer = 0;
 	time timestamp;
+	size_t checkpoint_interval = 65536;
+	size_t samples_since_checkpoint = 0;
 
 public:
 	template<typename ...Args>
 	recorder(Args &&...args) : writer(std::forward<Args>(args)...) {}
 
+	// Sets the maximum number of incremental samples between complete samples. Once this many incremental samples have
+	// been recorded, `record_incremental()` records a complete sample instead. Shorter intervals make rewinding faster
+	// and the log larger. An interval of zero disables this behavior.
+	void set_checkpoint_interval(size_t samples) {
+		checkpoint_interval = samples;
+	}
+
 	void start(module &module, std::string top_path = "") {
 		debug_items items;
 		module.debug_info(&items, /*scopes=*/nullptr, top_path);
@@ -602,6 +781,7 @@ public:
 	void record_complete() {
 		assert(streaming);
 
+		samples_since_checkpoint = 0;
 		writer.write_sample(/*incremental=*/false, pointer++, timestamp);
 		for (auto var : variables) {
 			assert(var.ident != 0);
@@ -619,6 +799,14 @@ public:
 	bool record_incremental(ModuleT &module) {
 		assert(streaming);
 
+		if (checkpoint_interval != 0 && samples_since_checkpoint >= checkpoint_interval) {
+			observer null_observer;
+			bool changed = module.commit(null_observer);
+			record_complete();
+			return changed;
+		}
+		samples_since_checkpoint++;
+
 		struct : observer {
 			std::unordered_map<const chunk_t*, spool::ident_t> *ident_lookup;
 			spool::writer *writer;
@@ -654,6 +842,7 @@ public:
 		// diagnostics should be rare enough that this inefficiency does not matter. If it turns out to be an issue, this
 		// code should be changed to accumulate diagnostics to a buffer that is flushed in `record_{complete,incremental}`
 		// and also in `advance_time` before the timestamp is changed. (Right now `advance_time` never writes to the spool.)
+		samples_since_checkpoint++;
 		writer.write_sample(/*incremental=*/true, pointer++, timestamp);
 		writer.write_diagnostic(diagnostic);
 		writer.write_end();
@@ -684,6 +873,18 @@ class player {
 	std::map<spool::pointer_t, spool::reader::pos_t, std::greater<spool::pointer_t>> index_by_pointer;
 	std::map<time, spool::reader::pos_t, std::greater<time>> index_by_timestamp;
 
+	// Adds the checkpoints written since the last call to the index. It is possible (though not very useful) to have
+	// several complete samples with the same timestamp in a row; the timestamp is associated with the first of them.
+	void update_index() {
+		spool::reader::pos_t position;
+		spool::pointer_t pointer;
+		time timestamp;
+		while (reader.read_checkpoint(position, pointer, timestamp)) {
+			index_by_pointer.emplace(pointer, position);
+			index_by_timestamp.emplace(timestamp, position);
+		}
+	}
+
 	bool peek_sample(spool::pointer_t &pointer, time &timestamp) {
 		bool incremental;
 		auto position = reader.position();
@@ -767,11 +968,16 @@ public:
 	// correspond to this pointer in the replay log. To obtain a valid pointer, call `current_pointer()`; while pointers
 	// are monotonically increasing for each consecutive sample, using arithmetic operations to create a new pointer is
 	// not allowed. The `diagnostics` argument, if not `nullptr`, receives the diagnostics recorded in this sample.
+	//
+	// Both this function and `rewind_to_or_before()` can move to any sample in the replay log, including the ones that
+	// come after the current sample and have never been read. Either takes time logarithmic in the number of checkpoints
+	// plus linear in the distance to the closest preceding checkpoint.
 	bool rewind_to(spool::pointer_t at_pointer, std::vector<diagnostic> *diagnostics) {
 		assert(initialized);
 
 		// The pointers in the replay log start from one that is greater than `at_pointer`. In this case the pointer will
 		// never be reached.
+		update_index();
 		assert(index_by_pointer.size() > 0);
 		if (at_pointer < index_by_pointer.rbegin()->first)
 			return false;
@@ -802,6 +1008,7 @@ public:
 
 		// The timestamps in the replay log start from one that is greater than `at_or_before_timestamp`. In this case
 		// the timestamp will never be reached. Otherwise, this function will always succeed.
+		update_index();
 		assert(index_by_timestamp.size() > 0);
 		if (at_or_before_timestamp < index_by_timestamp.rbegin()->first)
 			return false;
@@ -836,22 +1043,12 @@ public:
 		assert(streaming);
 
 		bool incremental;
-		auto position = reader.position();
 		if (!reader.read_sample(incremental, pointer, timestamp))
 			return false;
 
 		// The very first sample that is read must be a complete sample. This is required for the rewind functions to work.
 		assert(initialized || !incremental);
 
-		// It is possible (though not very useful) to have several complete samples with the same timestamp in a row.
-		// Ensure that we associate the timestamp with the position of the first such complete sample. (This condition
-		// works because the player never jumps over a sample.)
-		if (!incremental && !index_by_pointer.count(pointer)) {
-			assert(!index_by_timestamp.count(timestamp));
-			index_by_pointer[pointer] = position;
-			index_by_timestamp[timestamp] = position;
-		}
-
 		uint32_t header;
 		while (reader.read_header(header)) {
 			spool::ident_t ident;
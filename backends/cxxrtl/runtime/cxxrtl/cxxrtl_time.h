@@ -30,14 +30,14 @@ namespace cxxrtl {
 // of this format can represent any VCD timestamp within approx. ±1255321.2 years, without the need for a timescale.
 class time {
 public:
-	static constexpr size_t bits = 96; // 3 chunks
+	static constexpr size_t bits = 96; // 3 words
 
 private:
 	static constexpr size_t resolution_digits = 15;
 
-	static_assert(sizeof(chunk_t) == 4, "a chunk is expected to be 32-bit");
+	// Values are initialized with 32-bit words regardless of the chunk width.
 	static constexpr value<bits> resolution = value<bits> {
-		chunk_t(1000000000000000ull & 0xffffffffull), chunk_t(1000000000000000ull >> 32), 0u
+		uint32_t(1000000000000000ull & 0xffffffffull), uint32_t(1000000000000000ull >> 32), 0u
 	};
 
 	// Signed number of femtoseconds from the beginning of time.
@@ -19,25 +19,18 @@
 #ifndef CXXRTL_VCD_H
 #define CXXRTL_VCD_H
 
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
 #include <cxxrtl/cxxrtl.h>
+#include <cxxrtl/cxxrtl_waveform.h>
 
 namespace cxxrtl {
 
-class vcd_writer {
-	struct variable {
-		size_t ident;
-		size_t width;
-		chunk_t *curr;
-		size_t cache_offset;
-		debug_outline *outline;
-		bool *outline_warm;
-	};
-
+class vcd_writer : public waveform_writer {
 	std::vector<std::string> current_scope;
-	std::map<debug_outline*, bool> outlines;
-	std::vector<variable> variables;
-	std::vector<chunk_t> cache;
-	std::map<chunk_t*, size_t> aliases;
 	bool streaming = false;
 
 	void emit_timescale(unsigned number, const std::string &unit) {
@@ -48,7 +41,7 @@ class vcd_writer {
 		buffer += "$timescale " + std::to_string(number) + " " + unit + " $end\n";
 	}
 
-	void emit_scope(const std::vector<std::string> &scope) {
+	void emit_scope(const std::vector<std::string> &scope) override {
 		assert(!streaming);
 		size_t same_scope_count = 0;
 		while ((same_scope_count < current_scope.size()) &&
@@ -86,7 +79,7 @@ class vcd_writer {
 	}
 
 	void emit_var(const variable &var, const std::string &type, const std::string &name,
-	              size_t lsb_at, bool multipart) {
+	              size_t lsb_at, bool multipart) override {
 		assert(!streaming);
 		buffer += "$var " + type + " " + std::to_string(var.width) + " ";
 		emit_ident(var.ident);
@@ -122,72 +115,25 @@ class vcd_writer {
 
 	void emit_vector(const variable &var) {
 		assert(streaming);
-		buffer += 'b';
-		for (size_t bit = var.width - 1; bit != (size_t)-1; bit--) {
-			bool bit_curr = var.curr[bit / (8 * sizeof(chunk_t))] & (1 << (bit % (8 * sizeof(chunk_t))));
-			buffer += (bit_curr ? '1' : '0');
+		// Bits are written in place rather than appended one by one, which is the hot path of the writer.
+		size_t digits = std::max<size_t>(var.width, 1);
+		size_t offset = buffer.size();
+		buffer.resize(offset + 1 + digits);
+		char *digit = &buffer[offset];
+		*digit++ = 'b';
+		const size_t chunk_bits = 8 * sizeof(chunk_t);
+		for (size_t chunk_index = (var.width + chunk_bits - 1) / chunk_bits; chunk_index-- > 0;) {
+			chunk_t chunk = var.curr[chunk_index];
+			for (size_t bit = std::min(var.width - chunk_index * chunk_bits, chunk_bits); bit-- > 0;)
+				*digit++ = '0' + ((chunk >> bit) & 1);
 		}
 		if (var.width == 0)
-			buffer += '0';
+			*digit++ = '0';
 		buffer += ' ';
 		emit_ident(var.ident);
 		buffer += '\n';
 	}
 
-	void reset_outlines() {
-		for (auto &outline_it : outlines)
-			outline_it.second = /*warm=*/(outline_it.first == nullptr);
-	}
-
-	variable &register_variable(size_t width, chunk_t *curr, bool constant = false, debug_outline *outline = nullptr) {
-		if (aliases.count(curr)) {
-			return variables[aliases[curr]];
-		} else {
-			auto outline_it = outlines.emplace(outline, /*warm=*/(outline == nullptr)).first;
-			const size_t chunks = (width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
-			aliases[curr] = variables.size();
-			if (constant) {
-				variables.emplace_back(variable { variables.size(), width, curr, (size_t)-1, outline_it->first, &outline_it->second });
-			} else {
-				variables.emplace_back(variable { variables.size(), width, curr, cache.size(), outline_it->first, &outline_it->second });
-				cache.insert(cache.end(), &curr[0], &curr[chunks]);
-			}
-			return variables.back();
-		}
-	}
-
-	bool test_variable(const variable &var) {
-		if (var.cache_offset == (size_t)-1)
-			return false; // constant
-		if (!*var.outline_warm) {
-			var.outline->eval();
-			*var.outline_warm = true;
-		}
-		const size_t chunks = (var.width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
-		if (std::equal(&var.curr[0], &var.curr[chunks], &cache[var.cache_offset])) {
-			return false;
-		} else {
-			std::copy(&var.curr[0], &var.curr[chunks], &cache[var.cache_offset]);
-			return true;
-		}
-	}
-
-	static std::vector<std::string> split_hierarchy(const std::string &hier_name) {
-		std::vector<std::string> hierarchy;
-		size_t prev = 0;
-		while (true) {
-			size_t curr = hier_name.find_first_of(' ', prev);
-			if (curr == std::string::npos) {
-				hierarchy.push_back(hier_name.substr(prev));
-				break;
-			} else {
-				hierarchy.push_back(hier_name.substr(prev, curr - prev));
-				prev = curr + 1;
-			}
-		}
-		return hierarchy;
-	}
-
 public:
 	std::string buffer;
 
@@ -195,84 +141,108 @@ public:
 		emit_timescale(number, unit);
 	}
 
-	void add(const std::string &hier_name, const debug_item &item, bool multipart = false) {
-		std::vector<std::string> scope = split_hierarchy(hier_name);
-		std::string name = scope.back();
-		scope.pop_back();
-
-		emit_scope(scope);
-		switch (item.type) {
-			// Not the best naming but oh well...
-			case debug_item::VALUE:
-				emit_var(register_variable(item.width, item.curr, /*constant=*/item.next == nullptr),
-				         "wire", name, item.lsb_at, multipart);
-				break;
-			case debug_item::WIRE:
-				emit_var(register_variable(item.width, item.curr),
-				         "reg", name, item.lsb_at, multipart);
-				break;
-			case debug_item::MEMORY: {
-				const size_t stride = (item.width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
-				for (size_t index = 0; index < item.depth; index++) {
-					chunk_t *nth_curr = &item.curr[stride * index];
-					std::string nth_name = name + '[' + std::to_string(index) + ']';
-					emit_var(register_variable(item.width, nth_curr),
-					         "reg", nth_name, item.lsb_at, multipart);
-				}
-				break;
-			}
-			case debug_item::ALIAS:
-				// Like VALUE, but, even though `item.next == nullptr` always holds, the underlying value
-				// can actually change, and must be tracked. In most cases the VCD identifier will be
-				// unified with the aliased reg, but we should handle the case where only the alias is
-				// added to the VCD writer, too.
-				emit_var(register_variable(item.width, item.curr),
-				         "wire", name, item.lsb_at, multipart);
-				break;
-			case debug_item::OUTLINE:
-				emit_var(register_variable(item.width, item.curr, /*constant=*/false, item.outline),
-				         "wire", name, item.lsb_at, multipart);
-				break;
+	void sample(uint64_t timestamp) {
+		bool first_sample = !streaming;
+		if (first_sample) {
+			emit_scope({});
+			emit_enddefinitions();
 		}
+		emit_time(timestamp);
+		sample_variables(first_sample, [this](const variable &var) {
+			if (var.width == 1)
+				emit_scalar(var);
+			else
+				emit_vector(var);
+		});
 	}
+};
 
-	template<class Filter>
-	void add(const debug_items &items, const Filter &filter) {
-		// `debug_items` is a map, so the items are already sorted in an order optimal for emitting
-		// VCD scope sections.
-		for (auto &it : items.table)
-			for (auto &part : it.second)
-				if (filter(it.first, part))
-					add(it.first, part, it.second.size() > 1);
+// Writes the text produced by a `vcd_writer` to a stream on a background thread. The text is handed over by swapping
+// the buffer of the writer with one that has already been written out, so the simulation does not wait for the stream
+// unless it produces text much faster than the stream accepts it. The stream must not be used by anything else until
+// the `background_writer` is destroyed.
+//
+// Example usage:
+//
+//   cxxrtl::vcd_writer vcd;
+//   std::ofstream file("waves.vcd");
+//   cxxrtl::background_writer output(file);
+//   ...
+//   vcd.sample(steps);
+//   output.write(vcd.buffer);
+//   ...
+//   output.flush(vcd.buffer);
+class background_writer {
+	std::ostream &stream;
+	size_t threshold;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::string pending;
+	bool busy = false;
+	bool stopping = false;
+	std::thread thread; // must be initialized last
+
+	void worker() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			cond.wait(lock, [this] { return busy || stopping; });
+			if (!busy)
+				return;
+			lock.unlock();
+			stream.write(pending.data(), pending.size());
+			pending.clear();
+			lock.lock();
+			busy = false;
+			cond.notify_all();
+		}
 	}
 
-	void add(const debug_items &items) {
-		this->add(items, [](const std::string &, const debug_item &) {
-			return true;
-		});
+	void hand_over(std::string &buffer) {
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this] { return !busy; });
+		std::swap(pending, buffer);
+		busy = true;
+		cond.notify_all();
 	}
 
-	void add_without_memories(const debug_items &items) {
-		this->add(items, [](const std::string &, const debug_item &item) {
-			return item.type != debug_item::MEMORY;
-		});
+public:
+	// Text is handed over to the background thread in batches of at least `threshold` bytes.
+	explicit background_writer(std::ostream &stream, size_t threshold = 1 << 20)
+		: stream(stream), threshold(threshold), thread(&background_writer::worker, this) {}
+
+	~background_writer() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cond.notify_all();
+		thread.join();
+		stream.flush();
+	}
+
+	background_writer(const background_writer &) = delete;
+	background_writer &operator=(const background_writer &) = delete;
+
+	// Takes the contents of `buffer` if there are enough of them, leaving it empty. If the previous batch is still
+	// being written, waits for it only if `buffer` has grown well past the threshold.
+	void write(std::string &buffer) {
+		if (buffer.size() < threshold)
+			return;
+		if (buffer.size() < 8 * threshold) {
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if (!lock.owns_lock() || busy)
+				return;
+		}
+		hand_over(buffer);
 	}
 
-	void sample(uint64_t timestamp) {
-		bool first_sample = !streaming;
-		if (first_sample) {
-			emit_scope({});
-			emit_enddefinitions();
-		}
-		reset_outlines();
-		emit_time(timestamp);
-		for (auto var : variables)
-			if (test_variable(var) || first_sample) {
-				if (var.width == 1)
-					emit_scalar(var);
-				else
-					emit_vector(var);
-			}
+	// Takes all of the contents of `buffer`, leaving it empty, and waits until they are written to the stream.
+	void flush(std::string &buffer) {
+		hand_over(buffer);
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this] { return !busy; });
+		stream.flush();
 	}
 };
 
@@ -0,0 +1,282 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2020  whitequark <whitequark@whitequark.org>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef CXXRTL_WAVEFORM_H
+#define CXXRTL_WAVEFORM_H
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <cxxrtl/cxxrtl.h>
+
+namespace cxxrtl {
+
+// The part of a waveform writer that collects variables from debug items and finds out which of them have changed
+// between samples. The file format is implemented by a subclass (see `vcd_writer` and `fst_writer`).
+//
+// By default, every variable is compared against its value in the previous sample. If the design is committed
+// through `commit()` (or stepped through `step()`) of the writer instead, the writer learns which wires and memory
+// rows the design has changed, and only compares those, together with the variables that have no backing state
+// (values, aliases and outlines). In this mode, every change to wires and memories must be made through the writer:
+// changes made by writing to `curr` directly, or by committing the design in any other way, will be missed.
+class waveform_writer {
+protected:
+	struct variable {
+		size_t ident;
+		size_t width;
+		chunk_t *curr;
+		size_t cache_offset;
+		debug_outline *outline;
+		bool *outline_warm;
+		bool observed; // changes only through `commit()`
+		bool dirty; // changed by `commit()` since the previous sample
+	};
+
+	std::map<debug_outline*, bool> outlines;
+	std::vector<variable> variables;
+	std::vector<chunk_t> cache;
+	std::map<chunk_t*, size_t> aliases;
+
+	std::unordered_map<const chunk_t*, size_t> observed_lookup;
+	std::vector<size_t> polled; // variables that are compared on every sample even when observing
+	std::vector<size_t> dirty;
+	bool observing = false;
+
+	virtual void emit_scope(const std::vector<std::string> &scope) = 0;
+	virtual void emit_var(const variable &var, const std::string &type, const std::string &name,
+	                      size_t lsb_at, bool multipart) = 0;
+
+	void reset_outlines() {
+		for (auto &outline_it : outlines)
+			outline_it.second = /*warm=*/(outline_it.first == nullptr);
+	}
+
+	variable &register_variable(size_t width, chunk_t *curr, bool constant = false, debug_outline *outline = nullptr,
+	                            bool observed = false) {
+		if (aliases.count(curr)) {
+			variable &var = variables[aliases[curr]];
+			// An alias of a wire only changes when the wire does.
+			if (observed && !var.observed && var.cache_offset != (size_t)-1) {
+				var.observed = true;
+				observed_lookup[curr] = var.ident;
+			}
+			return var;
+		} else {
+			auto outline_it = outlines.emplace(outline, /*warm=*/(outline == nullptr)).first;
+			const size_t chunks = (width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
+			aliases[curr] = variables.size();
+			if (constant) {
+				variables.emplace_back(variable { variables.size(), width, curr, (size_t)-1, outline_it->first, &outline_it->second,
+				                                  /*observed=*/false, /*dirty=*/false });
+			} else {
+				variables.emplace_back(variable { variables.size(), width, curr, cache.size(), outline_it->first, &outline_it->second,
+				                                  observed, /*dirty=*/false });
+				cache.insert(cache.end(), &curr[0], &curr[chunks]);
+				if (observed)
+					observed_lookup[curr] = variables.back().ident;
+			}
+			return variables.back();
+		}
+	}
+
+	bool test_variable(const variable &var) {
+		if (var.cache_offset == (size_t)-1)
+			return false; // constant
+		if (!*var.outline_warm) {
+			var.outline->eval();
+			*var.outline_warm = true;
+		}
+		const size_t chunks = (var.width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
+		if (std::equal(&var.curr[0], &var.curr[chunks], &cache[var.cache_offset])) {
+			return false;
+		} else {
+			std::copy(&var.curr[0], &var.curr[chunks], &cache[var.cache_offset]);
+			return true;
+		}
+	}
+
+	CXXRTL_ALWAYS_INLINE
+	void mark_variable(const chunk_t *curr) {
+		auto it = observed_lookup.find(curr);
+		if (it != observed_lookup.end() && !variables[it->second].dirty) {
+			variables[it->second].dirty = true;
+			dirty.push_back(it->second);
+		}
+	}
+
+	// Calls `emit(var)` for every variable that has changed since the previous sample, or for every variable if
+	// `complete` is true. Variables are always visited in the order in which they were added.
+	template<class EmitFn>
+	void sample_variables(bool complete, EmitFn emit) {
+		reset_outlines();
+		if (complete || !observing) {
+			for (auto &var : variables)
+				if (test_variable(var) || complete)
+					emit(var);
+			if (complete) {
+				polled.clear();
+				for (auto &var : variables)
+					if (!var.observed && var.cache_offset != (size_t)-1)
+						polled.push_back(var.ident);
+			}
+		} else {
+			// Merge the (sorted) polled variables with the (sorted) dirty ones, which never overlap.
+			std::sort(dirty.begin(), dirty.end());
+			auto polled_it = polled.begin();
+			auto dirty_it = dirty.begin();
+			while (polled_it != polled.end() || dirty_it != dirty.end()) {
+				size_t index;
+				if (dirty_it == dirty.end() || (polled_it != polled.end() && *polled_it < *dirty_it))
+					index = *polled_it++;
+				else
+					index = *dirty_it++;
+				variable &var = variables[index];
+				if (test_variable(var))
+					emit(var);
+			}
+		}
+		for (size_t index : dirty)
+			variables[index].dirty = false;
+		dirty.clear();
+	}
+
+	static std::vector<std::string> split_hierarchy(const std::string &hier_name) {
+		std::vector<std::string> hierarchy;
+		size_t prev = 0;
+		while (true) {
+			size_t curr = hier_name.find_first_of(' ', prev);
+			if (curr == std::string::npos) {
+				hierarchy.push_back(hier_name.substr(prev));
+				break;
+			} else {
+				hierarchy.push_back(hier_name.substr(prev, curr - prev));
+				prev = curr + 1;
+			}
+		}
+		return hierarchy;
+	}
+
+public:
+	waveform_writer() {}
+	virtual ~waveform_writer() {}
+
+	waveform_writer(const waveform_writer &) = delete;
+	waveform_writer &operator=(const waveform_writer &) = delete;
+
+	void add(const std::string &hier_name, const debug_item &item, bool multipart = false) {
+		std::vector<std::string> scope = split_hierarchy(hier_name);
+		std::string name = scope.back();
+		scope.pop_back();
+
+		emit_scope(scope);
+		switch (item.type) {
+			// Not the best naming but oh well...
+			case debug_item::VALUE:
+				emit_var(register_variable(item.width, item.curr, /*constant=*/item.next == nullptr),
+				         "wire", name, item.lsb_at, multipart);
+				break;
+			case debug_item::WIRE:
+				emit_var(register_variable(item.width, item.curr, /*constant=*/false, /*outline=*/nullptr, /*observed=*/true),
+				         "reg", name, item.lsb_at, multipart);
+				break;
+			case debug_item::MEMORY: {
+				const size_t stride = (item.width + (sizeof(chunk_t) * 8 - 1)) / (sizeof(chunk_t) * 8);
+				for (size_t index = 0; index < item.depth; index++) {
+					chunk_t *nth_curr = &item.curr[stride * index];
+					std::string nth_name = name + '[' + std::to_string(index) + ']';
+					emit_var(register_variable(item.width, nth_curr, /*constant=*/false, /*outline=*/nullptr, /*observed=*/true),
+					         "reg", nth_name, item.lsb_at, multipart);
+				}
+				break;
+			}
+			case debug_item::ALIAS:
+				// Like VALUE, but, even though `item.next == nullptr` always holds, the underlying value
+				// can actually change, and must be tracked. In most cases the VCD identifier will be
+				// unified with the aliased reg, but we should handle the case where only the alias is
+				// added to the VCD writer, too.
+				emit_var(register_variable(item.width, item.curr),
+				         "wire", name, item.lsb_at, multipart);
+				break;
+			case debug_item::OUTLINE:
+				emit_var(register_variable(item.width, item.curr, /*constant=*/false, item.outline),
+				         "wire", name, item.lsb_at, multipart);
+				break;
+		}
+	}
+
+	template<class Filter>
+	void add(const debug_items &items, const Filter &filter) {
+		// `debug_items` is a map, so the items are already sorted in an order optimal for emitting
+		// VCD scope sections.
+		for (auto &it : items.table)
+			for (auto &part : it.second)
+				if (filter(it.first, part))
+					add(it.first, part, it.second.size() > 1);
+	}
+
+	void add(const debug_items &items) {
+		this->add(items, [](const std::string &, const debug_item &) {
+			return true;
+		});
+	}
+
+	void add_without_memories(const debug_items &items) {
+		this->add(items, [](const std::string &, const debug_item &item) {
+			return item.type != debug_item::MEMORY;
+		});
+	}
+
+	// Commits the design, and remembers which of the added wires and memory rows have changed. This function is
+	// generic over ModuleT to encourage observer callbacks to be inlined into the commit function.
+	template<class ModuleT>
+	bool commit(ModuleT &module) {
+		struct : observer {
+			waveform_writer *writer;
+
+			CXXRTL_ALWAYS_INLINE
+			void on_update(size_t chunks, const chunk_t *base, const chunk_t *value) {
+				writer->mark_variable(base);
+			}
+
+			CXXRTL_ALWAYS_INLINE
+			void on_update(size_t chunks, const chunk_t *base, const chunk_t *value, size_t index) {
+				writer->mark_variable(&base[chunks * index]);
+			}
+		} change_observer;
+		change_observer.writer = this;
+
+		observing = true;
+		return module.commit(change_observer);
+	}
+
+	// Same as `module::step()`, but commits the design through `commit()` above.
+	template<class ModuleT>
+	size_t step(ModuleT &module, performer *performer = nullptr) {
+		size_t deltas = 0;
+		bool converged = false;
+		do {
+			converged = module.eval(performer);
+			deltas++;
+		} while (commit(module) && !converged);
+		return deltas;
+	}
+};
+
+}
+
+#endif
@@ -23,6 +23,7 @@
 
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <string>
 #include <iostream>
 #include <algorithm>
@@ -30,71 +31,119 @@
 template<size_t n>
 class Signal {
     template<size_t m> friend class Signal;
-    std::array<bool, n> _bits;
+
+    // The bits are packed into 64-bit words, least significant word first. The bits of the last word that are above
+    // `n` are always zero; every operation below relies on this, and restores it with `mask()` where needed.
+    static constexpr size_t words = (n + 63) / 64;
+    static constexpr uint64_t top_mask = n % 64 == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (n % 64)) - 1;
+    std::array<uint64_t, words> _words = {};
+
+    void mask()
+    {
+        if constexpr (words > 0)
+            _words[words - 1] &= top_mask;
+    }
+
+    // Returns the 64 bits starting at bit `offset`, with the bits past the end of the signal read as zero.
+    uint64_t extract_word(size_t offset) const
+    {
+        size_t w = offset / 64, s = offset % 64;
+        if(w >= words)
+            return 0;
+        uint64_t ret = _words[w] >> s;
+        if(s != 0 && w + 1 < words)
+            ret |= _words[w + 1] << (64 - s);
+        return ret;
+    }
+
+    // Sets every bit from bit `offset` up to the end of the signal.
+    void fill_from(size_t offset)
+    {
+        for(size_t w = offset / 64; w < words; w++)
+            _words[w] |= w == offset / 64 ? ~(uint64_t)0 << (offset % 64) : ~(uint64_t)0;
+        mask();
+    }
+
+    // ORs `b` into the signal at bit `offset`; the bits of `b` that do not fit are dropped.
+    template<size_t m>
+    void deposit(size_t offset, Signal<m> const &b)
+    {
+        size_t w = offset / 64, s = offset % 64;
+        for(size_t i = 0; i < b.words && w + i < words; i++) {
+            _words[w + i] |= b._words[i] << s;
+            if(s != 0 && w + i + 1 < words)
+                _words[w + i + 1] |= b._words[i] >> (64 - s);
+        }
+        mask();
+    }
+
+    // Computes the 128-bit product of `a` and `b`, returning the low word and storing the high word in `hi`.
+    static uint64_t mul_wide(uint64_t a, uint64_t b, uint64_t &hi)
+    {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 p = (unsigned __int128)a * b;
+        hi = (uint64_t)(p >> 64);
+        return (uint64_t)p;
+#else
+        uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+        uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+        uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+        hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        return (mid << 32) | (uint32_t)ll;
+#endif
+    }
+
 public:
     Signal() { }
     Signal(uint32_t val)
     {
-        for(size_t i = 0; i < n; i++)
-            if(i < 32)
-                _bits[i] = val & (1<<i);
-            else
-                _bits[i] = false;
+        if constexpr (words > 0)
+            _words[0] = val;
+        mask();
     }
 
     Signal(std::initializer_list<uint32_t> vals)
     {
-        size_t k, i;
-
-        k = 0;
+        size_t k = 0;
         for (auto val : vals) {
-            for(i = 0; i < 32; i++)
-                if(i + k < n)
-                    _bits[i + k] = val & (1<<i);
+            if(k / 64 < words)
+                _words[k / 64] |= (uint64_t)val << (k % 64);
             k += 32;
         }
-        for(; k < n; k++)
-            _bits[k] = false;
+        mask();
     }
 
     template<typename T>
     static Signal from_array(T vals)
     {
-        size_t k, i;
         Signal ret;
-
-        k = 0;
+        size_t k = 0;
         for (auto val : vals) {
-            for(i = 0; i < 32; i++)
-                if(i + k < n)
-                    ret._bits[i + k] = val & (1<<i);
+            if(k / 64 < words)
+                ret._words[k / 64] |= (uint64_t)(uint32_t)val << (k % 64);
             k += 32;
         }
-        for(; k < n; k++)
-            ret._bits[k] = false;
+        ret.mask();
         return ret;
     }
 
     static Signal from_signed(int32_t val)
     {
-        Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            if(i < 32)
-                ret._bits[i] = val & (1<<i);
-            else
-                ret._bits[i] = val < 0;
+        Signal<n> ret = (uint32_t)val;
+        if(val < 0)
+            ret.fill_from(32);
         return ret;
     }
     static Signal repeat(bool b)
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = b;
+        if(b)
+            ret.fill_from(0);
         return ret;
     }
 
     int size() const { return n; }
-    bool operator[](int i) const { assert(n >= 0 && i < n); return _bits[i]; }
+    bool operator[](int i) const { assert(n >= 0 && i < n); return (_words[i / 64] >> (i % 64)) & 1; }
 
     template<size_t m>
     Signal<m> slice(size_t offset) const
@@ -102,51 +151,54 @@ public:
         Signal<m> ret;
 
         assert(offset + m <= n);
-        std::copy(_bits.begin() + offset, _bits.begin() + offset + m, ret._bits.begin());
+        for(size_t i = 0; i < ret.words; i++)
+            ret._words[i] = extract_word(offset + 64 * i);
+        ret.mask();
         return ret;
     }
 
     bool any() const
     {
-        for(int i = 0; i < n; i++)
-            if(_bits[i])
+        for(size_t i = 0; i < words; i++)
+            if(_words[i] != 0)
                 return true;
         return false;
     }
 
     bool all() const
     {
-        for(int i = 0; i < n; i++)
-            if(!_bits[i])
+        for(size_t i = 0; i < words; i++)
+            if(_words[i] != (i == words - 1 ? top_mask : ~(uint64_t)0))
                 return false;
         return true;
     }
 
     bool parity() const
     {
-        bool result = false;
-        for(int i = 0; i < n; i++)
-            result ^= _bits[i];
-        return result;
+        uint64_t x = 0;
+        for(size_t i = 0; i < words; i++)
+            x ^= _words[i];
+        for(size_t s = 32; s != 0; s >>= 1)
+            x ^= x >> s;
+        return x & 1;
     }
 
-    bool sign() const { return _bits[n-1]; }
+    bool sign() const { return (*this)[n-1]; }
 
     template<typename T>
     T as_numeric() const
     {
         T ret = 0;
-        for(size_t i = 0; i < std::min<size_t>(sizeof(T) * 8, n); i++)
-            if(_bits[i])
-                ret |= ((T)1)<<i;
+        for(size_t i = 0; i < words && i * 64 < sizeof(T) * 8; i++)
+            ret |= ((T)_words[i]) << (i * 64);
         return ret;
     }
 
     template<typename T>
     T as_numeric_clamped() const
     {
-        for(size_t i = sizeof(T) * 8; i < n; i++)
-            if(_bits[i])
+        for(size_t i = sizeof(T) * 8; i < n; i += 64)
+            if(extract_word(i) != 0)
                 return ~((T)0);
         return as_numeric<T>();
     }
@@ -157,7 +209,7 @@ private:
     std::string as_string_p2(int b) const {
         std::string ret;
         for(int i = (n - 1) - (n - 1) % b; i >= 0; i -= b)
-            ret += "0123456789abcdef"[(*this >> Signal<32>(i)).as_int() & ((1<<b)-1)];
+            ret += "0123456789abcdef"[extract_word(i) & ((1<<b)-1)];
         return ret;
     }
     std::string as_string_b10() const {
@@ -198,57 +250,65 @@ public:
     Signal<n> operator ~() const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = !_bits[i];
+        for(size_t i = 0; i < words; i++)
+            ret._words[i] = ~_words[i];
+        ret.mask();
         return ret;
     }
 
     Signal<n> operator -() const
     {
         Signal<n> ret;
-        int x = 1;
-        for(size_t i = 0; i < n; i++) {
-            x += (int)!_bits[i];
-            ret._bits[i] = (x & 1) != 0;
-            x >>= 1;
+        uint64_t carry = 1;
+        for(size_t i = 0; i < words; i++) {
+            ret._words[i] = ~_words[i] + carry;
+            carry = carry && ret._words[i] == 0;
         }
+        ret.mask();
         return ret;
     }
 
     Signal<n> operator +(Signal<n> const &b) const
     {
         Signal<n> ret;
-        int x = 0;
-        for(size_t i = 0; i < n; i++){
-            x += (int)_bits[i] + (int)b._bits[i];
-            ret._bits[i] = x & 1;
-            x >>= 1;
+        uint64_t carry = 0;
+        for(size_t i = 0; i < words; i++){
+            uint64_t x = _words[i] + b._words[i];
+            ret._words[i] = x + carry;
+            carry = (x < _words[i]) | (ret._words[i] < x);
         }
+        ret.mask();
         return ret;
     }
 
     Signal<n> operator -(Signal<n> const &b) const
     {
         Signal<n> ret;
-        int x = 1;
-        for(size_t i = 0; i < n; i++){
-            x += (int)_bits[i] + (int)!b._bits[i];
-            ret._bits[i] = x & 1;
-            x >>= 1;
+        uint64_t borrow = 0;
+        for(size_t i = 0; i < words; i++){
+            uint64_t x = _words[i] - b._words[i];
+            ret._words[i] = x - borrow;
+            borrow = (x > _words[i]) | (ret._words[i] > x);
         }
+        ret.mask();
         return ret;
     }
 
     Signal<n> operator *(Signal<n> const &b) const
     {
         Signal<n> ret;
-        int x = 0;
-        for(size_t i = 0; i < n; i++){
-            for(size_t j = 0; j <= i; j++)
-                x += (int)_bits[j] & (int)b._bits[i-j];
-            ret._bits[i] = x & 1;
-            x >>= 1;
+        for(size_t i = 0; i < words; i++){
+            uint64_t carry = 0;
+            for(size_t j = 0; i + j < words; j++){
+                uint64_t hi, lo = mul_wide(_words[i], b._words[j], hi);
+                lo += carry;
+                hi += lo < carry;
+                ret._words[i + j] += lo;
+                hi += ret._words[i + j] < lo;
+                carry = hi;
+            }
         }
+        ret.mask();
         return ret;
     }
 
@@ -258,12 +318,23 @@ private:
         if(!b.any()) return 0;
         Signal<n> q = 0;
         Signal<n> r = 0;
-        for(size_t i = n; i-- != 0; ){
-            r = r << Signal<1>(1);
-            r._bits[0] = _bits[i];
-            if(r >= b){
+        if constexpr (words == 1) {
+            q._words[0] = _words[0] / b._words[0];
+            r._words[0] = _words[0] % b._words[0];
+            return modulo ? r : q;
+        }
+        // Long division, a bit at a time, starting from the most significant bit that is set.
+        size_t i = n;
+        while(i != 0 && !(*this)[i - 1])
+            i--;
+        while(i-- != 0){
+            bool overflow = r.sign();
+            for(size_t w = words; w-- != 0; )
+                r._words[w] = (r._words[w] << 1) | (w > 0 ? r._words[w - 1] >> 63 : (*this)[i]);
+            r.mask();
+            if(overflow || r >= b){
                 r = r - b;
-                q._bits[i] = true;
+                q._words[i / 64] |= (uint64_t)1 << (i % 64);
             }
         }
         return modulo ? r : q;
@@ -275,67 +346,67 @@ public:
 
     bool operator ==(Signal<n> const &b) const
     {
-        for(size_t i = 0; i < n; i++)
-            if(_bits[i] != b._bits[i])
+        for(size_t i = 0; i < words; i++)
+            if(_words[i] != b._words[i])
                 return false;
         return true;
     }
 
     bool operator >=(Signal<n> const &b) const
     {
-        for(size_t i = n; i-- != 0; )
-            if(_bits[i] != b._bits[i])
-                return _bits[i];
+        for(size_t i = words; i-- != 0; )
+            if(_words[i] != b._words[i])
+                return _words[i] > b._words[i];
         return true;
     }
 
     bool operator >(Signal<n> const &b) const
     {
-        for(size_t i = n; i-- != 0; )
-            if(_bits[i] != b._bits[i])
-                return _bits[i];
+        for(size_t i = words; i-- != 0; )
+            if(_words[i] != b._words[i])
+                return _words[i] > b._words[i];
         return false;
     }
 
     bool operator !=(Signal<n> const &b) const { return !(*this == b); }
-    bool operator <=(Signal<n> const &b) const { return b <= *this; }
-    bool operator <(Signal<n> const &b) const { return b < *this; }
+    bool operator <=(Signal<n> const &b) const { return b >= *this; }
+    bool operator <(Signal<n> const &b) const { return b > *this; }
 
     bool signed_greater_than(Signal<n> const &b) const
     {
-        if(_bits[n-1] != b._bits[n-1])
-            return b._bits[n-1];
+        if(sign() != b.sign())
+            return b.sign();
         return *this > b;
     }
 
     bool signed_greater_equal(Signal<n> const &b) const
     {
-        if(_bits[n-1] != b._bits[n-1])
-            return b._bits[n-1];
+        if(sign() != b.sign())
+            return b.sign();
         return *this >= b;
     }
 
     Signal<n> operator &(Signal<n> const &b) const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = _bits[i] && b._bits[i];
+        for(size_t i = 0; i < words; i++)
+            ret._words[i] = _words[i] & b._words[i];
         return ret;
     }
 
     Signal<n> operator |(Signal<n> const &b) const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = _bits[i] || b._bits[i];
+        for(size_t i = 0; i < words; i++)
+            ret._words[i] = _words[i] | b._words[i];
         return ret;
     }
 
     Signal<n> operator ^(Signal<n> const &b) const
     {
         Signal<n> ret;
-        for(size_t i = 0; i < n; i++)
-            ret._bits[i] = _bits[i] != b._bits[i];
+        for(size_t i = 0; i < words; i++)
+            ret._words[i] = _words[i] ^ b._words[i];
         return ret;
     }
 
@@ -344,8 +415,12 @@ public:
     {
         Signal<n> ret = 0;
         size_t amount = b.template as_numeric_clamped<size_t>();
-        if(amount < n)
-            std::copy(_bits.begin(), _bits.begin() + (n - amount), ret._bits.begin() + amount);
+        if(amount < n) {
+            size_t w = amount / 64, s = amount % 64;
+            for(size_t i = w; i < words; i++)
+                ret._words[i] = (_words[i - w] << s) | (s != 0 && i > w ? _words[i - w - 1] >> (64 - s) : 0);
+            ret.mask();
+        }
         return ret;
     }
 
@@ -355,44 +430,46 @@ public:
         Signal<n> ret = 0;
         size_t amount = b.template as_numeric_clamped<size_t>();
         if(amount < n)
-            std::copy(_bits.begin() + amount, _bits.end(), ret._bits.begin());
+            for(size_t i = 0; i < words; i++)
+                ret._words[i] = extract_word(amount + 64 * i);
         return ret;
     }
 
     template<size_t nb>
     Signal<n> arithmetic_shift_right(Signal<nb> const &b) const
     {
-        Signal<n> ret = Signal::repeat(sign());
-        size_t amount = b.template as_numeric_clamped<size_t>();
-        if(amount < n)
-            std::copy(_bits.begin() + amount, _bits.end(), ret._bits.begin());
+        Signal<n> ret = *this >> b;
+        if(sign()) {
+            size_t amount = b.template as_numeric_clamped<size_t>();
+            ret.fill_from(amount < n ? n - amount : 0);
+        }
         return ret;
     }
 
     template<size_t m>
     Signal<n+m> concat(Signal<m> const& b) const
     {
-        Signal<n + m> ret;
-        std::copy(_bits.begin(), _bits.end(), ret._bits.begin());
-        std::copy(b._bits.begin(), b._bits.end(), ret._bits.begin() + n);
+        Signal<n + m> ret = zero_extend<n + m>();
+        ret.deposit(n, b);
         return ret;
     }
 
     template<size_t m>
     Signal<m> zero_extend() const
     {
-        assert(m >= n);
+        static_assert(m >= n);
         Signal<m> ret = 0;
-        std::copy(_bits.begin(), _bits.end(), ret._bits.begin());
+        std::copy(_words.begin(), _words.end(), ret._words.begin());
         return ret;
     }
 
     template<size_t m>
     Signal<m> sign_extend() const
     {
-        assert(m >= n);
-        Signal<m> ret = Signal<m>::repeat(sign());
-        std::copy(_bits.begin(), _bits.end(), ret._bits.begin());
+        static_assert(m >= n);
+        Signal<m> ret = zero_extend<m>();
+        if(sign())
+            ret.fill_from(n);
         return ret;
     }
 };
@@ -28,6 +28,7 @@
 #include "kernel/ff.h"
 #include "kernel/mem.h"
 #include "kernel/fmt.h"
+#include "kernel/threading.h"
 #include <string>
 #include <sstream>
 #include <set>
@@ -37,15 +38,20 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 bool verbose, norename, noattr, attr2comment, noexpr, nodec, nohex, nostr, extmem, defparam, decimal, siminit, systemverilog, simple_lhs, noparallelcase;
-int auto_name_counter, auto_name_offset, auto_name_digits, extmem_counter;
-dict<RTLIL::IdString, int> auto_name_map;
-std::set<RTLIL::IdString> reg_wires;
+int extmem_counter;
 std::string auto_prefix, extmem_prefix;
 
-RTLIL::Module *active_module;
-dict<RTLIL::SigBit, RTLIL::State> active_initdata;
-SigMap active_sigmap;
-IdString initial_id;
+// State of the module that is being dumped. Modules are dumped in parallel
+// when multiple jobs are enabled, so each thread has its own copy.
+thread_local int auto_name_counter, auto_name_offset, auto_name_digits;
+thread_local dict<RTLIL::IdString, int> auto_name_map;
+thread_local dict<RTLIL::IdString, std::string> id_cache;
+thread_local std::set<RTLIL::IdString> reg_wires;
+
+thread_local RTLIL::Module *active_module;
+thread_local dict<RTLIL::SigBit, RTLIL::State> active_initdata;
+thread_local SigMap active_sigmap;
+thread_local IdString initial_id;
 
 void reset_auto_counter_id(RTLIL::IdString id, bool may_rename)
 {
@@ -72,6 +78,7 @@ void reset_auto_counter_id(RTLIL::IdString id, bool may_rename)
 void reset_auto_counter(RTLIL::Module *module)
 {
 	auto_name_map.clear();
+	id_cache.clear();
 	auto_name_counter = 0;
 	auto_name_offset = 0;
 
@@ -102,7 +109,7 @@ std::string next_auto_id()
 	return stringf("%s_%0*d_", auto_prefix.c_str(), auto_name_digits, auto_name_offset + auto_name_counter++);
 }
 
-std::string id(RTLIL::IdString internal_id, bool may_rename = true)
+std::string escape_id(RTLIL::IdString internal_id, bool may_rename)
 {
 	const char *str = internal_id.c_str();
 	bool do_escape = false;
@@ -162,6 +169,25 @@ std::string id(RTLIL::IdString internal_id, bool may_rename = true)
 	return std::string(str);
 }
 
+// The same names are looked up many times while a module is dumped, so the
+// escaped form is cached. The reference is only valid until the next lookup.
+const std::string &cached_id(RTLIL::IdString internal_id)
+{
+	auto it = id_cache.find(internal_id);
+	if (it != id_cache.end())
+		return it->second;
+	std::string &str = id_cache[internal_id];
+	str = escape_id(internal_id, true);
+	return str;
+}
+
+std::string id(RTLIL::IdString internal_id, bool may_rename = true)
+{
+	if (!may_rename)
+		return escape_id(internal_id, false);
+	return cached_id(internal_id);
+}
+
 bool is_reg_wire(RTLIL::SigSpec sig, std::string &reg_name)
 {
 	if (!sig.is_chunk() || sig.as_chunk().wire == NULL)
@@ -210,7 +236,7 @@ void dump_const(std::ostream &f, const RTLIL::Const &data, int width = -1, int o
 					val |= 1 << (i - offset);
 			}
 			if (decimal)
-				f << stringf("%d", val);
+				f << val;
 			else if (set_signed && val < 0)
 				f << stringf("-32'sd%u", -val);
 			else
@@ -265,49 +291,49 @@ void dump_const(std::ostream &f, const RTLIL::Const &data, int width = -1, int o
 				int val = 8*(bit_3 - '0') + 4*(bit_2 - '0') + 2*(bit_1 - '0') + (bit_0 - '0');
 				hex_digits.push_back(val < 10 ? '0' + val : 'a' + val - 10);
 			}
-			f << stringf("%d'%sh", width, set_signed ? "s" : "");
+			f << width << "'" << (set_signed ? "s" : "") << "h";
 			for (int i = GetSize(hex_digits)-1; i >= 0; i--)
 				f << hex_digits[i];
 		}
 		if (0) {
 	dump_bin:
-			f << stringf("%d'%sb", width, set_signed ? "s" : "");
+			f << width << "'" << (set_signed ? "s" : "") << "b";
 			if (width == 0)
-				f << stringf("0");
+				f << "0";
 			for (int i = offset+width-1; i >= offset; i--) {
 				log_assert(i < (int)data.size());
 				switch (data[i]) {
-				case State::S0: f << stringf("0"); break;
-				case State::S1: f << stringf("1"); break;
-				case RTLIL::Sx: f << stringf("x"); break;
-				case RTLIL::Sz: f << stringf("z"); break;
-				case RTLIL::Sa: f << stringf("?"); break;
+				case State::S0: f << "0"; break;
+				case State::S1: f << "1"; break;
+				case RTLIL::Sx: f << "x"; break;
+				case RTLIL::Sz: f << "z"; break;
+				case RTLIL::Sa: f << "?"; break;
 				case RTLIL::Sm: log_error("Found marker state in final netlist.");
 				}
 			}
 		}
 	} else {
 		if ((data.flags & RTLIL::CONST_FLAG_REAL) == 0)
-			f << stringf("\"");
+			f << "\"";
 		std::string str = data.decode_string();
 		for (size_t i = 0; i < str.size(); i++) {
 			if (str[i] == '\n')
-				f << stringf("\\n");
+				f << "\\n";
 			else if (str[i] == '\t')
-				f << stringf("\\t");
+				f << "\\t";
 			else if (str[i] < 32)
 				f << stringf("\\%03o", str[i]);
 			else if (str[i] == '"')
-				f << stringf("\\\"");
+				f << "\\\"";
 			else if (str[i] == '\\')
-				f << stringf("\\\\");
+				f << "\\\\";
 			else if (str[i] == '/' && escape_comment && i > 0 && str[i-1] == '*')
-				f << stringf("\\/");
+				f << "\\/";
 			else
 				f << str[i];
 		}
 		if ((data.flags & RTLIL::CONST_FLAG_REAL) == 0)
-			f << stringf("\"");
+			f << "\"";
 	}
 }
 
@@ -337,21 +363,17 @@ void dump_sigchunk(std::ostream &f, const RTLIL::SigChunk &chunk, bool no_decima
 		dump_const(f, chunk.data, chunk.width, chunk.offset, no_decimal);
 	} else {
 		if (chunk.width == chunk.wire->width && chunk.offset == 0) {
-			f << stringf("%s", id(chunk.wire->name).c_str());
+			f << cached_id(chunk.wire->name);
 		} else if (chunk.width == 1) {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), (chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << cached_id(chunk.wire->name) << "[" << ((chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset) << "]";
 			else
-				f << stringf("%s[%d]", id(chunk.wire->name).c_str(), chunk.offset + chunk.wire->start_offset);
+				f << cached_id(chunk.wire->name) << "[" << (chunk.offset + chunk.wire->start_offset) << "]";
 		} else {
 			if (chunk.wire->upto)
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset,
-						(chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset);
+				f << cached_id(chunk.wire->name) << "[" << ((chunk.wire->width - (chunk.offset + chunk.width - 1) - 1) + chunk.wire->start_offset) << ":" << ((chunk.wire->width - chunk.offset - 1) + chunk.wire->start_offset) << "]";
 			else
-				f << stringf("%s[%d:%d]", id(chunk.wire->name).c_str(),
-						(chunk.offset + chunk.width - 1) + chunk.wire->start_offset,
-						chunk.offset + chunk.wire->start_offset);
+				f << cached_id(chunk.wire->name) << "[" << ((chunk.offset + chunk.width - 1) + chunk.wire->start_offset) << ":" << (chunk.offset + chunk.wire->start_offset) << "]";
 		}
 	}
 }
@@ -366,17 +388,17 @@ void dump_sigspec(std::ostream &f, const RTLIL::SigSpec &sig)
 	if (sig.is_chunk()) {
 		dump_sigchunk(f, sig.as_chunk());
 	} else {
-		f << stringf("{ ");
+		f << "{ ";
 		for (auto it = sig.chunks().rbegin(); it != sig.chunks().rend(); ++it) {
 			if (it != sig.chunks().rbegin())
-				f << stringf(", ");
+				f << ", ";
 			dump_sigchunk(f, *it, true);
 		}
-		f << stringf(" }");
+		f << " }";
 	}
 }
 
-void dump_attributes(std::ostream &f, std::string indent, dict<RTLIL::IdString, RTLIL::Const> &attributes, std::string term = "\n", bool modattr = false, bool regattr = false, bool as_comment = false)
+void dump_attributes(std::ostream &f, const std::string &indent, dict<RTLIL::IdString, RTLIL::Const> &attributes, const std::string &term = "\n", bool modattr = false, bool regattr = false, bool as_comment = false)
 {
 	if (noattr)
 		return;
@@ -384,33 +406,33 @@ void dump_attributes(std::ostream &f, std::string indent, dict<RTLIL::IdString,
 		as_comment = true;
 	for (auto it = attributes.begin(); it != attributes.end(); ++it) {
 		if (it->first == ID::init && regattr) continue;
-		f << stringf("%s" "%s %s", indent.c_str(), as_comment ? "/*" : "(*", id(it->first).c_str());
-		f << stringf(" = ");
+		f << indent << (as_comment ? "/*" : "(*") << " " << cached_id(it->first);
+		f << " = ";
 		if (modattr && (it->second == State::S0 || it->second == Const(0)))
-			f << stringf(" 0 ");
+			f << " 0 ";
 		else if (modattr && (it->second == State::S1 || it->second == Const(1)))
-			f << stringf(" 1 ");
+			f << " 1 ";
 		else
 			dump_const(f, it->second, -1, 0, false, as_comment);
-		f << stringf(" %s%s", as_comment ? "*/" : "*)", term.c_str());
+		f << " " << (as_comment ? "*/" : "*)") << term;
 	}
 }
 
-void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
+void dump_wire(std::ostream &f, const std::string &indent, RTLIL::Wire *wire)
 {
 	dump_attributes(f, indent, wire->attributes, "\n", /*modattr=*/false, /*regattr=*/reg_wires.count(wire->name));
 #if 0
 	if (wire->port_input && !wire->port_output)
-		f << stringf("%s" "input %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << indent << "input " << (reg_wires.count(wire->name) ? "reg " : "");
 	else if (!wire->port_input && wire->port_output)
-		f << stringf("%s" "output %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << indent << "output " << (reg_wires.count(wire->name) ? "reg " : "");
 	else if (wire->port_input && wire->port_output)
-		f << stringf("%s" "inout %s", indent.c_str(), reg_wires.count(wire->name) ? "reg " : "");
+		f << indent << "inout " << (reg_wires.count(wire->name) ? "reg " : "");
 	else
-		f << stringf("%s" "%s ", indent.c_str(), reg_wires.count(wire->name) ? "reg" : "wire");
+		f << indent << (reg_wires.count(wire->name) ? "reg" : "wire") << " ";
 	if (wire->width != 1)
-		f << stringf("[%d:%d] ", wire->width - 1 + wire->start_offset, wire->start_offset);
-	f << stringf("%s;\n", id(wire->name).c_str());
+		f << "[" << (wire->width - 1 + wire->start_offset) << ":" << wire->start_offset << "] ";
+	f << cached_id(wire->name) << ";\n";
 #else
 	// do not use Verilog-2k "output reg" syntax in Verilog export
 	std::string range = "";
@@ -421,29 +443,29 @@ void dump_wire(std::ostream &f, std::string indent, RTLIL::Wire *wire)
 			range = stringf(" [%d:%d]", wire->width - 1 + wire->start_offset, wire->start_offset);
 	}
 	if (wire->port_input && !wire->port_output)
-		f << stringf("%s" "input%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "input" << range << " " << cached_id(wire->name) << ";\n";
 	if (!wire->port_input && wire->port_output)
-		f << stringf("%s" "output%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "output" << range << " " << cached_id(wire->name) << ";\n";
 	if (wire->port_input && wire->port_output)
-		f << stringf("%s" "inout%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "inout" << range << " " << cached_id(wire->name) << ";\n";
 	if (reg_wires.count(wire->name)) {
-		f << stringf("%s" "reg%s %s", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "reg" << range << " " << cached_id(wire->name);
 		if (wire->attributes.count(ID::init)) {
-			f << stringf(" = ");
+			f << " = ";
 			dump_const(f, wire->attributes.at(ID::init));
 		}
-		f << stringf(";\n");
+		f << ";\n";
 	} else
-		f << stringf("%s" "wire%s %s;\n", indent.c_str(), range.c_str(), id(wire->name).c_str());
+		f << indent << "wire" << range << " " << cached_id(wire->name) << ";\n";
 #endif
 }
 
-void dump_memory(std::ostream &f, std::string indent, Mem &mem)
+void dump_memory(std::ostream &f, const std::string &indent, Mem &mem)
 {
 	std::string mem_id = id(mem.memid);
 
 	dump_attributes(f, indent, mem.attributes);
-	f << stringf("%s" "reg [%d:0] %s [%d:%d];\n", indent.c_str(), mem.width-1, mem_id.c_str(), mem.size+mem.start_offset-1, mem.start_offset);
+	f << indent << "reg [" << mem.width-1 << ":0] " << mem_id << " [" << (mem.size+mem.start_offset-1) << ":" << mem.start_offset << "];\n";
 
 	// for memory block make something like:
 	//  reg [7:0] memid [3:0];
@@ -472,7 +494,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 				else
 					extmem_filename_esc += c;
 			}
-			f << stringf("%s" "initial $readmemb(\"%s\", %s);\n", indent.c_str(), extmem_filename_esc.c_str(), mem_id.c_str());
+			f << indent << "initial $readmemb(\"" << extmem_filename_esc << "\", " << mem_id << ");\n";
 
 			std::ofstream extmem_f(extmem_filename, std::ofstream::trunc);
 			if (extmem_f.fail())
@@ -501,7 +523,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 		}
 		else
 		{
-			f << stringf("%s" "initial begin\n", indent.c_str());
+			f << indent << "initial begin\n";
 			for (auto &init : mem.inits) {
 				int words = GetSize(init.data) / mem.width;
 				int start = init.addr.as_int();
@@ -518,16 +540,16 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 							j++, width++;
 
 						if (width == mem.width) {
-							f << stringf("%s" "  %s[%d] = ", indent.c_str(), mem_id.c_str(), i + start);
+							f << indent << "  " << mem_id << "[" << (i + start) << "] = ";
 						} else {
-							f << stringf("%s" "  %s[%d][%d:%d] = ", indent.c_str(), mem_id.c_str(), i + start, j, start_j);
+							f << indent << "  " << mem_id << "[" << (i + start) << "][" << j << ":" << start_j << "] = ";
 						}
 						dump_const(f, init.data.extract(i*mem.width+start_j, width));
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				}
 			}
-			f << stringf("%s" "end\n", indent.c_str());
+			f << indent << "end\n";
 		}
 	}
 
@@ -583,7 +605,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 
 				if (port.arst != State::S0) {
 					std::ostringstream os;
-					os << stringf("%s <= ", temp_id.c_str());
+					os << temp_id << " <= ";
 					dump_sigspec(os, port.arst_value);
 					os << ";\n";
 					clk_to_arst_body[clk_domain_str].push_back(os.str());
@@ -591,12 +613,12 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 
 				if (port.srst != State::S0 && !port.ce_over_srst) {
 					std::ostringstream os;
-					os << stringf("if (");
+					os << "if (";
 					dump_sigspec(os, port.srst);
-					os << stringf(")\n");
+					os << ")\n";
 					clk_to_lof_body[clk_domain_str].push_back(os.str());
 					std::ostringstream os2;
-					os2 << stringf("%s" "%s <= ", indent.c_str(), temp_id.c_str());
+					os2 << indent << temp_id << " <= ";
 					dump_sigspec(os2, port.srst_value);
 					os2 << ";\n";
 					clk_to_lof_body[clk_domain_str].push_back(os2.str());
@@ -612,9 +634,9 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 					has_indent = true;
 				} else if (port.en != State::S1) {
 					std::ostringstream os;
-					os << stringf("if (");
+					os << "if (";
 					dump_sigspec(os, port.en);
-					os << stringf(") begin\n");
+					os << ") begin\n";
 					clk_to_lof_body[clk_domain_str].push_back(os.str());
 					has_indent = true;
 				}
@@ -627,10 +649,10 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 						os << indent;
 					os << temp_id;
 					if (port.wide_log2)
-						os << stringf("[%d:%d]", (sub + 1) * mem.width - 1, sub * mem.width);
-					os << stringf(" <= %s[", mem_id.c_str());
+						os << "[" << ((sub + 1) * mem.width - 1) << ":" << (sub * mem.width) << "]";
+					os << " <= " << mem_id << "[";
 					dump_sigspec(os, addr);
-					os << stringf("];\n");
+					os << "];\n";
 					clk_to_lof_body[clk_domain_str].push_back(os.str());
 				}
 
@@ -677,7 +699,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 							os2 << indent;
 							os2 << temp_id;
 							if (epos-pos != GetSize(port.data))
-								os2 << stringf("[%d:%d]", rsub * mem.width + epos-1, rsub * mem.width + pos);
+								os2 << "[" << (rsub * mem.width + epos-1) << ":" << (rsub * mem.width + pos) << "]";
 							os2 << " <= ";
 							if (port.transparency_mask[i])
 								dump_sigspec(os2, wport.data.extract(wsub * mem.width + pos, epos-pos));
@@ -696,14 +718,14 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 					std::ostringstream os;
 					if (has_indent)
 						os << indent;
-					os << stringf("if (");
+					os << "if (";
 					dump_sigspec(os, port.srst);
-					os << stringf(")\n");
+					os << ")\n";
 					clk_to_lof_body[clk_domain_str].push_back(os.str());
 					std::ostringstream os2;
 					if (has_indent)
 						os2 << indent;
-					os2 << stringf("%s" "%s <= ", indent.c_str(), temp_id.c_str());
+					os2 << indent << temp_id << " <= ";
 					dump_sigspec(os2, port.srst_value);
 					os2 << ";\n";
 					clk_to_lof_body[clk_domain_str].push_back(os2.str());
@@ -747,7 +769,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 					std::ostringstream os;
 					os << "assign ";
 					dump_sigspec(os, port.data.extract(sub * mem.width, mem.width));
-					os << stringf(" = %s[", mem_id.c_str());;
+					os << " = " << mem_id << "[";;
 					if (port.wide_log2) {
 						Const addr_lo;
 						for (int i = 0; i < port.wide_log2; i++)
@@ -823,11 +845,11 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 		}
 
 		if (root.clk_enable) {
-			f << stringf("%s" "always%s @(%sedge ", indent.c_str(), systemverilog ? "_ff" : "", root.clk_polarity ? "pos" : "neg");
+			f << indent << "always" << (systemverilog ? "_ff" : "") << " @(" << (root.clk_polarity ? "pos" : "neg") << "edge ";
 			dump_sigspec(f, root.clk);
 			f << ") begin\n";
 		} else {
-			f << stringf("%s" "always%s begin\n", indent.c_str(), systemverilog ? "_latch" : " @*");
+			f << indent << "always" << (systemverilog ? "_latch" : " @*") << " begin\n";
 		}
 
 		for (int pidx = 0; pidx < GetSize(mem.wr_ports); pidx++)
@@ -861,27 +883,27 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 					if (wen_bit == State::S0)
 						continue;
 
-					f << stringf("%s%s", indent.c_str(), indent.c_str());
+					f << indent << indent;
 					if (wen_bit != State::S1)
 					{
-						f << stringf("if (");
+						f << "if (";
 						dump_sigspec(f, wen_bit);
-						f << stringf(")\n");
-						f << stringf("%s%s%s", indent.c_str(), indent.c_str(), indent.c_str());
+						f << ")\n";
+						f << indent << indent << indent;
 					}
-					f << stringf("%s[", mem_id.c_str());
+					f << mem_id << "[";
 					dump_sigspec(f, addr);
 					if (width == GetSize(port.en))
-						f << stringf("] <= ");
+						f << "] <= ";
 					else
-						f << stringf("][%d:%d] <= ", i, start_i);
+						f << "][" << i << ":" << start_i << "] <= ";
 					dump_sigspec(f, port.data.extract(sub * mem.width + start_i, width));
-					f << stringf(";\n");
+					f << ";\n";
 				}
 			}
 		}
 
-		f << stringf("%s" "end\n", indent.c_str());
+		f << indent << "end\n";
 	}
 	// Output Verilog that looks something like this:
 	// reg [..] _3_;
@@ -904,7 +926,7 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 	// the reg ... definitions
 	for(auto &reg : lof_reg_declarations)
 	{
-		f << stringf("%s" "%s", indent.c_str(), reg.c_str());
+		f << indent << reg;
 	}
 	// the block of expressions by clock domain
 	for(auto &pair : clk_to_lof_body)
@@ -913,39 +935,50 @@ void dump_memory(std::ostream &f, std::string indent, Mem &mem)
 		std::vector<std::string> lof_lines = pair.second;
 		if( clk_domain != "")
 		{
-			f << stringf("%s" "always%s @(%s) begin\n", indent.c_str(), systemverilog ? "_ff" : "", clk_domain.c_str());
+			f << indent << "always" << (systemverilog ? "_ff" : "") << " @(" << clk_domain << ") begin\n";
 			bool has_arst = clk_to_arst_cond.count(clk_domain) != 0;
 			if (has_arst) {
-				f << stringf("%s%s" "if (%s) begin\n", indent.c_str(), indent.c_str(), clk_to_arst_cond[clk_domain].c_str());
+				f << indent << indent << "if (" << clk_to_arst_cond[clk_domain] << ") begin\n";
 				for(auto &line : clk_to_arst_body[clk_domain])
-					f << stringf("%s%s%s" "%s", indent.c_str(), indent.c_str(), indent.c_str(), line.c_str());
-				f << stringf("%s%s" "end else begin\n", indent.c_str(), indent.c_str());
+					f << indent << indent << indent << line;
+				f << indent << indent << "end else begin\n";
 				for(auto &line : lof_lines)
-					f << stringf("%s%s%s" "%s", indent.c_str(), indent.c_str(), indent.c_str(), line.c_str());
-				f << stringf("%s%s" "end\n", indent.c_str(), indent.c_str());
+					f << indent << indent << indent << line;
+				f << indent << indent << "end\n";
 			} else {
 				for(auto &line : lof_lines)
-					f << stringf("%s%s" "%s", indent.c_str(), indent.c_str(), line.c_str());
+					f << indent << indent << line;
 			}
-			f << stringf("%s" "end\n", indent.c_str());
+			f << indent << "end\n";
 		}
 		else
 		{
 			// the non-clocked assignments
 			for(auto &line : lof_lines)
-				f << stringf("%s" "%s", indent.c_str(), line.c_str());
+				f << indent << line;
 		}
 	}
 }
 
-void dump_cell_expr_port(std::ostream &f, RTLIL::Cell *cell, std::string port, bool gen_signed = true)
+void dump_cell_expr_port(std::ostream &f, RTLIL::Cell *cell, char port, bool gen_signed = true)
 {
-	if (gen_signed && cell->parameters.count("\\" + port + "_SIGNED") > 0 && cell->parameters["\\" + port + "_SIGNED"].as_bool()) {
-		f << stringf("$signed(");
-		dump_sigspec(f, cell->getPort("\\" + port));
-		f << stringf(")");
+	RTLIL::IdString port_id, signed_id;
+	switch (port) {
+		case 'A': port_id = ID::A; signed_id = ID::A_SIGNED; break;
+		case 'B': port_id = ID::B; signed_id = ID::B_SIGNED; break;
+		case 'C': port_id = ID::C; break;
+		case 'D': port_id = ID::D; break;
+		case 'S': port_id = ID::S; break;
+		default: log_abort();
+	}
+
+	auto it = gen_signed && !signed_id.empty() ? cell->parameters.find(signed_id) : cell->parameters.end();
+	if (it != cell->parameters.end() && it->second.as_bool()) {
+		f << "$signed(";
+		dump_sigspec(f, cell->getPort(port_id));
+		f << ")";
 	} else
-		dump_sigspec(f, cell->getPort("\\" + port));
+		dump_sigspec(f, cell->getPort(port_id));
 }
 
 std::string cellname(RTLIL::Cell *cell)
@@ -984,35 +1017,35 @@ no_special_reg_name:
 	}
 }
 
-void dump_cell_expr_uniop(std::ostream &f, std::string indent, RTLIL::Cell *cell, std::string op)
+void dump_cell_expr_uniop(std::ostream &f, const std::string &indent, RTLIL::Cell *cell, const std::string &op)
 {
-	f << stringf("%s" "assign ", indent.c_str());
+	f << indent << "assign ";
 	dump_sigspec(f, cell->getPort(ID::Y));
-	f << stringf(" = %s ", op.c_str());
+	f << " = " << op << " ";
 	dump_attributes(f, "", cell->attributes, " ");
-	dump_cell_expr_port(f, cell, "A", true);
-	f << stringf(";\n");
+	dump_cell_expr_port(f, cell, 'A', true);
+	f << ";\n";
 }
 
-void dump_cell_expr_binop(std::ostream &f, std::string indent, RTLIL::Cell *cell, std::string op)
+void dump_cell_expr_binop(std::ostream &f, const std::string &indent, RTLIL::Cell *cell, const std::string &op)
 {
-	f << stringf("%s" "assign ", indent.c_str());
+	f << indent << "assign ";
 	dump_sigspec(f, cell->getPort(ID::Y));
-	f << stringf(" = ");
-	dump_cell_expr_port(f, cell, "A", true);
-	f << stringf(" %s ", op.c_str());
+	f << " = ";
+	dump_cell_expr_port(f, cell, 'A', true);
+	f << " " << op << " ";
 	dump_attributes(f, "", cell->attributes, " ");
-	dump_cell_expr_port(f, cell, "B", true);
-	f << stringf(";\n");
+	dump_cell_expr_port(f, cell, 'B', true);
+	f << ";\n";
 }
 
-void dump_cell_expr_print(std::ostream &f, std::string indent, const RTLIL::Cell *cell)
+void dump_cell_expr_print(std::ostream &f, const std::string &indent, const RTLIL::Cell *cell)
 {
 	Fmt fmt;
 	fmt.parse_rtlil(cell);
 	std::vector<VerilogFmtArg> args = fmt.emit_verilog();
 
-	f << stringf("%s" "$write(", indent.c_str());
+	f << indent << "$write(";
 	bool first = true;
 	for (auto &arg : args) {
 		if (first) {
@@ -1038,130 +1071,130 @@ void dump_cell_expr_print(std::ostream &f, std::string indent, const RTLIL::Cell
 			default: log_abort();
 		}
 	}
-	f << stringf(");\n");
+	f << ");\n";
 }
 
-void dump_cell_expr_check(std::ostream &f, std::string indent, const RTLIL::Cell *cell)
+void dump_cell_expr_check(std::ostream &f, const std::string &indent, const RTLIL::Cell *cell)
 {
 	std::string flavor = cell->getParam(ID(FLAVOR)).decode_string();
 	if (flavor == "assert")
-		f << stringf("%s" "assert (", indent.c_str());
+		f << indent << "assert (";
 	else if (flavor == "assume")
-		f << stringf("%s" "assume (", indent.c_str());
+		f << indent << "assume (";
 	else if (flavor == "live")
-		f << stringf("%s" "assert (eventually ", indent.c_str());
+		f << indent << "assert (eventually ";
 	else if (flavor == "fair")
-		f << stringf("%s" "assume (eventually ", indent.c_str());
+		f << indent << "assume (eventually ";
 	else if (flavor == "cover")
-		f << stringf("%s" "cover (", indent.c_str());
+		f << indent << "cover (";
 	dump_sigspec(f, cell->getPort(ID::A));
-	f << stringf(");\n");
+	f << ");\n";
 }
 
-bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+bool dump_cell_expr(std::ostream &f, const std::string &indent, RTLIL::Cell *cell)
 {
 	if (cell->type == ID($_NOT_)) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		f << stringf("~");
+		f << " = ";
+		f << "~";
 		dump_attributes(f, "", cell->attributes, " ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, 'A', false);
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type == ID($_BUF_)) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		f << " = ";
+		dump_cell_expr_port(f, cell, 'A', false);
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_))) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		if (cell->type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_)))
-			f << stringf("~(");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(" ");
+			f << "~(";
+		dump_cell_expr_port(f, cell, 'A', false);
+		f << " ";
 		if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_ANDNOT_)))
-			f << stringf("&");
+			f << "&";
 		if (cell->type.in(ID($_OR_), ID($_NOR_), ID($_ORNOT_)))
-			f << stringf("|");
+			f << "|";
 		if (cell->type.in(ID($_XOR_), ID($_XNOR_)))
-			f << stringf("^");
+			f << "^";
 		dump_attributes(f, "", cell->attributes, " ");
-		f << stringf(" ");
+		f << " ";
 		if (cell->type.in(ID($_ANDNOT_), ID($_ORNOT_)))
-			f << stringf("~(");
-		dump_cell_expr_port(f, cell, "B", false);
+			f << "~(";
+		dump_cell_expr_port(f, cell, 'B', false);
 		if (cell->type.in(ID($_NAND_), ID($_NOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_)))
-			f << stringf(")");
-		f << stringf(";\n");
+			f << ")";
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type == ID($_MUX_)) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
-		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+		f << " = ";
+		dump_cell_expr_port(f, cell, 'S', false);
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, " ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(";\n");
+		dump_cell_expr_port(f, cell, 'B', false);
+		f << " : ";
+		dump_cell_expr_port(f, cell, 'A', false);
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type == ID($_NMUX_)) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = !(");
-		dump_cell_expr_port(f, cell, "S", false);
-		f << stringf(" ? ");
+		f << " = !(";
+		dump_cell_expr_port(f, cell, 'S', false);
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, " ");
-		dump_cell_expr_port(f, cell, "B", false);
-		f << stringf(" : ");
-		dump_cell_expr_port(f, cell, "A", false);
-		f << stringf(");\n");
+		dump_cell_expr_port(f, cell, 'B', false);
+		f << " : ";
+		dump_cell_expr_port(f, cell, 'A', false);
+		f << ");\n";
 		return true;
 	}
 
 	if (cell->type.in(ID($_AOI3_), ID($_OAI3_))) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ~((");
-		dump_cell_expr_port(f, cell, "A", false);
+		f << " = ~((";
+		dump_cell_expr_port(f, cell, 'A', false);
 		f << stringf(cell->type == ID($_AOI3_) ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "B", false);
+		dump_cell_expr_port(f, cell, 'B', false);
 		f << stringf(cell->type == ID($_AOI3_) ? ") |" : ") &");
 		dump_attributes(f, "", cell->attributes, " ");
-		f << stringf(" ");
-		dump_cell_expr_port(f, cell, "C", false);
-		f << stringf(");\n");
+		f << " ";
+		dump_cell_expr_port(f, cell, 'C', false);
+		f << ");\n";
 		return true;
 	}
 
 	if (cell->type.in(ID($_AOI4_), ID($_OAI4_))) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ~((");
-		dump_cell_expr_port(f, cell, "A", false);
+		f << " = ~((";
+		dump_cell_expr_port(f, cell, 'A', false);
 		f << stringf(cell->type == ID($_AOI4_) ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "B", false);
+		dump_cell_expr_port(f, cell, 'B', false);
 		f << stringf(cell->type == ID($_AOI4_) ? ") |" : ") &");
 		dump_attributes(f, "", cell->attributes, " ");
-		f << stringf(" (");
-		dump_cell_expr_port(f, cell, "C", false);
+		f << " (";
+		dump_cell_expr_port(f, cell, 'C', false);
 		f << stringf(cell->type == ID($_AOI4_) ? " & " : " | ");
-		dump_cell_expr_port(f, cell, "D", false);
-		f << stringf("));\n");
+		dump_cell_expr_port(f, cell, 'D', false);
+		f << "));\n";
 		return true;
 	}
 
@@ -1234,32 +1267,32 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			int size_max = std::max(size_a, std::max(size_b, size_y));
 
 			// intentionally one wider than maximum width
-			f << stringf("%s" "wire [%d:0] %s, %s, %s;\n", indent.c_str(), size_max, buf_a.c_str(), buf_b.c_str(), buf_num.c_str());
-			f << stringf("%s" "assign %s = ", indent.c_str(), buf_a.c_str());
-			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(";\n");
-			f << stringf("%s" "assign %s = ", indent.c_str(), buf_b.c_str());
-			dump_cell_expr_port(f, cell, "B", true);
-			f << stringf(";\n");
-
-			f << stringf("%s" "assign %s = ", indent.c_str(), buf_num.c_str());
-			f << stringf("(");
+			f << indent << "wire [" << size_max << ":0] " << buf_a << ", " << buf_b << ", " << buf_num << ";\n";
+			f << indent << "assign " << buf_a << " = ";
+			dump_cell_expr_port(f, cell, 'A', true);
+			f << ";\n";
+			f << indent << "assign " << buf_b << " = ";
+			dump_cell_expr_port(f, cell, 'B', true);
+			f << ";\n";
+
+			f << indent << "assign " << buf_num << " = ";
+			f << "(";
 			dump_sigspec(f, sig_a.extract(sig_a.size()-1));
-			f << stringf(" == ");
+			f << " == ";
 			dump_sigspec(f, sig_b.extract(sig_b.size()-1));
-			f << stringf(") || ");
+			f << ") || ";
 			dump_sigspec(f, sig_a);
-			f << stringf(" == 0 ? %s : ", buf_a.c_str());
-			f << stringf("$signed(%s - (", buf_a.c_str());
+			f << " == 0 ? " << buf_a << " : ";
+			f << "$signed(" << buf_a << " - (";
 			dump_sigspec(f, sig_b.extract(sig_b.size()-1));
-			f << stringf(" ? %s + 1 : %s - 1));\n", buf_b.c_str(), buf_b.c_str());
+			f << " ? " << buf_b << " + 1 : " << buf_b << " - 1));\n";
 
 
-			f << stringf("%s" "assign ", indent.c_str());
+			f << indent << "assign ";
 			dump_sigspec(f, cell->getPort(ID::Y));
-			f << stringf(" = $signed(%s) / ", buf_num.c_str());
+			f << " = $signed(" << buf_num << ") / ";
 			dump_attributes(f, "", cell->attributes, " ");
-			f << stringf("$signed(%s);\n", buf_b.c_str());
+			f << "$signed(" << buf_b << ");\n";
 			return true;
 		} else {
 			// same as truncating division
@@ -1278,22 +1311,22 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			SigSpec sig_b = cell->getPort(ID::B);
 
 			std::string temp_id = next_auto_id();
-			f << stringf("%s" "wire [%d:0] %s = ", indent.c_str(), GetSize(cell->getPort(ID::A))-1, temp_id.c_str());
-			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(" %% ");
+			f << indent << "wire [" << (GetSize(cell->getPort(ID::A))-1) << ":0] " << temp_id << " = ";
+			dump_cell_expr_port(f, cell, 'A', true);
+			f << " % ";
 			dump_attributes(f, "", cell->attributes, " ");
-			dump_cell_expr_port(f, cell, "B", true);
-			f << stringf(";\n");
+			dump_cell_expr_port(f, cell, 'B', true);
+			f << ";\n";
 
-			f << stringf("%s" "assign ", indent.c_str());
+			f << indent << "assign ";
 			dump_sigspec(f, cell->getPort(ID::Y));
-			f << stringf(" = (");
+			f << " = (";
 			dump_sigspec(f, sig_a.extract(sig_a.size()-1));
-			f << stringf(" == ");
+			f << " == ";
 			dump_sigspec(f, sig_b.extract(sig_b.size()-1));
-			f << stringf(") || %s == 0 ? $signed(%s) : ", temp_id.c_str(), temp_id.c_str());
-			dump_cell_expr_port(f, cell, "B", true);
-			f << stringf(" + $signed(%s);\n", temp_id.c_str());
+			f << ") || " << temp_id << " == 0 ? $signed(" << temp_id << ") : ";
+			dump_cell_expr_port(f, cell, 'B', true);
+			f << " + $signed(" << temp_id << ");\n";
 			return true;
 		} else {
 			// same as truncating modulo
@@ -1304,63 +1337,63 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 
 	if (cell->type == ID($shift))
 	{
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		if (cell->getParam(ID::B_SIGNED).as_bool())
 		{
-			dump_cell_expr_port(f, cell, "B", true);
-			f << stringf(" < 0 ? ");
-			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(" << - ");
+			dump_cell_expr_port(f, cell, 'B', true);
+			f << " < 0 ? ";
+			dump_cell_expr_port(f, cell, 'A', true);
+			f << " << - ";
 			dump_sigspec(f, cell->getPort(ID::B));
-			f << stringf(" : ");
-			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(" >> ");
+			f << " : ";
+			dump_cell_expr_port(f, cell, 'A', true);
+			f << " >> ";
 			dump_sigspec(f, cell->getPort(ID::B));
 		}
 		else
 		{
-			dump_cell_expr_port(f, cell, "A", true);
-			f << stringf(" >> ");
+			dump_cell_expr_port(f, cell, 'A', true);
+			f << " >> ";
 			dump_sigspec(f, cell->getPort(ID::B));
 		}
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
 	if (cell->type == ID($shiftx))
 	{
 		std::string temp_id = next_auto_id();
-		f << stringf("%s" "wire [%d:0] %s = ", indent.c_str(), GetSize(cell->getPort(ID::A))-1, temp_id.c_str());
+		f << indent << "wire [" << (GetSize(cell->getPort(ID::A))-1) << ":0] " << temp_id << " = ";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(";\n");
+		f << ";\n";
 
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = %s[", temp_id.c_str());
+		f << " = " << temp_id << "[";
 		if (cell->getParam(ID::B_SIGNED).as_bool())
-			f << stringf("$signed(");
+			f << "$signed(";
 		dump_sigspec(f, cell->getPort(ID::B));
 		if (cell->getParam(ID::B_SIGNED).as_bool())
-			f << stringf(")");
-		f << stringf(" +: %d", cell->getParam(ID::Y_WIDTH).as_int());
-		f << stringf("];\n");
+			f << ")";
+		f << " +: " << (cell->getParam(ID::Y_WIDTH).as_int());
+		f << "];\n";
 		return true;
 	}
 
 	if (cell->type == ID($mux))
 	{
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, cell->getPort(ID::S));
-		f << stringf(" ? ");
+		f << " ? ";
 		dump_attributes(f, "", cell->attributes, " ");
 		dump_sigspec(f, cell->getPort(ID::B));
-		f << stringf(" : ");
+		f << " : ";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
@@ -1370,104 +1403,104 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		int s_width = cell->getPort(ID::S).size();
 		std::string func_name = cellname(cell);
 
-		f << stringf("%s" "function [%d:0] %s;\n", indent.c_str(), width-1, func_name.c_str());
-		f << stringf("%s" "  input [%d:0] a;\n", indent.c_str(), width-1);
-		f << stringf("%s" "  input [%d:0] b;\n", indent.c_str(), s_width*width-1);
-		f << stringf("%s" "  input [%d:0] s;\n", indent.c_str(), s_width-1);
+		f << indent << "function [" << width-1 << ":0] " << func_name << ";\n";
+		f << indent << "  input [" << width-1 << ":0] a;\n";
+		f << indent << "  input [" << (s_width*width-1) << ":0] b;\n";
+		f << indent << "  input [" << s_width-1 << ":0] s;\n";
 
 		dump_attributes(f, indent + "  ", cell->attributes);
 		if (noparallelcase)
-			f << stringf("%s" "  case (s)\n", indent.c_str());
+			f << indent << "  case (s)\n";
 		else {
 			if (!noattr)
-				f << stringf("%s" "  (* parallel_case *)\n", indent.c_str());
-			f << stringf("%s" "  casez (s)", indent.c_str());
+				f << indent << "  (* parallel_case *)\n";
+			f << indent << "  casez (s)";
 			f << stringf(noattr ? " // synopsys parallel_case\n" : "\n");
 		}
 
 		for (int i = 0; i < s_width; i++)
 		{
-			f << stringf("%s" "    %d'b", indent.c_str(), s_width);
+			f << indent << "    " << s_width << "'b";
 
 			for (int j = s_width-1; j >= 0; j--)
 				f << stringf("%c", j == i ? '1' : noparallelcase ? '0' : '?');
 
-			f << stringf(":\n");
-			f << stringf("%s" "      %s = b[%d:%d];\n", indent.c_str(), func_name.c_str(), (i+1)*width-1, i*width);
+			f << ":\n";
+			f << indent << "      " << func_name << " = b[" << ((i+1)*width-1) << ":" << (i*width) << "];\n";
 		}
 
 		if (noparallelcase) {
-			f << stringf("%s" "    %d'b", indent.c_str(), s_width);
+			f << indent << "    " << s_width << "'b";
 			for (int j = s_width-1; j >= 0; j--)
 				f << '0';
-			f << stringf(":\n");
+			f << ":\n";
 		} else
-			f << stringf("%s" "    default:\n", indent.c_str());
-		f << stringf("%s" "      %s = a;\n", indent.c_str(), func_name.c_str());
+			f << indent << "    default:\n";
+		f << indent << "      " << func_name << " = a;\n";
 		if (noparallelcase) {
-			f << stringf("%s" "    default:\n", indent.c_str());
-			f << stringf("%s" "      %s = %d'bx;\n", indent.c_str(), func_name.c_str(), width);
+			f << indent << "    default:\n";
+			f << indent << "      " << func_name << " = " << width << "'bx;\n";
 		}
 
-		f << stringf("%s" "  endcase\n", indent.c_str());
-		f << stringf("%s" "endfunction\n", indent.c_str());
+		f << indent << "  endcase\n";
+		f << indent << "endfunction\n";
 
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = %s(", func_name.c_str());
+		f << " = " << func_name << "(";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(", ");
+		f << ", ";
 		dump_sigspec(f, cell->getPort(ID::B));
-		f << stringf(", ");
+		f << ", ";
 		dump_sigspec(f, cell->getPort(ID::S));
-		f << stringf(");\n");
+		f << ");\n";
 		return true;
 	}
 
 	if (cell->type == ID($tribuf))
 	{
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, cell->getPort(ID::EN));
-		f << stringf(" ? ");
+		f << " ? ";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(" : %d'bz;\n", cell->parameters.at(ID::WIDTH).as_int());
+		f << " : " << (cell->parameters.at(ID::WIDTH).as_int()) << "'bz;\n";
 		return true;
 	}
 
 	if (cell->type == ID($slice))
 	{
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(" >> %d;\n", cell->parameters.at(ID::OFFSET).as_int());
+		f << " >> " << (cell->parameters.at(ID::OFFSET).as_int()) << ";\n";
 		return true;
 	}
 
 	if (cell->type == ID($concat))
 	{
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = { ");
+		f << " = { ";
 		dump_sigspec(f, cell->getPort(ID::B));
-		f << stringf(" , ");
+		f << " , ";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(" };\n");
+		f << " };\n";
 		return true;
 	}
 
 	if (cell->type == ID($lut))
 	{
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, cell->getPort(ID::Y));
-		f << stringf(" = ");
+		f << " = ";
 		dump_const(f, cell->parameters.at(ID::LUT));
-		f << stringf(" >> ");
+		f << " >> ";
 		dump_attributes(f, "", cell->attributes, " ");
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(";\n");
+		f << ";\n";
 		return true;
 	}
 
@@ -1484,9 +1517,9 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 
 		if (!out_is_reg_wire) {
 			if (ff.width == 1)
-				f << stringf("%s" "reg %s", indent.c_str(), reg_name.c_str());
+				f << indent << "reg " << reg_name;
 			else
-				f << stringf("%s" "reg [%d:0] %s", indent.c_str(), ff.width-1, reg_name.c_str());
+				f << indent << "reg [" << ff.width-1 << ":0] " << reg_name;
 			dump_reg_init(f, ff.sig_q);
 			f << ";\n";
 		}
@@ -1522,32 +1555,32 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 					if (ff.sig_set[i].wire == NULL)
 					{
 						sig_set_name = next_auto_id();
-						f << stringf("%s" "wire %s = ", indent.c_str(), sig_set_name.c_str());
+						f << indent << "wire " << sig_set_name << " = ";
 						dump_const(f, ff.sig_set[i].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 					if (ff.sig_clr[i].wire == NULL)
 					{
 						sig_clr_name = next_auto_id();
-						f << stringf("%s" "wire %s = ", indent.c_str(), sig_clr_name.c_str());
+						f << indent << "wire " << sig_clr_name << " = ";
 						dump_const(f, ff.sig_clr[i].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				} else if (ff.has_arst) {
 					if (ff.sig_arst[0].wire == NULL)
 					{
 						sig_arst_name = next_auto_id();
-						f << stringf("%s" "wire %s = ", indent.c_str(), sig_arst_name.c_str());
+						f << indent << "wire " << sig_arst_name << " = ";
 						dump_const(f, ff.sig_arst[0].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				} else if (ff.has_aload) {
 					if (ff.sig_aload[0].wire == NULL)
 					{
 						sig_aload_name = next_auto_id();
-						f << stringf("%s" "wire %s = ", indent.c_str(), sig_aload_name.c_str());
+						f << indent << "wire " << sig_aload_name << " = ";
 						dump_const(f, ff.sig_aload[0].data);
-						f << stringf(";\n");
+						f << ";\n";
 					}
 				}
 			}
@@ -1556,140 +1589,140 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			if (ff.has_clk)
 			{
 				// FFs.
-				f << stringf("%s" "always%s @(%sedge ", indent.c_str(), systemverilog ? "_ff" : "", ff.pol_clk ? "pos" : "neg");
+				f << indent << "always" << (systemverilog ? "_ff" : "") << " @(" << (ff.pol_clk ? "pos" : "neg") << "edge ";
 				dump_sigspec(f, ff.sig_clk);
 				if (ff.has_sr) {
-					f << stringf(", %sedge ", ff.pol_set ? "pos" : "neg");
+					f << ", " << (ff.pol_set ? "pos" : "neg") << "edge ";
 					if (ff.sig_set[i].wire == NULL)
-						f << stringf("%s", sig_set_name.c_str());
+						f << sig_set_name;
 					else
 						dump_sigspec(f, ff.sig_set[i]);
 
-					f << stringf(", %sedge ", ff.pol_clr ? "pos" : "neg");
+					f << ", " << (ff.pol_clr ? "pos" : "neg") << "edge ";
 					if (ff.sig_clr[i].wire == NULL)
-						f << stringf("%s", sig_clr_name.c_str());
+						f << sig_clr_name;
 					else
 						dump_sigspec(f, ff.sig_clr[i]);
 				} else if (ff.has_arst) {
-					f << stringf(", %sedge ", ff.pol_arst ? "pos" : "neg");
+					f << ", " << (ff.pol_arst ? "pos" : "neg") << "edge ";
 					if (ff.sig_arst[0].wire == NULL)
-						f << stringf("%s", sig_arst_name.c_str());
+						f << sig_arst_name;
 					else
 						dump_sigspec(f, ff.sig_arst);
 				} else if (ff.has_aload) {
-					f << stringf(", %sedge ", ff.pol_aload ? "pos" : "neg");
+					f << ", " << (ff.pol_aload ? "pos" : "neg") << "edge ";
 					if (ff.sig_aload[0].wire == NULL)
-						f << stringf("%s", sig_aload_name.c_str());
+						f << sig_aload_name;
 					else
 						dump_sigspec(f, ff.sig_aload);
 				}
-				f << stringf(")\n");
+				f << ")\n";
 
-				f << stringf("%s" "  ", indent.c_str());
+				f << indent << "  ";
 				if (ff.has_sr) {
-					f << stringf("if (%s", ff.pol_clr ? "" : "!");
+					f << "if (" << (ff.pol_clr ? "" : "!");
 					if (ff.sig_clr[i].wire == NULL)
-						f << stringf("%s", sig_clr_name.c_str());
+						f << sig_clr_name;
 					else
 						dump_sigspec(f, ff.sig_clr[i]);
-					f << stringf(") %s <= 1'b0;\n", reg_bit_name.c_str());
-					f << stringf("%s" "  else if (%s", indent.c_str(), ff.pol_set ? "" : "!");
+					f << ") " << reg_bit_name << " <= 1'b0;\n";
+					f << indent << "  else if (" << (ff.pol_set ? "" : "!");
 					if (ff.sig_set[i].wire == NULL)
-						f << stringf("%s", sig_set_name.c_str());
+						f << sig_set_name;
 					else
 						dump_sigspec(f, ff.sig_set[i]);
-					f << stringf(") %s <= 1'b1;\n", reg_bit_name.c_str());
-					f << stringf("%s" "  else ", indent.c_str());
+					f << ") " << reg_bit_name << " <= 1'b1;\n";
+					f << indent << "  else ";
 				} else if (ff.has_arst) {
-					f << stringf("if (%s", ff.pol_arst ? "" : "!");
+					f << "if (" << (ff.pol_arst ? "" : "!");
 					if (ff.sig_arst[0].wire == NULL)
-						f << stringf("%s", sig_arst_name.c_str());
+						f << sig_arst_name;
 					else
 						dump_sigspec(f, ff.sig_arst);
-					f << stringf(") %s <= ", reg_bit_name.c_str());
+					f << ") " << reg_bit_name << " <= ";
 					dump_sigspec(f, val_arst);
-					f << stringf(";\n");
-					f << stringf("%s" "  else ", indent.c_str());
+					f << ";\n";
+					f << indent << "  else ";
 				} else if (ff.has_aload) {
-					f << stringf("if (%s", ff.pol_aload ? "" : "!");
+					f << "if (" << (ff.pol_aload ? "" : "!");
 					if (ff.sig_aload[0].wire == NULL)
-						f << stringf("%s", sig_aload_name.c_str());
+						f << sig_aload_name;
 					else
 						dump_sigspec(f, ff.sig_aload);
-					f << stringf(") %s <= ", reg_bit_name.c_str());
+					f << ") " << reg_bit_name << " <= ";
 					dump_sigspec(f, sig_ad);
-					f << stringf(";\n");
-					f << stringf("%s" "  else ", indent.c_str());
+					f << ";\n";
+					f << indent << "  else ";
 				}
 
 				if (ff.has_srst && ff.has_ce && ff.ce_over_srst) {
-					f << stringf("if (%s", ff.pol_ce ? "" : "!");
+					f << "if (" << (ff.pol_ce ? "" : "!");
 					dump_sigspec(f, ff.sig_ce);
-					f << stringf(")\n");
-					f << stringf("%s" "    if (%s", indent.c_str(), ff.pol_srst ? "" : "!");
+					f << ")\n";
+					f << indent << "    if (" << (ff.pol_srst ? "" : "!");
 					dump_sigspec(f, ff.sig_srst);
-					f << stringf(") %s <= ", reg_bit_name.c_str());
+					f << ") " << reg_bit_name << " <= ";
 					dump_sigspec(f, val_srst);
-					f << stringf(";\n");
-					f << stringf("%s" "    else ", indent.c_str());
+					f << ";\n";
+					f << indent << "    else ";
 				} else {
 					if (ff.has_srst) {
-						f << stringf("if (%s", ff.pol_srst ? "" : "!");
+						f << "if (" << (ff.pol_srst ? "" : "!");
 						dump_sigspec(f, ff.sig_srst);
-						f << stringf(") %s <= ", reg_bit_name.c_str());
+						f << ") " << reg_bit_name << " <= ";
 						dump_sigspec(f, val_srst);
-						f << stringf(";\n");
-						f << stringf("%s" "  else ", indent.c_str());
+						f << ";\n";
+						f << indent << "  else ";
 					}
 					if (ff.has_ce) {
-						f << stringf("if (%s", ff.pol_ce ? "" : "!");
+						f << "if (" << (ff.pol_ce ? "" : "!");
 						dump_sigspec(f, ff.sig_ce);
-						f << stringf(") ");
+						f << ") ";
 					}
 				}
 
-				f << stringf("%s <= ", reg_bit_name.c_str());
+				f << reg_bit_name << " <= ";
 				dump_sigspec(f, sig_d);
-				f << stringf(";\n");
+				f << ";\n";
 			}
 			else
 			{
 				// Latches.
-				f << stringf("%s" "always%s\n", indent.c_str(), systemverilog ? "_latch" : " @*");
+				f << indent << "always" << (systemverilog ? "_latch" : " @*") << "\n";
 
-				f << stringf("%s" "  ", indent.c_str());
+				f << indent << "  ";
 				if (ff.has_sr) {
-					f << stringf("if (%s", ff.pol_clr ? "" : "!");
+					f << "if (" << (ff.pol_clr ? "" : "!");
 					dump_sigspec(f, ff.sig_clr[i]);
-					f << stringf(") %s = 1'b0;\n", reg_bit_name.c_str());
-					f << stringf("%s" "  else if (%s", indent.c_str(), ff.pol_set ? "" : "!");
+					f << ") " << reg_bit_name << " = 1'b0;\n";
+					f << indent << "  else if (" << (ff.pol_set ? "" : "!");
 					dump_sigspec(f, ff.sig_set[i]);
-					f << stringf(") %s = 1'b1;\n", reg_bit_name.c_str());
+					f << ") " << reg_bit_name << " = 1'b1;\n";
 					if (ff.has_aload)
-						f << stringf("%s" "  else ", indent.c_str());
+						f << indent << "  else ";
 				} else if (ff.has_arst) {
-					f << stringf("if (%s", ff.pol_arst ? "" : "!");
+					f << "if (" << (ff.pol_arst ? "" : "!");
 					dump_sigspec(f, ff.sig_arst);
-					f << stringf(") %s = ", reg_bit_name.c_str());
+					f << ") " << reg_bit_name << " = ";
 					dump_sigspec(f, val_arst);
-					f << stringf(";\n");
+					f << ";\n";
 					if (ff.has_aload)
-						f << stringf("%s" "  else ", indent.c_str());
+						f << indent << "  else ";
 				}
 				if (ff.has_aload) {
-					f << stringf("if (%s", ff.pol_aload ? "" : "!");
+					f << "if (" << (ff.pol_aload ? "" : "!");
 					dump_sigspec(f, ff.sig_aload);
-					f << stringf(") %s = ", reg_bit_name.c_str());
+					f << ") " << reg_bit_name << " = ";
 					dump_sigspec(f, sig_ad);
-					f << stringf(";\n");
+					f << ";\n";
 				}
 			}
 		}
 
 		if (!out_is_reg_wire) {
-			f << stringf("%s" "assign ", indent.c_str());
+			f << indent << "assign ";
 			dump_sigspec(f, ff.sig_q);
-			f << stringf(" = %s;\n", reg_name.c_str());
+			f << " = " << reg_name << ";\n";
 		}
 
 		return true;
@@ -1697,23 +1730,23 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 
 	if (cell->type.in(ID($assert), ID($assume), ID($cover)))
 	{
-		f << stringf("%s" "always%s if (", indent.c_str(), systemverilog ? "_comb" : " @*");
+		f << indent << "always" << (systemverilog ? "_comb" : " @*") << " if (";
 		dump_sigspec(f, cell->getPort(ID::EN));
-		f << stringf(") %s(", cell->type.c_str()+1);
+		f << ") " << (cell->type.c_str()+1) << "(";
 		dump_sigspec(f, cell->getPort(ID::A));
-		f << stringf(");\n");
+		f << ");\n";
 		return true;
 	}
 
 	if (cell->type.in(ID($specify2), ID($specify3)))
 	{
-		f << stringf("%s" "specify\n%s  ", indent.c_str(), indent.c_str());
+		f << indent << "specify\n" << indent << "  ";
 
 		SigSpec en = cell->getPort(ID::EN);
 		if (en != State::S1) {
-			f << stringf("if (");
+			f << "if (";
 			dump_sigspec(f, cell->getPort(ID::EN));
-			f << stringf(") ");
+			f << ") ";
 		}
 
 		f << "(";
@@ -1759,16 +1792,16 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 
 		decimal = bak_decimal;
 
-		f << stringf("%s" "endspecify\n", indent.c_str());
+		f << indent << "endspecify\n";
 		return true;
 	}
 
 	if (cell->type == ID($specrule))
 	{
-		f << stringf("%s" "specify\n%s  ", indent.c_str(), indent.c_str());
+		f << indent << "specify\n" << indent << "  ";
 
 		IdString spec_type = cell->getParam(ID::TYPE).decode_string();
-		f << stringf("%s(", spec_type.c_str());
+		f << spec_type.c_str() << "(";
 
 		if (cell->getParam(ID::SRC_PEN).as_bool())
 			f << (cell->getParam(ID::SRC_POL).as_bool() ? "posedge ": "negedge ");
@@ -1811,7 +1844,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		f << ");\n";
 		decimal = bak_decimal;
 
-		f << stringf("%s" "endspecify\n", indent.c_str());
+		f << indent << "endspecify\n";
 		return true;
 	}
 
@@ -1821,11 +1854,11 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		if (cell->getParam(ID::TRG_ENABLE).as_bool())
 			return true;
 
-		f << stringf("%s" "always @*\n", indent.c_str());
+		f << indent << "always @*\n";
 
-		f << stringf("%s" "  if (", indent.c_str());
+		f << indent << "  if (";
 		dump_sigspec(f, cell->getPort(ID::EN));
-		f << stringf(")\n");
+		f << ")\n";
 
 		dump_cell_expr_print(f, indent + "    ", cell);
 		return true;
@@ -1837,29 +1870,29 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		if (cell->getParam(ID::TRG_ENABLE).as_bool())
 			return true;
 
-		f << stringf("%s" "always @*\n", indent.c_str());
+		f << indent << "always @*\n";
 
-		f << stringf("%s" "  if (", indent.c_str());
+		f << indent << "  if (";
 		dump_sigspec(f, cell->getPort(ID::EN));
-		f << stringf(") begin\n");
+		f << ") begin\n";
 
 		std::string flavor = cell->getParam(ID::FLAVOR).decode_string();
 		if (flavor == "assert" || flavor == "assume") {
 			Fmt fmt;
 			fmt.parse_rtlil(cell);
 			if (!fmt.parts.empty()) {
-				f << stringf("%s" "    if (!", indent.c_str());
+				f << indent << "    if (!";
 				dump_sigspec(f, cell->getPort(ID::A));
-				f << stringf(")\n");
+				f << ")\n";
 				dump_cell_expr_print(f, indent + "      ", cell);
 			}
 		} else {
-			f << stringf("%s" "  /* message omitted */\n", indent.c_str());
+			f << indent << "  /* message omitted */\n";
 		}
 
 		dump_cell_expr_check(f, indent + "    ", cell);
 
-		f << stringf("%s" "  end\n", indent.c_str());
+		f << indent << "  end\n";
 
 		return true;
 	}
@@ -1869,7 +1902,7 @@ bool dump_cell_expr(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	return false;
 }
 
-void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
+void dump_cell(std::ostream &f, const std::string &indent, RTLIL::Cell *cell)
 {
 	// To keep the output compatible with other tools we ignore $scopeinfo
 	// cells that exist only to hold metadata. If in the future that metadata
@@ -1888,26 +1921,26 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 	}
 
 	dump_attributes(f, indent, cell->attributes);
-	f << stringf("%s" "%s", indent.c_str(), id(cell->type, false).c_str());
+	f << indent << id(cell->type, false);
 
 	if (!defparam && cell->parameters.size() > 0) {
-		f << stringf(" #(");
+		f << " #(";
 		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); ++it) {
 			if (it != cell->parameters.begin())
-				f << stringf(",");
-			f << stringf("\n%s  .%s(", indent.c_str(), id(it->first).c_str());
+				f << ",";
+			f << "\n" << indent << "  ." << cached_id(it->first) << "(";
 			if (it->second.size() > 0)
 				dump_const(f, it->second);
-			f << stringf(")");
+			f << ")";
 		}
-		f << stringf("\n%s" ")", indent.c_str());
+		f << "\n" << indent << ")";
 	}
 
 	std::string cell_name = cellname(cell);
 	if (cell_name != id(cell->name))
-		f << stringf(" %s /* %s */ (", cell_name.c_str(), id(cell->name).c_str());
+		f << " " << cell_name << " /* " << cached_id(cell->name) << " */ (";
 	else
-		f << stringf(" %s (", cell_name.c_str());
+		f << " " << cell_name << " (";
 
 	bool first_arg = true;
 	std::set<RTLIL::IdString> numbered_ports;
@@ -1918,9 +1951,9 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 			if (it->first != str)
 				continue;
 			if (!first_arg)
-				f << stringf(",");
+				f << ",";
 			first_arg = false;
-			f << stringf("\n%s  ", indent.c_str());
+			f << "\n" << indent << "  ";
 			dump_sigspec(f, it->second);
 			numbered_ports.insert(it->first);
 			goto found_numbered_port;
@@ -1932,20 +1965,20 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		if (numbered_ports.count(it->first))
 			continue;
 		if (!first_arg)
-			f << stringf(",");
+			f << ",";
 		first_arg = false;
-		f << stringf("\n%s  .%s(", indent.c_str(), id(it->first).c_str());
+		f << "\n" << indent << "  ." << cached_id(it->first) << "(";
 		if (it->second.size() > 0)
 			dump_sigspec(f, it->second);
-		f << stringf(")");
+		f << ")";
 	}
-	f << stringf("\n%s" ");\n", indent.c_str());
+	f << "\n" << indent << ");\n";
 
 	if (defparam && cell->parameters.size() > 0) {
 		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); ++it) {
-			f << stringf("%sdefparam %s.%s = ", indent.c_str(), cell_name.c_str(), id(it->first).c_str());
+			f << indent << "defparam " << cell_name << "." << cached_id(it->first) << " = ";
 			dump_const(f, it->second);
-			f << stringf(";\n");
+			f << ";\n";
 		}
 	}
 
@@ -1953,19 +1986,19 @@ void dump_cell(std::ostream &f, std::string indent, RTLIL::Cell *cell)
 		std::stringstream ss;
 		dump_reg_init(ss, cell->getPort(ID::Q));
 		if (!ss.str().empty()) {
-			f << stringf("%sinitial %s.Q", indent.c_str(), cell_name.c_str());
+			f << indent << "initial " << cell_name << ".Q";
 			f << ss.str();
 			f << ";\n";
 		}
 	}
 }
 
-void dump_sync_effect(std::ostream &f, std::string indent, const RTLIL::SigSpec &trg, const RTLIL::Const &polarity, std::vector<const RTLIL::Cell*> &cells)
+void dump_sync_effect(std::ostream &f, const std::string &indent, const RTLIL::SigSpec &trg, const RTLIL::Const &polarity, std::vector<const RTLIL::Cell*> &cells)
 {
 	if (trg.size() == 0) {
-		f << stringf("%s" "initial begin\n", indent.c_str());
+		f << indent << "initial begin\n";
 	} else {
-		f << stringf("%s" "always @(", indent.c_str());
+		f << indent << "always @(";
 		for (int i = 0; i < trg.size(); i++) {
 			if (i != 0)
 				f << " or ";
@@ -1982,9 +2015,9 @@ void dump_sync_effect(std::ostream &f, std::string indent, const RTLIL::SigSpec
 		return a->getParam(ID::PRIORITY).as_int() > b->getParam(ID::PRIORITY).as_int();
 	});
 	for (auto cell : cells) {
-		f << stringf("%s" "  if (", indent.c_str());
+		f << indent << "  if (";
 		dump_sigspec(f, cell->getPort(ID::EN));
-		f << stringf(") begin\n");
+		f << ") begin\n";
 
 		if (cell->type == ID($print)) {
 			dump_cell_expr_print(f, indent + "    ", cell);
@@ -1994,68 +2027,68 @@ void dump_sync_effect(std::ostream &f, std::string indent, const RTLIL::SigSpec
 				Fmt fmt;
 				fmt.parse_rtlil(cell);
 				if (!fmt.parts.empty()) {
-					f << stringf("%s" "    if (!", indent.c_str());
+					f << indent << "    if (!";
 					dump_sigspec(f, cell->getPort(ID::A));
-					f << stringf(")\n");
+					f << ")\n";
 					dump_cell_expr_print(f, indent + "      ", cell);
 				}
 			} else {
-				f << stringf("%s" "  /* message omitted */\n", indent.c_str());
+				f << indent << "  /* message omitted */\n";
 			}
 
 			dump_cell_expr_check(f, indent + "    ", cell);
 		}
 
-		f << stringf("%s" "  end\n", indent.c_str());
+		f << indent << "  end\n";
 	}
 
-	f << stringf("%s" "end\n", indent.c_str());
+	f << indent << "end\n";
 }
 
-void dump_conn(std::ostream &f, std::string indent, const RTLIL::SigSpec &left, const RTLIL::SigSpec &right)
+void dump_conn(std::ostream &f, const std::string &indent, const RTLIL::SigSpec &left, const RTLIL::SigSpec &right)
 {
 	bool all_chunks_wires = true;
 	for (auto &chunk : left.chunks())
 		if (chunk.is_wire() && reg_wires.count(chunk.wire->name))
 			all_chunks_wires = false;
 	if (!simple_lhs && all_chunks_wires) {
-		f << stringf("%s" "assign ", indent.c_str());
+		f << indent << "assign ";
 		dump_sigspec(f, left);
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, right);
-		f << stringf(";\n");
+		f << ";\n";
 	} else {
 		int offset = 0;
 		for (auto &chunk : left.chunks()) {
 			if (chunk.is_wire() && reg_wires.count(chunk.wire->name))
-				f << stringf("%s" "always%s\n%s  ", indent.c_str(), systemverilog ? "_comb" : " @*", indent.c_str());
+				f << indent << "always" << (systemverilog ? "_comb" : " @*") << "\n" << indent << "  ";
 			else
-				f << stringf("%s" "assign ", indent.c_str());
+				f << indent << "assign ";
 			dump_sigspec(f, chunk);
-			f << stringf(" = ");
+			f << " = ";
 			dump_sigspec(f, right.extract(offset, GetSize(chunk)));
-			f << stringf(";\n");
+			f << ";\n";
 			offset += GetSize(chunk);
 		}
 	}
 }
 
-void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw);
+void dump_proc_switch(std::ostream &f, const std::string &indent, RTLIL::SwitchRule *sw);
 
-void dump_case_actions(std::ostream &f, std::string indent, RTLIL::CaseRule *cs)
+void dump_case_actions(std::ostream &f, const std::string &indent, RTLIL::CaseRule *cs)
 {
 	for (auto it = cs->actions.begin(); it != cs->actions.end(); ++it) {
 		if (it->first.size() == 0)
 			continue;
-		f << stringf("%s  ", indent.c_str());
+		f << indent << "  ";
 		dump_sigspec(f, it->first);
-		f << stringf(" = ");
+		f << " = ";
 		dump_sigspec(f, it->second);
-		f << stringf(";\n");
+		f << ";\n";
 	}
 }
 
-bool dump_proc_switch_ifelse(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw)
+bool dump_proc_switch_ifelse(std::ostream &f, const std::string &indent, RTLIL::SwitchRule *sw)
 {
 	for (auto it = sw->cases.begin(); it != sw->cases.end(); ++it) {
 		if ((*it)->compare.size() == 0) {
@@ -2086,9 +2119,9 @@ bool dump_proc_switch_ifelse(std::ostream &f, std::string indent, RTLIL::SwitchR
 				f << " else ";
 		}
 		if (!(*it)->compare.empty()) {
-			f << stringf("if (");
+			f << "if (";
 			dump_sigspec(f, *sig_it);
-			f << stringf(") begin\n");
+			f << ") begin\n";
 		}
 
 		dump_case_actions(f, indent, (*it));
@@ -2103,33 +2136,33 @@ bool dump_proc_switch_ifelse(std::ostream &f, std::string indent, RTLIL::SwitchR
 	return true;
 }
 
-void dump_case_body(std::ostream &f, std::string indent, RTLIL::CaseRule *cs, bool omit_trailing_begin = false)
+void dump_case_body(std::ostream &f, const std::string &indent, RTLIL::CaseRule *cs, bool omit_trailing_begin = false)
 {
 	int number_of_stmts = cs->switches.size() + cs->actions.size();
 
 	if (!omit_trailing_begin && number_of_stmts >= 2)
-		f << stringf("%s" "begin\n", indent.c_str());
+		f << indent << "begin\n";
 
 	dump_case_actions(f, indent, cs);
 	for (auto it = cs->switches.begin(); it != cs->switches.end(); ++it)
 		dump_proc_switch(f, indent + "  ", *it);
 
 	if (!omit_trailing_begin && number_of_stmts == 0)
-		f << stringf("%s  /* empty */;\n", indent.c_str());
+		f << indent << "  /* empty */;\n";
 
 	if (omit_trailing_begin || number_of_stmts >= 2)
-		f << stringf("%s" "end\n", indent.c_str());
+		f << indent << "end\n";
 }
 
-void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw)
+void dump_proc_switch(std::ostream &f, const std::string &indent, RTLIL::SwitchRule *sw)
 {
 	if (sw->signal.size() == 0) {
-		f << stringf("%s" "begin\n", indent.c_str());
+		f << indent << "begin\n";
 		for (auto it = sw->cases.begin(); it != sw->cases.end(); ++it) {
 			if ((*it)->compare.size() == 0)
 				dump_case_body(f, indent + "  ", *it);
 		}
-		f << stringf("%s" "end\n", indent.c_str());
+		f << indent << "end\n";
 		return;
 	}
 
@@ -2137,25 +2170,25 @@ void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw
 		return;
 
 	dump_attributes(f, indent, sw->attributes);
-	f << stringf("%s" "casez (", indent.c_str());
+	f << indent << "casez (";
 	dump_sigspec(f, sw->signal);
-	f << stringf(")\n");
+	f << ")\n";
 
 	for (auto it = sw->cases.begin(); it != sw->cases.end(); ++it) {
 		bool got_default = false;
 		dump_attributes(f, indent + "  ", (*it)->attributes, "\n", /*modattr=*/false, /*regattr=*/false, /*as_comment=*/true);
 		if ((*it)->compare.size() == 0) {
-			f << stringf("%s  default", indent.c_str());
+			f << indent << "  default";
 			got_default = true;
 		} else {
-			f << stringf("%s  ", indent.c_str());
+			f << indent << "  ";
 			for (size_t i = 0; i < (*it)->compare.size(); i++) {
 				if (i > 0)
-					f << stringf(", ");
+					f << ", ";
 				dump_sigspec(f, (*it)->compare[i]);
 			}
 		}
-		f << stringf(":\n");
+		f << ":\n";
 		dump_case_body(f, indent + "    ", *it);
 
 		if (got_default) {
@@ -2169,10 +2202,10 @@ void dump_proc_switch(std::ostream &f, std::string indent, RTLIL::SwitchRule *sw
 
 	if (sw->cases.empty()) {
 		// Verilog does not allow empty cases.
-		f << stringf("%s  default: ;\n", indent.c_str());
+		f << indent << "  default: ;\n";
 	}
 
-	f << stringf("%s" "endcase\n", indent.c_str());
+	f << indent << "endcase\n";
 }
 
 void case_body_find_regs(RTLIL::CaseRule *cs)
@@ -2201,9 +2234,9 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		return;
 	}
 
-	f << stringf("%s" "always%s begin\n", indent.c_str(), systemverilog ? "_comb" : " @*");
+	f << indent << "always" << (systemverilog ? "_comb" : " @*") << " begin\n";
 	if (!systemverilog)
-		f << indent + "  " << "if (" << id(initial_id) << ") begin end\n";
+		f << indent + "  " << "if (" << cached_id(initial_id) << ") begin end\n";
 	dump_case_body(f, indent, &proc->root_case, true);
 
 	std::string backup_indent = indent;
@@ -2214,25 +2247,25 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		indent = backup_indent;
 
 		if (sync->type == RTLIL::STa) {
-			f << stringf("%s" "always%s begin\n", indent.c_str(), systemverilog ? "_comb" : " @*");
+			f << indent << "always" << (systemverilog ? "_comb" : " @*") << " begin\n";
 		} else if (sync->type == RTLIL::STi) {
-			f << stringf("%s" "initial begin\n", indent.c_str());
+			f << indent << "initial begin\n";
 		} else {
-			f << stringf("%s" "always%s @(", indent.c_str(), systemverilog ? "_ff" : "");
+			f << indent << "always" << (systemverilog ? "_ff" : "") << " @(";
 			if (sync->type == RTLIL::STp || sync->type == RTLIL::ST1)
-				f << stringf("posedge ");
+				f << "posedge ";
 			if (sync->type == RTLIL::STn || sync->type == RTLIL::ST0)
-				f << stringf("negedge ");
+				f << "negedge ";
 			dump_sigspec(f, sync->signal);
-			f << stringf(") begin\n");
+			f << ") begin\n";
 		}
 		std::string ends = indent + "end\n";
 		indent += "  ";
 
 		if (sync->type == RTLIL::ST0 || sync->type == RTLIL::ST1) {
-			f << stringf("%s" "if (%s", indent.c_str(), sync->type == RTLIL::ST0 ? "!" : "");
+			f << indent << "if (" << (sync->type == RTLIL::ST0 ? "!" : "");
 			dump_sigspec(f, sync->signal);
-			f << stringf(") begin\n");
+			f << ") begin\n";
 			ends = indent + "end\n" + ends;
 			indent += "  ";
 		}
@@ -2241,9 +2274,9 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 			for (size_t j = 0; j < proc->syncs.size(); j++) {
 				RTLIL::SyncRule *sync2 = proc->syncs[j];
 				if (sync2->type == RTLIL::ST0 || sync2->type == RTLIL::ST1) {
-					f << stringf("%s" "if (%s", indent.c_str(), sync2->type == RTLIL::ST1 ? "!" : "");
+					f << indent << "if (" << (sync2->type == RTLIL::ST1 ? "!" : "");
 					dump_sigspec(f, sync2->signal);
-					f << stringf(") begin\n");
+					f << ") begin\n";
 					ends = indent + "end\n" + ends;
 					indent += "  ";
 				}
@@ -2253,19 +2286,20 @@ void dump_process(std::ostream &f, std::string indent, RTLIL::Process *proc, boo
 		for (auto it = sync->actions.begin(); it != sync->actions.end(); ++it) {
 			if (it->first.size() == 0)
 				continue;
-			f << stringf("%s  ", indent.c_str());
+			f << indent << "  ";
 			dump_sigspec(f, it->first);
-			f << stringf(" <= ");
+			f << " <= ";
 			dump_sigspec(f, it->second);
-			f << stringf(";\n");
+			f << ";\n";
 		}
 
-		f << stringf("%s", ends.c_str());
+		f << ends;
 	}
 }
 
-void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
+void dump_module(std::ostream &f, const std::string &indent, RTLIL::Module *module, RTLIL::IdString init_reg_id)
 {
+	std::string body_indent = indent + "  ";
 	std::map<std::pair<RTLIL::SigSpec, RTLIL::Const>, std::vector<const RTLIL::Cell*>> sync_effect_cells;
 
 	reg_wires.clear();
@@ -2293,9 +2327,9 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 				"unintended changes in simulation behavior are possible! Use \"proc\" "
 				"to convert processes to logic networks and registers.\n", log_id(module));
 
-	f << stringf("\n");
+	f << "\n";
 	for (auto it = module->processes.begin(); it != module->processes.end(); ++it)
-		dump_process(f, indent + "  ", it->second, true);
+		dump_process(f, body_indent, it->second, true);
 
 	if (!noexpr)
 	{
@@ -2331,7 +2365,7 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 	}
 
 	dump_attributes(f, indent, module->attributes, "\n", /*modattr=*/true);
-	f << stringf("%s" "module %s(", indent.c_str(), id(module->name, false).c_str());
+	f << indent << "module " << id(module->name, false) << "(";
 	bool keep_running = true;
 	int cnt = 0;
 	for (int port_id = 1; keep_running; port_id++) {
@@ -2339,39 +2373,39 @@ void dump_module(std::ostream &f, std::string indent, RTLIL::Module *module)
 		for (auto wire : module->wires()) {
 			if (wire->port_id == port_id) {
 				if (port_id != 1)
-					f << stringf(", ");
-				f << stringf("%s", id(wire->name).c_str());
+					f << ", ";
+				f << cached_id(wire->name);
 				keep_running = true;
-				if (cnt==20) { f << stringf("\n"); cnt = 0; } else cnt++;
+				if (cnt==20) { f << "\n"; cnt = 0; } else cnt++;
 				continue;
 			}
 		}
 	}
-	f << stringf(");\n");
+	f << ");\n";
 	if (!systemverilog && !module->processes.empty()) {
-		initial_id = NEW_ID;
-		f << indent + "  " << "reg " << id(initial_id) << " = 0;\n";
+		initial_id = init_reg_id;
+		f << body_indent << "reg " << cached_id(initial_id) << " = 0;\n";
 	}
 
 	for (auto w : module->wires())
-		dump_wire(f, indent + "  ", w);
+		dump_wire(f, body_indent, w);
 
 	for (auto &mem : Mem::get_all_memories(module))
-		dump_memory(f, indent + "  ", mem);
+		dump_memory(f, body_indent, mem);
 
 	for (auto cell : module->cells())
-		dump_cell(f, indent + "  ", cell);
+		dump_cell(f, body_indent, cell);
 
 	for (auto &it : sync_effect_cells)
-		dump_sync_effect(f, indent + "  ", it.first.first, it.first.second, it.second);
+		dump_sync_effect(f, body_indent, it.first.first, it.first.second, it.second);
 
 	for (auto it = module->processes.begin(); it != module->processes.end(); ++it)
-		dump_process(f, indent + "  ", it->second);
+		dump_process(f, body_indent, it->second);
 
 	for (auto it = module->connections().begin(); it != module->connections().end(); ++it)
-		dump_conn(f, indent + "  ", it->first, it->second);
+		dump_conn(f, body_indent, it->first, it->second);
 
-	f << stringf("%s" "endmodule\n", indent.c_str());
+	f << indent << "endmodule\n";
 	active_module = NULL;
 	active_sigmap.clear();
 	active_initdata.clear();
@@ -2464,6 +2498,11 @@ struct VerilogBackend : public Backend {
 		log("    -v\n");
 		log("        verbose output (print new names of all renamed wires and cells)\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        format up to N modules at the same time. the output does not depend\n");
+		log("        on the number of jobs. the default is the number of jobs given to\n");
+		log("        'yosys -j'. -extmem always uses a single job.\n");
+		log("\n");
 		log("Note that RTLIL processes can't always be mapped directly to Verilog\n");
 		log("always blocks. This frontend should only be used to export an RTLIL\n");
 		log("netlist, i.e. after the \"proc\" pass has been used to convert all\n");
@@ -2493,6 +2532,7 @@ struct VerilogBackend : public Backend {
 
 		bool blackboxes = false;
 		bool selected = false;
+		int jobs = yosys_jobs;
 
 		auto_name_map.clear();
 		reg_wires.clear();
@@ -2573,6 +2613,10 @@ struct VerilogBackend : public Backend {
 				verbose = true;
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
@@ -2593,7 +2637,8 @@ struct VerilogBackend : public Backend {
 
 		design->sort();
 
-		*f << stringf("/* Generated by %s */\n", yosys_version_str);
+		std::vector<RTLIL::Module*> modules;
+		std::vector<RTLIL::IdString> init_reg_ids;
 		for (auto module : design->modules()) {
 			if (module->get_blackbox_attribute() != blackboxes)
 				continue;
@@ -2602,11 +2647,38 @@ struct VerilogBackend : public Backend {
 					log_cmd_error("Can't handle partially selected module %s!\n", log_id(module->name));
 				continue;
 			}
-			log("Dumping module `%s'.\n", module->name.c_str());
-			dump_module(*f, "", module);
+			modules.push_back(module);
+			// allocated up front so the names do not depend on the thread schedule
+			init_reg_ids.push_back(!systemverilog && !module->processes.empty() ? NEW_ID : RTLIL::IdString());
+		}
+
+		*f << "/* Generated by " << yosys_version_str << " */\n";
+
+		// The -extmem files are numbered in the order memories are dumped, so
+		// that option keeps all modules on one thread.
+		if (extmem)
+			jobs = 1;
+
+		if (jobs > 1 && GetSize(modules) > 1) {
+			// Format the modules into separate buffers in parallel and write
+			// them out in design order, so the output is the same as with a
+			// single job.
+			std::vector<std::stringstream> buffers(GetSize(modules));
+			parallel_for(GetSize(modules), [&](int i) {
+				log("Dumping module `%s'.\n", modules[i]->name.c_str());
+				dump_module(buffers[i], "", modules[i], init_reg_ids[i]);
+			}, jobs);
+			for (auto &buf : buffers)
+				*f << buf.rdbuf();
+		} else {
+			for (int i = 0; i < GetSize(modules); i++) {
+				log("Dumping module `%s'.\n", modules[i]->name.c_str());
+				dump_module(*f, "", modules[i], init_reg_ids[i]);
+			}
 		}
 
 		auto_name_map.clear();
+		id_cache.clear();
 		reg_wires.clear();
 	}
 } VerilogBackend;
@@ -28,9 +28,12 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/rtlil_bin.h"
 #include "libs/sha1/sha1.h"
 #include "ast.h"
 
+#include <fstream>
+
 YOSYS_NAMESPACE_BEGIN
 
 using namespace AST;
@@ -1645,6 +1648,11 @@ void AstModule::expand_interfaces(RTLIL::Design *design, const dict<RTLIL::IdStr
 // This method is used to explode the interface when the interface is a port of the module (not instantiated inside)
 RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdString, RTLIL::Const> &parameters, const dict<RTLIL::IdString, RTLIL::Module*> &interfaces, const dict<RTLIL::IdString, RTLIL::IdString> &modports, bool /*mayfail*/)
 {
+	// hierarchy always derives through here, without interfaces this is the
+	// plain derivation below, which also uses the hierarchy cache
+	if (interfaces.empty())
+		return derive(design, parameters, false);
+
 	AstNode *new_ast = NULL;
 	std::string modname = derive_common(design, parameters, &new_ast);
 
@@ -1729,6 +1737,176 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdStr
 	return modname;
 }
 
+// With the scratchpad variable hierarchy.cache_dir set, derived modules are
+// also cached on disk, so that later runs do not have to simplify the same
+// module with the same parameters again. Entries are keyed by the AST with the
+// parameters already substituted and the frontend options of the module.
+// Simplification also looks at the ports of instantiated modules, so each entry
+// records those lookups and is only used while they still give the same result.
+
+static void hash_ast_node(std::string &buf, const AstNode *node, bool &cacheable)
+{
+	auto add_int = [&](int64_t value) { buf.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+	auto add_str = [&](const std::string &str) { add_int(GetSize(str)); buf += str; };
+
+	if (node == nullptr) {
+		add_int(-1);
+		return;
+	}
+
+	// the contents of memories initialized from a file are not part of the AST
+	if ((node->type == AST_FCALL || node->type == AST_TCALL) && (node->str == "\\$readmemh" || node->str == "\\$readmemb"))
+		cacheable = false;
+
+	add_int(node->type);
+	add_str(node->str);
+	add_int(GetSize(node->bits));
+	for (auto bit : node->bits)
+		buf.push_back(bit);
+
+	bool flags[] = { node->is_input, node->is_output, node->is_reg, node->is_logic, node->is_signed, node->is_string,
+			node->is_wand, node->is_wor, node->range_valid, node->range_swapped, node->was_checked, node->is_unsized,
+			node->is_custom_type, node->is_enum, node->basic_prep, node->lookahead, node->in_lvalue, node->in_param,
+			node->in_lvalue_from_above, node->in_param_from_above };
+	for (bool flag : flags)
+		buf.push_back(flag ? '1' : '0');
+
+	add_int(node->port_id);
+	add_int(node->range_left);
+	add_int(node->range_right);
+	add_int(node->integer);
+	buf.append(reinterpret_cast<const char*>(&node->realvalue), sizeof(node->realvalue));
+	add_int(GetSize(node->dimensions));
+	for (auto &dim : node->dimensions) {
+		add_int(dim.range_right);
+		add_int(dim.range_width);
+		add_int(dim.range_swapped);
+	}
+	add_int(node->unpacked_dimensions);
+
+	add_str(node->filename);
+	add_int(node->location.first_line);
+	add_int(node->location.first_column);
+	add_int(node->location.last_line);
+	add_int(node->location.last_column);
+
+	add_int(GetSize(node->attributes));
+	for (auto &attr : node->attributes) {
+		add_str(attr.first.str());
+		hash_ast_node(buf, attr.second, cacheable);
+	}
+	add_int(GetSize(node->children));
+	for (auto child : node->children)
+		hash_ast_node(buf, child, cacheable);
+}
+
+static std::string module_port_signature(const RTLIL::Module *module)
+{
+	if (module == nullptr)
+		return "-";
+
+	std::string sig;
+	for (auto param : module->avail_parameters)
+		sig += param.str() + " ";
+	sig += ";";
+	for (auto port : module->ports) {
+		const RTLIL::Wire *wire = module->wire(port);
+		sig += stringf(" %s:%d:%d:%d%d%d%d", port.c_str(), wire->width, wire->start_offset,
+				wire->upto, wire->is_signed, wire->port_input, wire->port_output);
+	}
+	return sha1(sig);
+}
+
+static std::string derive_cache_filename(RTLIL::Design *design, const AstModule *module, const AstNode *new_ast)
+{
+	std::string cache_dir = design->scratchpad_get_string("hierarchy.cache_dir");
+	if (cache_dir.empty())
+		return std::string();
+	rewrite_filename(cache_dir);
+	create_directory(cache_dir);
+
+	std::string buf = stringf("%s\n%s\n%d%d%d%d%d%d%d%d%d%d%d\n", yosys_version_str, new_ast->str.c_str(),
+			module->nolatches, module->nomeminit, module->nomem2reg, module->mem2reg, module->noblackbox,
+			module->lib, module->nowb, module->noopt, module->icells, module->pwires, module->autowire);
+	bool cacheable = true;
+	hash_ast_node(buf, new_ast, cacheable);
+	if (!cacheable)
+		return std::string();
+
+	return cache_dir + "/" + sha1(buf) + ".bin";
+}
+
+static bool derive_cache_load(RTLIL::Design *design, AstNode *new_ast, const std::string &filename)
+{
+	std::ifstream f(filename, std::ifstream::binary);
+	if (f.fail())
+		return false;
+
+	RTLIL::Design cache_design;
+	RTLIL_BIN::read_design(f, filename, &cache_design);
+	if (GetSize(cache_design.modules()) != 1) {
+		log_warning("Ignoring hierarchy cache file `%s' with %d modules.\n", filename.c_str(), GetSize(cache_design.modules()));
+		return false;
+	}
+
+	RTLIL::Module *cached = *cache_design.modules().begin();
+	for (auto &line : split_tokens(cached->get_string_attribute(ID(derive_cache_lookups)), "\n")) {
+		size_t pos = line.find('\t');
+		if (pos == std::string::npos || module_port_signature(design->module(line.substr(0, pos))) != line.substr(pos + 1))
+			return false;
+	}
+	cached->attributes.erase(ID(derive_cache_lookups));
+
+	// same as the tail of process_module(), loadconfig() has set the flags
+	AstModule *module = new AstModule;
+	module->name = new_ast->str;
+	cached->cloneInto(module);
+	module->ast = new_ast;
+	module->nolatches = flag_nolatches;
+	module->nomeminit = flag_nomeminit;
+	module->nomem2reg = flag_nomem2reg;
+	module->mem2reg = flag_mem2reg;
+	module->noblackbox = flag_noblackbox;
+	module->lib = flag_lib;
+	module->nowb = flag_nowb;
+	module->noopt = flag_noopt;
+	module->icells = flag_icells;
+	module->pwires = flag_pwires;
+	module->autowire = flag_autowire;
+	module->fixup_ports();
+
+	design->add(module);
+	return true;
+}
+
+static void derive_cache_store(const RTLIL::Module *derived, const std::string &filename)
+{
+	RTLIL::Module *mod = new RTLIL::Module;
+	mod->name = derived->name;
+	derived->cloneInto(mod);
+
+	std::string lookups;
+	for (auto &it : get_simplify_module_lookups())
+		lookups += it.first + "\t" + module_port_signature(it.second) + "\n";
+	mod->set_string_attribute(ID(derive_cache_lookups), lookups);
+
+	RTLIL::Design cache_design;
+	cache_design.add(mod);
+
+	// write to a temporary file first, so that concurrent runs sharing the
+	// cache directory never see a partially written module
+	std::string temp_filename = make_temp_file(filename + ".XXXXXX");
+	std::ofstream f(temp_filename, std::ofstream::trunc | std::ofstream::binary);
+	if (!f.fail()) {
+		RTLIL_BIN::write_design(f, &cache_design);
+		f.close();
+	}
+	if (f.fail() || rename(temp_filename.c_str(), filename.c_str()) != 0) {
+		log_warning("Failed to write hierarchy cache file `%s'.\n", filename.c_str());
+		remove(temp_filename.c_str());
+	}
+}
+
 // create a new parametric module (when needed) and return the name of the generated module - without support for interfaces
 RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdString, RTLIL::Const> &parameters, bool /*mayfail*/)
 {
@@ -1739,7 +1917,16 @@ RTLIL::IdString AstModule::derive(RTLIL::Design *design, const dict<RTLIL::IdStr
 
 	if (!design->has(modname) && new_ast) {
 		new_ast->str = modname;
-		process_module(design, new_ast, false, NULL, quiet);
+		std::string cache_filename = derive_cache_filename(design, this, new_ast);
+		if (!cache_filename.empty() && derive_cache_load(design, new_ast, cache_filename)) {
+			if (!quiet)
+				log("Loaded RTLIL representation for module `%s' from hierarchy cache.\n", modname.c_str());
+			new_ast = NULL;
+		} else {
+			process_module(design, new_ast, false, NULL, quiet);
+			if (!cache_filename.empty())
+				derive_cache_store(design->module(modname), cache_filename);
+		}
 		design->module(modname)->check();
 	} else if (!quiet) {
 		log("Found cached RTLIL representation for module `%s'.\n", modname.c_str());
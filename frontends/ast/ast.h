@@ -435,6 +435,10 @@ namespace AST
 	// used to provide simplify() access to the current design for looking up
 	// modules, ports, wires, etc.
 	void set_simplify_design_context(const RTLIL::Design *design);
+
+	// the modules looked up by simplify() since the design context was last
+	// set, including names that were not found
+	const dict<std::string, const RTLIL::Module*> &get_simplify_module_lookups();
 }
 
 namespace AST_INTERNAL
@@ -602,17 +602,27 @@ static std::string prefix_id(const std::string &prefix, const std::string &str)
 
 // direct access to this global should be limited to the following two functions
 static const RTLIL::Design *simplify_design_context = nullptr;
+static dict<std::string, const RTLIL::Module*> simplify_module_lookups;
 
 void AST::set_simplify_design_context(const RTLIL::Design *design)
 {
 	log_assert(!simplify_design_context || !design);
+	if (design)
+		simplify_module_lookups.clear();
 	simplify_design_context = design;
 }
 
+const dict<std::string, const RTLIL::Module*> &AST::get_simplify_module_lookups()
+{
+	return simplify_module_lookups;
+}
+
 // lookup the module with the given name in the current design context
 static const RTLIL::Module* lookup_module(const std::string &name)
 {
-	return simplify_design_context->module(name);
+	const RTLIL::Module *module = simplify_design_context->module(name);
+	simplify_module_lookups.emplace(name, module);
+	return module;
 }
 
 const RTLIL::Module* AstNode::lookup_cell_module()
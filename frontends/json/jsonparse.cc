@@ -21,233 +21,279 @@
 
 YOSYS_NAMESPACE_BEGIN
 
-struct JsonNode
+// Pull parser for the JSON netlist format. The importer below walks the
+// document with it and creates RTLIL objects as soon as their JSON objects
+// have been read, so that no tree of the whole file is ever built.
+struct JsonReader
 {
-	char type; // S=String, N=Number, A=Array, D=Dict
-	string data_string;
-	int64_t data_number;
-	vector<JsonNode*> data_array;
-	dict<string, JsonNode*> data_dict;
-	vector<string> data_dict_keys;
+	std::istream &f;
+	std::vector<char> buffer;
+	size_t buffer_pos = 0, buffer_len = 0;
+
+	JsonReader(std::istream &f) : f(f), buffer(64 * 1024) { }
 
-	JsonNode(std::istream &f)
+	bool refill()
 	{
-		type = 0;
-		data_number = 0;
+		f.read(buffer.data(), buffer.size());
+		buffer_len = f.gcount();
+		buffer_pos = 0;
+		return buffer_len != 0;
+	}
 
-		while (1)
-		{
-			int ch = f.get();
+	int get()
+	{
+		if (buffer_pos == buffer_len && !refill())
+			return EOF;
+		return (unsigned char)buffer[buffer_pos++];
+	}
+
+	int peek()
+	{
+		if (buffer_pos == buffer_len && !refill())
+			return EOF;
+		return (unsigned char)buffer[buffer_pos];
+	}
 
+	// skip whitespace and the given separator, returns the next character
+	// without consuming it
+	int skip(int separator = EOF)
+	{
+		while (1) {
+			int ch = peek();
 			if (ch == EOF)
-				log_error("Unexpected EOF in JSON file.\n");
+				return ch;
+			if (ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' && ch != separator)
+				return ch;
+			buffer_pos++;
+		}
+	}
 
-			if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
-				continue;
+	// returns the type of the next value: S=String, N=Number, A=Array, D=Dict
+	char peek_type()
+	{
+		int ch = skip();
+
+		if (ch == EOF)
+			log_error("Unexpected EOF in JSON file.\n");
+		if (ch == '"')
+			return 'S';
+		if (('0' <= ch && ch <= '9') || ch == '-')
+			return 'N';
+		if (ch == '[')
+			return 'A';
+		if (ch == '{')
+			return 'D';
+
+		log_error("Unexpected character in JSON file: '%c'\n", ch);
+	}
 
-			if (ch == '"')
-			{
-				type = 'S';
+	void parse_string(string &data_string)
+	{
+		data_string.clear();
+		log_assert(get() == '"');
 
-				while (1)
-				{
-					ch = f.get();
+		while (1)
+		{
+			int ch = get();
 
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON string.\n");
+			if (ch == EOF)
+				log_error("Unexpected EOF in JSON string.\n");
 
-					if (ch == '"')
-						break;
+			if (ch == '"')
+				break;
 
-					if (ch == '\\') {
-						ch = f.get();
-
-						switch (ch) {
-							case EOF: log_error("Unexpected EOF in JSON string.\n"); break;
-							case '"':
-							case '/':
-							case '\\':           break;
-							case 'b': ch = '\b'; break;
-							case 'f': ch = '\f'; break;
-							case 'n': ch = '\n'; break;
-							case 'r': ch = '\r'; break;
-							case 't': ch = '\t'; break;
-							case 'u':
-								int val = 0;
-								for (int i = 0; i < 4; i++) {
-									ch = f.get();
-									val <<= 4;
-									if (ch >= '0' && '9' >= ch) {
-										val += ch - '0';
-									} else if (ch >= 'A' && 'F' >= ch) {
-										val += 10 + ch - 'A';
-									} else if (ch >= 'a' && 'f' >= ch) {
-										val += 10 + ch - 'a';
-									} else
-										log_error("Unexpected non-digit character in \\uXXXX sequence: %c.\n", ch);
-								}
-								if (val < 128)
-									ch = val;
-								else
-									log_error("Unsupported \\uXXXX sequence in JSON string: %04X.\n", val);
-								break;
+			if (ch == '\\') {
+				ch = get();
+
+				switch (ch) {
+					case EOF: log_error("Unexpected EOF in JSON string.\n"); break;
+					case '"':
+					case '/':
+					case '\\':           break;
+					case 'b': ch = '\b'; break;
+					case 'f': ch = '\f'; break;
+					case 'n': ch = '\n'; break;
+					case 'r': ch = '\r'; break;
+					case 't': ch = '\t'; break;
+					case 'u':
+						int val = 0;
+						for (int i = 0; i < 4; i++) {
+							ch = get();
+							val <<= 4;
+							if (ch >= '0' && '9' >= ch) {
+								val += ch - '0';
+							} else if (ch >= 'A' && 'F' >= ch) {
+								val += 10 + ch - 'A';
+							} else if (ch >= 'a' && 'f' >= ch) {
+								val += 10 + ch - 'a';
+							} else
+								log_error("Unexpected non-digit character in \\uXXXX sequence: %c.\n", ch);
 						}
-					}
-
-					data_string += ch;
+						if (val < 128)
+							ch = val;
+						else
+							log_error("Unsupported \\uXXXX sequence in JSON string: %04X.\n", val);
+						break;
 				}
-
-				break;
 			}
 
-			if (('0' <= ch && ch <= '9') || ch == '-')
-			{
-				bool negative = false;
-				type = 'N';
-				if (ch == '-') {
-					data_number = 0;
-				       	negative = true;
-				} else {
-					data_number = ch - '0';
-				}
-
-				data_string += ch;
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						break;
+			data_string += ch;
+		}
+	}
 
-					if (ch == '.')
-						goto parse_real;
+	// Numbers with a fractional part are returned as type 'S' with their
+	// textual representation, like real-valued parameters in write_json.
+	void parse_number(char &type, string &data_string, int64_t &data_number)
+	{
+		int ch = get();
+		bool negative = false;
+		type = 'N';
+		data_string.clear();
+		if (ch == '-') {
+			data_number = 0;
+			negative = true;
+		} else {
+			data_number = ch - '0';
+		}
 
-					if (ch < '0' || '9' < ch) {
-						f.unget();
-						break;
-					}
+		data_string += ch;
 
-					data_number = data_number*10 + (ch - '0');
-					data_string += ch;
-				}
+		while (1)
+		{
+			ch = peek();
 
-				data_number = negative ? -data_number : data_number;
-				data_string = "";
+			if (ch == '.')
 				break;
 
-			parse_real:
-				type = 'S';
-				data_number = 0;
-				data_string += ch;
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						break;
-
-					if (ch < '0' || '9' < ch) {
-						f.unget();
-						break;
-					}
-
-					data_string += ch;
-				}
-
-				break;
+			if (ch < '0' || '9' < ch) {
+				data_number = negative ? -data_number : data_number;
+				data_string.clear();
+				return;
 			}
 
-			if (ch == '[')
-			{
-				type = 'A';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON file.\n");
-
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
-						continue;
-
-					if (ch == ']')
-						break;
+			buffer_pos++;
+			data_number = data_number*10 + (ch - '0');
+			data_string += ch;
+		}
 
-					f.unget();
-					data_array.push_back(new JsonNode(f));
-				}
+		type = 'S';
+		data_number = 0;
 
+		while (1)
+		{
+			data_string += get();
+			ch = peek();
+			if (ch < '0' || '9' < ch)
 				break;
-			}
-
-			if (ch == '{')
-			{
-				type = 'D';
-
-				while (1)
-				{
-					ch = f.get();
-
-					if (ch == EOF)
-						log_error("Unexpected EOF in JSON file.\n");
-
-					if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ',')
-						continue;
-
-					if (ch == '}')
-						break;
+		}
+	}
 
-					f.unget();
-					JsonNode key(f);
+	// object iteration: returns false after the closing brace
+	void begin_dict()
+	{
+		skip();
+		log_assert(get() == '{');
+	}
 
-					while (1)
-					{
-						ch = f.get();
+	bool next_key(string &key)
+	{
+		int ch = skip(',');
 
-						if (ch == EOF)
-							log_error("Unexpected EOF in JSON file.\n");
+		if (ch == EOF)
+			log_error("Unexpected EOF in JSON file.\n");
 
-						if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == ':')
-							continue;
+		if (ch == '}') {
+			get();
+			return false;
+		}
 
-						f.unget();
-						break;
-					}
+		if (peek_type() != 'S')
+			log_error("Unexpected non-string key in JSON dict.\n");
+		parse_string(key);
 
-					JsonNode *value = new JsonNode(f);
+		if (skip(':') == EOF)
+			log_error("Unexpected EOF in JSON file.\n");
+		return true;
+	}
 
-					if (key.type != 'S')
-						log_error("Unexpected non-string key in JSON dict.\n");
+	// array iteration: returns false after the closing bracket
+	void begin_array()
+	{
+		skip();
+		log_assert(get() == '[');
+	}
 
-					data_dict[key.data_string] = value;
-					data_dict_keys.push_back(key.data_string);
-				}
+	bool next_element()
+	{
+		int ch = skip(',');
 
-				break;
-			}
+		if (ch == EOF)
+			log_error("Unexpected EOF in JSON file.\n");
 
-			log_error("Unexpected character in JSON file: '%c'\n", ch);
+		if (ch == ']') {
+			get();
+			return false;
 		}
+		return true;
 	}
 
-	~JsonNode()
+	void skip_value()
 	{
-		for (auto it : data_array)
-			delete it;
-		for (auto &it : data_dict)
-			delete it.second;
+		string key;
+		switch (peek_type()) {
+		case 'S':
+			parse_string(key);
+			break;
+		case 'N': {
+			char type;
+			int64_t number;
+			parse_number(type, key, number);
+			break;
+		}
+		case 'A':
+			begin_array();
+			while (next_element())
+				skip_value();
+			break;
+		case 'D':
+			begin_dict();
+			while (next_key(key))
+				skip_value();
+			break;
+		}
 	}
 };
 
-Const json_parse_attr_param_value(JsonNode *node)
+struct JsonScalar
+{
+	char type = 0; // S=String, N=Number
+	string data_string;
+	int64_t data_number = 0;
+};
+
+// parse a string or number, with a description of the node for errors
+void json_parse_scalar(JsonReader &r, JsonScalar &value, const char *what)
+{
+	char type = r.peek_type();
+	if (type == 'S') {
+		value.type = 'S';
+		value.data_number = 0;
+		r.parse_string(value.data_string);
+	} else if (type == 'N') {
+		r.parse_number(value.type, value.data_string, value.data_number);
+	} else if (type == 'A') {
+		log_error("%s is an array.\n", what);
+	} else {
+		log_error("%s is a dict.\n", what);
+	}
+}
+
+Const json_parse_attr_param_value(const JsonScalar &node)
 {
 	Const value;
 
-	if (node->type == 'S') {
-		string &s = node->data_string;
+	if (node.type == 'S') {
+		const string &s = node.data_string;
 		size_t cursor = s.find_first_not_of("01xz");
 		if (cursor == string::npos) {
 			value = Const::from_string(s);
@@ -257,16 +303,10 @@ Const json_parse_attr_param_value(JsonNode *node)
 			value = Const(s);
 		}
 	} else
-	if (node->type == 'N') {
-		value = Const(node->data_number, 32);
-		if (node->data_number < 0)
+	if (node.type == 'N') {
+		value = Const(node.data_number, 32);
+		if (node.data_number < 0)
 			value.flags |= RTLIL::CONST_FLAG_SIGNED;
-	} else
-	if (node->type == 'A') {
-		log_error("JSON attribute or parameter value is an array.\n");
-	} else
-	if (node->type == 'D') {
-		log_error("JSON attribute or parameter value is a dict.\n");
 	} else {
 		log_abort();
 	}
@@ -274,350 +314,497 @@ Const json_parse_attr_param_value(JsonNode *node)
 	return value;
 }
 
-void json_parse_attr_param(dict<IdString, Const> &results, JsonNode *node)
+void json_parse_attr_param(dict<IdString, Const> &results, JsonReader &r)
 {
-	if (node->type != 'D')
+	if (r.peek_type() != 'D')
 		log_error("JSON attributes or parameters node is not a dictionary.\n");
 
-	for (auto it : node->data_dict)
-	{
-		IdString key = RTLIL::escape_id(it.first.c_str());
-		Const value = json_parse_attr_param_value(it.second);
-		results[key] = value;
+	// insert in reverse so that the results iterate in file order
+	std::vector<std::pair<IdString, Const>> items;
+	string key;
+	JsonScalar value;
+	r.begin_dict();
+	while (r.next_key(key)) {
+		json_parse_scalar(r, value, "JSON attribute or parameter value");
+		items.emplace_back(RTLIL::escape_id(key.c_str()), json_parse_attr_param_value(value));
 	}
+	for (auto it = items.rbegin(); it != items.rend(); ++it)
+		results[it->first] = std::move(it->second);
 }
 
-void json_import(Design *design, string &modname, JsonNode *node)
+// A bit of a "bits" array, kept until the end of the module when all named
+// signals are known: either a constant or a signal index. State is a single
+// byte, so this takes eight bytes per bit.
+struct JsonBit
 {
-	log("Importing module %s from JSON tree.\n", modname.c_str());
-
-	Module *module = new RTLIL::Module;
-	module->name = RTLIL::escape_id(modname.c_str());
-
-	if (design->module(module->name))
-		log_error("Re-definition of module %s.\n", log_id(module->name));
-
-	design->add(module);
+	bool is_const;
+	State state;
+	int index;
+};
 
-	if (node->data_dict.count("attributes"))
-		json_parse_attr_param(module->attributes, node->data_dict.at("attributes"));
+static_assert(sizeof(JsonBit) == 8, "JsonBit is expected to take eight bytes");
 
-	dict<int, SigBit> signal_bits;
+void json_parse_bits(std::vector<JsonBit> &bits, JsonReader &r, const string &what)
+{
+	bits.clear();
+	JsonScalar bitval_node;
 
-	if (node->data_dict.count("ports"))
+	r.begin_array();
+	while (r.next_element())
 	{
-		JsonNode *ports_node = node->data_dict.at("ports");
-
-		if (ports_node->type != 'D')
-			log_error("JSON ports node is not a dictionary.\n");
-
-		for (int port_id = 1; port_id <= GetSize(ports_node->data_dict_keys); port_id++)
-		{
-			IdString port_name = RTLIL::escape_id(ports_node->data_dict_keys[port_id-1].c_str());
-			JsonNode *port_node = ports_node->data_dict.at(ports_node->data_dict_keys[port_id-1]);
-
-			if (port_node->type != 'D')
-				log_error("JSON port node '%s' is not a dictionary.\n", log_id(port_name));
-
-			if (port_node->data_dict.count("direction") == 0)
-				log_error("JSON port node '%s' has no direction attribute.\n", log_id(port_name));
-
-			if (port_node->data_dict.count("bits") == 0)
-				log_error("JSON port node '%s' has no bits attribute.\n", log_id(port_name));
-
-			JsonNode *port_direction_node = port_node->data_dict.at("direction");
-			JsonNode *port_bits_node = port_node->data_dict.at("bits");
-
-			if (port_direction_node->type != 'S')
-				log_error("JSON port node '%s' has non-string direction attribute.\n", log_id(port_name));
-
-			if (port_bits_node->type != 'A')
-				log_error("JSON port node '%s' has non-array bits attribute.\n", log_id(port_name));
+		int i = GetSize(bits);
+		char type = r.peek_type();
+
+		if (type == 'S') {
+			r.parse_string(bitval_node.data_string);
+			if (bitval_node.data_string == "0")
+				bits.push_back({true, State::S0, 0});
+			else if (bitval_node.data_string == "1")
+				bits.push_back({true, State::S1, 0});
+			else if (bitval_node.data_string == "x")
+				bits.push_back({true, State::Sx, 0});
+			else if (bitval_node.data_string == "z")
+				bits.push_back({true, State::Sz, 0});
+			else
+				log_error("%s has invalid '%s' bit string value on bit %d.\n",
+						what.c_str(), bitval_node.data_string.c_str(), i);
+		} else
+		if (type == 'N') {
+			r.parse_number(bitval_node.type, bitval_node.data_string, bitval_node.data_number);
+			if (bitval_node.type != 'N')
+				log_error("%s has invalid '%s' bit string value on bit %d.\n",
+						what.c_str(), bitval_node.data_string.c_str(), i);
+			bits.push_back({false, State::Sx, int(bitval_node.data_number)});
+		} else
+			log_error("%s has invalid bit value on bit %d.\n", what.c_str(), i);
+	}
+}
 
-			Wire *port_wire = module->wire(port_name);
+struct JsonModuleImporter
+{
+	Design *design;
+	Module *module;
+	JsonReader &r;
+
+	struct PendingWire {
+		Wire *wire;
+		std::vector<JsonBit> bits;
+	};
+
+	struct PendingConnection {
+		Cell *cell;
+		IdString port;
+		std::vector<JsonBit> bits;
+	};
+
+	// Netnames, cells and memories are only created once the whole module has
+	// been read, in reverse file order. This is the order in which they were
+	// created when the frontend still iterated over a hashlib dict of each
+	// section, so objects still end up in the module in the same order.
+	struct PendingNetname {
+		IdString name;
+		std::vector<JsonBit> bits;
+		int upto;
+		bool has_offset;
+		int64_t offset;
+		dict<IdString, Const> attributes;
+	};
+
+	struct PendingCell {
+		IdString name, type;
+		dict<IdString, Const> attributes, parameters;
+		std::vector<PendingConnection> connections;
+	};
+
+	bool has_ports = false;
+	std::vector<PendingWire> ports, netnames;
+	std::vector<PendingNetname> pending_netnames;
+	std::vector<PendingCell> pending_cells;
+	std::vector<std::unique_ptr<RTLIL::Memory>> pending_memories;
+	std::vector<std::vector<PendingConnection>> cell_connections;
+	dict<int, SigBit> signal_bits;
 
-			if (port_wire == nullptr)
-				port_wire = module->addWire(port_name, GetSize(port_bits_node->data_array));
+	JsonModuleImporter(Design *design, JsonReader &r) : design(design), r(r) { }
 
-			if (port_node->data_dict.count("upto") != 0) {
-				JsonNode *val = port_node->data_dict.at("upto");
-				if (val->type == 'N')
-					port_wire->upto = val->data_number != 0;
-			}
-
-			if (port_node->data_dict.count("signed") != 0) {
-				JsonNode *val = port_node->data_dict.at("signed");
-				if (val->type == 'N')
-					port_wire->is_signed = val->data_number != 0;
-			}
+	void check_dict(const char *what, IdString name)
+	{
+		if (r.peek_type() != 'D')
+			log_error("JSON %s node '%s' is not a dictionary.\n", what, log_id(name));
+	}
 
-			if (port_node->data_dict.count("offset") != 0) {
-				JsonNode *val = port_node->data_dict.at("offset");
-				if (val->type == 'N')
-					port_wire->start_offset = val->data_number;
+	void parse_port(IdString port_name, int port_id)
+	{
+		check_dict("port", port_name);
+
+		string key;
+		JsonScalar direction, val;
+		bool has_bits = false;
+		std::vector<JsonBit> bits;
+		int upto = -1, is_signed = -1;
+		int64_t offset = 0;
+		bool has_offset = false;
+
+		r.begin_dict();
+		while (r.next_key(key)) {
+			if (key == "direction") {
+				if (r.peek_type() != 'S')
+					log_error("JSON port node '%s' has non-string direction attribute.\n", log_id(port_name));
+				json_parse_scalar(r, direction, "");
+			} else if (key == "bits") {
+				if (r.peek_type() != 'A')
+					log_error("JSON port node '%s' has non-array bits attribute.\n", log_id(port_name));
+				json_parse_bits(bits, r, stringf("JSON port node '%s'", log_id(port_name)));
+				has_bits = true;
+			} else if ((key == "upto" || key == "signed" || key == "offset") && r.peek_type() == 'N') {
+				json_parse_scalar(r, val, "");
+				if (val.type != 'N')
+					continue;
+				if (key == "upto")
+					upto = val.data_number != 0;
+				else if (key == "signed")
+					is_signed = val.data_number != 0;
+				else
+					offset = val.data_number, has_offset = true;
+			} else {
+				r.skip_value();
 			}
+		}
 
-			if (port_direction_node->data_string == "input") {
-				port_wire->port_input = true;
-			} else
-			if (port_direction_node->data_string == "output") {
-				port_wire->port_output = true;
-			} else
-			if (port_direction_node->data_string == "inout") {
-				port_wire->port_input = true;
-				port_wire->port_output = true;
-			} else
-				log_error("JSON port node '%s' has invalid '%s' direction attribute.\n", log_id(port_name), port_direction_node->data_string.c_str());
-
-			port_wire->port_id = port_id;
-
-			for (int i = 0; i < GetSize(port_bits_node->data_array); i++)
-			{
-				JsonNode *bitval_node = port_bits_node->data_array.at(i);
-				SigBit sigbit(port_wire, i);
+		if (direction.type == 0)
+			log_error("JSON port node '%s' has no direction attribute.\n", log_id(port_name));
+
+		if (!has_bits)
+			log_error("JSON port node '%s' has no bits attribute.\n", log_id(port_name));
+
+		Wire *port_wire = module->wire(port_name);
+
+		if (port_wire == nullptr)
+			port_wire = module->addWire(port_name, GetSize(bits));
+
+		if (upto >= 0)
+			port_wire->upto = upto;
+		if (is_signed >= 0)
+			port_wire->is_signed = is_signed;
+		if (has_offset)
+			port_wire->start_offset = offset;
+
+		if (direction.data_string == "input") {
+			port_wire->port_input = true;
+		} else
+		if (direction.data_string == "output") {
+			port_wire->port_output = true;
+		} else
+		if (direction.data_string == "inout") {
+			port_wire->port_input = true;
+			port_wire->port_output = true;
+		} else
+			log_error("JSON port node '%s' has invalid '%s' direction attribute.\n", log_id(port_name), direction.data_string.c_str());
+
+		port_wire->port_id = port_id;
+		ports.push_back({port_wire, std::move(bits)});
+	}
 
-				if (bitval_node->type == 'S') {
-					if (bitval_node->data_string == "0")
-						module->connect(sigbit, State::S0);
-					else if (bitval_node->data_string == "1")
-						module->connect(sigbit, State::S1);
-					else if (bitval_node->data_string == "x")
-						module->connect(sigbit, State::Sx);
-					else if (bitval_node->data_string == "z")
-						module->connect(sigbit, State::Sz);
-					else
-						log_error("JSON port node '%s' has invalid '%s' bit string value on bit %d.\n",
-								log_id(port_name), bitval_node->data_string.c_str(), i);
-				} else
-				if (bitval_node->type == 'N') {
-					int bitidx = bitval_node->data_number;
-					if (signal_bits.count(bitidx)) {
-						if (port_wire->port_output) {
-							module->connect(sigbit, signal_bits.at(bitidx));
-						} else {
-							module->connect(signal_bits.at(bitidx), sigbit);
-							signal_bits[bitidx] = sigbit;
-						}
-					} else {
-						signal_bits[bitidx] = sigbit;
-					}
-				} else
-					log_error("JSON port node '%s' has invalid bit value on bit %d.\n", log_id(port_name), i);
+	void parse_netname(IdString net_name)
+	{
+		check_dict("netname", net_name);
+
+		string key;
+		JsonScalar val;
+		bool has_bits = false;
+		std::vector<JsonBit> bits;
+		int upto = -1;
+		int64_t offset = 0;
+		bool has_offset = false;
+		dict<IdString, Const> attributes;
+
+		r.begin_dict();
+		while (r.next_key(key)) {
+			if (key == "bits") {
+				if (r.peek_type() != 'A')
+					log_error("JSON netname node '%s' has non-array bits attribute.\n", log_id(net_name));
+				json_parse_bits(bits, r, stringf("JSON netname node '%s'", log_id(net_name)));
+				has_bits = true;
+			} else if ((key == "upto" || key == "offset") && r.peek_type() == 'N') {
+				json_parse_scalar(r, val, "");
+				if (val.type != 'N')
+					continue;
+				if (key == "upto")
+					upto = val.data_number != 0;
+				else
+					offset = val.data_number, has_offset = true;
+			} else if (key == "attributes") {
+				json_parse_attr_param(attributes, r);
+			} else {
+				r.skip_value();
 			}
 		}
 
-		module->fixup_ports();
+		if (!has_bits)
+			log_error("JSON netname node '%s' has no bits attribute.\n", log_id(net_name));
+
+		pending_netnames.push_back({net_name, std::move(bits), upto, has_offset, offset, std::move(attributes)});
 	}
 
-	if (node->data_dict.count("netnames"))
+	void create_netnames()
 	{
-		JsonNode *netnames_node = node->data_dict.at("netnames");
-
-		if (netnames_node->type != 'D')
-			log_error("JSON netnames node is not a dictionary.\n");
-
-		for (auto &net : netnames_node->data_dict)
+		for (auto it = pending_netnames.rbegin(); it != pending_netnames.rend(); ++it)
 		{
-			IdString net_name = RTLIL::escape_id(net.first.c_str());
-			JsonNode *net_node = net.second;
-
-			if (net_node->type != 'D')
-				log_error("JSON netname node '%s' is not a dictionary.\n", log_id(net_name));
-
-			if (net_node->data_dict.count("bits") == 0)
-				log_error("JSON netname node '%s' has no bits attribute.\n", log_id(net_name));
-
-			JsonNode *bits_node = net_node->data_dict.at("bits");
-
-			if (bits_node->type != 'A')
-				log_error("JSON netname node '%s' has non-array bits attribute.\n", log_id(net_name));
-
-			Wire *wire = module->wire(net_name);
+			Wire *wire = module->wire(it->name);
 
 			if (wire == nullptr)
-				wire = module->addWire(net_name, GetSize(bits_node->data_array));
-
-			if (net_node->data_dict.count("upto") != 0) {
-				JsonNode *val = net_node->data_dict.at("upto");
-				if (val->type == 'N')
-					wire->upto = val->data_number != 0;
-			}
+				wire = module->addWire(it->name, GetSize(it->bits));
 
-			if (net_node->data_dict.count("offset") != 0) {
-				JsonNode *val = net_node->data_dict.at("offset");
-				if (val->type == 'N')
-					wire->start_offset = val->data_number;
-			}
+			if (it->upto >= 0)
+				wire->upto = it->upto;
+			if (it->has_offset)
+				wire->start_offset = it->offset;
 
-			for (int i = 0; i < GetSize(bits_node->data_array); i++)
-			{
-				JsonNode *bitval_node = bits_node->data_array.at(i);
-				SigBit sigbit(wire, i);
-
-				if (bitval_node->type == 'S') {
-					if (bitval_node->data_string == "0")
-						module->connect(sigbit, State::S0);
-					else if (bitval_node->data_string == "1")
-						module->connect(sigbit, State::S1);
-					else if (bitval_node->data_string == "x")
-						module->connect(sigbit, State::Sx);
-					else if (bitval_node->data_string == "z")
-						module->connect(sigbit, State::Sz);
-					else
-						log_error("JSON netname node '%s' has invalid '%s' bit string value on bit %d.\n",
-								log_id(net_name), bitval_node->data_string.c_str(), i);
-				} else
-				if (bitval_node->type == 'N') {
-					int bitidx = bitval_node->data_number;
-					if (signal_bits.count(bitidx)) {
-						if (sigbit != signal_bits.at(bitidx))
-							module->connect(sigbit, signal_bits.at(bitidx));
-					} else {
-						signal_bits[bitidx] = sigbit;
-					}
-				} else
-					log_error("JSON netname node '%s' has invalid bit value on bit %d.\n", log_id(net_name), i);
-			}
+			for (auto &attr : it->attributes)
+				wire->attributes[attr.first] = std::move(attr.second);
 
-			if (net_node->data_dict.count("attributes"))
-				json_parse_attr_param(wire->attributes, net_node->data_dict.at("attributes"));
+			netnames.push_back({wire, std::move(it->bits)});
 		}
+		pending_netnames.clear();
 	}
 
-	if (node->data_dict.count("cells"))
+	void parse_cell(IdString cell_name)
 	{
-		JsonNode *cells_node = node->data_dict.at("cells");
+		check_dict("cells", cell_name);
+
+		string key;
+		JsonScalar type_node;
+		bool has_connections = false;
+		std::vector<PendingConnection> connections;
+		dict<IdString, Const> attributes, parameters;
+
+		r.begin_dict();
+		while (r.next_key(key)) {
+			if (key == "type") {
+				if (r.peek_type() != 'S')
+					log_error("JSON cells node '%s' has a non-string type.\n", log_id(cell_name));
+				json_parse_scalar(r, type_node, "");
+			} else if (key == "connections") {
+				if (r.peek_type() != 'D')
+					log_error("JSON cells node '%s' has non-dictionary connections attribute.\n", log_id(cell_name));
+				has_connections = true;
+				string conn_key;
+				r.begin_dict();
+				while (r.next_key(conn_key)) {
+					IdString conn_name = RTLIL::escape_id(conn_key.c_str());
+					if (r.peek_type() != 'A')
+						log_error("JSON cells node '%s' connection '%s' is not an array.\n", log_id(cell_name), log_id(conn_name));
+					connections.push_back({nullptr, conn_name, {}});
+					json_parse_bits(connections.back().bits, r,
+							stringf("JSON cells node '%s' connection '%s'", log_id(cell_name), log_id(conn_name)));
+				}
+			} else if (key == "attributes") {
+				json_parse_attr_param(attributes, r);
+			} else if (key == "parameters") {
+				json_parse_attr_param(parameters, r);
+			} else {
+				r.skip_value();
+			}
+		}
 
-		if (cells_node->type != 'D')
-			log_error("JSON cells node is not a dictionary.\n");
+		if (type_node.type == 0)
+			log_error("JSON cells node '%s' has no type attribute.\n", log_id(cell_name));
 
-		for (auto &cell_node_it : cells_node->data_dict)
-		{
-			IdString cell_name = RTLIL::escape_id(cell_node_it.first.c_str());
-			JsonNode *cell_node = cell_node_it.second;
+		if (!has_connections)
+			log_error("JSON cells node '%s' has no connections attribute.\n", log_id(cell_name));
 
-			if (cell_node->type != 'D')
-				log_error("JSON cells node '%s' is not a dictionary.\n", log_id(cell_name));
+		pending_cells.push_back({cell_name, RTLIL::escape_id(type_node.data_string.c_str()),
+				std::move(attributes), std::move(parameters), std::move(connections)});
+	}
 
-			if (cell_node->data_dict.count("type") == 0)
-				log_error("JSON cells node '%s' has no type attribute.\n", log_id(cell_name));
+	void create_cells()
+	{
+		for (auto it = pending_cells.rbegin(); it != pending_cells.rend(); ++it)
+		{
+			Cell *cell = module->addCell(it->name, it->type);
+			cell->attributes = std::move(it->attributes);
+			cell->parameters = std::move(it->parameters);
 
-			JsonNode *type_node = cell_node->data_dict.at("type");
+			for (auto &conn : it->connections)
+				conn.cell = cell;
+			cell_connections.push_back(std::move(it->connections));
+		}
+		pending_cells.clear();
+	}
 
-			if (type_node->type != 'S')
-				log_error("JSON cells node '%s' has a non-string type.\n", log_id(cell_name));
+	void parse_memory(IdString memory_name)
+	{
+		check_dict("memory", memory_name);
+
+		string key;
+		JsonScalar val;
+		bool has_width = false, has_size = false;
+
+		std::unique_ptr<RTLIL::Memory> mem(new RTLIL::Memory);
+		mem->name = memory_name;
+		mem->start_offset = 0;
+
+		r.begin_dict();
+		while (r.next_key(key)) {
+			if (key == "width" || key == "size") {
+				json_parse_scalar(r, val, "");
+				if (val.type != 'N')
+					log_error("JSON memory node '%s' has a non-number %s.\n", log_id(memory_name), key.c_str());
+				if (key == "width")
+					mem->width = val.data_number, has_width = true;
+				else
+					mem->size = val.data_number, has_size = true;
+			} else if (key == "start_offset" && r.peek_type() == 'N') {
+				json_parse_scalar(r, val, "");
+				if (val.type == 'N')
+					mem->start_offset = val.data_number;
+			} else if (key == "attributes") {
+				json_parse_attr_param(mem->attributes, r);
+			} else {
+				r.skip_value();
+			}
+		}
 
-			IdString cell_type = RTLIL::escape_id(type_node->data_string.c_str());
+		if (!has_width)
+			log_error("JSON memory node '%s' has no width attribute.\n", log_id(memory_name));
+		if (!has_size)
+			log_error("JSON memory node '%s' has no size attribute.\n", log_id(memory_name));
 
-			Cell *cell = module->addCell(cell_name, cell_type);
+		pending_memories.push_back(std::move(mem));
+	}
 
-			if (cell_node->data_dict.count("connections") == 0)
-				log_error("JSON cells node '%s' has no connections attribute.\n", log_id(cell_name));
+	void create_memories()
+	{
+		for (auto it = pending_memories.rbegin(); it != pending_memories.rend(); ++it) {
+			RTLIL::Memory *mem = it->release();
+			if (module->memories.count(mem->name))
+				delete module->memories.at(mem->name);
+			module->memories[mem->name] = mem;
+		}
+		pending_memories.clear();
+	}
 
-			JsonNode *connections_node = cell_node->data_dict.at("connections");
+	template<typename F>
+	void parse_dict(const char *what, F parse_item)
+	{
+		if (r.peek_type() != 'D')
+			log_error("JSON %s node is not a dictionary.\n", what);
 
-			if (connections_node->type != 'D')
-				log_error("JSON cells node '%s' has non-dictionary connections attribute.\n", log_id(cell_name));
+		string key;
+		r.begin_dict();
+		while (r.next_key(key))
+			parse_item(RTLIL::escape_id(key.c_str()));
+	}
 
-			for (auto &conn_it : connections_node->data_dict)
+	// Connect the collected bits. This happens in the same order as when
+	// the frontend still built a tree of the whole file: ports in file order,
+	// then netnames and cell connections in the order they were created.
+	void connect_bits()
+	{
+		for (auto &port : ports)
+		{
+			Wire *port_wire = port.wire;
+			for (int i = 0; i < GetSize(port.bits); i++)
 			{
-				IdString conn_name = RTLIL::escape_id(conn_it.first.c_str());
-				JsonNode *conn_node = conn_it.second;
-
-				if (conn_node->type != 'A')
-					log_error("JSON cells node '%s' connection '%s' is not an array.\n", log_id(cell_name), log_id(conn_name));
-
-				SigSpec sig;
-
-				for (int i = 0; i < GetSize(conn_node->data_array); i++)
-				{
-					JsonNode *bitval_node = conn_node->data_array.at(i);
-
-					if (bitval_node->type == 'S') {
-						if (bitval_node->data_string == "0")
-							sig.append(State::S0);
-						else if (bitval_node->data_string == "1")
-							sig.append(State::S1);
-						else if (bitval_node->data_string == "x")
-							sig.append(State::Sx);
-						else if (bitval_node->data_string == "z")
-							sig.append(State::Sz);
-						else
-							log_error("JSON cells node '%s' connection '%s' has invalid '%s' bit string value on bit %d.\n",
-									log_id(cell_name), log_id(conn_name), bitval_node->data_string.c_str(), i);
-					} else
-					if (bitval_node->type == 'N') {
-						int bitidx = bitval_node->data_number;
-						if (signal_bits.count(bitidx) == 0)
-							signal_bits[bitidx] = module->addWire(NEW_ID);
-						sig.append(signal_bits.at(bitidx));
-					} else
-						log_error("JSON cells node '%s' connection '%s' has invalid bit value on bit %d.\n",
-								log_id(cell_name), log_id(conn_name), i);
+				auto &bit = port.bits[i];
+				SigBit sigbit(port_wire, i);
 
+				if (bit.is_const) {
+					module->connect(sigbit, bit.state);
+				} else if (signal_bits.count(bit.index)) {
+					if (port_wire->port_output) {
+						module->connect(sigbit, signal_bits.at(bit.index));
+					} else {
+						module->connect(signal_bits.at(bit.index), sigbit);
+						signal_bits[bit.index] = sigbit;
+					}
+				} else {
+					signal_bits[bit.index] = sigbit;
 				}
-
-				cell->setPort(conn_name, sig);
 			}
+		}
 
-			if (cell_node->data_dict.count("attributes"))
-				json_parse_attr_param(cell->attributes, cell_node->data_dict.at("attributes"));
+		for (auto it = netnames.begin(); it != netnames.end(); ++it)
+		{
+			for (int i = 0; i < GetSize(it->bits); i++)
+			{
+				auto &bit = it->bits[i];
+				SigBit sigbit(it->wire, i);
+
+				if (bit.is_const) {
+					module->connect(sigbit, bit.state);
+				} else if (signal_bits.count(bit.index)) {
+					if (sigbit != signal_bits.at(bit.index))
+						module->connect(sigbit, signal_bits.at(bit.index));
+				} else {
+					signal_bits[bit.index] = sigbit;
+				}
+			}
+		}
 
-			if (cell_node->data_dict.count("parameters"))
-				json_parse_attr_param(cell->parameters, cell_node->data_dict.at("parameters"));
+		for (auto &connections : cell_connections)
+		for (auto it = connections.rbegin(); it != connections.rend(); ++it)
+		{
+			SigSpec sig;
+			for (auto &bit : it->bits) {
+				if (bit.is_const) {
+					sig.append(bit.state);
+					continue;
+				}
+				if (signal_bits.count(bit.index) == 0)
+					signal_bits[bit.index] = module->addWire(NEW_ID);
+				sig.append(signal_bits.at(bit.index));
+			}
+			it->cell->setPort(it->port, sig);
 		}
 	}
 
-	if (node->data_dict.count("memories"))
+	// The module is not added to the design, see JsonFrontend::execute().
+	void run(const string &modname, const pool<IdString> &imported)
 	{
-		JsonNode *memories_node = node->data_dict.at("memories");
+		log("Importing module %s from JSON tree.\n", modname.c_str());
+
+		module = new RTLIL::Module;
+		module->name = RTLIL::escape_id(modname.c_str());
 
-		if (memories_node->type != 'D')
-			log_error("JSON memories node is not a dictionary.\n");
+		if (design->module(module->name) || imported.count(module->name))
+			log_error("Re-definition of module %s.\n", log_id(module->name));
 
-		for (auto &memory_node_it : memories_node->data_dict)
+		if (r.peek_type() != 'D')
+			log_error("JSON module node '%s' is not a dictionary.\n", log_id(module->name));
+
+		string key;
+		r.begin_dict();
+		while (r.next_key(key))
 		{
-			IdString memory_name = RTLIL::escape_id(memory_node_it.first.c_str());
-			JsonNode *memory_node = memory_node_it.second;
-
-			RTLIL::Memory *mem = new RTLIL::Memory;
-			mem->name = memory_name;
-
-			if (memory_node->type != 'D')
-				log_error("JSON memory node '%s' is not a dictionary.\n", log_id(memory_name));
-
-			if (memory_node->data_dict.count("width") == 0)
-				log_error("JSON memory node '%s' has no width attribute.\n", log_id(memory_name));
-			JsonNode *width_node = memory_node->data_dict.at("width");
-			if (width_node->type != 'N')
-				log_error("JSON memory node '%s' has a non-number width.\n", log_id(memory_name));
-			mem->width = width_node->data_number;
-
-			if (memory_node->data_dict.count("size") == 0)
-				log_error("JSON memory node '%s' has no size attribute.\n", log_id(memory_name));
-			JsonNode *size_node = memory_node->data_dict.at("size");
-			if (size_node->type != 'N')
-				log_error("JSON memory node '%s' has a non-number size.\n", log_id(memory_name));
-			mem->size = size_node->data_number;
-
-			mem->start_offset = 0;
-			if (memory_node->data_dict.count("start_offset") != 0) {
-				JsonNode *val = memory_node->data_dict.at("start_offset");
-				if (val->type == 'N')
-					mem->start_offset = val->data_number;
+			if (key == "attributes") {
+				json_parse_attr_param(module->attributes, r);
+			} else if (key == "ports") {
+				has_ports = true;
+				parse_dict("ports", [&](IdString name) { parse_port(name, GetSize(ports) + 1); });
+			} else if (key == "netnames") {
+				parse_dict("netnames", [&](IdString name) { parse_netname(name); });
+			} else if (key == "cells") {
+				parse_dict("cells", [&](IdString name) { parse_cell(name); });
+			} else if (key == "memories") {
+				parse_dict("memories", [&](IdString name) { parse_memory(name); });
+			} else {
+				r.skip_value();
 			}
+		}
 
-			if (memory_node->data_dict.count("attributes"))
-				json_parse_attr_param(mem->attributes, memory_node->data_dict.at("attributes"));
+		create_netnames();
+		create_cells();
+		create_memories();
+		connect_bits();
 
-			module->memories[mem->name] = mem;
-		}
-	}
+		if (has_ports)
+			module->fixup_ports();
 
-	// remove duplicates from connections array
-	pool<RTLIL::SigSig> unique_connections(module->connections_.begin(), module->connections_.end());
-	module->connections_ = std::vector<RTLIL::SigSig>(unique_connections.begin(), unique_connections.end());
-}
+		// remove duplicates from connections array
+		pool<RTLIL::SigSig> unique_connections(module->connections_.begin(), module->connections_.end());
+		module->connections_ = std::vector<RTLIL::SigSig>(unique_connections.begin(), unique_connections.end());
+	}
+};
 
 struct JsonFrontend : public Frontend {
 	JsonFrontend() : Frontend("json", "read JSON file") { }
@@ -630,6 +817,11 @@ struct JsonFrontend : public Frontend {
 		log("Load modules from a JSON file into the current design See \"help write_json\"\n");
 		log("for a description of the file format.\n");
 		log("\n");
+		log("The file is read in a single pass without building a tree of its contents.\n");
+		log("The netnames, cells and memories of a module are collected while it is being\n");
+		log("parsed and created once the module is complete, so memory use depends on the\n");
+		log("size of the largest module, not on the size of the whole file.\n");
+		log("\n");
 	}
 	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -646,20 +838,38 @@ struct JsonFrontend : public Frontend {
 		}
 		extra_args(f, filename, args, argidx);
 
-		JsonNode root(*f);
+		JsonReader r(*f);
 
-		if (root.type != 'D')
+		if (r.peek_type() != 'D')
 			log_error("JSON root node is not a dictionary.\n");
 
-		if (root.data_dict.count("modules") != 0)
+		string key;
+		r.begin_dict();
+		while (r.next_key(key))
 		{
-			JsonNode *modules = root.data_dict.at("modules");
+			if (key != "modules") {
+				r.skip_value();
+				continue;
+			}
 
-			if (modules->type != 'D')
+			if (r.peek_type() != 'D')
 				log_error("JSON modules node is not a dictionary.\n");
 
-			for (auto &it : modules->data_dict)
-				json_import(design, it.first, it.second);
+			// Like their contents, the modules used to be added in reverse file
+			// order, so they are kept aside and only added once all are read.
+			string modname;
+			std::vector<Module*> imported;
+			pool<IdString> imported_names;
+			r.begin_dict();
+			while (r.next_key(modname)) {
+				JsonModuleImporter importer(design, r);
+				importer.run(modname, imported_names);
+				imported.push_back(importer.module);
+				imported_names.insert(importer.module->name);
+			}
+
+			for (auto it = imported.rbegin(); it != imported.rend(); ++it)
+				design->add(*it);
 		}
 	}
 } JsonFrontend;
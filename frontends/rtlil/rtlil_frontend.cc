@@ -25,6 +25,7 @@
 #include "rtlil_frontend.h"
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "kernel/rtlil_bin.h"
 
 void rtlil_frontend_yyerror(char const *s)
 {
@@ -55,12 +56,17 @@ struct RTLILFrontend : public Frontend {
 		log("    -lib\n");
 		log("        only create empty blackbox modules\n");
 		log("\n");
+		log("    -legacy\n");
+		log("        use the old flex/bison based parser instead of the default reader,\n");
+		log("        which maps the input file into memory and tokenizes it in place.\n");
+		log("\n");
 	}
 	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
 	{
 		RTLIL_FRONTEND::flag_nooverwrite = false;
 		RTLIL_FRONTEND::flag_overwrite = false;
 		RTLIL_FRONTEND::flag_lib = false;
+		bool flag_legacy = false;
 
 		log_header(design, "Executing RTLIL frontend.\n");
 
@@ -81,14 +87,24 @@ struct RTLILFrontend : public Frontend {
 				RTLIL_FRONTEND::flag_lib = true;
 				continue;
 			}
+			if (arg == "-legacy") {
+				flag_legacy = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(f, filename, args, argidx);
 
 		log("Input filename: %s\n", filename.c_str());
 
-		RTLIL_FRONTEND::lexin = f;
 		RTLIL_FRONTEND::current_design = design;
+
+		if (!flag_legacy) {
+			RTLIL_FRONTEND::read_rtlil_stream(f, filename);
+			return;
+		}
+
+		RTLIL_FRONTEND::lexin = f;
 		rtlil_frontend_yydebug = false;
 		rtlil_frontend_yyrestart(NULL);
 		rtlil_frontend_yyparse();
@@ -111,5 +127,69 @@ struct IlangFrontend : public Frontend {
 	}
 } IlangFrontend;
 
+struct RTLILBinFrontend : public Frontend {
+	RTLILBinFrontend() : Frontend("rtlil_bin", "read modules from binary RTLIL file") { }
+	void help() override
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    read_rtlil_bin [filename]\n");
+		log("\n");
+		log("Load modules from a binary RTLIL checkpoint written by 'write_rtlil_bin' or\n");
+		log("'design -save-file'.\n");
+		log("\n");
+		log("    -nooverwrite\n");
+		log("        ignore re-definitions of modules. (the default behavior is to\n");
+		log("        create an error message if the existing module is not a blackbox\n");
+		log("        module, and overwrite the existing module if it is a blackbox module.)\n");
+		log("\n");
+		log("    -overwrite\n");
+		log("        overwrite existing modules with the same name\n");
+		log("\n");
+		log("    -lib\n");
+		log("        only create empty blackbox modules\n");
+		log("\n");
+		log("    -module <name>\n");
+		log("        only load the given module. The sections of all other modules are\n");
+		log("        skipped without being decoded. This option can be used multiple times.\n");
+		log("\n");
+	}
+	void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
+	{
+		RTLIL_BIN::ReadOptions options;
+
+		log_header(design, "Executing binary RTLIL frontend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-nooverwrite") {
+				options.nooverwrite = true;
+				options.overwrite = false;
+				continue;
+			}
+			if (arg == "-overwrite") {
+				options.nooverwrite = false;
+				options.overwrite = true;
+				continue;
+			}
+			if (arg == "-lib") {
+				options.lib = true;
+				continue;
+			}
+			if (arg == "-module" && argidx+1 < args.size()) {
+				options.modules.insert(RTLIL::escape_id(args[++argidx]));
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx, true);
+
+		log("Input filename: %s\n", filename.c_str());
+
+		RTLIL_BIN::read_design(*f, filename, design, options);
+	}
+} RTLILBinFrontend;
+
 YOSYS_NAMESPACE_END
 
@@ -35,6 +35,10 @@ namespace RTLIL_FRONTEND {
 	extern bool flag_nooverwrite;
 	extern bool flag_overwrite;
 	extern bool flag_lib;
+
+	// hand-written reader in rtlil_reader.cc
+	void read_rtlil_buffer(const char *data, size_t size);
+	void read_rtlil_stream(std::istream *f, const std::string &filename);
 }
 
 YOSYS_NAMESPACE_END
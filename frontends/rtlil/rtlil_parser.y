@@ -170,7 +170,7 @@ attr_stmt:
 
 autoidx_stmt:
 	TOK_AUTOIDX TOK_INT EOL {
-		autoidx = max(autoidx, $2);
+		autoidx = max(int(autoidx), $2);
 	};
 
 wire_stmt:
@@ -0,0 +1,783 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Hand-written reader for the RTLIL text representation. It accepts the
+ *  same language as rtlil_lexer.l/rtlil_parser.y, but tokenizes the input
+ *  buffer in place (usually a memory mapped file) instead of copying every
+ *  token. Other streams are read in chunks into a buffer that is refilled
+ *  as the tokenizer reaches its end.
+ *
+ */
+
+#include "frontends/rtlil/rtlil_frontend.h"
+
+#include <climits>
+
+#if !defined(_WIN32) && !defined(__wasm)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define RTLIL_READER_MMAP
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL_FRONTEND {
+
+namespace {
+
+enum TokenType {
+	TOK_EOF, TOK_EOL, TOK_ID, TOK_VALUE, TOK_INT, TOK_STRING, TOK_INVALID, TOK_CHAR,
+	TOK_AUTOIDX, TOK_MODULE, TOK_ATTRIBUTE, TOK_PARAMETER, TOK_SIGNED, TOK_REAL, TOK_WIRE,
+	TOK_MEMORY, TOK_WIDTH, TOK_UPTO, TOK_OFFSET, TOK_SIZE, TOK_INPUT, TOK_OUTPUT, TOK_INOUT,
+	TOK_CELL, TOK_CONNECT, TOK_SWITCH, TOK_CASE, TOK_ASSIGN, TOK_SYNC, TOK_LOW, TOK_HIGH,
+	TOK_POSEDGE, TOK_NEGEDGE, TOK_EDGE, TOK_ALWAYS, TOK_GLOBAL, TOK_INIT, TOK_UPDATE,
+	TOK_MEMWR, TOK_PROCESS, TOK_END
+};
+
+const std::pair<const char*, TokenType> keywords[] = {
+	{"autoidx", TOK_AUTOIDX}, {"module", TOK_MODULE}, {"attribute", TOK_ATTRIBUTE},
+	{"parameter", TOK_PARAMETER}, {"signed", TOK_SIGNED}, {"real", TOK_REAL},
+	{"wire", TOK_WIRE}, {"memory", TOK_MEMORY}, {"width", TOK_WIDTH}, {"upto", TOK_UPTO},
+	{"offset", TOK_OFFSET}, {"size", TOK_SIZE}, {"input", TOK_INPUT}, {"output", TOK_OUTPUT},
+	{"inout", TOK_INOUT}, {"cell", TOK_CELL}, {"connect", TOK_CONNECT}, {"switch", TOK_SWITCH},
+	{"case", TOK_CASE}, {"assign", TOK_ASSIGN}, {"sync", TOK_SYNC}, {"low", TOK_LOW},
+	{"high", TOK_HIGH}, {"posedge", TOK_POSEDGE}, {"negedge", TOK_NEGEDGE}, {"edge", TOK_EDGE},
+	{"always", TOK_ALWAYS}, {"global", TOK_GLOBAL}, {"init", TOK_INIT}, {"update", TOK_UPDATE},
+	{"memwr", TOK_MEMWR}, {"process", TOK_PROCESS}, {"end", TOK_END},
+};
+
+struct RTLILReader
+{
+	static constexpr size_t chunk_size = 1 << 16;
+
+	const char *ptr, *end;
+	int line = 1;
+
+	// when reading from a stream, [ptr, end) lies in buffer
+	std::istream *stream = nullptr;
+	std::vector<char> buffer;
+
+	// current token; for TOK_ID and TOK_VALUE the text is [tok_begin, tok_end)
+	TokenType tok;
+	const char *tok_begin, *tok_end;
+	int tok_int;
+	char tok_char;
+	std::string tok_string;
+
+	std::string id_buffer;
+
+	RTLIL::Module *current_module = nullptr;
+	dict<RTLIL::IdString, RTLIL::Const> attrbuf;
+
+	RTLILReader(const char *begin, const char *end) : ptr(begin), end(end)
+	{
+		next();
+	}
+
+	RTLILReader(std::istream *stream) : ptr(nullptr), end(nullptr), stream(stream)
+	{
+		next();
+	}
+
+	[[noreturn]] void error(const std::string &msg)
+	{
+		log_error("Parser error in line %d: %s\n", line, msg.c_str());
+	}
+
+	[[noreturn]] void syntax_error()
+	{
+		error("syntax error");
+	}
+
+	static bool is_space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	// Reads the next chunk of the stream. The text of the current token,
+	// starting at tok_begin, is moved to the front of the buffer first, so a
+	// token that crosses a chunk boundary stays in one piece.
+	bool refill()
+	{
+		if (stream == nullptr || !*stream)
+			return false;
+		size_t keep = end - tok_begin, offset = ptr - tok_begin;
+		if (keep > 0)
+			memmove(buffer.data(), tok_begin, keep);
+		if (buffer.size() < keep + chunk_size)
+			buffer.resize(keep + chunk_size);
+		stream->read(buffer.data() + keep, chunk_size);
+		size_t count = stream->gcount();
+		tok_begin = buffer.data();
+		ptr = tok_begin + offset;
+		end = tok_begin + keep + count;
+		return count > 0;
+	}
+
+	// true if at least n more characters are available after ptr
+	bool available(size_t n = 1)
+	{
+		while (size_t(end - ptr) < n)
+			if (!refill())
+				return false;
+		return true;
+	}
+
+	void next()
+	{
+		// nothing before tok_begin is kept across a refill
+		tok_begin = ptr;
+		while (available() && (*ptr == ' ' || *ptr == '\t'))
+			tok_begin = ++ptr;
+		if (available() && *ptr == '#')
+			while (available() && *ptr != '\n')
+				tok_begin = ++ptr;
+
+		if (!available()) {
+			tok = TOK_EOF;
+			return;
+		}
+
+		char c = *ptr;
+		if (c == '\r' || c == '\n') {
+			for (; available() && (*ptr == '\r' || *ptr == '\n'); ptr++)
+				if (*ptr == '\n')
+					line++;
+			tok = TOK_EOL;
+		} else if ('a' <= c && c <= 'z') {
+			while (available() && 'a' <= *ptr && *ptr <= 'z')
+				ptr++;
+			tok = TOK_INVALID;
+			size_t len = ptr - tok_begin;
+			for (auto &kw : keywords)
+				if (strlen(kw.first) == len && memcmp(kw.first, tok_begin, len) == 0) {
+					tok = kw.second;
+					break;
+				}
+		} else if ((c == '\\' || c == '$') && available(2) && !is_space(ptr[1])) {
+			ptr++;
+			while (available() && !is_space(*ptr))
+				ptr++;
+			tok = TOK_ID;
+		} else if (('0' <= c && c <= '9') || (c == '-' && available(2) && '0' <= ptr[1] && ptr[1] <= '9')) {
+			ptr++;
+			while (available() && '0' <= *ptr && *ptr <= '9')
+				ptr++;
+			if (c != '-' && available() && *ptr == '\'') {
+				ptr++;
+				if (available() && *ptr == 's')
+					ptr++;
+				while (available() && strchr("01xzm-", *ptr) && *ptr != 0)
+					ptr++;
+				tok = TOK_VALUE;
+			} else {
+				std::string digits(tok_begin, ptr);
+				errno = 0;
+				long value = strtol(digits.c_str(), nullptr, 10);
+				if (errno == ERANGE || value < INT_MIN || value > INT_MAX) {
+					tok = TOK_INVALID;
+				} else {
+					tok = TOK_INT;
+					tok_int = value;
+				}
+			}
+		} else if (c == '"') {
+			ptr++;
+			tok_string.clear();
+			while (1) {
+				if (!available())
+					error("unterminated string");
+				char ch = *ptr++;
+				if (ch == '"')
+					break;
+				if (ch == '\n')
+					line++;
+				if (ch == '\\' && available()) {
+					ch = *ptr++;
+					if (ch == 'n')
+						ch = '\n';
+					else if (ch == 't')
+						ch = '\t';
+					else if ('0' <= ch && ch <= '7') {
+						ch = ch - '0';
+						for (int i = 0; i < 2 && available() && '0' <= *ptr && *ptr <= '7'; i++)
+							ch = ch * 8 + *ptr++ - '0';
+					}
+				}
+				tok_string += ch;
+			}
+			tok = TOK_STRING;
+		} else {
+			ptr++;
+			tok = TOK_CHAR;
+			tok_char = c;
+		}
+		tok_end = ptr;
+	}
+
+	bool is_char(char c)
+	{
+		return tok == TOK_CHAR && tok_char == c;
+	}
+
+	void expect(TokenType type)
+	{
+		if (tok != type)
+			syntax_error();
+		next();
+	}
+
+	void expect_char(char c)
+	{
+		if (!is_char(c))
+			syntax_error();
+		next();
+	}
+
+	void expect_eol()
+	{
+		expect(TOK_EOL);
+		while (tok == TOK_EOL)
+			next();
+	}
+
+	int parse_int()
+	{
+		if (tok != TOK_INT)
+			syntax_error();
+		int value = tok_int;
+		next();
+		return value;
+	}
+
+	RTLIL::IdString parse_id()
+	{
+		if (tok != TOK_ID)
+			syntax_error();
+		id_buffer.assign(tok_begin, tok_end);
+		next();
+		return RTLIL::IdString(id_buffer);
+	}
+
+	bool at_constant()
+	{
+		return tok == TOK_VALUE || tok == TOK_INT || tok == TOK_STRING;
+	}
+
+	RTLIL::Const parse_constant()
+	{
+		RTLIL::Const value;
+		if (tok == TOK_VALUE) {
+			const char *p = tok_begin;
+			int width = 0;
+			while (p < tok_end && *p != '\'')
+				width = width * 10 + (*p++ - '0');
+			p++;
+			bool is_signed = false;
+			if (p < tok_end && *p == 's') {
+				is_signed = true;
+				p++;
+			}
+			std::vector<RTLIL::State> &bits = value.bits();
+			bits.reserve(std::max(width, 1));
+			for (const char *q = tok_end; q > p; ) {
+				switch (*--q) {
+				case '0': bits.push_back(RTLIL::S0); break;
+				case '1': bits.push_back(RTLIL::S1); break;
+				case 'z': bits.push_back(RTLIL::Sz); break;
+				case '-': bits.push_back(RTLIL::Sa); break;
+				case 'm': bits.push_back(RTLIL::Sm); break;
+				default: bits.push_back(RTLIL::Sx); break;
+				}
+			}
+			if (bits.empty())
+				bits.push_back(RTLIL::Sx);
+			RTLIL::State pad = bits.back() == RTLIL::S1 ? RTLIL::S0 : bits.back();
+			bits.resize(width, pad);
+			if (is_signed)
+				value.flags |= RTLIL::CONST_FLAG_SIGNED;
+		} else if (tok == TOK_INT) {
+			value = RTLIL::Const(tok_int, 32);
+		} else if (tok == TOK_STRING) {
+			value = RTLIL::Const(tok_string);
+		} else
+			syntax_error();
+		next();
+		return value;
+	}
+
+	RTLIL::SigSpec parse_sigspec()
+	{
+		RTLIL::SigSpec sig;
+
+		if (is_char('{')) {
+			next();
+			std::vector<RTLIL::SigSpec> parts;
+			while (!is_char('}'))
+				parts.push_back(parse_sigspec());
+			next();
+			for (auto it = parts.rbegin(); it != parts.rend(); it++)
+				sig.append(*it);
+		} else if (tok == TOK_ID) {
+			id_buffer.assign(tok_begin, tok_end);
+			RTLIL::Wire *wire = current_module->wire(id_buffer);
+			if (wire == nullptr)
+				error(stringf("RTLIL error: wire %s not found", id_buffer.c_str()));
+			next();
+			sig = RTLIL::SigSpec(wire);
+		} else if (at_constant()) {
+			sig = RTLIL::SigSpec(parse_constant());
+		} else
+			syntax_error();
+
+		while (is_char('[')) {
+			next();
+			int hi = parse_int();
+			if (is_char(']')) {
+				next();
+				if (hi >= sig.size() || hi < 0)
+					error("bit index out of range");
+				sig = sig.extract(hi);
+			} else {
+				expect_char(':');
+				int lo = parse_int();
+				expect_char(']');
+				if (hi >= sig.size() || hi < 0 || hi < lo)
+					error("invalid slice");
+				sig = sig.extract(lo, hi - lo + 1);
+			}
+		}
+
+		return sig;
+	}
+
+	void check_dangling_attributes()
+	{
+		if (attrbuf.size() != 0)
+			error("dangling attribute");
+	}
+
+	void parse_attribute()
+	{
+		expect(TOK_ATTRIBUTE);
+		RTLIL::IdString name = parse_id();
+		attrbuf[name] = parse_constant();
+		expect_eol();
+	}
+
+	void parse_autoidx()
+	{
+		expect(TOK_AUTOIDX);
+		int value = parse_int();
+		autoidx = max(int(autoidx), value);
+		expect_eol();
+	}
+
+	void parse_module()
+	{
+		expect(TOK_MODULE);
+		RTLIL::IdString name = parse_id();
+		expect_eol();
+
+		bool delete_current_module = false;
+		if (current_design->has(name)) {
+			RTLIL::Module *existing_mod = current_design->module(name);
+			if (!flag_overwrite && (flag_lib || (attrbuf.count(ID::blackbox) && attrbuf.at(ID::blackbox).as_bool()))) {
+				log("Ignoring blackbox re-definition of module %s.\n", name.c_str());
+				delete_current_module = true;
+			} else if (!flag_nooverwrite && !flag_overwrite && !existing_mod->get_bool_attribute(ID::blackbox)) {
+				error(stringf("RTLIL error: redefinition of module %s.", name.c_str()));
+			} else if (flag_nooverwrite) {
+				log("Ignoring re-definition of module %s.\n", name.c_str());
+				delete_current_module = true;
+			} else {
+				log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute(ID::blackbox) ? " blackbox" : "", name.c_str());
+				current_design->remove(existing_mod);
+			}
+		}
+
+		current_module = new RTLIL::Module;
+		current_module->name = name;
+		current_module->attributes = std::move(attrbuf);
+		attrbuf.clear();
+		if (!delete_current_module)
+			current_design->add(current_module);
+
+		while (1) {
+			switch (tok) {
+			case TOK_PARAMETER: parse_module_parameter(); continue;
+			case TOK_ATTRIBUTE: parse_attribute(); continue;
+			case TOK_WIRE: parse_wire(); continue;
+			case TOK_MEMORY: parse_memory(); continue;
+			case TOK_CELL: parse_cell(); continue;
+			case TOK_PROCESS: parse_process(); continue;
+			case TOK_CONNECT: parse_connect(); continue;
+			case TOK_END: break;
+			default: syntax_error();
+			}
+			break;
+		}
+		next();
+
+		check_dangling_attributes();
+		current_module->fixup_ports();
+		if (delete_current_module)
+			delete current_module;
+		else if (flag_lib)
+			current_module->makeblackbox();
+		current_module = nullptr;
+		expect_eol();
+	}
+
+	void parse_module_parameter()
+	{
+		expect(TOK_PARAMETER);
+		RTLIL::IdString name = parse_id();
+		current_module->avail_parameters(name);
+		if (tok != TOK_EOL)
+			current_module->parameter_default_values[name] = parse_constant();
+		expect_eol();
+	}
+
+	void parse_wire()
+	{
+		expect(TOK_WIRE);
+		dict<RTLIL::IdString, RTLIL::Const> attributes = std::move(attrbuf);
+		attrbuf.clear();
+
+		int width = 1, start_offset = 0, port_id = 0;
+		bool upto = false, is_signed = false, port_input = false, port_output = false;
+		while (tok != TOK_ID) {
+			switch (tok) {
+			case TOK_WIDTH:
+				next();
+				if (tok == TOK_INVALID)
+					error("RTLIL error: invalid wire width");
+				width = parse_int();
+				break;
+			case TOK_UPTO:
+				next();
+				upto = true;
+				break;
+			case TOK_SIGNED:
+				next();
+				is_signed = true;
+				break;
+			case TOK_OFFSET:
+				next();
+				start_offset = parse_int();
+				break;
+			case TOK_INPUT:
+			case TOK_OUTPUT:
+			case TOK_INOUT:
+				port_input = tok != TOK_OUTPUT;
+				port_output = tok != TOK_INPUT;
+				next();
+				port_id = parse_int();
+				break;
+			default:
+				syntax_error();
+			}
+		}
+
+		RTLIL::IdString name = parse_id();
+		if (current_module->wire(name) != nullptr)
+			error(stringf("RTLIL error: redefinition of wire %s.", name.c_str()));
+		RTLIL::Wire *wire = current_module->addWire(name);
+		wire->attributes = std::move(attributes);
+		wire->width = width;
+		wire->start_offset = start_offset;
+		wire->upto = upto;
+		wire->is_signed = is_signed;
+		wire->port_id = port_id;
+		wire->port_input = port_input;
+		wire->port_output = port_output;
+		expect_eol();
+	}
+
+	void parse_memory()
+	{
+		expect(TOK_MEMORY);
+		RTLIL::Memory *memory = new RTLIL::Memory;
+		memory->attributes = std::move(attrbuf);
+		attrbuf.clear();
+
+		while (tok != TOK_ID) {
+			TokenType option = tok;
+			if (option != TOK_WIDTH && option != TOK_SIZE && option != TOK_OFFSET) {
+				delete memory;
+				syntax_error();
+			}
+			next();
+			int value = parse_int();
+			if (option == TOK_WIDTH)
+				memory->width = value;
+			else if (option == TOK_SIZE)
+				memory->size = value;
+			else
+				memory->start_offset = value;
+		}
+
+		RTLIL::IdString name = parse_id();
+		if (current_module->memories.count(name) != 0) {
+			delete memory;
+			error(stringf("RTLIL error: redefinition of memory %s.", name.c_str()));
+		}
+		memory->name = name;
+		current_module->memories[name] = memory;
+		expect_eol();
+	}
+
+	void parse_cell()
+	{
+		expect(TOK_CELL);
+		RTLIL::IdString type = parse_id();
+		RTLIL::IdString name = parse_id();
+		expect_eol();
+
+		if (current_module->cell(name) != nullptr)
+			error(stringf("RTLIL error: redefinition of cell %s.", name.c_str()));
+		RTLIL::Cell *cell = current_module->addCell(name, type);
+		cell->attributes = std::move(attrbuf);
+		attrbuf.clear();
+
+		while (tok != TOK_END) {
+			if (tok == TOK_PARAMETER) {
+				next();
+				int flags = RTLIL::CONST_FLAG_NONE;
+				if (tok == TOK_SIGNED) {
+					flags = RTLIL::CONST_FLAG_SIGNED;
+					next();
+				} else if (tok == TOK_REAL) {
+					flags = RTLIL::CONST_FLAG_REAL;
+					next();
+				}
+				RTLIL::IdString param = parse_id();
+				RTLIL::Const &value = cell->parameters[param];
+				value = parse_constant();
+				value.flags |= flags;
+			} else if (tok == TOK_CONNECT) {
+				next();
+				RTLIL::IdString port = parse_id();
+				if (cell->hasPort(port))
+					error(stringf("RTLIL error: redefinition of cell port %s.", port.c_str()));
+				cell->setPort(port, parse_sigspec());
+			} else
+				syntax_error();
+			expect_eol();
+		}
+		next();
+		expect_eol();
+	}
+
+	void parse_case_body(RTLIL::CaseRule *rule)
+	{
+		while (1) {
+			if (tok == TOK_ATTRIBUTE) {
+				parse_attribute();
+			} else if (tok == TOK_SWITCH) {
+				parse_switch(rule->switches);
+			} else if (tok == TOK_ASSIGN) {
+				next();
+				check_dangling_attributes();
+				RTLIL::SigSpec lhs = parse_sigspec();
+				RTLIL::SigSpec rhs = parse_sigspec();
+				rule->actions.push_back(RTLIL::SigSig(std::move(lhs), std::move(rhs)));
+				expect_eol();
+			} else
+				break;
+		}
+	}
+
+	void parse_switch(std::vector<RTLIL::SwitchRule*> &switches)
+	{
+		expect(TOK_SWITCH);
+		RTLIL::SwitchRule *rule = new RTLIL::SwitchRule;
+		switches.push_back(rule);
+		rule->signal = parse_sigspec();
+		expect_eol();
+		rule->attributes = std::move(attrbuf);
+		attrbuf.clear();
+
+		while (tok == TOK_ATTRIBUTE)
+			parse_attribute();
+
+		while (tok == TOK_CASE) {
+			next();
+			RTLIL::CaseRule *case_rule = new RTLIL::CaseRule;
+			rule->cases.push_back(case_rule);
+			case_rule->attributes = std::move(attrbuf);
+			attrbuf.clear();
+			if (tok != TOK_EOL) {
+				case_rule->compare.push_back(parse_sigspec());
+				while (is_char(',')) {
+					next();
+					case_rule->compare.push_back(parse_sigspec());
+				}
+			}
+			expect_eol();
+			parse_case_body(case_rule);
+		}
+
+		expect(TOK_END);
+		expect_eol();
+	}
+
+	void parse_process()
+	{
+		expect(TOK_PROCESS);
+		RTLIL::IdString name = parse_id();
+		expect_eol();
+
+		if (current_module->processes.count(name) != 0)
+			error(stringf("RTLIL error: redefinition of process %s.", name.c_str()));
+		RTLIL::Process *process = current_module->addProcess(name);
+		process->attributes = std::move(attrbuf);
+		attrbuf.clear();
+
+		parse_case_body(&process->root_case);
+
+		while (tok == TOK_SYNC) {
+			next();
+			RTLIL::SyncRule *rule = new RTLIL::SyncRule;
+			process->syncs.push_back(rule);
+			switch (tok) {
+			case TOK_LOW: rule->type = RTLIL::ST0; break;
+			case TOK_HIGH: rule->type = RTLIL::ST1; break;
+			case TOK_POSEDGE: rule->type = RTLIL::STp; break;
+			case TOK_NEGEDGE: rule->type = RTLIL::STn; break;
+			case TOK_EDGE: rule->type = RTLIL::STe; break;
+			case TOK_ALWAYS: rule->type = RTLIL::STa; break;
+			case TOK_GLOBAL: rule->type = RTLIL::STg; break;
+			case TOK_INIT: rule->type = RTLIL::STi; break;
+			default: syntax_error();
+			}
+			bool has_signal = tok != TOK_ALWAYS && tok != TOK_GLOBAL && tok != TOK_INIT;
+			next();
+			if (has_signal)
+				rule->signal = parse_sigspec();
+			expect_eol();
+
+			while (1) {
+				if (tok == TOK_UPDATE) {
+					next();
+					RTLIL::SigSpec lhs = parse_sigspec();
+					RTLIL::SigSpec rhs = parse_sigspec();
+					rule->actions.push_back(RTLIL::SigSig(std::move(lhs), std::move(rhs)));
+					expect_eol();
+					continue;
+				}
+				if (tok != TOK_ATTRIBUTE && tok != TOK_MEMWR)
+					break;
+				while (tok == TOK_ATTRIBUTE)
+					parse_attribute();
+				expect(TOK_MEMWR);
+				RTLIL::MemWriteAction act;
+				act.attributes = std::move(attrbuf);
+				attrbuf.clear();
+				act.memid = parse_id();
+				act.address = parse_sigspec();
+				act.data = parse_sigspec();
+				act.enable = parse_sigspec();
+				act.priority_mask = parse_constant();
+				rule->mem_write_actions.push_back(std::move(act));
+				expect_eol();
+			}
+		}
+
+		expect(TOK_END);
+		expect_eol();
+	}
+
+	void parse_connect()
+	{
+		expect(TOK_CONNECT);
+		check_dangling_attributes();
+		RTLIL::SigSpec lhs = parse_sigspec();
+		RTLIL::SigSpec rhs = parse_sigspec();
+		current_module->connect(lhs, rhs);
+		expect_eol();
+	}
+
+	void parse_design()
+	{
+		while (tok == TOK_EOL)
+			next();
+
+		while (tok != TOK_EOF) {
+			if (tok == TOK_MODULE)
+				parse_module();
+			else if (tok == TOK_ATTRIBUTE)
+				parse_attribute();
+			else if (tok == TOK_AUTOIDX)
+				parse_autoidx();
+			else
+				syntax_error();
+		}
+
+		check_dangling_attributes();
+	}
+};
+
+}
+
+void read_rtlil_buffer(const char *data, size_t size)
+{
+	RTLILReader reader(data, data + size);
+	reader.parse_design();
+}
+
+void read_rtlil_stream(std::istream *f, const std::string &filename)
+{
+#ifdef RTLIL_READER_MMAP
+	// Map plain files directly, everything else (gzip input, here documents,
+	// stdin) is read in chunks.
+	if (dynamic_cast<std::ifstream*>(f) != nullptr) {
+		int fd = open(filename.c_str(), O_RDONLY);
+		struct stat st;
+		if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+			void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				close(fd);
+				madvise(data, st.st_size, MADV_SEQUENTIAL);
+				try {
+					read_rtlil_buffer((const char*)data, st.st_size);
+				} catch (...) {
+					munmap(data, st.st_size);
+					throw;
+				}
+				munmap(data, st.st_size);
+				return;
+			}
+		}
+		if (fd >= 0)
+			close(fd);
+	}
+#else
+	(void)filename;
+#endif
+	RTLILReader reader(f);
+	reader.parse_design();
+}
+
+}
+
+YOSYS_NAMESPACE_END
@@ -97,6 +97,194 @@ static RTLIL::Const big2const(const BigInteger &val, int result_len, int undef_b
 	return result;
 }
 
+// Word-parallel implementations of the cheap operators, working on the
+// two-plane form of RTLIL::Const::Packed. They return false if an operand
+// contains Sa or Sm bits or if use_packed() says the operands are too small,
+// in which case the bit-by-bit code is used instead.
+
+using Packed = RTLIL::Const::Packed;
+
+static uint64_t fill_word(int plane_bit)
+{
+	return plane_bit ? ~uint64_t(0) : 0;
+}
+
+// resizes `p` to `width` bits, filling new bits with the MSB if `is_signed`
+// and with zero otherwise (like extend_u0)
+static void packed_extend(Packed &p, int width, bool is_signed)
+{
+	RTLIL::State padding = is_signed && p.width > 0 ? p.get(p.width - 1) : RTLIL::State::S0;
+	int old_width = p.width;
+	p.words.resize(2 * ((width + 63) / 64));
+	p.width = width;
+
+	for (int i = old_width / 64; width > old_width && i < p.num_words(); i++) {
+		uint64_t m = i * 64 < old_width ? ~uint64_t(0) << (old_width % 64) : ~uint64_t(0);
+		p.val(i) |= fill_word(padding & 1) & m;
+		p.unk(i) |= fill_word(padding & 2) & m;
+	}
+
+	if (p.num_words() > 0) {
+		uint64_t m = p.mask(p.num_words() - 1);
+		p.val(p.num_words() - 1) &= m;
+		p.unk(p.num_words() - 1) &= m;
+	}
+}
+
+// Converting small operands to the packed form, and the packed result back to
+// bits once the caller looks at them, costs more than the bit-by-bit code saves.
+// So the packed code is only used when an operand is packed already, or when an
+// operand or the result is wide.
+static bool use_packed(const RTLIL::Const &arg1, const RTLIL::Const &arg2, int result_len)
+{
+	if (arg1.has_packed_backing() || arg2.has_packed_backing())
+		return true;
+	return max(max(GetSize(arg1), GetSize(arg2)), result_len) > RTLIL::Const::packed_threshold;
+}
+
+static bool pack_ext(const RTLIL::Const &arg, int width, bool is_signed, Packed &p)
+{
+	if (!arg.to_packed(p))
+		return false;
+	packed_extend(p, width, is_signed);
+	return true;
+}
+
+static bool packed_has_undef(const Packed &p)
+{
+	for (int i = 0; i < p.num_words(); i++)
+		if (p.unk(i))
+			return true;
+	return false;
+}
+
+// sets word i of `p` from the masks of bits known to be 1 and known to be 0,
+// all other bits become x
+static void set_word(Packed &p, int i, uint64_t y1, uint64_t y0)
+{
+	uint64_t m = p.mask(i);
+	p.val(i) = y1 & m;
+	p.unk(i) = ~(y1 | y0) & m;
+}
+
+// `func(a1, a0, b1, b0, y1, y0)` maps the masks of known 1 and known 0 bits
+// of both operands to those of the result
+template<typename F>
+static bool packed_logic(F func, const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, RTLIL::Const &result)
+{
+	if (result_len < 0)
+		result_len = max(arg1.size(), arg2.size());
+
+	if (!use_packed(arg1, arg2, result_len))
+		return false;
+
+	Packed a, b;
+	if (!pack_ext(arg1, result_len, signed1, a) || !pack_ext(arg2, result_len, signed2, b))
+		return false;
+
+	Packed y(result_len);
+	for (int i = 0; i < y.num_words(); i++) {
+		uint64_t y1, y0;
+		func(a.val(i) & ~a.unk(i), ~a.val(i) & ~a.unk(i), b.val(i) & ~b.unk(i), ~b.val(i) & ~b.unk(i), y1, y0);
+		set_word(y, i, y1, y0);
+	}
+
+	result = RTLIL::Const(std::move(y));
+	return true;
+}
+
+// computes arg1 + arg2 (or arg1 - arg2) modulo 2^result_len, with an all-x
+// result if any operand bit is undefined
+static bool packed_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, bool subtract, RTLIL::Const &result)
+{
+	if (result_len < 0)
+		result_len = max(arg1.size(), arg2.size());
+
+	if (!use_packed(arg1, arg2, result_len))
+		return false;
+
+	Packed a, b;
+	if (!arg1.to_packed(a) || !arg2.to_packed(b))
+		return false;
+
+	if (packed_has_undef(a) || packed_has_undef(b)) {
+		result = RTLIL::Const(RTLIL::State::Sx, result_len);
+		return true;
+	}
+
+	packed_extend(a, result_len, signed1);
+	packed_extend(b, result_len, signed2);
+
+	Packed y(result_len);
+	uint64_t carry = subtract ? 1 : 0;
+	for (int i = 0; i < y.num_words(); i++) {
+		uint64_t x = a.val(i), z = subtract ? ~b.val(i) : b.val(i);
+		uint64_t sum = x + z;
+		uint64_t sum_carry = sum + carry;
+		carry = (sum < x) | (sum_carry < sum);
+		y.val(i) = sum_carry & y.mask(i);
+	}
+
+	result = RTLIL::Const(std::move(y));
+	return true;
+}
+
+// sets `cmp` to -1, 0 or 1 if arg1 is less than, equal to or greater than
+// arg2, or sets `undef_bit_pos` if any operand bit is undefined
+static bool packed_compare(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int &cmp, int &undef_bit_pos)
+{
+	if (!use_packed(arg1, arg2, 0))
+		return false;
+
+	Packed a, b;
+	if (!arg1.to_packed(a) || !arg2.to_packed(b))
+		return false;
+
+	cmp = 0;
+	if (packed_has_undef(a) || packed_has_undef(b)) {
+		undef_bit_pos = 0;
+		return true;
+	}
+
+	// one extra bit so that both operands can be compared as signed numbers
+	int width = max(a.width, b.width) + 1;
+	packed_extend(a, width, signed1);
+	packed_extend(b, width, signed2);
+
+	int top = (width - 1) / 64;
+	uint64_t sign = uint64_t(1) << ((width - 1) % 64);
+	for (int i = a.num_words() - 1; i >= 0; i--) {
+		uint64_t x = a.val(i), z = b.val(i);
+		if (i == top)
+			x ^= sign, z ^= sign;
+		if (x != z) {
+			cmp = x < z ? -1 : 1;
+			break;
+		}
+	}
+	return true;
+}
+
+// returns the bits [pos, pos+63] of one plane of `p`, where bits below zero
+// are taken from `below` and bits at or above the width of `p` from `above`
+static uint64_t packed_window(const Packed &p, int plane, long long pos, uint64_t below, uint64_t above)
+{
+	auto word = [&](long long w) -> uint64_t {
+		if (w < 0)
+			return below;
+		if (w >= p.num_words())
+			return above;
+		uint64_t m = p.mask(w);
+		return (p.words[2*w + plane] & m) | (above & ~m);
+	};
+
+	long long w = pos >= 0 ? pos / 64 : -((-pos + 63) / 64);
+	int shift = pos - w * 64;
+	if (shift == 0)
+		return word(w);
+	return (word(w) >> shift) | (word(w + 1) << (64 - shift));
+}
+
 static RTLIL::State logic_and(RTLIL::State a, RTLIL::State b)
 {
 	if (a == RTLIL::State::S0) return RTLIL::State::S0;
@@ -134,6 +322,14 @@ RTLIL::Const RTLIL::const_not(const RTLIL::Const &arg1, const RTLIL::Const&, boo
 	if (result_len < 0)
 		result_len = arg1.size();
 
+	Packed a;
+	if (use_packed(arg1, arg1, result_len) && pack_ext(arg1, result_len, signed1, a)) {
+		Packed y(result_len);
+		for (int i = 0; i < y.num_words(); i++)
+			set_word(y, i, ~a.val(i) & ~a.unk(i), a.val(i) & ~a.unk(i));
+		return RTLIL::Const(std::move(y));
+	}
+
 	RTLIL::Const arg1_ext = arg1;
 	extend_u0(arg1_ext, result_len, signed1);
 
@@ -171,21 +367,47 @@ static RTLIL::Const logic_wrapper(RTLIL::State(*logic_func)(RTLIL::State, RTLIL:
 
 RTLIL::Const RTLIL::const_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	auto func = [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t &y1, uint64_t &y0) {
+		y1 = a1 & b1, y0 = a0 | b0;
+	};
+	if (packed_logic(func, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
 	return logic_wrapper(logic_and, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	auto func = [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t &y1, uint64_t &y0) {
+		y1 = a1 | b1, y0 = a0 & b0;
+	};
+	if (packed_logic(func, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
 	return logic_wrapper(logic_or, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	auto func = [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t &y1, uint64_t &y0) {
+		uint64_t def = (a1 | a0) & (b1 | b0);
+		y1 = (a1 ^ b1) & def, y0 = ~(a1 ^ b1) & def;
+	};
+	if (packed_logic(func, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
 	return logic_wrapper(logic_xor, arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xnor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	auto func = [](uint64_t a1, uint64_t a0, uint64_t b1, uint64_t b0, uint64_t &y1, uint64_t &y0) {
+		uint64_t def = (a1 | a0) & (b1 | b0);
+		y1 = ~(a1 ^ b1) & def, y0 = (a1 ^ b1) & def;
+	};
+	if (packed_logic(func, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
 	return logic_wrapper(logic_xnor, arg1, arg2, signed1, signed2, result_len);
 }
 
@@ -292,6 +514,21 @@ static RTLIL::Const const_shift_worker(const RTLIL::Const &arg1, const RTLIL::Co
 	if (undef_bit_pos >= 0)
 		return result;
 
+	Packed a;
+	if (use_packed(arg1, arg1, result_len) && arg1.to_packed(a)) {
+		// beyond these bounds all result bits are padding
+		BigInteger min_offset = BigInteger(-result_len - 1), max_offset = BigInteger(a.width + 1);
+		long long off = offset < min_offset ? min_offset.toInt() : offset > max_offset ? max_offset.toInt() : offset.toInt();
+		RTLIL::State above = sign_ext && a.width > 0 ? a.get(a.width - 1) : vacant_bits;
+		Packed y(result_len);
+		for (int i = 0; i < y.num_words(); i++) {
+			long long pos = off + 64 * (long long)i;
+			y.val(i) = packed_window(a, 0, pos, fill_word(vacant_bits & 1), fill_word(above & 1)) & y.mask(i);
+			y.unk(i) = packed_window(a, 1, pos, fill_word(vacant_bits & 2), fill_word(above & 2)) & y.mask(i);
+		}
+		return RTLIL::Const(std::move(y));
+	}
+
 	for (int i = 0; i < result_len; i++) {
 		BigInteger pos = BigInteger(i) + offset;
 		if (pos < 0)
@@ -343,8 +580,12 @@ RTLIL::Const RTLIL::const_shiftx(const RTLIL::Const &arg1, const RTLIL::Const &a
 
 RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
+	int undef_bit_pos = -1, cmp;
+	bool y;
+	if (packed_compare(arg1, arg2, signed1, signed2, cmp, undef_bit_pos))
+		y = cmp < 0;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.size()) < result_len)
@@ -354,8 +595,12 @@ RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_le(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
+	int undef_bit_pos = -1, cmp;
+	bool y;
+	if (packed_compare(arg1, arg2, signed1, signed2, cmp, undef_bit_pos))
+		y = cmp <= 0;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.size()) < result_len)
@@ -370,6 +615,20 @@ RTLIL::Const RTLIL::const_eq(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 	RTLIL::Const result(RTLIL::State::S0, result_len);
 
 	int width = max(arg1_ext.size(), arg2_ext.size());
+
+	Packed a, b;
+	if (use_packed(arg1, arg2, 0) && pack_ext(arg1, width, signed1 && signed2, a) && pack_ext(arg2, width, signed1 && signed2, b)) {
+		RTLIL::State matched_status = RTLIL::State::S1;
+		for (int i = 0; i < a.num_words(); i++) {
+			if ((a.val(i) ^ b.val(i)) & ~a.unk(i) & ~b.unk(i))
+				return result;
+			if (a.unk(i) | b.unk(i))
+				matched_status = RTLIL::State::Sx;
+		}
+		result.bits().front() = matched_status;
+		return result;
+	}
+
 	extend_u0(arg1_ext, width, signed1 && signed2);
 	extend_u0(arg2_ext, width, signed1 && signed2);
 
@@ -404,6 +663,15 @@ RTLIL::Const RTLIL::const_eqx(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 	RTLIL::Const result(RTLIL::State::S0, result_len);
 
 	int width = max(arg1_ext.size(), arg2_ext.size());
+
+	Packed a, b;
+	if (use_packed(arg1, arg2, 0) && pack_ext(arg1, width, signed1 && signed2, a) && pack_ext(arg2, width, signed1 && signed2, b)) {
+		if (a.words != b.words)
+			return result;
+		result.bits().front() = RTLIL::State::S1;
+		return result;
+	}
+
 	extend_u0(arg1_ext, width, signed1 && signed2);
 	extend_u0(arg2_ext, width, signed1 && signed2);
 
@@ -428,8 +696,12 @@ RTLIL::Const RTLIL::const_nex(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
+	int undef_bit_pos = -1, cmp;
+	bool y;
+	if (packed_compare(arg1, arg2, signed1, signed2, cmp, undef_bit_pos))
+		y = cmp >= 0;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.size()) < result_len)
@@ -439,8 +711,12 @@ RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
+	int undef_bit_pos = -1, cmp;
+	bool y;
+	if (packed_compare(arg1, arg2, signed1, signed2, cmp, undef_bit_pos))
+		y = cmp > 0;
+	else
+		y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
 	RTLIL::Const result(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
 
 	while (int(result.size()) < result_len)
@@ -450,6 +726,10 @@ RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2,
 
 RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (packed_add(arg1, arg2, signed1, signed2, result_len, false, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) + const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.size(), arg2.size()), undef_bit_pos);
@@ -457,6 +737,10 @@ RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (packed_add(arg1, arg2, signed1, signed2, result_len, true, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) - const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : max(arg1.size(), arg2.size()), undef_bit_pos);
@@ -18,6 +18,7 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/threading.h"
 #include "libs/sha1/sha1.h"
 #include "libs/cxxopts/include/cxxopts.hpp"
 #include <iostream>
@@ -232,6 +233,8 @@ int main(int argc, char **argv)
 			cxxopts::value<std::vector<std::string>>(), "<plugin>")
 		("D,define", "set the specified Verilog define to <value> if supplied via command \"read -define\"",
 			cxxopts::value<std::vector<std::string>>(), "<define>[=<value>]")
+		("j,jobs", "use up to <N> threads for passes that can process modules in parallel",
+			cxxopts::value<int>(), "<N>")
 		("S,synth", "shortcut for calling the \"synth\" command, a default script for transforming " \
 					"the Verilog input to a gate-level netlist. For example: " \
 					"yosys -o output.blif -S input.v " \
@@ -367,6 +370,7 @@ int main(int argc, char **argv)
 			log_verbose_level = result["v"].as<int>();
 		}
 		if (result.count("t")) log_time = true;
+		if (result.count("j")) yosys_jobs = std::max(1, result["j"].as<int>());
 		if (result.count("d")) timing_details = true;
 		for (const auto& key : {"s", "c"}) {
 			if (result.count(key)) {
@@ -90,19 +90,30 @@ static void normalize_brackets(std::string &str)
 
 fstHandle FstData::getHandle(std::string name) { 
 	normalize_brackets(name);
-	if (name_to_handle.find(name) != name_to_handle.end())
+	if (name_to_handle.find(name) != name_to_handle.end()) {
+		watched_handles.insert(name_to_handle[name]);
 		return name_to_handle[name];
-	else 
+	} else 
 		return 0;
 };
 
 dict<int,fstHandle> FstData::getMemoryHandles(std::string name) { 
-	if (memory_to_handle.find(name) != memory_to_handle.end())
+	if (memory_to_handle.find(name) != memory_to_handle.end()) {
+		for (auto &it : memory_to_handle[name])
+			watched_handles.insert(it.second);
 		return memory_to_handle[name];
-	else 
+	} else 
 		return dict<int,fstHandle>();
 };
 
+void FstData::watchScope(std::string scope)
+{
+	normalize_brackets(scope);
+	for (auto &var : vars)
+		if (var.scope == scope || var.scope.compare(0, scope.size()+1, scope+".") == 0)
+			watched_handles.insert(var.id);
+}
+
 static std::string remove_spaces(std::string str)
 {
 	str.erase(std::remove(str.begin(), str.end(), ' '), str.end());
@@ -245,8 +256,19 @@ void FstData::reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t sta
 	past_time = start_time;
 	all_samples = clk_signals.empty();
 
-	fstReaderSetUnlimitedTimeRange(ctx);
-	fstReaderSetFacProcessMaskAll(ctx);
+	// Only decode the blocks overlapping the requested time range (the first
+	// of them starts with a full frame, so the values at start are still known)
+	// and only the signals that were asked for.
+	fstReaderSetLimitTimeRange(ctx, start, end);
+	if (watched_handles.empty()) {
+		fstReaderSetFacProcessMaskAll(ctx);
+	} else {
+		fstReaderClrFacProcessMaskAll(ctx);
+		for (auto handle : watched_handles)
+			fstReaderSetFacProcessMask(ctx, handle);
+		for (auto handle : clk_signals)
+			fstReaderSetFacProcessMask(ctx, handle);
+	}
 	fstReaderIterBlocks2(ctx, reconstruct_clb_attimes, reconstruct_clb_varlen_attimes, this, nullptr);
 	if (last_time!=end_time) {
 		past_data = last_data;
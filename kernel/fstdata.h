@@ -53,8 +53,13 @@ class FstData
 	void reconstructAllAtTimes(std::vector<fstHandle> &signal, uint64_t start_time, uint64_t end_time, CallbackFunction cb);
 
 	std::string valueOf(fstHandle signal);
+	// Only the values of handles returned by getHandle() or getMemoryHandles(),
+	// of the vars in scopes passed to watchScope() and of the clock signals are
+	// decoded by reconstructAllAtTimes(). When nothing was requested, all
+	// values are decoded.
 	fstHandle getHandle(std::string name);
 	dict<int,fstHandle> getMemoryHandles(std::string name);
+	void watchScope(std::string scope);
 	double getTimescale() { return timescale; }
 	const char *getTimescaleString() { return timescale_str.c_str(); }
 private:
@@ -65,6 +70,7 @@ private:
 	std::map<fstHandle, FstVar> handle_to_var;
 	std::map<std::string, fstHandle> name_to_handle;
 	std::map<std::string, dict<int, fstHandle>> memory_to_handle;
+	std::set<fstHandle> watched_handles;
 	std::map<fstHandle, std::string> last_data;
 	uint64_t last_time;
 	std::map<fstHandle, std::string> past_data;
@@ -61,14 +61,15 @@ string log_last_error;
 void (*log_error_atexit)() = NULL;
 void (*log_verific_callback)(int msg_type, const char *message_id, const char* file_path, unsigned int left_line, unsigned int left_col, unsigned int right_line, unsigned int right_col, const char *msg) = NULL;
 
-int log_make_debug = 0;
+thread_local int log_make_debug = 0;
 int log_force_debug = 0;
-int log_debug_suppressed = 0;
+thread_local int log_debug_suppressed = 0;
+thread_local LogCapture *log_capture = nullptr;
 
 vector<int> header_count;
-vector<char*> log_id_cache;
-vector<shared_str> string_buf;
-int string_buf_index = -1;
+thread_local vector<char*> log_id_cache;
+thread_local vector<shared_str> string_buf;
+thread_local int string_buf_index = -1;
 
 static struct timeval initial_tv = { 0, 0 };
 static bool next_print_log = false;
@@ -116,6 +117,13 @@ void logv(const char *format, va_list ap)
 	if (str.empty())
 		return;
 
+	if (log_capture != nullptr) {
+		if (log_capture->items.empty() || log_capture->items.back().kind != LogCapture::TEXT)
+			log_capture->items.push_back({LogCapture::TEXT, {}, {}});
+		log_capture->items.back().text += str;
+		return;
+	}
+
 	size_t nnl_pos = str.find_last_not_of('\n');
 	if (nnl_pos == std::string::npos)
 		log_newline_count += GetSize(str);
@@ -248,6 +256,11 @@ static void logv_warning_with_prefix(const char *prefix,
 	std::string message = vstringf(format, ap);
 	bool suppressed = false;
 
+	if (log_capture != nullptr) {
+		log_capture->items.push_back({LogCapture::WARNING, prefix, message});
+		return;
+	}
+
 	for (auto &re : log_nowarn_regexes)
 		if (std::regex_search(message, re))
 			suppressed = true;
@@ -298,6 +311,14 @@ static void logv_warning_with_prefix(const char *prefix,
 	}
 }
 
+static void log_warning_with_prefix(const char *prefix, const char *format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	logv_warning_with_prefix(prefix, format, ap);
+	va_end(ap);
+}
+
 void logv_warning(const char *format, va_list ap)
 {
 	logv_warning_with_prefix("Warning: ", format, ap);
@@ -336,6 +357,18 @@ static void logv_error_with_prefix(const char *prefix,
 {
 #ifdef EMSCRIPTEN
 	auto backup_log_files = log_files;
+#endif
+#ifdef YOSYS_ENABLE_THREADS
+	// On a worker thread, write out everything it has logged so far before
+	// the error message. The lock is never released, as we are about to exit.
+	static std::mutex error_mutex;
+	std::unique_lock<std::mutex> error_lock(error_mutex, std::defer_lock);
+	if (log_capture != nullptr) {
+		error_lock.lock();
+		LogCapture *capture = log_capture;
+		log_capture = nullptr;
+		capture->replay();
+	}
 #endif
 	int bak_log_make_debug = log_make_debug;
 	log_make_debug = 0;
@@ -463,7 +496,7 @@ void log_cmd_error(const char *format, ...)
 		// Make sure the error message gets through any selective silencing
 		// of log output
 		bool pop_errfile = false;
-		if (log_errfile != NULL) {
+		if (log_errfile != NULL && log_capture == nullptr) {
 			log_files.push_back(log_errfile);
 			pop_errfile = true;
 		}
@@ -482,6 +515,11 @@ void log_cmd_error(const char *format, ...)
 
 void log_spacer()
 {
+	if (log_capture != nullptr) {
+		log_capture->items.push_back({LogCapture::SPACER, {}, {}});
+		return;
+	}
+
 	if (log_newline_count < 2) log("\n");
 	if (log_newline_count < 2) log("\n");
 }
@@ -607,6 +645,38 @@ void log_reset_stack()
 	log_flush();
 }
 
+void log_free_thread_caches()
+{
+	log_id_cache_clear();
+	string_buf.clear();
+	string_buf_index = -1;
+}
+
+void LogCapture::replay()
+{
+	int bak_log_make_debug = log_make_debug;
+	log_make_debug = 0;
+
+	for (auto &item : items)
+		switch (item.kind) {
+		case TEXT:
+			log("%s", item.text.c_str());
+			break;
+		case WARNING:
+			log_warning_with_prefix(item.prefix.c_str(), "%s", item.text.c_str());
+			break;
+		case SPACER:
+			log_spacer();
+			break;
+		}
+
+	log_make_debug = bak_log_make_debug;
+	log_debug_suppressed += debug_suppressed;
+
+	items.clear();
+	debug_suppressed = 0;
+}
+
 void log_flush()
 {
 	for (auto f : log_files)
@@ -115,9 +115,28 @@ extern int log_verbose_level;
 extern string log_last_error;
 extern void (*log_error_atexit)();
 
-extern int log_make_debug;
+extern thread_local int log_make_debug;
 extern int log_force_debug;
-extern int log_debug_suppressed;
+extern thread_local int log_debug_suppressed;
+
+// Log output of worker threads started by parallel_for() (kernel/threading.h)
+// is recorded in a LogCapture instead of being written out, so that it can be
+// replayed on the main thread in a deterministic order.
+struct LogCapture
+{
+	enum kind_t { TEXT, WARNING, SPACER };
+	struct item_t {
+		kind_t kind;
+		std::string prefix, text;
+	};
+	std::vector<item_t> items;
+	int debug_suppressed = 0;
+
+	void replay();
+};
+
+extern thread_local LogCapture *log_capture;
+void log_free_thread_caches();
 
 void logv(const char *format, va_list ap);
 void logv_header(RTLIL::Design *design, const char *format, va_list ap);
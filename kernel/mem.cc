@@ -261,6 +261,8 @@ void Mem::emit() {
 			}
 		}
 		cell->parameters[ID::INIT] = get_init_data();
+		// init data can be huge and is rarely modified in place
+		cell->parameters[ID::INIT].pack();
 	} else {
 		if (cell) {
 			module->remove(cell);
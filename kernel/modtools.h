@@ -77,6 +77,7 @@ struct ModIndex : public RTLIL::Monitor
 	std::map<RTLIL::SigBit, SigBitInfo> database;
 	int auto_reload_counter;
 	bool auto_reload_module;
+	bool sigmap_fresh;
 
 	void port_add(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
 	{
@@ -107,6 +108,7 @@ struct ModIndex : public RTLIL::Monitor
 			sigmap.clear();
 			sigmap.set(module);
 		}
+		sigmap_fresh = true;
 
 		database.clear();
 		for (auto wire : module->wires())
@@ -173,8 +175,12 @@ struct ModIndex : public RTLIL::Monitor
 	{
 		log_assert(module == mod);
 
-		if (auto_reload_module)
+		if (auto_reload_module) {
+			// keep the sigmap usable so that the reload can reuse it
+			if (sigmap_fresh)
+				sigmap.add(sigsig.first, sigsig.second);
 			return;
+		}
 
 		for (int i = 0; i < GetSize(sigsig.first); i++)
 		{
@@ -218,18 +224,21 @@ struct ModIndex : public RTLIL::Monitor
 	{
 		log_assert(module == mod);
 		auto_reload_module = true;
+		sigmap_fresh = false;
 	}
 
 	void notify_blackout(RTLIL::Module *mod) override
 	{
 		log_assert(module == mod);
 		auto_reload_module = true;
+		sigmap_fresh = false;
 	}
 
 	ModIndex(RTLIL::Module *_m) : sigmap(_m), module(_m)
 	{
 		auto_reload_counter = 0;
 		auto_reload_module = true;
+		sigmap_fresh = true;
 		module->monitors.insert(this);
 	}
 
@@ -241,7 +250,7 @@ struct ModIndex : public RTLIL::Monitor
 	SigBitInfo *query(RTLIL::SigBit bit)
 	{
 		if (auto_reload_module)
-			reload_module();
+			reload_module(!sigmap_fresh);
 
 		auto it = database.find(sigmap(bit));
 		if (it == database.end())
@@ -281,7 +290,7 @@ struct ModIndex : public RTLIL::Monitor
 
 		if (auto_reload_module) {
 			log("AUTO-RELOAD\n");
-			reload_module();
+			reload_module(!sigmap_fresh);
 		}
 
 		for (auto &it : database) {
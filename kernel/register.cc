@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/satgen.h"
 #include "kernel/json.h"
+#include "kernel/threading.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -30,22 +31,88 @@
 #include <zlib.h>
 
 PRIVATE_NAMESPACE_BEGIN
-#define GZ_BUFFER_SIZE 8192
-void decompress_gzip(const std::string &filename, std::stringstream &out)
-{
-	char buffer[GZ_BUFFER_SIZE];
-	int bytes_read;
-	gzFile gzf = gzopen(filename.c_str(), "rb");
-	while(!gzeof(gzf)) {
-		bytes_read = gzread(gzf, reinterpret_cast<void *>(buffer), GZ_BUFFER_SIZE);
-		out.write(buffer, bytes_read);
+#define GZ_BUFFER_SIZE 65536
+
+/*
+An input stream that decompresses a gzip file with zlib while it is read,
+so that only GZ_BUFFER_SIZE bytes of uncompressed data are held in memory.
+Seeking is supported (zlib implements it by decompressing up to the target
+position, restarting from the beginning for backwards seeks).
+*/
+class gzip_istream : public std::istream  {
+public:
+	gzip_istream() : std::istream(nullptr)
+	{
+		rdbuf(&inbuf);
 	}
-	gzclose(gzf);
-}
+	bool open(const std::string &filename)
+	{
+		return inbuf.open(filename);
+	}
+private:
+	class gzip_streambuf : public std::streambuf {
+	public:
+		gzip_streambuf() { };
+		bool open(const std::string &filename)
+		{
+			gzf = gzopen(filename.c_str(), "rb");
+			if (gzf != nullptr)
+				gzbuffer(gzf, GZ_BUFFER_SIZE);
+			return gzf != nullptr;
+		}
+		virtual int_type underflow() override
+		{
+			if (gptr() < egptr())
+				return traits_type::to_int_type(*gptr());
+			int bytes_read = gzread(gzf, buffer, GZ_BUFFER_SIZE);
+			if (bytes_read <= 0) {
+				setg(buffer, buffer, buffer);
+				return traits_type::eof();
+			}
+			setg(buffer, buffer, buffer + bytes_read);
+			return traits_type::to_int_type(*gptr());
+		}
+		virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override
+		{
+			if (dir == std::ios_base::cur) {
+				z_off_t pos = gztell(gzf);
+				if (pos < 0)
+					return pos_type(off_type(-1));
+				return seekpos(pos_type(pos - (egptr() - gptr()) + off), std::ios_base::in);
+			}
+			if (dir != std::ios_base::beg)
+				return pos_type(off_type(-1));
+			return seekpos(pos_type(off), std::ios_base::in);
+		}
+		virtual pos_type seekpos(pos_type pos, std::ios_base::openmode) override
+		{
+			z_off_t cur = gztell(gzf);
+			// stay in the buffer when possible, this is what tellg() ends up doing
+			if (cur >= 0 && off_type(pos) <= cur && off_type(pos) >= cur - (egptr() - eback())) {
+				setg(eback(), egptr() - (cur - off_type(pos)), egptr());
+				return pos;
+			}
+			if (gzseek(gzf, z_off_t(off_type(pos)), SEEK_SET) < 0)
+				return pos_type(off_type(-1));
+			setg(buffer, buffer, buffer);
+			return pos;
+		}
+		virtual ~gzip_streambuf()
+		{
+			if (gzf != nullptr)
+				gzclose(gzf);
+		}
+	private:
+		gzFile gzf = nullptr;
+		char buffer[GZ_BUFFER_SIZE];
+	} inbuf;
+};
 
 /*
-An output stream that uses a stringbuf to buffer data internally,
-using zlib to write gzip-compressed data every time the stream is flushed.
+An output stream that compresses data with zlib as it is written, passing
+it on to zlib in GZ_BUFFER_SIZE chunks. Flushing the stream hands buffered
+data to zlib but does not force a gzip flush point, which would hurt the
+compression ratio.
 */
 class gzip_ostream : public std::ostream  {
 public:
@@ -58,27 +125,57 @@ public:
 		return outbuf.open(filename);
 	}
 private:
-	class gzip_streambuf : public std::stringbuf {
+	class gzip_streambuf : public std::streambuf {
 	public:
-		gzip_streambuf() { };
+		gzip_streambuf()
+		{
+			setp(buffer, buffer + GZ_BUFFER_SIZE);
+		}
 		bool open(const std::string &filename)
 		{
 			gzf = gzopen(filename.c_str(), "wb");
+			if (gzf != nullptr)
+				gzbuffer(gzf, GZ_BUFFER_SIZE);
 			return gzf != nullptr;
 		}
+		virtual int_type overflow(int_type ch) override
+		{
+			if (sync() != 0)
+				return traits_type::eof();
+			if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+				*pptr() = traits_type::to_char_type(ch);
+				pbump(1);
+			}
+			return traits_type::not_eof(ch);
+		}
+		virtual std::streamsize xsputn(const char *s, std::streamsize n) override
+		{
+			// large writes go to zlib directly instead of through the buffer
+			if (n >= GZ_BUFFER_SIZE) {
+				if (sync() != 0 || gzwrite(gzf, s, unsigned(n)) != int(n))
+					return 0;
+				return n;
+			}
+			return std::streambuf::xsputn(s, n);
+		}
 		virtual int sync() override
 		{
-			gzwrite(gzf, reinterpret_cast<const void *>(str().c_str()), unsigned(str().size()));
-			str("");
+			int len = int(pptr() - pbase());
+			if (len > 0 && gzwrite(gzf, pbase(), unsigned(len)) != len)
+				return -1;
+			setp(buffer, buffer + GZ_BUFFER_SIZE);
 			return 0;
 		}
 		virtual ~gzip_streambuf()
 		{
-			sync();
-			gzclose(gzf);
+			if (gzf != nullptr) {
+				sync();
+				gzclose(gzf);
+			}
 		}
 	private:
 		gzFile gzf = nullptr;
+		char buffer[GZ_BUFFER_SIZE];
 	} outbuf;
 };
 PRIVATE_NAMESPACE_END
@@ -172,6 +269,11 @@ void Pass::post_execute(Pass::pre_post_exec_state_t state)
 		current_pass->runtime_ns -= time_ns;
 }
 
+void Pass::parallel_for_modules(const std::vector<RTLIL::Module*> &modules, const std::function<void(RTLIL::Module*)> &worker)
+{
+	parallel_for(GetSize(modules), [&](int i) { worker(modules[i]); }, module_local_flag ? yosys_jobs : 1);
+}
+
 void Pass::help()
 {
 	log("\n");
@@ -313,6 +415,10 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 	if (pass_register[args[0]]->experimental_flag)
 		log_experimental("%s", args[0].c_str());
 
+	// only set by script passes that take "-j <N>", see ScriptPass::run_script()
+	if (ScriptPass *script_pass = dynamic_cast<ScriptPass*>(pass_register[args[0]]))
+		script_pass->script_jobs = 0;
+
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 	auto state = pass_register[args[0]]->pre_execute();
 	pass_register[args[0]]->execute(args, design);
@@ -425,7 +531,17 @@ void ScriptPass::run_script(RTLIL::Design *design, std::string run_from, std::st
 	block_active = run_from.empty();
 	active_run_from = run_from;
 	active_run_to = run_to;
-	script();
+
+	int orig_yosys_jobs = yosys_jobs;
+	if (script_jobs > 0)
+		yosys_jobs = script_jobs;
+	try {
+		script();
+	} catch (...) {
+		yosys_jobs = orig_yosys_jobs;
+		throw;
+	}
+	yosys_jobs = orig_yosys_jobs;
 }
 
 void ScriptPass::help_script()
@@ -554,9 +670,12 @@ void Frontend::extra_args(std::istream *&f, std::string &filename, std::vector<s
 						log_cmd_error("gzip file `%s' uses unsupported compression type %02x\n",
 							filename.c_str(), unsigned(magic[2]));
 					delete ff;
-					std::stringstream *df = new std::stringstream();
-					decompress_gzip(filename, *df);
-					f = df;
+					gzip_istream *gf = new gzip_istream;
+					if (!gf->open(filename)) {
+						delete gf;
+						log_cmd_error("Can't open input file `%s' for reading: %s\n", filename.c_str(), strerror(errno));
+					}
+					f = gf;
 	#else
 					log_cmd_error("File `%s' is a gzip file, but Yosys is compiled without zlib.\n", filename.c_str());
 	#endif
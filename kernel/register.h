@@ -38,11 +38,21 @@ struct Pass
 	int call_counter;
 	int64_t runtime_ns;
 	bool experimental_flag = false;
+	bool module_local_flag = false;
 
 	void experimental() {
 		experimental_flag = true;
 	}
 
+	// Declares that the per-module work of this pass only reads and modifies
+	// the module it is working on, which lets parallel_for_modules() process
+	// several modules at once (see "yosys -j").
+	void module_local() {
+		module_local_flag = true;
+	}
+
+	void parallel_for_modules(const std::vector<RTLIL::Module*> &modules, const std::function<void(RTLIL::Module*)> &worker);
+
 	struct pre_post_exec_state_t {
 		Pass *parent_pass;
 		int64_t begin_ns;
@@ -79,6 +89,7 @@ struct ScriptPass : Pass
 	bool block_active, help_mode;
 	RTLIL::Design *active_design;
 	std::string active_run_from, active_run_to;
+	int script_jobs = 0; // from "-j <N>" of script passes that have this option
 
 	ScriptPass(std::string name, std::string short_help = "** document me **") : Pass(name, short_help) { }
 
@@ -34,10 +34,13 @@ YOSYS_NAMESPACE_BEGIN
 
 bool RTLIL::IdString::destruct_guard_ok = false;
 RTLIL::IdString::destruct_guard_t RTLIL::IdString::destruct_guard;
-std::vector<char*> RTLIL::IdString::global_id_storage_;
-dict<char*, int, hash_cstr_ops> RTLIL::IdString::global_id_index_;
+// These are constant-initialized, and thus valid before any dynamic initializer runs.
+RTLIL::IdString::storage_entry_t RTLIL::IdString::global_id_storage_first_page_[RTLIL::IdString::storage_page_size] = { { (char*)"" } };
+RTLIL::IdString::storage_entry_t *RTLIL::IdString::global_id_storage_[RTLIL::IdString::storage_max_pages] = { RTLIL::IdString::global_id_storage_first_page_ };
+RTLIL::IdString::index_shard_t RTLIL::IdString::global_id_index_[1 << RTLIL::IdString::index_shard_bits];
+RTLIL::IdString::mutex_t RTLIL::IdString::global_id_alloc_mutex_;
+int RTLIL::IdString::global_id_storage_size_ = 1;
 #ifndef YOSYS_NO_IDS_REFCNT
-std::vector<int> RTLIL::IdString::global_refcount_storage_;
 std::vector<int> RTLIL::IdString::global_free_idx_list_;
 #endif
 #ifdef YOSYS_USE_STICKY_IDS
@@ -51,6 +54,67 @@ int RTLIL::IdString::last_created_idx_ptr_;
 
 dict<std::string, std::string> RTLIL::constpad;
 
+// Each kind of object has its own sequence of hashidx_ values: value p is
+// mkhash_xorshift() applied p times to a fixed seed. Objects created by the
+// main thread simply take the next value. Objects created by a parallel_for()
+// worker (kernel/threading.h) take the positions handed out by its IdSource,
+// and the value at such a position is computed with xorshift_jump(). As the
+// sequence only repeats after 2^32-1 values, the hashidx_ of two objects of
+// the same kind are the same only if their positions are.
+
+static const unsigned int hashidx_seed = 123456789;
+
+// mkhash_xorshift() applied `steps` times to hashidx_seed. mkhash_xorshift() is
+// linear over GF(2), so this multiplies the seed with powers of its matrix.
+static unsigned int xorshift_jump(int64_t steps)
+{
+	// matrix_powers[k][j] is column j of the matrix of 2^k applications
+	static const std::vector<std::array<unsigned int, 32>> matrix_powers = []() {
+		std::vector<std::array<unsigned int, 32>> powers(32);
+		for (int j = 0; j < 32; j++)
+			powers[0][j] = mkhash_xorshift(1u << j);
+		for (int k = 1; k < 32; k++)
+			for (int j = 0; j < 32; j++) {
+				unsigned int column = 0, v = powers[k-1][j];
+				for (int i = 0; i < 32; i++)
+					if (v & (1u << i))
+						column ^= powers[k-1][i];
+				powers[k][j] = column;
+			}
+		return powers;
+	}();
+
+	uint64_t remaining = uint64_t(steps) % 0xffffffffu;
+	unsigned int value = hashidx_seed;
+	for (int k = 0; remaining != 0; k++, remaining >>= 1) {
+		if (!(remaining & 1))
+			continue;
+		unsigned int next = 0;
+		for (int j = 0; j < 32; j++)
+			if (value & (1u << j))
+				next ^= matrix_powers[k][j];
+		value = next;
+	}
+	return value;
+}
+
+static unsigned int next_hashidx(HashidxKind kind)
+{
+	// the last value each thread computed, so that consecutive positions only
+	// take one step
+	struct LastValue {
+		int64_t pos = 0;
+		unsigned int value = hashidx_seed;
+	};
+	static thread_local LastValue last[HASHIDX_KINDS];
+
+	int64_t pos = task_id_source ? task_id_source->take(task_id_source->hashidx[kind]) + 1 : ++hashidx_pos[kind];
+	LastValue &l = last[kind];
+	l.value = pos == l.pos + 1 ? mkhash_xorshift(l.value) : xorshift_jump(pos);
+	l.pos = pos;
+	return l.value;
+}
+
 const pool<IdString> &RTLIL::builtin_ff_cell_types() {
 	static const pool<IdString> res = {
 		ID($sr),
@@ -256,17 +320,53 @@ RTLIL::Const::Const(const std::vector<bool> &bits)
 		bv.emplace_back(b ? State::S1 : State::S0);
 }
 
-RTLIL::Const::Const(const RTLIL::Const &other) {
+void RTLIL::Const::Packed::set(int i, State bit)
+{
+	log_assert(bit <= State::Sz);
+	uint64_t m = uint64_t(1) << (i % 64);
+	uint64_t &v = words[2*(i/64)], &u = words[2*(i/64)+1];
+	v = (bit & 1) ? (v | m) : (v & ~m);
+	u = (bit & 2) ? (u | m) : (u & ~m);
+}
+
+RTLIL::Const::Const(Packed &&packed)
+{
+	flags = RTLIL::CONST_FLAG_NONE;
+	new ((void*)&packed_) Packed(std::move(packed));
+	tag = backing_tag::packed;
+}
+
+void RTLIL::Const::destroy_backing() const
+{
+	if (is_bits())
+		bits_.~bitvectype();
+	else if (is_str())
+		str_.~string();
+	else if (is_packed())
+		packed_.~Packed();
+	else
+		check(false);
+}
+
+// expects the union to be uninitialized
+void RTLIL::Const::copy_backing(const RTLIL::Const &other)
+{
 	tag = other.tag;
-	flags = other.flags;
 	if (is_str())
 		new ((void*)&str_) std::string(other.get_str());
 	else if (is_bits())
 		new ((void*)&bits_) bitvectype(other.get_bits());
+	else if (is_packed())
+		new ((void*)&packed_) Packed(other.packed_);
 	else
 		check(false);
 }
 
+RTLIL::Const::Const(const RTLIL::Const &other) {
+	flags = other.flags;
+	copy_backing(other);
+}
+
 RTLIL::Const::Const(RTLIL::Const &&other) {
 	tag = other.tag;
 	flags = other.flags;
@@ -274,43 +374,63 @@ RTLIL::Const::Const(RTLIL::Const &&other) {
 		new ((void*)&str_) std::string(std::move(other.get_str()));
 	else if (is_bits())
 		new ((void*)&bits_) bitvectype(std::move(other.get_bits()));
+	else if (is_packed())
+		new ((void*)&packed_) Packed(std::move(other.packed_));
 	else
 		check(false);
 }
 
 RTLIL::Const &RTLIL::Const::operator =(const RTLIL::Const &other) {
+	if (this == &other)
+		return *this;
 	flags = other.flags;
-	if (other.is_str()) {
-		if (!is_str()) {
-			// sketchy zone
-			check(is_bits());
-			bits_.~bitvectype();
-			(void)new ((void*)&str_) std::string();
-		}
-		tag = other.tag;
-		get_str() = other.get_str();
-	} else if (other.is_bits()) {
-		if (!is_bits()) {
-			// sketchy zone
-			check(is_str());
-			str_.~string();
-			(void)new ((void*)&bits_) bitvectype();
-		}
-		tag = other.tag;
-		get_bits() = other.get_bits();
+	if (other.tag == tag) {
+		if (is_str())
+			get_str() = other.get_str();
+		else if (is_bits())
+			get_bits() = other.get_bits();
+		else if (is_packed())
+			packed_ = other.packed_;
+		else
+			check(false);
 	} else {
-		check(false);
+		// sketchy zone
+		destroy_backing();
+		copy_backing(other);
+	}
+	return *this;
+}
+
+RTLIL::Const &RTLIL::Const::operator =(RTLIL::Const &&other) {
+	if (this == &other)
+		return *this;
+	flags = other.flags;
+	if (other.tag == tag) {
+		if (is_str())
+			get_str() = std::move(other.get_str());
+		else if (is_bits())
+			get_bits() = std::move(other.get_bits());
+		else if (is_packed())
+			packed_ = std::move(other.packed_);
+		else
+			check(false);
+	} else {
+		destroy_backing();
+		tag = other.tag;
+		if (is_str())
+			new ((void*)&str_) std::string(std::move(other.get_str()));
+		else if (is_bits())
+			new ((void*)&bits_) bitvectype(std::move(other.get_bits()));
+		else if (is_packed())
+			new ((void*)&packed_) Packed(std::move(other.packed_));
+		else
+			check(false);
 	}
 	return *this;
 }
 
 RTLIL::Const::~Const() {
-	if (is_bits())
-		bits_.~bitvectype();
-	else if (is_str())
-		str_.~string();
-	else
-		check(false);
+	destroy_backing();
 }
 
 bool RTLIL::Const::operator<(const RTLIL::Const &other) const
@@ -330,6 +450,9 @@ bool RTLIL::Const::operator ==(const RTLIL::Const &other) const
 	if (size() != other.size())
 		return false;
 
+	if (is_packed() && other.is_packed())
+		return packed_.words == other.packed_.words;
+
 	for (int i = 0; i < size(); i++)
 	if ((*this)[i] != other[i])
 		return false;
@@ -358,6 +481,13 @@ std::vector<RTLIL::State> RTLIL::Const::to_bits() const
 
 bool RTLIL::Const::as_bool() const
 {
+	if (auto p = get_if_packed()) {
+		for (int i = 0; i < p->num_words(); i++)
+			if (p->val(i) & ~p->unk(i))
+				return true;
+		return false;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 	for (size_t i = 0; i < bv.size(); i++)
@@ -368,6 +498,13 @@ bool RTLIL::Const::as_bool() const
 
 int RTLIL::Const::as_int(bool is_signed) const
 {
+	if (auto p = get_if_packed()) {
+		int32_t ret = p->width == 0 ? 0 : int32_t(p->val(0) & ~p->unk(0));
+		if (is_signed && p->width > 0 && p->width < 32 && p->get(p->width-1) == State::S1)
+			ret |= int32_t(~uint32_t(0) << p->width);
+		return ret;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 	int32_t ret = 0;
@@ -428,6 +565,14 @@ std::optional<int> RTLIL::Const::as_int_compress(bool is_signed) const
 
 std::string RTLIL::Const::as_string(const char* any) const
 {
+	if (auto p = get_if_packed()) {
+		static const char packed_chars[] = "01xz";
+		std::string ret(p->width, '0');
+		for (int i = 0; i < p->width; i++)
+			ret[p->width - i - 1] = packed_chars[p->get(i)];
+		return ret;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 	std::string ret;
@@ -500,6 +645,8 @@ std::string RTLIL::Const::decode_string() const
 int RTLIL::Const::size() const {
 	if (is_str())
 		return 8 * str_.size();
+	else if (is_packed())
+		return packed_.width;
 	else {
 		check(is_bits());
 		return bits_.size();
@@ -509,6 +656,8 @@ int RTLIL::Const::size() const {
 bool RTLIL::Const::empty() const {
 	if (is_str())
 		return str_.empty();
+	else if (is_packed())
+		return packed_.width == 0;
 	else {
 		check(is_bits());
 		return bits_.empty();
@@ -519,31 +668,82 @@ void RTLIL::Const::bitvectorize() const {
 	if (tag == backing_tag::bits)
 		return;
 
-	check(is_str());
-
 	bitvectype new_bits;
 
-	new_bits.reserve(str_.size() * 8);
-	for (int i = str_.size() - 1; i >= 0; i--) {
-		unsigned char ch = str_[i];
-		for (int j = 0; j < 8; j++) {
-			new_bits.push_back((ch & 1) != 0 ? State::S1 : State::S0);
-			ch = ch >> 1;
+	if (is_packed()) {
+		new_bits.reserve(packed_.width);
+		for (int i = 0; i < packed_.width; i++)
+			new_bits.push_back(packed_.get(i));
+	} else {
+		check(is_str());
+		new_bits.reserve(str_.size() * 8);
+		for (int i = str_.size() - 1; i >= 0; i--) {
+			unsigned char ch = str_[i];
+			for (int j = 0; j < 8; j++) {
+				new_bits.push_back((ch & 1) != 0 ? State::S1 : State::S0);
+				ch = ch >> 1;
+			}
 		}
 	}
 
 	{
 		// sketchy zone
-		str_.~string();
+		destroy_backing();
 		(void)new ((void*)&bits_) bitvectype(std::move(new_bits));
 		tag = backing_tag::bits;
 	}
 }
 
+bool RTLIL::Const::to_packed(Packed &packed) const
+{
+	if (auto p = get_if_packed()) {
+		packed = *p;
+		return true;
+	}
+
+	packed = Packed(size());
+	if (auto str = get_if_str()) {
+		for (int i = 0; i < GetSize(*str); i++) {
+			int k = GetSize(*str) - i - 1;
+			packed.val(k / 8) |= uint64_t((unsigned char)(*str)[i]) << (8 * (k % 8));
+		}
+		return true;
+	}
+
+	const bitvectype &bv = get_bits();
+	for (int i = 0; i < GetSize(bv); i++) {
+		if (bv[i] > State::Sz)
+			return false;
+		packed.words[2*(i/64)] |= uint64_t(bv[i] & 1) << (i%64);
+		packed.words[2*(i/64)+1] |= uint64_t(bv[i] >> 1) << (i%64);
+	}
+	return true;
+}
+
+void RTLIL::Const::pack() const
+{
+	if (!is_bits())
+		return;
+
+	Packed packed;
+	if (!to_packed(packed))
+		return;
+
+	{
+		// sketchy zone
+		destroy_backing();
+		(void)new ((void*)&packed_) Packed(std::move(packed));
+		tag = backing_tag::packed;
+	}
+}
+
 RTLIL::State RTLIL::Const::const_iterator::operator*() const {
 	if (auto bv = parent.get_if_bits())
 		return (*bv)[idx];
 
+	if (auto p = parent.get_if_packed())
+		return p->get(idx);
+
 	int char_idx = parent.get_str().size() - idx / 8 - 1;
 	bool bit = (parent.get_str()[char_idx] & (1 << (idx % 8)));
 	return bit ? State::S1 : State::S0;
@@ -551,9 +751,17 @@ RTLIL::State RTLIL::Const::const_iterator::operator*() const {
 
 bool RTLIL::Const::is_fully_zero() const
 {
+	cover("kernel.rtlil.const.is_fully_zero");
+
+	if (auto p = get_if_packed()) {
+		for (int i = 0; i < p->num_words(); i++)
+			if (p->val(i) | p->unk(i))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
-	cover("kernel.rtlil.const.is_fully_zero");
 
 	for (const auto &bit : bv)
 		if (bit != RTLIL::State::S0)
@@ -564,9 +772,17 @@ bool RTLIL::Const::is_fully_zero() const
 
 bool RTLIL::Const::is_fully_ones() const
 {
+	cover("kernel.rtlil.const.is_fully_ones");
+
+	if (auto p = get_if_packed()) {
+		for (int i = 0; i < p->num_words(); i++)
+			if ((p->val(i) & ~p->unk(i)) != p->mask(i))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
-	cover("kernel.rtlil.const.is_fully_ones");
 
 	for (const auto &bit : bv)
 		if (bit != RTLIL::State::S1)
@@ -579,6 +795,13 @@ bool RTLIL::Const::is_fully_def() const
 {
 	cover("kernel.rtlil.const.is_fully_def");
 
+	if (auto p = get_if_packed()) {
+		for (int i = 0; i < p->num_words(); i++)
+			if (p->unk(i))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 
@@ -593,6 +816,13 @@ bool RTLIL::Const::is_fully_undef() const
 {
 	cover("kernel.rtlil.const.is_fully_undef");
 
+	if (auto p = get_if_packed()) {
+		for (int i = 0; i < p->num_words(); i++)
+			if (~p->unk(i) & p->mask(i))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 
@@ -607,6 +837,13 @@ bool RTLIL::Const::is_fully_undef_x_only() const
 {
 	cover("kernel.rtlil.const.is_fully_undef_x_only");
 
+	if (auto p = get_if_packed()) {
+		for (int i = 0; i < p->num_words(); i++)
+			if ((p->val(i) | ~p->unk(i)) & p->mask(i))
+				return false;
+		return true;
+	}
+
 	bitvectorize();
 	bitvectype& bv = get_bits();
 
@@ -849,12 +1086,15 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 	}
 }
 
+RTLIL::Monitor::Monitor()
+{
+	hashidx_ = next_hashidx(HASHIDX_MONITOR);
+}
+
 RTLIL::Design::Design()
   : verilog_defines (new define_map_t)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(HASHIDX_DESIGN);
 
 	refcount_modules_ = 0;
 	selection_stack.push_back(RTLIL::Selection());
@@ -1042,6 +1282,23 @@ void RTLIL::Design::remove(RTLIL::Module *module)
 	delete module;
 }
 
+RTLIL::Module *RTLIL::Design::release(RTLIL::Module *module)
+{
+	for (auto mon : monitors)
+		mon->notify_module_del(module);
+
+	if (yosys_xtrace) {
+		log("#X# Release Module: %s\n", log_id(module));
+		log_backtrace("-X- ", yosys_xtrace-1);
+	}
+
+	log_assert(modules_.at(module->name) == module);
+	log_assert(refcount_modules_ == 0);
+	modules_.erase(module->name);
+	module->design = nullptr;
+	return module;
+}
+
 void RTLIL::Design::rename(RTLIL::Module *module, RTLIL::IdString new_name)
 {
 	modules_.erase(module->name);
@@ -1152,9 +1409,7 @@ std::vector<RTLIL::Module*> RTLIL::Design::selected_whole_modules_warn(bool incl
 
 RTLIL::Module::Module()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(HASHIDX_MODULE);
 
 	design = nullptr;
 	refcount_wires_ = 0;
@@ -3685,9 +3940,7 @@ RTLIL::SigSpec RTLIL::Module::FutureFF(RTLIL::IdString name, const RTLIL::SigSpe
 
 RTLIL::Wire::Wire()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(HASHIDX_WIRE);
 
 	module = nullptr;
 	width = 1;
@@ -3720,9 +3973,7 @@ std::map<unsigned int, RTLIL::Wire*> *RTLIL::Wire::get_all_wires(void)
 
 RTLIL::Memory::Memory()
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(HASHIDX_MEMORY);
 
 	width = 1;
 	start_offset = 0;
@@ -3734,16 +3985,12 @@ RTLIL::Memory::Memory()
 
 RTLIL::Process::Process() : module(nullptr)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(HASHIDX_PROCESS);
 }
 
 RTLIL::Cell::Cell() : module(nullptr)
 {
-	static unsigned int hashidx_count = 123456789;
-	hashidx_count = mkhash_xorshift(hashidx_count);
-	hashidx_ = hashidx_count;
+	hashidx_ = next_hashidx(HASHIDX_CELL);
 
 	// log("#memtrace# %p\n", this);
 	memhasher();
@@ -87,6 +87,42 @@ namespace RTLIL
 		#undef YOSYS_NO_IDS_REFCNT
 
 		// the global id string cache
+		//
+		// When built with YOSYS_ENABLE_THREADS, IdStrings may be created and destroyed
+		// concurrently from multiple threads. The storage entries live in fixed-size
+		// pages that are never reallocated, so c_str() and taking another reference
+		// to an index that is already held do not need any locking. The name index is
+		// split into shards that are locked individually, and a refcount only ever
+		// drops from one to zero while the shard of its name is locked, so a lookup by
+		// name can never resurrect an entry that is in the process of being freed.
+
+	#ifdef YOSYS_ENABLE_THREADS
+		typedef std::atomic<int> refcount_t;
+		typedef std::mutex mutex_t;
+		typedef std::lock_guard<std::mutex> lock_t;
+		static constexpr int index_shard_bits = 6;
+	#else
+		typedef int refcount_t;
+		struct mutex_t { };
+		struct lock_t { lock_t(mutex_t &) { } };
+		static constexpr int index_shard_bits = 0;
+	#endif
+
+		static constexpr int storage_page_bits = 14;
+		static constexpr int storage_page_size = 1 << storage_page_bits;
+		static constexpr int storage_max_pages = 0x40000000 >> storage_page_bits;
+
+		struct storage_entry_t {
+			char *str = nullptr;
+		#ifndef YOSYS_NO_IDS_REFCNT
+			refcount_t refcount { 0 };
+		#endif
+		};
+
+		struct index_shard_t {
+			mutex_t mutex;
+			dict<char*, int, hash_cstr_ops> index;
+		};
 
 		static bool destruct_guard_ok; // POD, will be initialized to zero
 		static struct destruct_guard_t {
@@ -94,10 +130,15 @@ namespace RTLIL
 			~destruct_guard_t() { destruct_guard_ok = false; }
 		} destruct_guard;
 
-		static std::vector<char*> global_id_storage_;
-		static dict<char*, int, hash_cstr_ops> global_id_index_;
+		// The first page holds the empty string at index 0 and is allocated statically,
+		// so that c_str() of a default-constructed IdString works even before the first
+		// name is interned (e.g. during static initialization).
+		static storage_entry_t global_id_storage_first_page_[storage_page_size];
+		static storage_entry_t *global_id_storage_[storage_max_pages];
+		static index_shard_t global_id_index_[1 << index_shard_bits];
+		static mutex_t global_id_alloc_mutex_;
+		static int global_id_storage_size_;
 	#ifndef YOSYS_NO_IDS_REFCNT
-		static std::vector<int> global_refcount_storage_;
 		static std::vector<int> global_free_idx_list_;
 	#endif
 
@@ -106,15 +147,28 @@ namespace RTLIL
 		static int last_created_idx_[8];
 	#endif
 
+		static inline storage_entry_t &storage_entry(int idx)
+		{
+			return global_id_storage_[idx >> storage_page_bits][idx & (storage_page_size - 1)];
+		}
+
+		static inline index_shard_t &index_shard(const char *p)
+		{
+			if (index_shard_bits == 0)
+				return global_id_index_[0];
+			return global_id_index_[hash_cstr_ops::hash(p) & ((1 << index_shard_bits) - 1)];
+		}
+
 		static inline void xtrace_db_dump()
 		{
 		#ifdef YOSYS_XTRACE_GET_PUT
-			for (int idx = 0; idx < GetSize(global_id_storage_); idx++)
+			lock_t lock(global_id_alloc_mutex_);
+			for (int idx = 0; idx < global_id_storage_size_; idx++)
 			{
-				if (global_id_storage_.at(idx) == nullptr)
+				if (storage_entry(idx).str == nullptr)
 					log("#X# DB-DUMP index %d: FREE\n", idx);
 				else
-					log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, global_id_storage_.at(idx), global_refcount_storage_.at(idx));
+					log("#X# DB-DUMP index %d: '%s' (ref %d)\n", idx, storage_entry(idx).str, int(storage_entry(idx).refcount));
 			}
 		#endif
 		}
@@ -130,6 +184,7 @@ namespace RTLIL
 			}
 		#endif
 		#ifdef YOSYS_SORT_ID_FREE_LIST
+			lock_t lock(global_id_alloc_mutex_);
 			std::sort(global_free_idx_list_.begin(), global_free_idx_list_.end(), std::greater<int>());
 		#endif
 		}
@@ -138,16 +193,35 @@ namespace RTLIL
 		{
 			if (idx) {
 		#ifndef YOSYS_NO_IDS_REFCNT
-				global_refcount_storage_[idx]++;
+				storage_entry(idx).refcount++;
 		#endif
 		#ifdef YOSYS_XTRACE_GET_PUT
 				if (yosys_xtrace)
-					log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+					log("#X# GET-BY-INDEX '%s' (index %d, refcount %d)\n", storage_entry(idx).str, idx, int(storage_entry(idx).refcount));
 		#endif
 			}
 			return idx;
 		}
 
+		static int alloc_index()
+		{
+			lock_t lock(global_id_alloc_mutex_);
+
+		#ifndef YOSYS_NO_IDS_REFCNT
+			if (!global_free_idx_list_.empty()) {
+				int idx = global_free_idx_list_.back();
+				global_free_idx_list_.pop_back();
+				return idx;
+			}
+		#endif
+
+			log_assert(global_id_storage_size_ < 0x40000000);
+			int idx = global_id_storage_size_++;
+			if ((idx & (storage_page_size - 1)) == 0)
+				global_id_storage_[idx >> storage_page_bits] = new storage_entry_t[storage_page_size]();
+			return idx;
+		}
+
 		static int get_reference(const char *p)
 		{
 			log_assert(destruct_guard_ok);
@@ -155,14 +229,17 @@ namespace RTLIL
 			if (!p[0])
 				return 0;
 
-			auto it = global_id_index_.find((char*)p);
-			if (it != global_id_index_.end()) {
+			index_shard_t &shard = index_shard(p);
+			lock_t lock(shard.mutex);
+
+			auto it = shard.index.find((char*)p);
+			if (it != shard.index.end()) {
 		#ifndef YOSYS_NO_IDS_REFCNT
-				global_refcount_storage_.at(it->second)++;
+				storage_entry(it->second).refcount++;
 		#endif
 		#ifdef YOSYS_XTRACE_GET_PUT
 				if (yosys_xtrace)
-					log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(it->second), it->second, global_refcount_storage_.at(it->second));
+					log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", storage_entry(it->second).str, it->second, int(storage_entry(it->second).refcount));
 		#endif
 				return it->second;
 			}
@@ -173,33 +250,13 @@ namespace RTLIL
 				if ((unsigned)*c <= (unsigned)' ')
 					log_error("Found control character or space (0x%02x) in string '%s' which is not allowed in RTLIL identifiers\n", *c, p);
 
+			int idx = alloc_index();
+			storage_entry_t &entry = storage_entry(idx);
+			entry.str = strdup(p);
 		#ifndef YOSYS_NO_IDS_REFCNT
-			if (global_free_idx_list_.empty()) {
-				if (global_id_storage_.empty()) {
-					global_refcount_storage_.push_back(0);
-					global_id_storage_.push_back((char*)"");
-					global_id_index_[global_id_storage_.back()] = 0;
-				}
-				log_assert(global_id_storage_.size() < 0x40000000);
-				global_free_idx_list_.push_back(global_id_storage_.size());
-				global_id_storage_.push_back(nullptr);
-				global_refcount_storage_.push_back(0);
-			}
-
-			int idx = global_free_idx_list_.back();
-			global_free_idx_list_.pop_back();
-			global_id_storage_.at(idx) = strdup(p);
-			global_id_index_[global_id_storage_.at(idx)] = idx;
-			global_refcount_storage_.at(idx)++;
-		#else
-			if (global_id_storage_.empty()) {
-				global_id_storage_.push_back((char*)"");
-				global_id_index_[global_id_storage_.back()] = 0;
-			}
-			int idx = global_id_storage_.size();
-			global_id_storage_.push_back(strdup(p));
-			global_id_index_[global_id_storage_.back()] = idx;
+			entry.refcount = 1;
 		#endif
+			shard.index[entry.str] = idx;
 
 			if (yosys_xtrace) {
 				log("#X# New IdString '%s' with index %d.\n", p, idx);
@@ -208,11 +265,11 @@ namespace RTLIL
 
 		#ifdef YOSYS_XTRACE_GET_PUT
 			if (yosys_xtrace)
-				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+				log("#X# GET-BY-NAME '%s' (index %d, refcount %d)\n", entry.str, idx, int(entry.refcount));
 		#endif
 
 		#ifdef YOSYS_USE_STICKY_IDS
-			// Avoid Create->Delete->Create pattern
+			// Avoid Create->Delete->Create pattern (not thread safe)
 			if (last_created_idx_[last_created_idx_ptr_])
 				put_reference(last_created_idx_[last_created_idx_ptr_]);
 			last_created_idx_[last_created_idx_ptr_] = idx;
@@ -227,34 +284,60 @@ namespace RTLIL
 		static inline void put_reference(int idx)
 		{
 			// put_reference() may be called from destructors after the destructor of
-			// global_refcount_storage_ has been run. in this case we simply do nothing.
+			// global_id_index_ has been run. in this case we simply do nothing.
 			if (!destruct_guard_ok || !idx)
 				return;
 
 		#ifdef YOSYS_XTRACE_GET_PUT
 			if (yosys_xtrace) {
-				log("#X# PUT '%s' (index %d, refcount %d)\n", global_id_storage_.at(idx), idx, global_refcount_storage_.at(idx));
+				log("#X# PUT '%s' (index %d, refcount %d)\n", storage_entry(idx).str, idx, int(storage_entry(idx).refcount));
 			}
 		#endif
 
-			int &refcount = global_refcount_storage_[idx];
+			refcount_t &refcount = storage_entry(idx).refcount;
 
-			if (--refcount > 0)
+			// dropping a reference that is not the last one never needs the lock
+		#ifdef YOSYS_ENABLE_THREADS
+			int count = refcount.load(std::memory_order_relaxed);
+			while (count > 1)
+				if (refcount.compare_exchange_weak(count, count - 1))
+					return;
+		#else
+			if (refcount > 1) {
+				refcount--;
 				return;
+			}
+		#endif
 
-			log_assert(refcount == 0);
-			free_reference(idx);
+			put_last_reference(idx);
 		}
-		static inline void free_reference(int idx)
+		static void put_last_reference(int idx)
 		{
+			index_shard_t &shard = index_shard(storage_entry(idx).str);
+			lock_t lock(shard.mutex);
+
+			// another thread may have looked up the name before we got the lock
+			int count = --storage_entry(idx).refcount;
+			if (count > 0)
+				return;
+
+			log_assert(count == 0);
+			free_reference(shard, idx);
+		}
+		static inline void free_reference(index_shard_t &shard, int idx)
+		{
+			storage_entry_t &entry = storage_entry(idx);
+
 			if (yosys_xtrace) {
-				log("#X# Removed IdString '%s' with index %d.\n", global_id_storage_.at(idx), idx);
+				log("#X# Removed IdString '%s' with index %d.\n", entry.str, idx);
 				log_backtrace("-X- ", yosys_xtrace-1);
 			}
 
-			global_id_index_.erase(global_id_storage_.at(idx));
-			free(global_id_storage_.at(idx));
-			global_id_storage_.at(idx) = nullptr;
+			shard.index.erase(entry.str);
+			free(entry.str);
+			entry.str = nullptr;
+
+			lock_t lock(global_id_alloc_mutex_);
 			global_free_idx_list_.push_back(idx);
 		}
 	#else
@@ -288,11 +371,11 @@ namespace RTLIL
 		}
 
 		inline const char *c_str() const {
-			return global_id_storage_.at(index_);
+			return storage_entry(index_).str;
 		}
 
 		inline std::string str() const {
-			return std::string(global_id_storage_.at(index_));
+			return std::string(storage_entry(index_).str);
 		}
 
 		inline bool operator<(const IdString &rhs) const {
@@ -661,27 +744,75 @@ namespace RTLIL
 struct RTLIL::Const
 {
 	short int flags;
+
+	// Two bit planes with 64 bits per machine word: bit i is stored in bit
+	// i%64 of words[2*(i/64)] (value plane) and words[2*(i/64)+1] (unknown
+	// plane). 0, 1, x and z are encoded as (val, unk) = (0,0), (1,0), (0,1)
+	// and (1,1). Bits at and above width are zero in both planes. Sa and Sm
+	// cannot be represented.
+	struct Packed {
+		int width = 0;
+		std::vector<uint64_t> words;
+
+		Packed() {}
+		Packed(int width) : width(width), words(2 * ((width + 63) / 64)) {}
+		Packed(const Packed &other) = default;
+		Packed &operator=(const Packed &other) = default;
+		// A moved-from value is empty rather than keeping a width without words.
+		Packed(Packed &&other) : width(other.width), words(std::move(other.words)) { other.width = 0; other.words.clear(); }
+		Packed &operator=(Packed &&other) {
+			if (this != &other) {
+				width = other.width;
+				words = std::move(other.words);
+				other.width = 0;
+				other.words.clear();
+			}
+			return *this;
+		}
+		int num_words() const { return GetSize(words) / 2; }
+		uint64_t &val(int i) { return words[2*i]; }
+		uint64_t &unk(int i) { return words[2*i+1]; }
+		uint64_t val(int i) const { return words[2*i]; }
+		uint64_t unk(int i) const { return words[2*i+1]; }
+		// mask of the bits of word i that are below width
+		uint64_t mask(int i) const { return (i+1)*64 <= width ? ~uint64_t(0) : (uint64_t(1) << (width % 64)) - 1; }
+		State get(int i) const { return State(((words[2*(i/64)] >> (i%64)) & 1) | ((words[2*(i/64)+1] >> (i%64)) & 1) << 1); }
+		void set(int i, State bit);
+	};
+
+	// Code that can choose between the two forms keeps (or makes) a Const
+	// packed only when it is wider than this, as converting small consts costs
+	// more than the packed form saves.
+	static constexpr int packed_threshold = 1024;
+
 private:
 	friend class KernelRtlilTest;
 	FRIEND_TEST(KernelRtlilTest, ConstStr);
+	FRIEND_TEST(KernelRtlilTest, ConstPacked);
 	using bitvectype = std::vector<RTLIL::State>;
-	enum class backing_tag: bool { bits, string };
+	enum class backing_tag: unsigned char { bits, string, packed };
 	// Do not access the union or tag even in Const methods unless necessary
 	mutable backing_tag tag;
 	union {
 		mutable bitvectype bits_;
 		mutable std::string str_;
+		mutable Packed packed_;
 	};
 
 	// Use these private utilities instead
 	bool is_bits() const { return tag == backing_tag::bits; }
 	bool is_str() const { return tag == backing_tag::string; }
+	bool is_packed() const { return tag == backing_tag::packed; }
 
 	bitvectype* get_if_bits() const { return is_bits() ? &bits_ : NULL; }
 	std::string* get_if_str() const { return is_str() ? &str_ : NULL; }
+	Packed* get_if_packed() const { return is_packed() ? &packed_ : NULL; }
 
 	bitvectype& get_bits() const;
 	std::string& get_str() const;
+
+	void destroy_backing() const;
+	void copy_backing(const RTLIL::Const &other);
 public:
 	Const() : flags(RTLIL::CONST_FLAG_NONE), tag(backing_tag::bits), bits_(std::vector<RTLIL::State>()) {}
 	Const(const std::string &str);
@@ -689,9 +820,11 @@ public:
 	Const(RTLIL::State bit, int width = 1);
 	Const(const std::vector<RTLIL::State> &bits) : flags(RTLIL::CONST_FLAG_NONE), tag(backing_tag::bits), bits_(bits) {}
 	Const(const std::vector<bool> &bits);
+	Const(Packed &&packed);
 	Const(const RTLIL::Const &other);
 	Const(RTLIL::Const &&other);
 	RTLIL::Const &operator =(const RTLIL::Const &other);
+	RTLIL::Const &operator =(RTLIL::Const &&other);
 	~Const();
 
 	bool operator <(const RTLIL::Const &other) const;
@@ -710,6 +843,16 @@ public:
 	bool empty() const;
 	void bitvectorize() const;
 
+	// Fills `packed` with the value of this const. Returns false (leaving
+	// `packed` unspecified) if it contains Sa or Sm bits.
+	bool to_packed(Packed &packed) const;
+	// Switches to the packed backing, which needs a quarter of the memory of
+	// the bits() backing, if all bits are 0, 1, x or z. Meant for large values
+	// that are mostly read, like memory init data.
+	void pack() const;
+	// Whether this const currently uses the packed backing.
+	bool has_packed_backing() const { return is_packed(); }
+
 	class const_iterator {
 	private:
 		const Const& parent;
@@ -1126,11 +1269,7 @@ struct RTLIL::Monitor
 	unsigned int hashidx_;
 	unsigned int hash() const { return hashidx_; }
 
-	Monitor() {
-		static unsigned int hashidx_count = 123456789;
-		hashidx_count = mkhash_xorshift(hashidx_count);
-		hashidx_ = hashidx_count;
-	}
+	Monitor();
 
 	virtual ~Monitor() { }
 	virtual void notify_module_add(RTLIL::Module*) { }
@@ -1183,6 +1322,8 @@ struct RTLIL::Design
 
 	RTLIL::Module *addModule(RTLIL::IdString name);
 	void remove(RTLIL::Module *module);
+	// remove module from the design without deleting it
+	RTLIL::Module *release(RTLIL::Module *module);
 	void rename(RTLIL::Module *module, RTLIL::IdString new_name);
 
 	void scratchpad_unset(const std::string &varname);
@@ -1597,7 +1738,7 @@ public:
 };
 
 namespace RTLIL_BACKEND {
-void dump_wire(std::ostream &f, std::string indent, const RTLIL::Wire *wire);
+void dump_wire(std::ostream &f, const std::string &indent, const RTLIL::Wire *wire);
 }
 
 struct RTLIL::Wire : public RTLIL::AttrObject
@@ -1613,7 +1754,7 @@ protected:
 
 	friend struct RTLIL::Design;
 	friend struct RTLIL::Cell;
-	friend void RTLIL_BACKEND::dump_wire(std::ostream &f, std::string indent, const RTLIL::Wire *wire);
+	friend void RTLIL_BACKEND::dump_wire(std::ostream &f, const std::string &indent, const RTLIL::Wire *wire);
 	RTLIL::Cell *driverCell_ = nullptr;
 	RTLIL::IdString driverPort_;
 
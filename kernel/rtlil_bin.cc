@@ -0,0 +1,951 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/rtlil_bin.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL_BIN {
+
+namespace {
+
+// File layout (all integers little endian):
+//
+//   header:   "YSRTLBIN" u32:version i32:autoidx
+//   section:  u8:SECTION_MODULE u32:num_new_ids u64:ids_size { var:len bytes }*
+//             u32:module_name u64:body_size body
+//   trailer:  u8:SECTION_END
+//
+// Module bodies store wires, memories and cells as records with a fixed
+// field layout, followed by their variable-length parts (attributes,
+// parameters, ports) once all records of that kind are written. Integers
+// inside bodies and the identifier table are LEB128 varints (zigzag for
+// signed values). SigSpec chunks refer to wires by their index within the
+// module body, with a short form for chunks that cover a whole wire.
+
+const char magic[8] = {'Y', 'S', 'R', 'T', 'L', 'B', 'I', 'N'};
+const uint32_t format_version = 1;
+
+enum : uint8_t {
+	SECTION_END = 0,
+	SECTION_MODULE = 1,
+};
+
+// Const encodings
+enum : uint8_t {
+	CONST_BINARY = 0,  // only 0 and 1 bits, one bit per bit
+	CONST_PACKED = 1,  // 0, 1, x and z, value and unknown plane per 64 bits
+	CONST_STATES = 2,  // one byte per bit
+	CONST_STRING = 3,  // string constants, raw bytes
+};
+
+enum : uint8_t {
+	WIRE_INPUT = 1,
+	WIRE_OUTPUT = 2,
+	WIRE_UPTO = 4,
+	WIRE_SIGNED = 8,
+};
+
+struct BinWriter
+{
+	std::string buf;
+
+	void u8(uint8_t v) { buf.push_back(char(v)); }
+	void u32(uint32_t v) {
+		char b[4] = {char(v), char(v >> 8), char(v >> 16), char(v >> 24)};
+		buf.append(b, 4);
+	}
+	void i32(int v) { u32(uint32_t(v)); }
+	void u64(uint64_t v) {
+		u32(uint32_t(v));
+		u32(uint32_t(v >> 32));
+	}
+	void var(uint64_t v) {
+		while (v >= 0x80) {
+			buf.push_back(char(v | 0x80));
+			v >>= 7;
+		}
+		buf.push_back(char(v));
+	}
+	void svar(int64_t v) { var((uint64_t(v) << 1) ^ uint64_t(v >> 63)); }
+	void bytes(const char *data, size_t len) { buf.append(data, len); }
+	void str(const std::string &s) {
+		var(s.size());
+		buf.append(s);
+	}
+};
+
+struct DesignWriter
+{
+	std::ostream &f;
+	RTLIL::Design *design;
+
+	dict<RTLIL::IdString, uint32_t> id_index;
+	std::vector<RTLIL::IdString> new_ids;
+	dict<const RTLIL::Wire*, uint32_t> wire_index;
+	BinWriter w;
+
+	DesignWriter(std::ostream &f, RTLIL::Design *design) : f(f), design(design) { }
+
+	uint32_t id(RTLIL::IdString name)
+	{
+		auto it = id_index.find(name);
+		if (it != id_index.end())
+			return it->second;
+		uint32_t index = GetSize(id_index);
+		id_index[name] = index;
+		new_ids.push_back(name);
+		return index;
+	}
+
+	void put_id(RTLIL::IdString name)
+	{
+		w.var(id(name));
+	}
+
+	void put_words(const RTLIL::Const::Packed &packed, bool with_unknown)
+	{
+		for (int i = 0; i < packed.num_words(); i++) {
+			w.u64(packed.val(i));
+			if (with_unknown)
+				w.u64(packed.unk(i));
+		}
+	}
+
+	void put_states(const std::vector<RTLIL::State> &bits)
+	{
+		w.u8(CONST_STATES);
+		w.var(0);
+		w.var(GetSize(bits));
+		for (auto bit : bits)
+			w.u8(bit);
+	}
+
+	void put_const(const RTLIL::Const &value)
+	{
+		if (value.flags & RTLIL::CONST_FLAG_STRING) {
+			w.u8(CONST_STRING);
+			w.var(value.flags);
+			w.str(value.decode_string());
+			return;
+		}
+
+		RTLIL::Const::Packed packed;
+		if (!value.to_packed(packed)) {
+			w.u8(CONST_STATES);
+			w.var(value.flags);
+			w.var(value.size());
+			for (auto bit : value)
+				w.u8(bit);
+			return;
+		}
+
+		bool with_unknown = false;
+		for (int i = 0; i < packed.num_words(); i++)
+			if (packed.unk(i))
+				with_unknown = true;
+
+		w.u8(with_unknown ? CONST_PACKED : CONST_BINARY);
+		w.var(value.flags);
+		w.var(packed.width);
+		put_words(packed, with_unknown);
+	}
+
+	void put_const_chunk(const std::vector<RTLIL::State> &data)
+	{
+		for (auto bit : data)
+			if (bit != RTLIL::S0 && bit != RTLIL::S1) {
+				put_states(data);
+				return;
+			}
+
+		w.u8(CONST_BINARY);
+		w.var(0);
+		w.var(GetSize(data));
+		for (int i = 0; i < GetSize(data); i += 64) {
+			uint64_t word = 0;
+			for (int j = 0; j < 64 && i + j < GetSize(data); j++)
+				if (data[i + j] == RTLIL::S1)
+					word |= uint64_t(1) << j;
+			w.u64(word);
+		}
+	}
+
+	void put_sigspec(const RTLIL::SigSpec &sig)
+	{
+		const auto &chunks = sig.chunks();
+		w.var(GetSize(chunks));
+		for (auto &chunk : chunks) {
+			if (chunk.wire) {
+				uint64_t index = wire_index.at(chunk.wire);
+				if (chunk.offset == 0 && chunk.width == chunk.wire->width) {
+					w.var(2*index + 1);
+				} else {
+					w.var(2*index + 2);
+					w.var(chunk.offset);
+					w.var(chunk.width);
+				}
+			} else {
+				w.var(0);
+				put_const_chunk(chunk.data);
+			}
+		}
+	}
+
+	void put_sigsig(const RTLIL::SigSig &sigsig)
+	{
+		put_sigspec(sigsig.first);
+		put_sigspec(sigsig.second);
+	}
+
+	template<typename T, typename F>
+	void put_dict(const dict<RTLIL::IdString, T> &d, F put_value)
+	{
+		w.var(GetSize(d));
+		std::vector<const std::pair<RTLIL::IdString, T>*> items;
+		items.reserve(GetSize(d));
+		for (auto &it : d)
+			items.push_back(&it);
+		for (auto it = items.rbegin(); it != items.rend(); ++it) {
+			put_id((*it)->first);
+			put_value((*it)->second);
+		}
+	}
+
+	void put_attributes(const RTLIL::AttrObject *obj)
+	{
+		put_dict(obj->attributes, [&](const RTLIL::Const &value) { put_const(value); });
+	}
+
+	void put_case(const RTLIL::CaseRule *rule)
+	{
+		put_attributes(rule);
+		w.var(GetSize(rule->compare));
+		for (auto &sig : rule->compare)
+			put_sigspec(sig);
+		w.var(GetSize(rule->actions));
+		for (auto &action : rule->actions)
+			put_sigsig(action);
+		w.var(GetSize(rule->switches));
+		for (auto sw : rule->switches) {
+			put_attributes(sw);
+			put_sigspec(sw->signal);
+			w.var(GetSize(sw->cases));
+			for (auto cs : sw->cases)
+				put_case(cs);
+		}
+	}
+
+	void put_process(const RTLIL::Process *proc)
+	{
+		put_id(proc->name);
+		put_attributes(proc);
+		put_case(&proc->root_case);
+		w.var(GetSize(proc->syncs));
+		for (auto sync : proc->syncs) {
+			w.u8(sync->type);
+			put_sigspec(sync->signal);
+			w.var(GetSize(sync->actions));
+			for (auto &action : sync->actions)
+				put_sigsig(action);
+			w.var(GetSize(sync->mem_write_actions));
+			for (auto &action : sync->mem_write_actions) {
+				put_id(action.memid);
+				put_sigspec(action.address);
+				put_sigspec(action.data);
+				put_sigspec(action.enable);
+				put_const(action.priority_mask);
+				put_attributes(&action);
+			}
+		}
+	}
+
+	template<typename T>
+	static std::vector<T*> reversed(const dict<RTLIL::IdString, T*> &d)
+	{
+		std::vector<T*> items;
+		items.reserve(GetSize(d));
+		for (auto &it : d)
+			items.push_back(it.second);
+		std::reverse(items.begin(), items.end());
+		return items;
+	}
+
+	void put_module(RTLIL::Module *module)
+	{
+		w.buf.clear();
+		wire_index.clear();
+
+		put_attributes(module);
+
+		w.var(GetSize(module->avail_parameters));
+		for (auto &param : module->avail_parameters)
+			put_id(param);
+		put_dict(module->parameter_default_values, [&](const RTLIL::Const &value) { put_const(value); });
+
+		std::vector<RTLIL::Wire*> wires;
+		for (auto wire : module->wires())
+			wires.push_back(wire);
+		std::reverse(wires.begin(), wires.end());
+
+		w.var(GetSize(wires));
+		for (auto wire : wires) {
+			wire_index[wire] = GetSize(wire_index);
+			put_id(wire->name);
+			w.svar(wire->width);
+			w.svar(wire->start_offset);
+			w.svar(wire->port_id);
+			w.u8((wire->port_input ? WIRE_INPUT : 0) | (wire->port_output ? WIRE_OUTPUT : 0) |
+					(wire->upto ? WIRE_UPTO : 0) | (wire->is_signed ? WIRE_SIGNED : 0));
+		}
+		for (auto wire : wires)
+			put_attributes(wire);
+
+		auto memories = reversed(module->memories);
+		w.var(GetSize(memories));
+		for (auto mem : memories) {
+			put_id(mem->name);
+			w.svar(mem->width);
+			w.svar(mem->start_offset);
+			w.svar(mem->size);
+		}
+		for (auto mem : memories)
+			put_attributes(mem);
+
+		std::vector<RTLIL::Cell*> cells;
+		for (auto cell : module->cells())
+			cells.push_back(cell);
+		std::reverse(cells.begin(), cells.end());
+
+		w.var(GetSize(cells));
+		for (auto cell : cells) {
+			put_id(cell->name);
+			put_id(cell->type);
+		}
+		for (auto cell : cells) {
+			put_dict(cell->parameters, [&](const RTLIL::Const &value) { put_const(value); });
+			put_dict(cell->connections(), [&](const RTLIL::SigSpec &sig) { put_sigspec(sig); });
+			put_attributes(cell);
+		}
+
+		w.var(GetSize(module->connections()));
+		for (auto &conn : module->connections())
+			put_sigsig(conn);
+
+		auto processes = reversed(module->processes);
+		w.var(GetSize(processes));
+		for (auto proc : processes)
+			put_process(proc);
+	}
+
+	void write_raw(const BinWriter &data)
+	{
+		f.write(data.buf.data(), data.buf.size());
+	}
+
+	void run(bool only_selected)
+	{
+		BinWriter header;
+		header.bytes(magic, sizeof(magic));
+		header.u32(format_version);
+		header.i32(autoidx);
+		write_raw(header);
+
+		std::vector<RTLIL::Module*> modules;
+		for (auto module : design->modules()) {
+			if (only_selected && !design->selected_whole_module(module->name)) {
+				if (design->selected_module(module->name))
+					log_cmd_error("Module %s is only partly selected.\n", log_id(module->name));
+				continue;
+			}
+			modules.push_back(module);
+		}
+		std::reverse(modules.begin(), modules.end());
+
+		for (auto module : modules) {
+			new_ids.clear();
+			uint32_t name_index = id(module->name);
+			put_module(module);
+
+			BinWriter id_table;
+			for (auto name : new_ids)
+				id_table.str(name.str());
+
+			BinWriter section;
+			section.u8(SECTION_MODULE);
+			section.u32(GetSize(new_ids));
+			section.u64(id_table.buf.size());
+			section.bytes(id_table.buf.data(), id_table.buf.size());
+			section.u32(name_index);
+			section.u64(w.buf.size());
+			write_raw(section);
+			write_raw(w);
+		}
+
+		BinWriter trailer;
+		trailer.u8(SECTION_END);
+		write_raw(trailer);
+	}
+};
+
+struct DesignReader
+{
+	std::istream &f;
+	std::string filename;
+	RTLIL::Design *design;
+	const ReadOptions &options;
+
+	std::vector<RTLIL::IdString> ids;
+	std::vector<RTLIL::Wire*> wires;
+	RTLIL::Module *module = nullptr;
+
+	std::string buf;
+	const unsigned char *ptr = nullptr, *end = nullptr;
+
+	// Bytes left in the file when the stream can tell, otherwise UINT64_MAX.
+	// Section sizes are read from the file and are checked against this
+	// before any memory is allocated for them.
+	uint64_t remaining = UINT64_MAX;
+
+	DesignReader(std::istream &f, const std::string &filename, RTLIL::Design *design, const ReadOptions &options) :
+			f(f), filename(filename), design(design), options(options) { }
+
+	[[noreturn]] void error(const char *what)
+	{
+		log_error("Malformed binary RTLIL file `%s': %s.\n", filename.c_str(), what);
+	}
+
+	void consume(uint64_t len)
+	{
+		if (remaining == UINT64_MAX)
+			return;
+		if (len > remaining)
+			error("section extends past the end of the file");
+		remaining -= len;
+	}
+
+	void fill(uint64_t len)
+	{
+		consume(len);
+		// when the size of the file is unknown, only grow the buffer as the
+		// data actually arrives
+		uint64_t chunk = remaining == UINT64_MAX ? 1 << 20 : len;
+		buf.clear();
+		while (buf.size() < len) {
+			size_t offset = buf.size();
+			size_t n = std::min<uint64_t>(len - offset, chunk);
+			buf.resize(offset + n);
+			f.read(&buf[offset], n);
+			if (size_t(f.gcount()) != n)
+				error("unexpected end of file");
+		}
+		ptr = reinterpret_cast<const unsigned char*>(buf.data());
+		end = ptr + buf.size();
+	}
+
+	void skip(uint64_t len)
+	{
+		consume(len);
+		if (!f.seekg(len, std::ios::cur)) {
+			f.clear();
+			char tmp[4096];
+			while (len > 0) {
+				size_t n = std::min<uint64_t>(len, sizeof(tmp));
+				f.read(tmp, n);
+				if (size_t(f.gcount()) != n)
+					error("unexpected end of file");
+				len -= n;
+			}
+		}
+	}
+
+	void need(size_t len)
+	{
+		if (size_t(end - ptr) < len)
+			error("truncated section");
+	}
+
+	uint8_t u8()
+	{
+		need(1);
+		return *ptr++;
+	}
+
+	uint32_t u32()
+	{
+		need(4);
+		uint32_t v = uint32_t(ptr[0]) | uint32_t(ptr[1]) << 8 | uint32_t(ptr[2]) << 16 | uint32_t(ptr[3]) << 24;
+		ptr += 4;
+		return v;
+	}
+
+	uint64_t var64()
+	{
+		uint64_t v = 0;
+		for (int shift = 0;; shift += 7) {
+			if (shift >= 64)
+				error("invalid varint");
+			uint8_t b = u8();
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80))
+				break;
+		}
+		return v;
+	}
+
+	uint32_t var()
+	{
+		uint64_t v = var64();
+		if (v > UINT32_MAX)
+			error("integer out of range");
+		return v;
+	}
+
+	int svar()
+	{
+		uint64_t v = var64();
+		int64_t s = int64_t(v >> 1) ^ -int64_t(v & 1);
+		if (s < INT_MIN || s > INT_MAX)
+			error("integer out of range");
+		return s;
+	}
+
+	uint64_t u64()
+	{
+		uint64_t lo = u32();
+		uint64_t hi = u32();
+		return lo | hi << 32;
+	}
+
+	// every element takes at least one byte, which bounds the counts of
+	// malformed files before anything is allocated for them
+	int count()
+	{
+		uint32_t n = var();
+		if (n > size_t(end - ptr))
+			error("invalid element count");
+		return n;
+	}
+
+	RTLIL::IdString id()
+	{
+		return id_at(var());
+	}
+
+	RTLIL::IdString id_at(uint32_t index)
+	{
+		if (index >= ids.size())
+			error("invalid identifier index");
+		return ids[index];
+	}
+
+	void read_words(RTLIL::Const::Packed &packed, bool with_unknown)
+	{
+		need(size_t(packed.num_words()) * (with_unknown ? 16 : 8));
+		for (int i = 0; i < packed.num_words(); i++) {
+			packed.val(i) = u64();
+			if (with_unknown)
+				packed.unk(i) = u64();
+		}
+		if (packed.num_words() > 0) {
+			int last = packed.num_words() - 1;
+			packed.val(last) &= packed.mask(last);
+			packed.unk(last) &= packed.mask(last);
+		}
+	}
+
+	std::vector<RTLIL::State> unpack(const RTLIL::Const::Packed &packed)
+	{
+		std::vector<RTLIL::State> bits(packed.width);
+		for (int i = 0; i < packed.width; i++)
+			bits[i] = packed.get(i);
+		return bits;
+	}
+
+	std::vector<RTLIL::State> read_states(int width)
+	{
+		// one byte per bit, checked before allocating for a width that may be bogus
+		need(width);
+		std::vector<RTLIL::State> bits(width);
+		for (int i = 0; i < width; i++) {
+			if (*ptr > RTLIL::Sm)
+				error("invalid constant bit");
+			bits[i] = RTLIL::State(*ptr++);
+		}
+		return bits;
+	}
+
+	RTLIL::Const read_const()
+	{
+		uint8_t kind = u8();
+		short int flags = var();
+		int width = var();
+		if (width < 0)
+			error("invalid constant width");
+
+		RTLIL::Const value;
+		switch (kind)
+		{
+		case CONST_STRING: {
+			need(width);
+			value = RTLIL::Const(std::string(reinterpret_cast<const char*>(ptr), width));
+			ptr += width;
+			break;
+		}
+		case CONST_STATES:
+			value = RTLIL::Const(read_states(width));
+			break;
+		case CONST_BINARY:
+		case CONST_PACKED: {
+			// check the size before allocating for a width that may be bogus
+			need((size_t(width) + 63) / 64 * (kind == CONST_PACKED ? 16 : 8));
+			RTLIL::Const::Packed packed(width);
+			read_words(packed, kind == CONST_PACKED);
+			if (width > RTLIL::Const::packed_threshold)
+				value = RTLIL::Const(std::move(packed));
+			else
+				value = RTLIL::Const(unpack(packed));
+			break;
+		}
+		default:
+			error("invalid constant encoding");
+		}
+		value.flags = flags;
+		return value;
+	}
+
+	RTLIL::SigSpec read_sigspec()
+	{
+		int num_chunks = count();
+		RTLIL::SigSpec sig;
+		for (int i = 0; i < num_chunks; i++) {
+			uint64_t tag = var64();
+			if (tag == 0) {
+				sig.append(read_const());
+				continue;
+			}
+			uint64_t index = (tag - 1) / 2;
+			if (index >= wires.size())
+				error("invalid wire index");
+			RTLIL::Wire *w = wires[index];
+			int offset = 0, width = w->width;
+			if (!(tag & 1)) {
+				offset = var();
+				width = var();
+				if (offset < 0 || width < 0 || int64_t(offset) + width > w->width)
+					error("invalid wire slice");
+			}
+			if (num_chunks == 1)
+				return RTLIL::SigSpec(w, offset, width);
+			sig.append(RTLIL::SigSpec(w, offset, width));
+		}
+		return sig;
+	}
+
+	RTLIL::SigSig read_sigsig()
+	{
+		RTLIL::SigSpec first = read_sigspec();
+		RTLIL::SigSpec second = read_sigspec();
+		return RTLIL::SigSig(first, second);
+	}
+
+	void read_attributes(dict<RTLIL::IdString, RTLIL::Const> &attributes)
+	{
+		int n = count();
+		for (int i = 0; i < n; i++) {
+			RTLIL::IdString name = id();
+			attributes[name] = read_const();
+		}
+	}
+
+	void read_attributes(RTLIL::AttrObject *obj)
+	{
+		read_attributes(obj->attributes);
+	}
+
+	void read_case(RTLIL::CaseRule *rule)
+	{
+		read_attributes(rule);
+		int n = count();
+		for (int i = 0; i < n; i++)
+			rule->compare.push_back(read_sigspec());
+		n = count();
+		for (int i = 0; i < n; i++)
+			rule->actions.push_back(read_sigsig());
+		n = count();
+		for (int i = 0; i < n; i++) {
+			RTLIL::SwitchRule *sw = new RTLIL::SwitchRule;
+			rule->switches.push_back(sw);
+			read_attributes(sw);
+			sw->signal = read_sigspec();
+			int num_cases = count();
+			for (int j = 0; j < num_cases; j++) {
+				RTLIL::CaseRule *cs = new RTLIL::CaseRule;
+				sw->cases.push_back(cs);
+				read_case(cs);
+			}
+		}
+	}
+
+	void read_process()
+	{
+		RTLIL::IdString name = id();
+		if (module->processes.count(name))
+			error("duplicate process");
+		RTLIL::Process *proc = module->addProcess(name);
+		read_attributes(proc);
+		read_case(&proc->root_case);
+		int n = count();
+		for (int i = 0; i < n; i++) {
+			RTLIL::SyncRule *sync = new RTLIL::SyncRule;
+			proc->syncs.push_back(sync);
+			uint8_t type = u8();
+			if (type > RTLIL::STi)
+				error("invalid sync type");
+			sync->type = RTLIL::SyncType(type);
+			sync->signal = read_sigspec();
+			int num_actions = count();
+			for (int j = 0; j < num_actions; j++)
+				sync->actions.push_back(read_sigsig());
+			int num_memwr = count();
+			for (int j = 0; j < num_memwr; j++) {
+				RTLIL::MemWriteAction act;
+				act.memid = id();
+				act.address = read_sigspec();
+				act.data = read_sigspec();
+				act.enable = read_sigspec();
+				act.priority_mask = read_const();
+				read_attributes(&act);
+				sync->mem_write_actions.push_back(std::move(act));
+			}
+		}
+	}
+
+	void read_module_body()
+	{
+		wires.clear();
+
+		int n = count();
+		for (int i = 0; i < n; i++)
+			module->avail_parameters(id());
+		n = count();
+		for (int i = 0; i < n; i++) {
+			RTLIL::IdString name = id();
+			module->parameter_default_values[name] = read_const();
+		}
+
+		n = count();
+		wires.reserve(n);
+		for (int i = 0; i < n; i++) {
+			RTLIL::IdString name = id();
+			if (module->wire(name))
+				error("duplicate wire");
+			RTLIL::Wire *wire = module->addWire(name);
+			wire->width = svar();
+			wire->start_offset = svar();
+			wire->port_id = svar();
+			uint8_t flags = u8();
+			wire->port_input = flags & WIRE_INPUT;
+			wire->port_output = flags & WIRE_OUTPUT;
+			wire->upto = flags & WIRE_UPTO;
+			wire->is_signed = flags & WIRE_SIGNED;
+			if (wire->width < 0)
+				error("invalid wire width");
+			wires.push_back(wire);
+		}
+		for (auto wire : wires)
+			read_attributes(wire);
+
+		n = count();
+		std::vector<RTLIL::Memory*> memories;
+		memories.reserve(n);
+		for (int i = 0; i < n; i++) {
+			RTLIL::Memory *mem = new RTLIL::Memory;
+			mem->name = id();
+			mem->width = svar();
+			mem->start_offset = svar();
+			mem->size = svar();
+			if (module->memories.count(mem->name)) {
+				delete mem;
+				error("duplicate memory");
+			}
+			module->memories[mem->name] = mem;
+			memories.push_back(mem);
+		}
+		for (auto mem : memories)
+			read_attributes(mem);
+
+		n = count();
+		std::vector<RTLIL::Cell*> cells;
+		cells.reserve(n);
+		for (int i = 0; i < n; i++) {
+			RTLIL::IdString name = id();
+			RTLIL::IdString type = id();
+			if (module->cell(name))
+				error("duplicate cell");
+			cells.push_back(module->addCell(name, type));
+		}
+		for (auto cell : cells) {
+			int num_params = count();
+			for (int i = 0; i < num_params; i++) {
+				RTLIL::IdString name = id();
+				cell->parameters[name] = read_const();
+			}
+			int num_ports = count();
+			for (int i = 0; i < num_ports; i++) {
+				RTLIL::IdString name = id();
+				cell->setPort(name, read_sigspec());
+			}
+			read_attributes(cell);
+		}
+
+		n = count();
+		std::vector<RTLIL::SigSig> connections;
+		connections.reserve(n);
+		for (int i = 0; i < n; i++) {
+			connections.push_back(read_sigsig());
+			if (GetSize(connections.back().first) != GetSize(connections.back().second))
+				error("connection width mismatch");
+		}
+		module->new_connections(connections);
+
+		n = count();
+		for (int i = 0; i < n; i++)
+			read_process();
+
+		if (ptr != end)
+			error("trailing data in module section");
+	}
+
+	void read_section()
+	{
+		fill(12);
+		uint32_t num_new_ids = u32();
+		fill(u64());
+		if (num_new_ids > buf.size())
+			error("invalid identifier count");
+		ids.reserve(ids.size() + num_new_ids);
+		for (uint32_t i = 0; i < num_new_ids; i++) {
+			uint32_t len = var();
+			need(len);
+			if (len == 0 || (ptr[0] != '\\' && ptr[0] != '$'))
+				error("invalid identifier");
+			ids.push_back(RTLIL::IdString(std::string(reinterpret_cast<const char*>(ptr), len)));
+			ptr += len;
+		}
+		if (ptr != end)
+			error("trailing data in identifier table");
+
+		fill(12);
+		RTLIL::IdString name = id_at(u32());
+		uint64_t body_size = u64();
+
+		if (!options.modules.empty() && !options.modules.count(name)) {
+			skip(body_size);
+			return;
+		}
+
+		// with -lib or -nooverwrite an existing module is kept whatever the
+		// new one contains, so its body is skipped without reading it
+		if (design->has(name) && !options.overwrite && (options.lib || options.nooverwrite)) {
+			log("Ignoring %sre-definition of module %s.\n", options.lib ? "blackbox " : "", name.c_str());
+			skip(body_size);
+			return;
+		}
+
+		fill(body_size);
+		dict<RTLIL::IdString, RTLIL::Const> attributes;
+		read_attributes(attributes);
+
+		if (design->has(name)) {
+			RTLIL::Module *existing_mod = design->module(name);
+			if (!options.overwrite && attributes.count(ID::blackbox) && attributes.at(ID::blackbox).as_bool()) {
+				log("Ignoring blackbox re-definition of module %s.\n", name.c_str());
+				return;
+			} else if (!options.overwrite && !existing_mod->get_bool_attribute(ID::blackbox)) {
+				log_error("Binary RTLIL file `%s' redefines module %s.\n", filename.c_str(), name.c_str());
+			} else {
+				log("Replacing existing%s module %s.\n", existing_mod->get_bool_attribute(ID::blackbox) ? " blackbox" : "", name.c_str());
+				design->remove(existing_mod);
+			}
+		}
+
+		module = design->addModule(name);
+		module->attributes = std::move(attributes);
+		read_module_body();
+		module->fixup_ports();
+		if (options.lib)
+			module->makeblackbox();
+		module = nullptr;
+	}
+
+	void run()
+	{
+		std::streampos start = f.tellg();
+		if (start != std::streampos(-1)) {
+			f.seekg(0, std::ios::end);
+			std::streampos stop = f.tellg();
+			f.clear();
+			f.seekg(start);
+			if (stop != std::streampos(-1) && stop >= start)
+				remaining = uint64_t(stop - start);
+		}
+		f.clear();
+
+		char header[sizeof(magic)];
+		f.read(header, sizeof(header));
+		if (f.gcount() != sizeof(header) || memcmp(header, magic, sizeof(magic)))
+			log_error("File `%s' is not a binary RTLIL file.\n", filename.c_str());
+		consume(sizeof(header));
+
+		fill(8);
+		uint32_t version = u32();
+		if (version != format_version)
+			log_error("Binary RTLIL file `%s' has unsupported format version %u.\n", filename.c_str(), version);
+		autoidx = max(int(autoidx), int(u32()));
+
+		while (1) {
+			fill(1);
+			uint8_t section = u8();
+			if (section == SECTION_END)
+				break;
+			if (section != SECTION_MODULE)
+				error("invalid section type");
+			read_section();
+		}
+	}
+};
+
+} // namespace
+
+void write_design(std::ostream &f, RTLIL::Design *design, bool only_selected)
+{
+	DesignWriter writer(f, design);
+	writer.run(only_selected);
+}
+
+void read_design(std::istream &f, const std::string &filename, RTLIL::Design *design, const ReadOptions &options)
+{
+	DesignReader reader(f, filename, design, options);
+	reader.run();
+}
+
+} // namespace RTLIL_BIN
+
+YOSYS_NAMESPACE_END
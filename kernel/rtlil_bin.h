@@ -0,0 +1,54 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// Binary serialization of RTLIL designs, used for fast checkpoints.
+//
+// A file starts with a fixed header and is followed by one section per
+// module. Each section first lists the IdStrings it uses that were not seen
+// in an earlier section, so the string table is built up incrementally and
+// every later reference is a 32-bit index. The module body follows with its
+// size up front, which lets a reader skip modules it does not want without
+// decoding them. Objects are written in the reverse of their iteration order
+// so that a loaded design iterates exactly like the one that was saved.
+
+#ifndef RTLIL_BIN_H
+#define RTLIL_BIN_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace RTLIL_BIN
+{
+	struct ReadOptions
+	{
+		bool overwrite = false;
+		bool nooverwrite = false;
+		bool lib = false;
+		// if not empty, only load these modules and skip over the others
+		pool<RTLIL::IdString> modules;
+	};
+
+	void write_design(std::ostream &f, RTLIL::Design *design, bool only_selected = false);
+	void read_design(std::istream &f, const std::string &filename, RTLIL::Design *design, const ReadOptions &options = ReadOptions());
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -235,10 +235,16 @@ class SigSet<T, sort_by_name_id_guard<T>> : public SigSet<T, RTLIL::sort_by_name
  * SigBits that are connected share a set in the underlying database.
  * If a SigBit has a const state (impl: bit.wire is nullptr),
  * it's promoted to a representative.
+ * Wires that never took part in a connection are not looked up bit by bit,
+ * chunks of them are passed through as a whole.
  */
 struct SigMap
 {
 	mfp<SigBit> database;
+	// wires with bits in the database
+	pool<RTLIL::Wire*> mapped_wires;
+	// set when const bits were merged with other bits
+	bool mapped_consts = false;
 
 	SigMap(RTLIL::Module *module = NULL)
 	{
@@ -249,11 +255,15 @@ struct SigMap
 	void swap(SigMap &other)
 	{
 		database.swap(other.database);
+		mapped_wires.swap(other.mapped_wires);
+		std::swap(mapped_consts, other.mapped_consts);
 	}
 
 	void clear()
 	{
 		database.clear();
+		mapped_wires.clear();
+		mapped_consts = false;
 	}
 
 	// Rebuild SigMap for all connections in module
@@ -263,7 +273,7 @@ struct SigMap
 		for (auto &it : module->connections())
 			bitcount += it.first.size();
 
-		database.clear();
+		clear();
 		database.reserve(bitcount);
 
 		for (auto &it : module->connections())
@@ -285,6 +295,13 @@ struct SigMap
 
 			if (bf.wire || bt.wire)
 			{
+				if (from[i].wire)
+					mapped_wires.insert(from[i].wire);
+				if (to[i].wire)
+					mapped_wires.insert(to[i].wire);
+				if (!bf.wire || !bt.wire)
+					mapped_consts = true;
+
 				database.imerge(bfi, bti);
 
 				if (bf.wire == nullptr)
@@ -318,10 +335,45 @@ struct SigMap
 		bit = database.find(bit);
 	}
 
+	bool is_mapped(const RTLIL::SigChunk &chunk) const
+	{
+		return chunk.wire ? mapped_wires.count(chunk.wire) != 0 : mapped_consts;
+	}
+
 	void apply(RTLIL::SigSpec &sig) const
 	{
-		for (auto &bit : sig)
-			apply(bit);
+		bool any_mapped = false;
+		for (auto &chunk : sig.chunks())
+			if (is_mapped(chunk)) {
+				any_mapped = true;
+				break;
+			}
+		if (!any_mapped)
+			return;
+
+		RTLIL::SigSpec mapped;
+		for (auto &chunk : sig.chunks())
+			if (!is_mapped(chunk))
+				mapped.append(chunk);
+			else
+				for (int i = 0; i < chunk.width; i++)
+					mapped.append(database.find(chunk.wire ? RTLIL::SigBit(chunk.wire, chunk.offset + i) : RTLIL::SigBit(chunk.data[i])));
+		sig = std::move(mapped);
+	}
+
+	// Map sig into a caller provided vector of bits, so that the same buffer
+	// can be reused across many lookups
+	void apply(const RTLIL::SigSpec &sig, std::vector<RTLIL::SigBit> &bits) const
+	{
+		bits.clear();
+		bits.reserve(GetSize(sig));
+		for (auto &chunk : sig.chunks()) {
+			bool chunk_mapped = is_mapped(chunk);
+			for (int i = 0; i < chunk.width; i++) {
+				RTLIL::SigBit bit = chunk.wire ? RTLIL::SigBit(chunk.wire, chunk.offset + i) : RTLIL::SigBit(chunk.data[i]);
+				bits.push_back(chunk_mapped ? database.find(bit) : bit);
+			}
+		}
 	}
 
 	RTLIL::SigBit operator()(RTLIL::SigBit bit) const
@@ -354,6 +406,90 @@ struct SigMap
 	}
 };
 
+/**
+ * SigMap of a module that follows changes to the module's connections
+ * through the RTLIL::Monitor interface. New connections are merged in
+ * incrementally; when connections are replaced or removed (which the union
+ * find structure cannot undo), the map is rebuilt on the next lookup.
+ *
+ * The underlying SigMap is only handed out as a const reference, so the map
+ * always reflects the connections of the module. Code that wants to add its
+ * own equivalences or pick representatives has to work on a copy.
+ */
+struct ModSigMap : public RTLIL::Monitor
+{
+	ModSigMap() { }
+
+	ModSigMap(RTLIL::Module *module)
+	{
+		set(module);
+	}
+
+	~ModSigMap()
+	{
+		if (module_ != nullptr)
+			module_->monitors.erase(this);
+	}
+
+	ModSigMap(const ModSigMap&) = delete;
+	ModSigMap &operator=(const ModSigMap&) = delete;
+
+	void set(RTLIL::Module *module)
+	{
+		if (module_ != nullptr)
+			module_->monitors.erase(this);
+		module_ = module;
+		module_->monitors.insert(this);
+		map.set(module_);
+		stale_ = false;
+	}
+
+	RTLIL::Module *module() const { return module_; }
+	bool stale() const { return stale_; }
+
+	const SigMap &sigmap() { refresh(); return map; }
+
+	void apply(RTLIL::SigBit &bit) { refresh(); map.apply(bit); }
+	void apply(RTLIL::SigSpec &sig) { refresh(); map.apply(sig); }
+	void apply(const RTLIL::SigSpec &sig, std::vector<RTLIL::SigBit> &bits) { refresh(); map.apply(sig, bits); }
+
+	RTLIL::SigBit operator()(RTLIL::SigBit bit) { refresh(); return map(bit); }
+	RTLIL::SigSpec operator()(RTLIL::SigSpec sig) { refresh(); return map(sig); }
+	RTLIL::SigSpec operator()(RTLIL::Wire *wire) { refresh(); return map(wire); }
+
+	void notify_connect(RTLIL::Module *mod, const RTLIL::SigSig &sigsig) override
+	{
+		log_assert(module_ == mod);
+		if (!stale_)
+			map.add(sigsig.first, sigsig.second);
+	}
+
+	void notify_connect(RTLIL::Module *mod, const std::vector<RTLIL::SigSig>&) override
+	{
+		log_assert(module_ == mod);
+		stale_ = true;
+	}
+
+	void notify_blackout(RTLIL::Module *mod) override
+	{
+		log_assert(module_ == mod);
+		stale_ = true;
+	}
+
+private:
+	RTLIL::Module *module_ = nullptr;
+	SigMap map;
+	bool stale_ = false;
+
+	void refresh()
+	{
+		if (stale_) {
+			map.set(module_);
+			stale_ = false;
+		}
+	}
+};
+
 YOSYS_NAMESPACE_END
 
 #endif /* SIGTOOLS_H */
@@ -0,0 +1,217 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/threading.h"
+#include "kernel/log.h"
+
+#if defined(__linux__)
+#  include <dirent.h>
+#elif defined(__APPLE__)
+#  include <pthread.h>
+#endif
+
+YOSYS_NAMESPACE_BEGIN
+
+int yosys_jobs = 1;
+
+#ifdef YOSYS_ENABLE_THREADS
+namespace {
+
+struct WorkRange
+{
+	std::mutex mutex;
+	int begin = 0, end = 0;
+};
+
+struct WorkStealingScheduler
+{
+	std::vector<WorkRange> ranges;
+
+	WorkStealingScheduler(int n, int jobs) : ranges(jobs)
+	{
+		for (int t = 0; t < jobs; t++) {
+			ranges[t].begin = int64_t(n) * t / jobs;
+			ranges[t].end = int64_t(n) * (t+1) / jobs;
+		}
+	}
+
+	// returns the next index for thread t to work on, or -1 when all work is taken
+	int next(int t)
+	{
+		WorkRange &own = ranges[t];
+		{
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (own.begin < own.end)
+				return own.begin++;
+		}
+
+		for (int k = 1; k < GetSize(ranges); k++)
+		{
+			WorkRange &victim = ranges[(t + k) % GetSize(ranges)];
+			int stolen_begin, stolen_end;
+			{
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				int count = victim.end - victim.begin;
+				if (count <= 0)
+					continue;
+				stolen_end = victim.end;
+				stolen_begin = victim.end - (count + 1) / 2;
+				victim.end = stolen_begin;
+			}
+
+			std::lock_guard<std::mutex> lock(own.mutex);
+			own.begin = stolen_begin + 1;
+			own.end = stolen_end;
+			return stolen_begin;
+		}
+
+		return -1;
+	}
+};
+
+}
+#endif
+
+void IdSource::next_block(Sequence &seq)
+{
+	seq.block_size = seq.block_size == 0 ? first_block_size : std::min(2 * seq.block_size, max_block_size);
+	seq.next = seq.cursor->fetch_add(seq.block_size);
+	seq.end = seq.next + seq.block_size;
+}
+
+int64_t IdSource::peek(Sequence &seq)
+{
+	if (seq.next >= seq.end)
+		next_block(seq);
+	return seq.next;
+}
+
+int64_t IdSource::take(Sequence &seq)
+{
+	int64_t value = peek(seq);
+	seq.next++;
+	return value;
+}
+
+void IdSource::skip_to(Sequence &seq, int64_t value)
+{
+	if (value < seq.end) {
+		seq.next = std::max(seq.next, value);
+		return;
+	}
+
+	// no other call can take a number below the cursor once it is moved
+	int64_t cursor = seq.cursor->load();
+	while (cursor < value && !seq.cursor->compare_exchange_weak(cursor, value)) { }
+	seq.next = seq.end;
+}
+
+void parallel_for(int n, const std::function<void(int)> &worker, int jobs)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	jobs = std::min(jobs, n);
+
+	// nested calls run on the thread of the enclosing worker and keep using its
+	// IdSource
+	if (jobs > 1 && task_id_source == nullptr)
+	{
+		std::atomic<int64_t> autoidx_cursor(autoidx);
+		std::vector<std::atomic<int64_t>> hashidx_cursors(HASHIDX_KINDS);
+		for (int k = 0; k < HASHIDX_KINDS; k++)
+			hashidx_cursors[k] = hashidx_pos[k];
+
+		std::vector<IdSource> id_sources(n);
+		for (auto &source : id_sources) {
+			source.autoidx.cursor = &autoidx_cursor;
+			for (int k = 0; k < HASHIDX_KINDS; k++)
+				source.hashidx[k].cursor = &hashidx_cursors[k];
+		}
+
+		WorkStealingScheduler scheduler(n, jobs);
+		std::vector<LogCapture> captures(n);
+		std::vector<std::exception_ptr> exceptions(n);
+		int parent_log_make_debug = log_make_debug;
+
+		auto thread_main = [&](int t) {
+			log_make_debug = parent_log_make_debug;
+			for (int i = scheduler.next(t); i >= 0; i = scheduler.next(t)) {
+				log_capture = &captures[i];
+				task_id_source = &id_sources[i];
+				try {
+					worker(i);
+				} catch (...) {
+					exceptions[i] = std::current_exception();
+				}
+				task_id_source = nullptr;
+				captures[i].debug_suppressed += log_debug_suppressed;
+				log_debug_suppressed = 0;
+				log_capture = nullptr;
+			}
+			log_free_thread_caches();
+		};
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < jobs; t++)
+			threads.emplace_back(thread_main, t);
+		for (auto &thread : threads)
+			thread.join();
+
+		// the global counters continue after every block that was handed out
+		log_assert(autoidx_cursor <= INT_MAX);
+		autoidx = int(autoidx_cursor);
+		for (int k = 0; k < HASHIDX_KINDS; k++)
+			hashidx_pos[k] = hashidx_cursors[k];
+
+		for (int i = 0; i < n; i++) {
+			captures[i].replay();
+			if (exceptions[i])
+				std::rethrow_exception(exceptions[i]);
+		}
+		return;
+	}
+#else
+	(void)jobs;
+#endif
+
+	for (int i = 0; i < n; i++)
+		worker(i);
+}
+
+bool is_single_threaded()
+{
+#if defined(__linux__)
+	// every thread of the process has an entry in /proc/self/task
+	DIR *dir = opendir("/proc/self/task");
+	if (dir == nullptr)
+		return false;
+	int count = 0;
+	while (struct dirent *entry = readdir(dir))
+		if (entry->d_name[0] != '.')
+			count++;
+	closedir(dir);
+	return count == 1;
+#elif defined(__APPLE__)
+	// conservative: true only if no thread was ever started
+	return !pthread_is_threaded_np();
+#else
+	return false;
+#endif
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,60 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "kernel/yosys_common.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Maximum number of threads used for work that can run in parallel. Set with
+// "yosys -j <N>", or for one script pass with its -j option (e.g. "synth -j 4").
+// The default of 1 keeps everything on the main thread.
+extern int yosys_jobs;
+
+// Calls worker(i) for every i in [0, n) using up to `jobs` threads. Each thread
+// starts with an equal share of the indices and steals from the others once it
+// runs out of work.
+//
+// Log output of each call is buffered and written out in order of i after all
+// calls have finished, so the log does not depend on the thread schedule. If a
+// call throws, the exception of the lowest such i is rethrown once the log of
+// all calls up to and including it has been written.
+//
+// With more than one job, each call takes the autoidx values and hashidx_ of the
+// objects it creates from blocks handed out to it (see IdSource in
+// kernel/yosys_common.h), so they are unique, but which numbers a call gets
+// depends on the thread schedule. Monitors of the design are notified of
+// changes from the thread that makes them, so a design monitor must only touch
+// state that belongs to the module it is notified about.
+//
+// Without YOSYS_ENABLE_THREADS, when called from inside another parallel_for,
+// or when jobs <= 1 or n <= 1 this simply runs all calls in order on the
+// calling thread, which numbers new objects exactly like a plain loop would.
+void parallel_for(int n, const std::function<void(int)> &worker, int jobs = yosys_jobs);
+
+// Returns true if the calling thread is the only thread of the process, e.g.
+// to check that fork() cannot copy a lock held by another thread. Returns false
+// when this cannot be determined on the platform.
+bool is_single_threaded();
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -77,7 +77,9 @@
 
 YOSYS_NAMESPACE_BEGIN
 
-int autoidx = 1;
+AutoIdx autoidx(1);
+int64_t hashidx_pos[HASHIDX_KINDS];
+thread_local IdSource *task_id_source = nullptr;
 int yosys_xtrace = 0;
 RTLIL::Design *yosys_design = NULL;
 CellTypes yosys_celltypes;
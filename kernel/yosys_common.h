@@ -52,6 +52,13 @@
 #include <sys/stat.h>
 #include <errno.h>
 
+#include <atomic>
+
+#ifdef YOSYS_ENABLE_THREADS
+#include <mutex>
+#include <thread>
+#endif
+
 #ifdef WITH_PYTHON
 #include <Python.h>
 #endif
@@ -347,7 +354,94 @@ std::string escape_filename_spaces(const std::string& filename);
 template<typename T> int GetSize(const T &obj) { return obj.size(); }
 inline int GetSize(RTLIL::Wire *wire);
 
-extern int autoidx;
+// The kinds of RTLIL objects that each have their own sequence of hashidx_
+// values, see next_hashidx() in kernel/rtlil.cc.
+enum HashidxKind {
+	HASHIDX_DESIGN,
+	HASHIDX_MODULE,
+	HASHIDX_WIRE,
+	HASHIDX_MEMORY,
+	HASHIDX_CELL,
+	HASHIDX_PROCESS,
+	HASHIDX_MONITOR,
+	HASHIDX_KINDS
+};
+
+// Numbers for new objects created by the calls of a parallel_for() with more
+// than one job (kernel/threading.h). Each call gets its own IdSource, and the
+// autoidx values and hashidx_ positions of everything it creates are taken from
+// it instead of the global counters.
+//
+// A call takes its numbers in blocks from a cursor that all calls of the same
+// parallel_for() share, starting with first_block_size numbers and doubling up
+// to max_block_size. The numbers are thus unique, and the global counters only
+// move on by the numbers that were taken plus the unused rest of the last block
+// of each call. Which numbers a call gets depends on the thread schedule.
+struct IdSource
+{
+	static constexpr int64_t first_block_size = 16;
+	static constexpr int64_t max_block_size = 4096;
+
+	struct Sequence
+	{
+		std::atomic<int64_t> *cursor = nullptr;
+		int64_t next = 0, end = 0, block_size = 0;
+	};
+
+	Sequence autoidx;
+	Sequence hashidx[HASHIDX_KINDS];
+
+	// the number that the next call of take() returns
+	int64_t peek(Sequence &seq);
+	int64_t take(Sequence &seq);
+	// makes all further numbers at least `value`
+	void skip_to(Sequence &seq, int64_t value);
+
+private:
+	void next_block(Sequence &seq);
+};
+
+extern thread_local IdSource *task_id_source;
+
+// The counter behind the numbers in auto-generated names ("$auto$...$<n>").
+struct AutoIdx
+{
+#ifdef YOSYS_ENABLE_THREADS
+	std::atomic<int> value;
+#else
+	int value;
+#endif
+
+	AutoIdx(int value) : value(value) { }
+	AutoIdx(const AutoIdx &) = delete;
+
+	int operator++(int) {
+		if (task_id_source)
+			return task_id_source->take(task_id_source->autoidx);
+		return value++;
+	}
+
+	// Inside a parallel_for() worker this can only move the counter forward, as
+	// in "autoidx = max(int(autoidx), n)".
+	AutoIdx &operator=(int new_value) {
+		if (task_id_source)
+			task_id_source->skip_to(task_id_source->autoidx, new_value);
+		else
+			value = new_value;
+		return *this;
+	}
+
+	operator int() const {
+		return task_id_source ? task_id_source->peek(task_id_source->autoidx) : int(value);
+	}
+};
+
+extern AutoIdx autoidx;
+
+// Number of hashidx_ values taken so far from the sequence of each kind of
+// RTLIL object, see next_hashidx() in kernel/rtlil.cc.
+extern int64_t hashidx_pos[HASHIDX_KINDS];
+
 extern int yosys_xtrace;
 
 RTLIL::IdString new_id(std::string file, int line, std::string func);
@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "frontends/verilog/preproc.h"
 #include "frontends/ast/ast.h"
+#include "kernel/rtlil_bin.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -47,27 +48,32 @@ struct DesignPass : public Pass {
 		log("\n");
 		log("    design -save <name>\n");
 		log("\n");
-		log("Save the current design under the given name.\n");
+		log("Save a copy of the current design under the given name. Every module is\n");
+		log("copied, so this takes as long and as much memory as the design itself.\n");
 		log("\n");
 		log("\n");
 		log("    design -stash <name>\n");
 		log("\n");
 		log("Save the current design under the given name and then clear the current design.\n");
+		log("The modules are moved to the saved design without copying them.\n");
 		log("\n");
 		log("\n");
 		log("    design -push\n");
 		log("\n");
 		log("Push the current design to the stack and then clear the current design.\n");
+		log("The modules are moved to the stack without copying them.\n");
 		log("\n");
 		log("\n");
 		log("    design -push-copy\n");
 		log("\n");
-		log("Push the current design to the stack without clearing the current design.\n");
+		log("Push a copy of the current design to the stack without clearing the current\n");
+		log("design. Like -save, this copies every module.\n");
 		log("\n");
 		log("\n");
 		log("    design -pop\n");
 		log("\n");
-		log("Reset the current design and pop the last design from the stack.\n");
+		log("Reset the current design and pop the last design from the stack. The modules\n");
+		log("of the popped design are moved without copying them.\n");
 		log("\n");
 		log("\n");
 		log("    design -load <name>\n");
@@ -76,6 +82,18 @@ struct DesignPass : public Pass {
 		log("name.\n");
 		log("\n");
 		log("\n");
+		log("    design -save-file <filename>\n");
+		log("\n");
+		log("Save the current design to a binary RTLIL checkpoint file. This is the same\n");
+		log("format as written by 'write_rtlil_bin'.\n");
+		log("\n");
+		log("\n");
+		log("    design -load-file <filename>\n");
+		log("\n");
+		log("Reset the current design and load a checkpoint file previously written by\n");
+		log("'design -save-file' or 'write_rtlil_bin'.\n");
+		log("\n");
+		log("\n");
 		log("    design -copy-from <name> [-as <new_mod_name>] <selection>\n");
 		log("\n");
 		log("Copy modules from the specified design into the current one. The selection is\n");
@@ -116,6 +134,7 @@ struct DesignPass : public Pass {
 		bool import_mode = false;
 		RTLIL::Design *copy_from_design = NULL, *copy_to_design = NULL;
 		std::string save_name, load_name, as_name, delete_name;
+		std::string save_file_name, load_file_name;
 		std::vector<RTLIL::Module*> copy_src_modules;
 
 		if (!design)
@@ -168,6 +187,18 @@ struct DesignPass : public Pass {
 					log_cmd_error("No saved design '%s' found!\n", load_name.c_str());
 				continue;
 			}
+			if (!got_mode && args[argidx] == "-save-file" && argidx+1 < args.size()) {
+				got_mode = true;
+				save_file_name = args[++argidx];
+				continue;
+			}
+			if (!got_mode && args[argidx] == "-load-file" && argidx+1 < args.size()) {
+				got_mode = true;
+				load_file_name = args[++argidx];
+				if (!check_file_exists(load_file_name))
+					log_cmd_error("Can't open checkpoint file `%s' for reading.\n", load_file_name.c_str());
+				continue;
+			}
 			if (!got_mode && args[argidx] == "-copy-from" && argidx+1 < args.size()) {
 				got_mode = true;
 				if (saved_designs.count(args[++argidx]) == 0)
@@ -343,8 +374,12 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *design_copy = new RTLIL::Design;
 
-			for (auto mod : design->modules())
-				design_copy->add(mod->clone());
+			// -stash and -push clear the design right after, so take its modules.
+			// -save and -push-copy clone every module. Sharing modules until their
+			// first change would need a write barrier that RTLIL does not have.
+			bool move_modules = reset_mode || push_mode;
+			for (auto mod : design->modules().to_vector())
+				design_copy->add(move_modules ? design->release(mod) : mod->clone());
 
 			design_copy->selection_stack = design->selection_stack;
 			design_copy->selection_vars = design->selection_vars;
@@ -359,7 +394,18 @@ struct DesignPass : public Pass {
 				saved_designs[save_name] = design_copy;
 		}
 
-		if (reset_mode || !load_name.empty() || push_mode || pop_mode)
+		if (!save_file_name.empty())
+		{
+			std::ofstream f(save_file_name, std::ofstream::trunc | std::ofstream::binary);
+			if (f.fail())
+				log_cmd_error("Can't open checkpoint file `%s' for writing: %s\n", save_file_name.c_str(), strerror(errno));
+			RTLIL_BIN::write_design(f, design);
+			f.close();
+			if (f.fail())
+				log_cmd_error("Failed to write checkpoint file `%s'.\n", save_file_name.c_str());
+		}
+
+		if (reset_mode || !load_name.empty() || !load_file_name.empty() || push_mode || pop_mode)
 		{
 			for (auto mod : design->modules().to_vector())
 				design->remove(mod);
@@ -371,7 +417,7 @@ struct DesignPass : public Pass {
 			design->selection_stack.push_back(RTLIL::Selection());
 		}
 
-		if (reset_mode || reset_vlog_mode || !load_name.empty() || push_mode || pop_mode)
+		if (reset_mode || reset_vlog_mode || !load_name.empty() || !load_file_name.empty() || push_mode || pop_mode)
 		{
 			for (auto node : design->verilog_packages)
 				delete node;
@@ -388,8 +434,9 @@ struct DesignPass : public Pass {
 		{
 			RTLIL::Design *saved_design = pop_mode ? pushed_designs.back() : saved_designs.at(load_name);
 
-			for (auto mod : saved_design->modules())
-				design->add(mod->clone());
+			// a popped design is deleted afterwards, so take its modules
+			for (auto mod : saved_design->modules().to_vector())
+				design->add(pop_mode ? saved_design->release(mod) : mod->clone());
 
 			design->selection_stack = saved_design->selection_stack;
 			design->selection_vars = saved_design->selection_vars;
@@ -401,6 +448,14 @@ struct DesignPass : public Pass {
 			}
 		}
 
+		if (!load_file_name.empty())
+		{
+			std::ifstream f(load_file_name, std::ifstream::binary);
+			if (f.fail())
+				log_cmd_error("Can't open checkpoint file `%s' for reading: %s\n", load_file_name.c_str(), strerror(errno));
+			RTLIL_BIN::read_design(f, load_file_name, design);
+		}
+
 		if (!delete_name.empty())
 		{
 			auto it = saved_designs.find(delete_name);
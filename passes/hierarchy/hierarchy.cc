@@ -19,6 +19,8 @@
  */
 
 #include "kernel/yosys.h"
+#include "kernel/threading.h"
+#include "frontends/ast/ast.h"
 #include "frontends/verific/verific.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -26,6 +28,7 @@
 
 #ifndef _WIN32
 #  include <unistd.h>
+#  include <sys/wait.h>
 #endif
 
 
@@ -599,6 +602,160 @@ bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool flag_check
 	return did_something;
 }
 
+// Temporary hierarchy cache for the worker processes of prederive_modules(),
+// removed together with its scratchpad entry however hierarchy is left. As
+// log_error() exits without unwinding, it is also removed from the
+// log_error_atexit hook, which then calls the hook it replaced.
+struct TempHierarchyCache
+{
+	static TempHierarchyCache *active;
+	static void (*saved_error_atexit)();
+
+	RTLIL::Design *design;
+	std::string dir;
+
+	TempHierarchyCache(RTLIL::Design *design) : design(design)
+	{
+		log_assert(active == nullptr);
+		dir = make_temp_dir(get_base_tmpdir() + "/yosys_hierarchy_XXXXXX");
+		design->scratchpad_set_string("hierarchy.cache_dir", dir);
+		active = this;
+		saved_error_atexit = log_error_atexit;
+		log_error_atexit = on_error;
+	}
+
+	~TempHierarchyCache()
+	{
+		release();
+		design->scratchpad_unset("hierarchy.cache_dir");
+		remove_directory(dir);
+	}
+
+	void release()
+	{
+		if (active != this)
+			return;
+		log_error_atexit = saved_error_atexit;
+		active = nullptr;
+	}
+
+	static void on_error()
+	{
+		TempHierarchyCache *cache = active;
+		cache->release();
+		remove_directory(cache->dir);
+		if (log_error_atexit)
+			log_error_atexit();
+	}
+};
+
+TempHierarchyCache *TempHierarchyCache::active = nullptr;
+void (*TempHierarchyCache::saved_error_atexit)() = nullptr;
+
+// AST simplify and genRTLIL keep their state in globals of the frontend, so
+// parameterized modules cannot be derived on threads. Instead, the modules
+// instantiated with parameters in the given modules are derived in forked
+// worker processes that only fill the hierarchy cache (see AstModule::derive).
+// expand_module() then loads the results from there and stays the only place
+// that changes the design, so a worker that fails only costs the time it took.
+void prederive_modules(RTLIL::Design *design, const std::set<RTLIL::Module*, IdString::compare_ptr_by_name<Module>> &modules)
+{
+#if !defined(_WIN32) && !defined(YOSYS_DISABLE_SPAWN)
+	std::vector<std::pair<AST::AstModule*, const dict<RTLIL::IdString, RTLIL::Const>*>> jobs;
+	pool<std::string> seen;
+
+	for (auto module : modules)
+	for (auto cell : module->cells())
+	{
+		if (cell->parameters.empty())
+			continue;
+
+		AST::AstModule *mod = dynamic_cast<AST::AstModule*>(design->module(cell->type));
+		if (mod == nullptr || mod->get_blackbox_attribute() || mod->get_bool_attribute(ID::is_interface))
+			continue;
+
+		// interface connections are resolved by expand_module() first
+		bool has_interface_ports = false;
+		for (auto port : mod->ports)
+			if (mod->wire(port)->get_bool_attribute(ID::is_interface))
+				has_interface_ports = true;
+		if (has_interface_ports)
+			continue;
+
+		std::string key = cell->type.str();
+		for (auto &it : cell->parameters)
+			key += stringf(" %s=%s", log_id(it.first), it.second.as_string().c_str());
+		if (seen.insert(key).second)
+			jobs.push_back({mod, &cell->parameters});
+	}
+
+	int workers = std::min(yosys_jobs, GetSize(jobs));
+	if (workers < 2)
+		return;
+
+	// fork() only copies the calling thread, so a lock held by another thread
+	// (of a plugin, or of an application that embeds yosys) would never be
+	// released in the workers
+	if (!is_single_threaded()) {
+		log("Other threads are running, deriving parameterized modules in this process.\n");
+		return;
+	}
+
+	log("Deriving %d parameterized modules in %d worker processes.\n", GetSize(jobs), workers);
+	log_flush();
+
+	std::vector<pid_t> pids;
+	for (int i = 0; i < workers; i++)
+	{
+		pid_t pid = fork();
+		if (pid != 0) {
+			if (pid > 0)
+				pids.push_back(pid);
+			continue;
+		}
+
+		// the worker only writes cache entries, everything it would log is
+		// logged again by the derivation in the parent
+		log_files.clear();
+		log_streams.clear();
+		log_errfile = nullptr;
+		log_error_atexit = nullptr;
+		log_expect_log.clear();
+		log_expect_warning.clear();
+		log_expect_error.clear();
+		log_cmd_error_throw = true;
+
+		try {
+			for (int k = i; k < GetSize(jobs); k += workers)
+				jobs[k].first->derive(design, *jobs[k].second, false);
+		} catch (...) {
+			_exit(1);
+		}
+		_exit(0);
+	}
+
+	for (auto pid : pids) {
+		int status;
+		while (waitpid(pid, &status, 0) < 0)
+			if (errno != EINTR) {
+				log_warning("Waiting for hierarchy worker process %d failed: %s\n", int(pid), strerror(errno));
+				status = 0;
+				break;
+			}
+		// the modules of a failed worker are derived by expand_module(), which
+		// also reports the errors that made it fail
+		if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+			log("Hierarchy worker process %d failed, its modules are derived in this process.\n", int(pid));
+		else if (WIFSIGNALED(status))
+			log_warning("Hierarchy worker process %d was terminated by signal %d, its modules are derived in this process.\n",
+					int(pid), WTERMSIG(status));
+	}
+#else
+	(void)design;
+	(void)modules;
+#endif
+}
+
 void hierarchy_worker(RTLIL::Design *design, std::set<RTLIL::Module*, IdString::compare_ptr_by_name<Module>> &used, RTLIL::Module *mod, int indent)
 {
 	if (used.count(mod) > 0)
@@ -741,6 +898,18 @@ struct HierarchyPass : public Pass {
 		log("needed. It also resolves assignments to wired logic data types (wand/wor),\n");
 		log("resolves positional module parameters, unrolls array instances, and more.\n");
 		log("\n");
+		log("When the scratchpad variable hierarchy.cache_dir is set to a directory, the\n");
+		log("modules derived from the Verilog frontend are also stored there and loaded\n");
+		log("again when a later run derives the same module with the same parameters.\n");
+		log("\n");
+		log("With more than one job (yosys -j), the modules instantiated with parameters\n");
+		log("are first derived in that many forked worker processes, which hand their\n");
+		log("results back through the hierarchy cache (a temporary one unless\n");
+		log("hierarchy.cache_dir is set). As fork() is not safe while other threads run,\n");
+		log("this is only done when yosys is the only thread of the process (and never on\n");
+		log("platforms where that cannot be checked); otherwise all modules are derived\n");
+		log("in this process.\n");
+		log("\n");
 		log("    -check\n");
 		log("        also check the design hierarchy. this generates an error when\n");
 		log("        an unknown module is used as cell type.\n");
@@ -1066,6 +1235,14 @@ struct HierarchyPass : public Pass {
 					mod->attributes.erase(ID::initial_top);
 		}
 
+#if !defined(_WIN32) && !defined(YOSYS_DISABLE_SPAWN)
+		// the worker processes of prederive_modules() hand their results back
+		// through the hierarchy cache, use a temporary one if none is set
+		std::unique_ptr<TempHierarchyCache> temp_cache;
+		if (yosys_jobs > 1 && design->scratchpad_get_string("hierarchy.cache_dir").empty())
+			temp_cache.reset(new TempHierarchyCache(design));
+#endif
+
 		bool did_something = true;
 		while (did_something)
 		{
@@ -1080,6 +1257,9 @@ struct HierarchyPass : public Pass {
 					used_modules.insert(mod);
 			}
 
+			if (yosys_jobs > 1)
+				prederive_modules(design, used_modules);
+
 			for (auto module : used_modules) {
 				if (expand_module(design, module, flag_check, flag_simcheck, flag_smtcheck, libdirs))
 					did_something = true;
@@ -1108,6 +1288,10 @@ struct HierarchyPass : public Pass {
 			}
 		}
 
+#if !defined(_WIN32) && !defined(YOSYS_DISABLE_SPAWN)
+		temp_cache.reset();
+#endif
+
 
 		if (top_mod != NULL) {
 			log_header(design, "Analyzing design hierarchy..\n");
@@ -104,9 +104,9 @@ keep_cache_t keep_cache;
 CellTypes ct_reg, ct_all;
 int count_rm_cells, count_rm_wires;
 
-void rmunused_module_cells(Module *module, bool verbose)
+void rmunused_module_cells(ModSigMap &modmap, Module *module, bool verbose)
 {
-	SigMap sigmap(module);
+	const SigMap &sigmap = modmap.sigmap();
 	dict<IdString, pool<Cell*>> mem2cells;
 	pool<IdString> mem_unused;
 	pool<Cell*> queue, unused;
@@ -298,7 +298,7 @@ bool check_public_name(RTLIL::IdString id)
 	return true;
 }
 
-bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbose)
+bool rmunused_module_signals(ModSigMap &modmap, RTLIL::Module *module, bool purge_mode, bool verbose)
 {
 	// `register_signals` and `connected_signals` will help us decide later on
 	// on picking representatives out of groups of connected signals
@@ -317,7 +317,8 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 				connected_signals.add(it2.second);
 		}
 
-	SigMap assign_map(module);
+	// a private copy, the representatives are re-chosen below
+	SigMap assign_map = modmap.sigmap();
 
 	// construct a pool of wires which are directly driven by a known celltype,
 	// this will influence our choice of representatives
@@ -349,7 +350,7 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 	}
 
 	// we are removing all connections
-	module->connections_.clear();
+	module->new_connections({});
 
 	// used signals sigmapped
 	SigPool used_signals;
@@ -513,13 +514,13 @@ bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbos
 	return !del_wires_queue.empty();
 }
 
-bool rmunused_module_init(RTLIL::Module *module, bool verbose)
+bool rmunused_module_init(ModSigMap &modmap, RTLIL::Module *module, bool verbose)
 {
 	bool did_something = false;
 	CellTypes fftypes;
 	fftypes.setup_internals_mem();
 
-	SigMap sigmap(module);
+	SigMap sigmap = modmap.sigmap();
 	dict<SigBit, State> qbits;
 
 	for (auto cell : module->cells())
@@ -599,6 +600,7 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 	if (verbose)
 		log("Finding unused cells or wires in module %s..\n", module->name.c_str());
 
+	ModSigMap sigmap(module);
 	std::vector<RTLIL::Cell*> delcells;
 	for (auto cell : module->cells())
 		if (cell->type.in(ID($pos), ID($_BUF_)) && !cell->has_keep_attr()) {
@@ -618,11 +620,11 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 	if (!delcells.empty())
 		module->design->scratchpad_set_bool("opt.did_something", true);
 
-	rmunused_module_cells(module, verbose);
-	while (rmunused_module_signals(module, purge_mode, verbose)) { }
+	rmunused_module_cells(sigmap, module, verbose);
+	while (rmunused_module_signals(sigmap, module, purge_mode, verbose)) { }
 
-	if (rminit && rmunused_module_init(module, verbose))
-		while (rmunused_module_signals(module, purge_mode, verbose)) { }
+	if (rminit && rmunused_module_init(sigmap, module, verbose))
+		while (rmunused_module_signals(sigmap, module, purge_mode, verbose)) { }
 }
 
 struct OptCleanPass : public Pass {
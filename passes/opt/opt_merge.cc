@@ -35,13 +35,22 @@ struct OptMergeWorker
 {
 	RTLIL::Design *design;
 	RTLIL::Module *module;
-	SigMap assign_map;
+	ModSigMap assign_map;
 	FfInitVals initvals;
 	bool mode_share_all;
 
 	CellTypes ct;
 	int total_count;
 
+	// initvals looks up the SigMap of assign_map directly and keys its bits by
+	// the representatives of that map. When a bulk change of the connections
+	// has made assign_map stale, both are rebuilt before initvals is used.
+	void refresh_initvals()
+	{
+		if (assign_map.stale())
+			initvals.set(&assign_map.sigmap(), module);
+	}
+
 	static void sort_pmux_conn(dict<RTLIL::IdString, RTLIL::SigSpec> &conn)
 	{
 		SigSpec sig_s = conn.at(ID::S);
@@ -65,90 +74,92 @@ struct OptMergeWorker
 		}
 	}
 
-	std::string int_to_hash_string(unsigned int v)
+	// 64 bit hashing (splitmix64 finalizer), so that buckets stay unique even
+	// for modules with millions of cells
+	static inline uint64_t hash_mix(uint64_t x)
 	{
-		if (v == 0)
-			return "0";
-		std::string str = "";
-		while (v > 0) {
-			str += 'a' + (v & 15);
-			v = v >> 4;
-		}
-		return str;
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
 	}
 
-        uint64_t hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	static inline uint64_t hash_add(uint64_t h, uint64_t v)
 	{
-		vector<string> hash_conn_strings;
-		std::string hash_string = cell->type.str() + "\n";
-
-		const dict<RTLIL::IdString, RTLIL::SigSpec> *conn = &cell->connections();
-		dict<RTLIL::IdString, RTLIL::SigSpec> alt_conn;
-
-		if (cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
-				ID($logic_and), ID($logic_or), ID($_AND_), ID($_OR_), ID($_XOR_))) {
-			alt_conn = *conn;
-			if (assign_map(alt_conn.at(ID::A)) < assign_map(alt_conn.at(ID::B))) {
-				alt_conn[ID::A] = conn->at(ID::B);
-				alt_conn[ID::B] = conn->at(ID::A);
-			}
-			conn = &alt_conn;
-		} else
-		if (cell->type.in(ID($reduce_xor), ID($reduce_xnor))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort();
-			conn = &alt_conn;
-		} else
-		if (cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool))) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			alt_conn.at(ID::A).sort_and_unify();
-			conn = &alt_conn;
-		} else
-		if (cell->type == ID($pmux)) {
-			alt_conn = *conn;
-			assign_map.apply(alt_conn.at(ID::A));
-			assign_map.apply(alt_conn.at(ID::B));
-			assign_map.apply(alt_conn.at(ID::S));
-			sort_pmux_conn(alt_conn);
-			conn = &alt_conn;
-		}
+		return hash_mix(h + v + 0x9e3779b97f4a7c15ULL);
+	}
+
+	static inline uint64_t hash_bit(const RTLIL::SigBit &bit)
+	{
+		if (bit.wire)
+			return (uint64_t(bit.wire->name.index_) << 32) | uint32_t(bit.offset);
+		return (uint64_t(1) << 63) | uint64_t(bit.data);
+	}
 
-		for (auto &it : *conn) {
-			RTLIL::SigSpec sig;
+	static uint64_t hash_bits(std::vector<RTLIL::SigBit>::const_iterator begin, std::vector<RTLIL::SigBit>::const_iterator end)
+	{
+		uint64_t h = 0;
+		for (auto it = begin; it != end; ++it)
+			h = hash_add(h, hash_bit(*it));
+		return h;
+	}
+
+	std::vector<RTLIL::SigBit> hash_bits_a, hash_bits_b;
+
+	// Hash of everything compare_cell_parameters_and_connections() looks at.
+	// Ports and parameters are combined by addition so that their order does
+	// not matter, the same goes for the inputs of commutative cells.
+	uint64_t hash_cell_parameters_and_connections(const RTLIL::Cell *cell)
+	{
+		bool commutative = cell->type.in(ID($and), ID($or), ID($xor), ID($xnor), ID($add), ID($mul),
+				ID($logic_and), ID($logic_or), ID($_AND_), ID($_OR_), ID($_XOR_));
+		bool reduce_sort = cell->type.in(ID($reduce_xor), ID($reduce_xnor));
+		bool reduce_unify = cell->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_bool));
+		bool pmux = cell->type == ID($pmux);
+
+		uint64_t conn_hash = 0;
+		for (auto &it : cell->connections()) {
+			uint64_t port_hash;
 			if (cell->output(it.first)) {
 				if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell->type)) {
 					// For the 'Q' output of state elements,
 					//   use its (* init *) attribute value
-					sig = initvals(it.second);
+					refresh_initvals();
+					port_hash = initvals(it.second).hash();
 				}
 				else
 					continue;
 			}
-			else
-				sig = assign_map(it.second);
-			string s = "C " + it.first.str() + "=";
-			for (auto &chunk : sig.chunks()) {
-				if (chunk.wire)
-					s += "{" + chunk.wire->name.str() + " " +
-							int_to_hash_string(chunk.offset) + " " +
-							int_to_hash_string(chunk.width) + "}";
-				else
-					s += RTLIL::Const(chunk.data).as_string();
+			else if (pmux && it.first == ID::B)
+				continue;
+			else if (pmux && it.first == ID::S) {
+				// the order of the (S, B) pairs does not matter
+				assign_map.apply(it.second, hash_bits_a);
+				assign_map.apply(cell->getPort(ID::B), hash_bits_b);
+				int width = GetSize(hash_bits_b) / std::max(GetSize(hash_bits_a), 1);
+				port_hash = 0;
+				for (int i = 0; i < GetSize(hash_bits_a); i++)
+					port_hash += hash_add(hash_bit(hash_bits_a[i]), hash_bits(hash_bits_b.begin() + i*width, hash_bits_b.begin() + (i+1)*width));
 			}
-			hash_conn_strings.push_back(s + "\n");
+			else {
+				assign_map.apply(it.second, hash_bits_a);
+				if ((reduce_sort || reduce_unify) && it.first == ID::A)
+					std::sort(hash_bits_a.begin(), hash_bits_a.end());
+				if (reduce_unify && it.first == ID::A)
+					hash_bits_a.erase(std::unique(hash_bits_a.begin(), hash_bits_a.end()), hash_bits_a.end());
+				port_hash = hash_bits(hash_bits_a.begin(), hash_bits_a.end());
+			}
+			RTLIL::IdString port = commutative && it.first == ID::B ? ID::A : it.first;
+			conn_hash += hash_add(port.index_, port_hash);
 		}
 
+		uint64_t param_hash = 0;
 		for (auto &it : cell->parameters)
-			hash_conn_strings.push_back("P " + it.first.str() + "=" + it.second.as_string() + "\n");
-
-		std::sort(hash_conn_strings.begin(), hash_conn_strings.end());
+			param_hash += hash_add(it.first.index_, it.second.hash());
 
-		for (auto it : hash_conn_strings)
-			hash_string += it;
-
-		return std::hash<std::string>{}(hash_string);
+		return hash_add(hash_add(cell->type.index_, conn_hash), param_hash);
 	}
 
 	bool compare_cell_parameters_and_connections(const RTLIL::Cell *cell1, const RTLIL::Cell *cell2)
@@ -174,6 +185,7 @@ struct OptMergeWorker
 				if (it.first == ID::Q && RTLIL::builtin_ff_cell_types().count(cell1->type)) {
 					// For the 'Q' output of state elements,
 					//   use the (* init *) attribute value
+					refresh_initvals();
 					conn1[it.first] = initvals(it.second);
 					conn2[it.first] = initvals(cell2->getPort(it.first));
 				}
@@ -222,6 +234,7 @@ struct OptMergeWorker
 		if (!RTLIL::builtin_ff_cell_types().count(cell->type))
 			return false;
 
+		refresh_initvals();
 		return !initvals(cell->getPort(ID::Q)).is_fully_def();
 	}
 
@@ -247,9 +260,8 @@ struct OptMergeWorker
 		ct.cell_types.erase(ID($allconst));
 
 		log("Finding identical cells in module `%s'.\n", module->name.c_str());
-		assign_map.set(module);
 
-		initvals.set(&assign_map, module);
+		initvals.set(&assign_map.sigmap(), module);
 
 		bool did_something = true;
 		while (did_something)
@@ -293,11 +305,11 @@ struct OptMergeWorker
 								RTLIL::SigSpec other_sig = r.first->second->getPort(it.first);
 								log_debug("    Redirecting output %s: %s = %s\n", it.first.c_str(),
 										log_signal(it.second), log_signal(other_sig));
+								refresh_initvals();
 								Const init = initvals(other_sig);
 								initvals.remove_init(it.second);
 								initvals.remove_init(other_sig);
 								module->connect(RTLIL::SigSig(it.second, other_sig));
-								assign_map.add(it.second, other_sig);
 								initvals.set_init(other_sig, init);
 							}
 						}
@@ -314,7 +326,9 @@ struct OptMergeWorker
 };
 
 struct OptMergePass : public Pass {
-	OptMergePass() : Pass("opt_merge", "consolidate identical cells") { }
+	OptMergePass() : Pass("opt_merge", "consolidate identical cells") {
+		module_local();
+	}
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -361,15 +375,15 @@ struct OptMergePass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		int total_count = 0;
-		for (auto module : design->selected_modules()) {
+		std::atomic<int> total_count(0);
+		parallel_for_modules(design->selected_modules(), [&](RTLIL::Module *module) {
 			OptMergeWorker worker(design, module, mode_nomux, mode_share_all, mode_keepdc);
 			total_count += worker.total_count;
-		}
+		});
 
 		if (total_count)
 			design->scratchpad_set_bool("opt.did_something", true);
-		log("Removed a total of %d cells.\n", total_count);
+		log("Removed a total of %d cells.\n", int(total_count));
 	}
 } OptMergePass;
 
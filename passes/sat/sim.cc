@@ -26,8 +26,11 @@
 #include "kernel/yw.h"
 #include "kernel/json.h"
 #include "kernel/fmt.h"
+#include "kernel/utils.h"
+#include "kernel/threading.h"
 
 #include <ctime>
+#include <condition_variable>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -125,6 +128,7 @@ struct SimShared
 	bool serious_asserts = false;
 	bool fst_noinit = false;
 	bool initstate = true;
+	bool compiled = false;
 };
 
 void zinit(State &v)
@@ -139,6 +143,44 @@ void zinit(Const &v)
 		zinit(bit);
 }
 
+// single-bit versions of the gate evaluation in CellTypes::eval()
+static State sim_gate_not(State a)
+{
+	return a == State::S0 ? State::S1 : a == State::S1 ? State::S0 : a;
+}
+
+static State sim_gate_and(State a, State b)
+{
+	if (a == State::S0 || b == State::S0)
+		return State::S0;
+	return a == State::S1 && b == State::S1 ? State::S1 : State::Sx;
+}
+
+static State sim_gate_or(State a, State b)
+{
+	if (a == State::S1 || b == State::S1)
+		return State::S1;
+	return a == State::S0 && b == State::S0 ? State::S0 : State::Sx;
+}
+
+static State sim_gate_xor(State a, State b)
+{
+	if (a > State::S1 || b > State::S1)
+		return State::Sx;
+	return a != b ? State::S1 : State::S0;
+}
+
+static State sim_gate_mux(State a, State b, State s)
+{
+	if (s == State::S0)
+		return a;
+	if (s == State::S1)
+		return b;
+	return a == b ? a : State::Sx;
+}
+
+typedef RTLIL::Const (*sim_word_func_t)(const RTLIL::Const&, const RTLIL::Const&, bool, bool, int);
+
 struct SimInstance
 {
 	SimShared *shared;
@@ -163,6 +205,67 @@ struct SimInstance
 	pool<IdString> dirty_memories;
 	pool<SimInstance*, hash_ptr_ops> dirty_children;
 
+	// With "sim -compiled" the combinational cells are compiled into a
+	// topologically sorted program over a dense, word-packed array of nets,
+	// replacing state_nets and the cell lookups in update_ph1() for those
+	// cells. The signals of FFs, memories, submodules and the other cells read
+	// or written in every cycle are resolved to nets once as well.
+	enum class sim_op_t {
+		// single-bit gates evaluated directly on State values
+		Buf, Not, And, Nand, Or, Nor, Xor, Xnor, AndNot, OrNot, Mux, NMux,
+		// word-level cells evaluated with a const_* function selected at compile time
+		Word,
+		// $mux evaluated on whole words
+		WordMux,
+		// everything else goes through CellTypes::eval() like update_cell() does
+		EvalA, EvalABC, EvalAS, EvalABS
+	};
+
+	// a signal resolved to nets, `base` is the first of them when they are
+	// consecutive so that the value can be moved in whole words
+	struct sim_port_t
+	{
+		int base = -1;
+		std::vector<int> nets;
+	};
+
+	struct sim_instr_t
+	{
+		Cell *cell;
+		sim_op_t op;
+		sim_word_func_t func = nullptr;
+		bool signed_a = false, signed_b = false;
+		int result_len = -1;
+		sim_port_t a, b, c, s, y;
+	};
+
+	// something outside the program that has to run when one of its nets
+	// changes: the inputs of a submodule, the read ports of a memory, an
+	// output port driving the parent, or a cell left to update_cell()
+	struct sim_user_t
+	{
+		Cell *cell = nullptr;
+		SimInstance *child = nullptr;
+		IdString memid;
+		Wire *outport = nullptr;
+		// (source, destination) pairs copied into the child or the parent
+		std::vector<std::pair<sim_port_t, sim_port_t>> copy;
+		bool queued = false;
+	};
+
+	bool compiled = false;
+	dict<SigBit, int> net_index;
+	Const::Packed net_state;
+	std::vector<std::vector<int>> net_fanout;
+	std::vector<std::vector<int>> net_users;
+	std::vector<sim_instr_t> program;
+	std::vector<bool> instr_dirty;
+	int first_dirty = 0, program_pos = 0;
+	std::vector<sim_user_t> users;
+	std::vector<int> user_queue;
+	// nets of the wires in signal_database, fst_inputs and fst_handles, in iteration order
+	std::vector<sim_port_t> signal_ports, fst_input_ports, fst_handle_ports;
+
 	struct ff_state_t
 	{
 		Const past_d;
@@ -172,6 +275,9 @@ struct SimInstance
 		State past_srst;
 		
 		FfData data;
+
+		sim_port_t port_q, port_d, port_ad, port_clk, port_ce, port_srst;
+		sim_port_t port_aload, port_arst, port_clr, port_set;
 	};
 
 	struct mem_state_t
@@ -182,6 +288,9 @@ struct SimInstance
 		std::vector<Const> past_wr_addr;
 		std::vector<Const> past_wr_data;
 		Const data;
+
+		std::vector<sim_port_t> rd_addr, rd_data;
+		std::vector<sim_port_t> wr_clk, wr_en, wr_addr, wr_data;
 	};
 
 	struct print_state_t
@@ -194,6 +303,8 @@ struct SimInstance
 		Cell *cell;
 		Fmt fmt;
 
+		sim_port_t port_trg, port_en, port_args;
+
 		std::tuple<bool, SigSpec, Const, int, Cell*> _sort_label() const
 		{
 			return std::make_tuple(
@@ -214,6 +325,8 @@ struct SimInstance
 	dict<Cell*, ff_state_t> ff_database;
 	dict<IdString, mem_state_t> mem_database;
 	pool<Cell*> formal_database;
+	// nets of the A and EN inputs of formal_database, in iteration order
+	std::vector<std::pair<sim_port_t, sim_port_t>> formal_ports;
 	pool<Cell*> initstate_database;
 	dict<Cell*, IdString> mem_cells;
 	std::vector<print_state_t> print_database;
@@ -292,6 +405,12 @@ struct SimInstance
 				mdb.past_wr_addr.push_back(Const(State::Sx, GetSize(port.addr)));
 				mdb.past_wr_data.push_back(Const(State::Sx, GetSize(port.data)));
 			}
+			mdb.rd_addr.resize(GetSize(mem.rd_ports));
+			mdb.rd_data.resize(GetSize(mem.rd_ports));
+			mdb.wr_clk.resize(GetSize(mem.wr_ports));
+			mdb.wr_en.resize(GetSize(mem.wr_ports));
+			mdb.wr_addr.resize(GetSize(mem.wr_ports));
+			mdb.wr_data.resize(GetSize(mem.wr_ports));
 			mdb.data = mem.get_init_data();
 		}
 
@@ -338,8 +457,10 @@ struct SimInstance
 					fst_memories[name] = shared->fst->getMemoryHandles(scope + "." + RTLIL::unescape_id(name));
 			}
 
-			if (cell->type.in(ID($assert), ID($cover), ID($assume)))
+			if (cell->type.in(ID($assert), ID($cover), ID($assume))) {
 				formal_database.insert(cell);
+				formal_ports.emplace_back();
+			}
 
 			if (cell->type == ID($initstate))
 				initstate_database.insert(cell);
@@ -379,6 +500,9 @@ struct SimInstance
 				zinit(mem.data);
 			}
 		}
+
+		if (shared->compiled)
+			compile_program();
 	}
 
 	~SimInstance()
@@ -424,7 +548,10 @@ struct SimInstance
 		for (auto bit : sigmap(sig))
 			if (bit.wire == nullptr)
 				value.bits().push_back(bit.data);
-			else if (state_nets.count(bit))
+			else if (compiled) {
+				auto it = net_index.find(bit);
+				value.bits().push_back(it != net_index.end() ? net_state.get(it->second) : State::Sz);
+			} else if (state_nets.count(bit))
 				value.bits().push_back(state_nets.at(bit));
 			else
 				value.bits().push_back(State::Sz);
@@ -441,6 +568,11 @@ struct SimInstance
 		sig = sigmap(sig);
 		log_assert(GetSize(sig) <= GetSize(value));
 
+		if (compiled) {
+			for (int i = 0; i < GetSize(sig); i++)
+				if (value[i] != State::Sa && set_net(net_index.at(sig[i]), value[i]))
+					did_something = true;
+		} else
 		for (int i = 0; i < GetSize(sig); i++)
 			if (value[i] != State::Sa && state_nets.at(sig[i]) != value[i]) {
 				state_nets.at(sig[i]) = value[i];
@@ -587,6 +719,491 @@ struct SimInstance
 		log_error("Unsupported cell type: %s (%s.%s)\n", log_id(cell->type), log_id(module), log_id(cell));
 	}
 
+	int net(SigBit bit)
+	{
+		auto it = net_index.find(bit);
+		if (it != net_index.end())
+			return it->second;
+		int idx = net_state.width++;
+		if (idx % 64 == 0)
+			net_state.words.resize(net_state.words.size() + 2);
+		State init = bit.wire ? State::Sz : bit.data;
+		// Sa and Sm cannot be stored in the packed form
+		if (init > State::Sz)
+			init = State::Sx;
+		net_state.set(idx, init);
+		net_index.emplace(bit, idx);
+		net_fanout.emplace_back();
+		net_users.emplace_back();
+		return idx;
+	}
+
+	sim_port_t port(SigSpec sig)
+	{
+		sim_port_t result;
+		for (auto bit : sigmap(sig))
+			result.nets.push_back(net(bit));
+		if (!result.nets.empty()) {
+			result.base = result.nets[0];
+			for (int i = 1; i < GetSize(result.nets); i++)
+				if (result.nets[i] != result.base + i) {
+					result.base = -1;
+					break;
+				}
+		}
+		return result;
+	}
+
+	void mark_dirty(int instr)
+	{
+		instr_dirty[instr] = true;
+		if (instr <= program_pos)
+			first_dirty = std::min(first_dirty, instr);
+	}
+
+	void queue_user(int user)
+	{
+		if (!users[user].queued) {
+			users[user].queued = true;
+			user_queue.push_back(user);
+		}
+	}
+
+	void net_changed(int idx)
+	{
+		for (int instr : net_fanout[idx])
+			mark_dirty(instr);
+		for (int user : net_users[idx])
+			queue_user(user);
+	}
+
+	bool set_net(int idx, State value)
+	{
+		if (net_state.get(idx) == value)
+			return false;
+		net_state.set(idx, value);
+		net_changed(idx);
+		return true;
+	}
+
+	// the 64 bits of `plane` (0 for the values, 1 for the unknown bits)
+	// of the nets starting at `pos`
+	uint64_t load_word(int plane, int pos) const
+	{
+		int w = pos / 64, sh = pos % 64;
+		uint64_t result = net_state.words[2*w + plane] >> sh;
+		if (sh != 0 && w + 1 < net_state.num_words())
+			result |= net_state.words[2*(w+1) + plane] << (64 - sh);
+		return result;
+	}
+
+	void store_word(int plane, int pos, uint64_t data, uint64_t mask)
+	{
+		int w = pos / 64, sh = pos % 64;
+		uint64_t &lo = net_state.words[2*w + plane];
+		lo = (lo & ~(mask << sh)) | ((data & mask) << sh);
+		if (sh != 0 && (mask >> (64 - sh)) != 0) {
+			uint64_t &hi = net_state.words[2*(w+1) + plane];
+			hi = (hi & ~(mask >> (64 - sh))) | ((data & mask) >> (64 - sh));
+		}
+	}
+
+	Const get_port(const sim_port_t &port) const
+	{
+		Const::Packed value(GetSize(port.nets));
+		if (port.base >= 0) {
+			for (int i = 0; i < value.num_words(); i++) {
+				value.val(i) = load_word(0, port.base + 64*i) & value.mask(i);
+				value.unk(i) = load_word(1, port.base + 64*i) & value.mask(i);
+			}
+		} else {
+			for (int i = 0; i < GetSize(port.nets); i++)
+				value.set(i, net_state.get(port.nets[i]));
+		}
+		return Const(std::move(value));
+	}
+
+	bool set_port(const sim_port_t &port, const Const &value)
+	{
+		bool did_something = false;
+		int width = GetSize(port.nets);
+		log_assert(width <= GetSize(value));
+
+		Const::Packed packed;
+		if (port.base < 0 || !value.to_packed(packed)) {
+			for (int i = 0; i < width; i++)
+				if (value[i] != State::Sa && set_net(port.nets[i], value[i]))
+					did_something = true;
+			return did_something;
+		}
+
+		for (int i = 0; 64*i < width; i++) {
+			int pos = port.base + 64*i;
+			uint64_t mask = width - 64*i >= 64 ? ~uint64_t(0) : (uint64_t(1) << (width - 64*i)) - 1;
+			uint64_t val = packed.val(i), unk = packed.unk(i);
+			uint64_t changed = ((load_word(0, pos) ^ val) | (load_word(1, pos) ^ unk)) & mask;
+			if (changed == 0)
+				continue;
+			store_word(0, pos, val, changed);
+			store_word(1, pos, unk, changed);
+			for (int k = 0; changed != 0; k++, changed >>= 1)
+				if (changed & 1)
+					net_changed(pos + k);
+			did_something = true;
+		}
+		return did_something;
+	}
+
+	// get_state() and set_state() for signals that were resolved to nets
+	// by compile_program(), so that they can be used without lookups
+	Const get_state(const SigSpec &sig, const sim_port_t &port)
+	{
+		if (!compiled)
+			return get_state(sig);
+
+		Const value = get_port(port);
+		if (shared->debug)
+			log("[%s] get %s: %s\n", hiername().c_str(), log_signal(sig), log_signal(value));
+		return value;
+	}
+
+	bool set_state(const SigSpec &sig, const sim_port_t &port, const Const &value)
+	{
+		if (!compiled)
+			return set_state(sig, value);
+
+		if (shared->debug)
+			log("[%s] set %s: %s\n", hiername().c_str(), log_signal(sig), log_signal(value));
+		return set_port(port, value);
+	}
+
+	// the nets of the wires in `wires`, in iteration order
+	template<typename T>
+	void wire_ports(const dict<Wire*, T> &wires, std::vector<sim_port_t> &ports)
+	{
+		if (GetSize(ports) == GetSize(wires))
+			return;
+		ports.clear();
+		for (auto &it : wires)
+			ports.push_back(port(it.first));
+	}
+
+	bool compile_cell(Cell *cell, sim_instr_t &instr)
+	{
+		if (ff_database.count(cell) || formal_database.count(cell) || mem_cells.count(cell) || children.count(cell))
+			return false;
+		if (!yosys_celltypes.cell_evaluable(cell->type))
+			return false;
+
+		static const dict<IdString, sim_op_t> gate_ops = {
+			{ID($_BUF_), sim_op_t::Buf}, {ID($_NOT_), sim_op_t::Not},
+			{ID($_AND_), sim_op_t::And}, {ID($_NAND_), sim_op_t::Nand},
+			{ID($_OR_), sim_op_t::Or}, {ID($_NOR_), sim_op_t::Nor},
+			{ID($_XOR_), sim_op_t::Xor}, {ID($_XNOR_), sim_op_t::Xnor},
+			{ID($_ANDNOT_), sim_op_t::AndNot}, {ID($_ORNOT_), sim_op_t::OrNot},
+			{ID($_MUX_), sim_op_t::Mux}, {ID($_NMUX_), sim_op_t::NMux},
+		};
+		static const dict<IdString, sim_word_func_t> word_funcs = {
+			{ID($not), RTLIL::const_not}, {ID($pos), RTLIL::const_pos}, {ID($neg), RTLIL::const_neg},
+			{ID($and), RTLIL::const_and}, {ID($or), RTLIL::const_or},
+			{ID($xor), RTLIL::const_xor}, {ID($xnor), RTLIL::const_xnor},
+			{ID($reduce_and), RTLIL::const_reduce_and}, {ID($reduce_or), RTLIL::const_reduce_or},
+			{ID($reduce_xor), RTLIL::const_reduce_xor}, {ID($reduce_xnor), RTLIL::const_reduce_xnor},
+			{ID($reduce_bool), RTLIL::const_reduce_bool}, {ID($logic_not), RTLIL::const_logic_not},
+			{ID($logic_and), RTLIL::const_logic_and}, {ID($logic_or), RTLIL::const_logic_or},
+			{ID($shl), RTLIL::const_shl}, {ID($shr), RTLIL::const_shr},
+			{ID($sshl), RTLIL::const_sshl}, {ID($sshr), RTLIL::const_sshr},
+			{ID($shift), RTLIL::const_shift}, {ID($shiftx), RTLIL::const_shiftx},
+			{ID($lt), RTLIL::const_lt}, {ID($le), RTLIL::const_le},
+			{ID($eq), RTLIL::const_eq}, {ID($ne), RTLIL::const_ne},
+			{ID($eqx), RTLIL::const_eqx}, {ID($nex), RTLIL::const_nex},
+			{ID($ge), RTLIL::const_ge}, {ID($gt), RTLIL::const_gt},
+			{ID($add), RTLIL::const_add}, {ID($sub), RTLIL::const_sub},
+			{ID($mul), RTLIL::const_mul}, {ID($div), RTLIL::const_div},
+			{ID($mod), RTLIL::const_mod}, {ID($divfloor), RTLIL::const_divfloor},
+			{ID($modfloor), RTLIL::const_modfloor}, {ID($pow), RTLIL::const_pow},
+		};
+
+		bool has_a = cell->hasPort(ID::A);
+		bool has_b = cell->hasPort(ID::B);
+		bool has_c = cell->hasPort(ID::C);
+		bool has_d = cell->hasPort(ID::D);
+		bool has_s = cell->hasPort(ID::S);
+		bool has_y = cell->hasPort(ID::Y);
+
+		// same port patterns as in update_cell()
+		if (has_a && !has_c && !has_d && !has_s && has_y)
+			instr.op = sim_op_t::EvalA;
+		else if (has_a && has_b && has_c && !has_d && !has_s && has_y)
+			instr.op = sim_op_t::EvalABC;
+		else if (has_a && !has_b && !has_c && !has_d && has_s && has_y)
+			instr.op = sim_op_t::EvalAS;
+		else if (has_a && has_b && !has_c && !has_d && has_s && has_y)
+			instr.op = sim_op_t::EvalABS;
+		else
+			return false;
+
+		instr.cell = cell;
+		if (has_a) instr.a = port(cell->getPort(ID::A));
+		if (has_b) instr.b = port(cell->getPort(ID::B));
+		if (has_c) instr.c = port(cell->getPort(ID::C));
+		if (has_s) instr.s = port(cell->getPort(ID::S));
+		instr.y = port(cell->getPort(ID::Y));
+
+		auto gate_it = gate_ops.find(cell->type);
+		if (gate_it != gate_ops.end()) {
+			instr.op = gate_it->second;
+			return true;
+		}
+
+		if (cell->type == ID($mux)) {
+			instr.op = sim_op_t::WordMux;
+			return true;
+		}
+
+		auto word_it = word_funcs.find(cell->type);
+		if (word_it != word_funcs.end() && instr.op == sim_op_t::EvalA) {
+			// same signedness rules as CellTypes::eval()
+			IdString type = cell->type;
+			instr.signed_a = cell->hasParam(ID::A_SIGNED) && cell->getParam(ID::A_SIGNED).as_bool();
+			instr.signed_b = cell->hasParam(ID::B_SIGNED) && cell->getParam(ID::B_SIGNED).as_bool();
+			instr.result_len = cell->hasParam(ID::Y_WIDTH) ? cell->getParam(ID::Y_WIDTH).as_int() : -1;
+			if (type == ID($sshr) && !instr.signed_a)
+				type = ID($shr);
+			if (type == ID($sshl) && !instr.signed_a)
+				type = ID($shl);
+			if (!type.in(ID($sshr), ID($sshl), ID($shr), ID($shl), ID($shift), ID($shiftx), ID($pos), ID($neg), ID($not)))
+				if (!instr.signed_a || !instr.signed_b)
+					instr.signed_a = false, instr.signed_b = false;
+			instr.op = sim_op_t::Word;
+			instr.func = word_funcs.at(type);
+		}
+		return true;
+	}
+
+	void compile_program()
+	{
+		log_assert(!compiled);
+
+		// number the nets wire by wire, so that most ports are consecutive
+		for (auto wire : module->wires())
+			port(wire);
+		for (auto &it : state_nets)
+			net_state.set(net(it.first), it.second);
+		state_nets.clear();
+
+		for (auto cell : module->cells()) {
+			sim_instr_t instr;
+			if (compile_cell(cell, instr))
+				program.push_back(std::move(instr));
+		}
+
+		// sort the program so that cells come after the cells driving their inputs
+		std::vector<int> net_driver(net_state.width, -1);
+		for (int i = 0; i < GetSize(program); i++)
+			for (int n : program[i].y.nets)
+				net_driver[n] = i;
+
+		TopoSort<Cell*, IdString::compare_ptr_by_name<Cell>> topo;
+		topo.analyze_loops = false;
+		dict<Cell*, int> cell_instr;
+		for (int i = 0; i < GetSize(program); i++) {
+			topo.node(program[i].cell);
+			cell_instr[program[i].cell] = i;
+		}
+		for (int i = 0; i < GetSize(program); i++)
+			for (auto *port : {&program[i].a, &program[i].b, &program[i].c, &program[i].s})
+				for (int n : port->nets)
+					if (net_driver[n] >= 0)
+						topo.edge(program[net_driver[n]].cell, program[i].cell);
+		if (!topo.sort())
+			log_warning("Combinational loop in module %s, cells in the loop are evaluated until the loop settles.\n", log_id(module));
+
+		std::vector<sim_instr_t> sorted_program;
+		sorted_program.reserve(GetSize(program));
+		for (auto cell : topo.sorted)
+			sorted_program.push_back(std::move(program[cell_instr.at(cell)]));
+		program.swap(sorted_program);
+
+		pool<Cell*> compiled_cells;
+		for (int i = 0; i < GetSize(program); i++) {
+			compiled_cells.insert(program[i].cell);
+			for (auto *port : {&program[i].a, &program[i].b, &program[i].c, &program[i].s})
+				for (int n : port->nets)
+					if (net_fanout[n].empty() || net_fanout[n].back() != i)
+						net_fanout[n].push_back(i);
+		}
+
+		// FFs, formal cells and prints are only looked at in update_ph2()
+		// and update_ph3(), all other readers become users of their nets
+		dict<Cell*, int> cell_users;
+		for (auto &it : upd_cells)
+			for (auto cell : it.second)
+			{
+				if (compiled_cells.count(cell) || ff_database.count(cell) || formal_database.count(cell) || cell->type == ID($print))
+					continue;
+
+				if (cell_users.count(cell) == 0) {
+					cell_users[cell] = GetSize(users);
+					sim_user_t user;
+					user.cell = cell;
+					if (mem_cells.count(cell))
+						user.memid = mem_cells.at(cell);
+					else if (children.count(cell)) {
+						user.child = children.at(cell);
+						for (auto &conn : cell->connections())
+							if (cell->input(conn.first) && GetSize(conn.second))
+								user.copy.emplace_back(port(conn.second), user.child->port(user.child->module->wire(conn.first)));
+					}
+					users.push_back(std::move(user));
+				}
+				net_users[net(it.first)].push_back(cell_users.at(cell));
+			}
+
+		// output ports driving the parent, the parent side of the copy is
+		// filled in by the compile_program() of the parent
+		if (parent != nullptr)
+			for (auto wire : module->wires())
+			{
+				if (!wire->port_output || !instance->hasPort(wire->name))
+					continue;
+
+				int user_idx = GetSize(users);
+				users.emplace_back();
+				users.back().outport = wire;
+				users.back().copy.emplace_back(port(wire), sim_port_t());
+				for (int n : users.back().copy.back().first.nets)
+					if (net_users[n].empty() || net_users[n].back() != user_idx)
+						net_users[n].push_back(user_idx);
+			}
+
+		for (auto &it : ff_database) {
+			ff_state_t &ff = it.second;
+			ff.port_q = port(ff.data.sig_q);
+			ff.port_d = port(ff.data.sig_d);
+			ff.port_ad = port(ff.data.sig_ad);
+			ff.port_clk = port(ff.data.sig_clk);
+			ff.port_ce = port(ff.data.sig_ce);
+			ff.port_srst = port(ff.data.sig_srst);
+			ff.port_aload = port(ff.data.sig_aload);
+			ff.port_arst = port(ff.data.sig_arst);
+			ff.port_clr = port(ff.data.sig_clr);
+			ff.port_set = port(ff.data.sig_set);
+		}
+
+		for (auto &it : mem_database) {
+			mem_state_t &mdb = it.second;
+			for (int i = 0; i < GetSize(mdb.mem->rd_ports); i++) {
+				mdb.rd_addr[i] = port(mdb.mem->rd_ports[i].addr);
+				mdb.rd_data[i] = port(mdb.mem->rd_ports[i].data);
+			}
+			for (int i = 0; i < GetSize(mdb.mem->wr_ports); i++) {
+				mdb.wr_clk[i] = port(mdb.mem->wr_ports[i].clk);
+				mdb.wr_en[i] = port(mdb.mem->wr_ports[i].en);
+				mdb.wr_addr[i] = port(mdb.mem->wr_ports[i].addr);
+				mdb.wr_data[i] = port(mdb.mem->wr_ports[i].data);
+			}
+		}
+
+		for (auto &print : print_database) {
+			print.port_trg = port(print.cell->getPort(ID::TRG));
+			print.port_en = port(print.cell->getPort(ID::EN));
+			print.port_args = port(print.cell->getPort(ID::ARGS));
+		}
+
+		int formal_idx = 0;
+		for (auto cell : formal_database)
+			formal_ports[formal_idx++] = {port(cell->getPort(ID::A)), port(cell->getPort(ID::EN))};
+
+		// the parent side of the output ports of the submodules, see above
+		for (auto &it : children)
+			for (auto &user : it.second->users)
+				if (user.outport != nullptr)
+					user.copy.back().second = port(it.first->getPort(user.outport->name));
+
+		instr_dirty.assign(GetSize(program), false);
+		first_dirty = program_pos = GetSize(program);
+		compiled = true;
+
+		// whatever was set up in the constructor is evaluated in the first cycle
+		for (auto bit : dirty_bits) {
+			auto it = net_index.find(bit);
+			if (it != net_index.end())
+				net_changed(it->second);
+		}
+		dirty_bits.clear();
+	}
+
+	void set_gate_output(const sim_instr_t &instr, State value)
+	{
+		if (value != State::Sa)
+			set_net(instr.y.nets[0], value);
+	}
+
+	void run_instr(const sim_instr_t &instr)
+	{
+		if (shared->debug)
+			log("[%s] eval %s (%s)\n", hiername().c_str(), log_id(instr.cell), log_id(instr.cell->type));
+
+		auto a = [&]() { return net_state.get(instr.a.nets[0]); };
+		auto b = [&]() { return net_state.get(instr.b.nets[0]); };
+		auto s = [&]() { return net_state.get(instr.s.nets[0]); };
+
+		switch (instr.op)
+		{
+		case sim_op_t::Buf: set_gate_output(instr, a()); break;
+		case sim_op_t::Not: set_gate_output(instr, sim_gate_not(a())); break;
+		case sim_op_t::And: set_gate_output(instr, sim_gate_and(a(), b())); break;
+		case sim_op_t::Nand: set_gate_output(instr, sim_gate_not(sim_gate_and(a(), b()))); break;
+		case sim_op_t::Or: set_gate_output(instr, sim_gate_or(a(), b())); break;
+		case sim_op_t::Nor: set_gate_output(instr, sim_gate_not(sim_gate_or(a(), b()))); break;
+		case sim_op_t::Xor: set_gate_output(instr, sim_gate_xor(a(), b())); break;
+		case sim_op_t::Xnor: set_gate_output(instr, sim_gate_not(sim_gate_xor(a(), b()))); break;
+		case sim_op_t::AndNot: set_gate_output(instr, sim_gate_and(a(), sim_gate_not(b()))); break;
+		case sim_op_t::OrNot: set_gate_output(instr, sim_gate_or(a(), sim_gate_not(b()))); break;
+		case sim_op_t::Mux: set_gate_output(instr, sim_gate_mux(a(), b(), s())); break;
+		case sim_op_t::NMux: set_gate_output(instr, sim_gate_not(sim_gate_mux(a(), b(), s()))); break;
+		case sim_op_t::Word:
+			set_port(instr.y, instr.func(get_port(instr.a), get_port(instr.b), instr.signed_a, instr.signed_b, instr.result_len));
+			break;
+		case sim_op_t::WordMux:
+			if (s() == State::S0)
+				set_port(instr.y, get_port(instr.a));
+			else if (s() == State::S1)
+				set_port(instr.y, get_port(instr.b));
+			else
+				set_port(instr.y, RTLIL::const_mux(get_port(instr.a), get_port(instr.b), Const(s())));
+			break;
+		case sim_op_t::EvalA:
+			set_port(instr.y, CellTypes::eval(instr.cell, get_port(instr.a), get_port(instr.b)));
+			break;
+		case sim_op_t::EvalABC:
+			set_port(instr.y, CellTypes::eval(instr.cell, get_port(instr.a), get_port(instr.b), get_port(instr.c)));
+			break;
+		case sim_op_t::EvalAS:
+			set_port(instr.y, CellTypes::eval(instr.cell, get_port(instr.a), get_port(instr.s)));
+			break;
+		case sim_op_t::EvalABS:
+			set_port(instr.y, CellTypes::eval(instr.cell, get_port(instr.a), get_port(instr.b), get_port(instr.s)));
+			break;
+		}
+	}
+
+	// evaluates the dirty instructions in program order, going back when a
+	// combinational loop changes the inputs of an instruction that already ran
+	void run_program()
+	{
+		while (first_dirty < GetSize(program)) {
+			program_pos = first_dirty;
+			first_dirty = GetSize(program);
+			for (; program_pos < GetSize(program); program_pos++)
+				if (instr_dirty[program_pos]) {
+					instr_dirty[program_pos] = false;
+					run_instr(program[program_pos]);
+				}
+		}
+	}
+
 	void update_memory(IdString id) {
 		auto &mdb = mem_database[id];
 		auto &mem = *mdb.mem;
@@ -594,7 +1211,7 @@ struct SimInstance
 		for (int port_idx = 0; port_idx < GetSize(mem.rd_ports); port_idx++)
 		{
 			auto &port = mem.rd_ports[port_idx];
-			Const addr = get_state(port.addr);
+			Const addr = get_state(port.addr, mdb.rd_addr[port_idx]);
 			Const data = Const(State::Sx, mem.width << port.wide_log2);
 
 			if (port.clk_enable)
@@ -611,12 +1228,75 @@ struct SimInstance
 				}
 			}
 
-			set_state(port.data, data);
+			set_state(port.data, mdb.rd_data[port_idx], data);
+		}
+	}
+
+	// update_ph1() for -compiled, going through the users of the changed
+	// nets instead of dirty_bits
+	void update_ph1_compiled()
+	{
+		std::vector<int> queue_outports;
+
+		while (1)
+		{
+			run_program();
+
+			bool did_something = false;
+			std::vector<int> queue;
+			queue.swap(user_queue);
+
+			for (int idx : queue)
+			{
+				sim_user_t &user = users[idx];
+				if (user.outport != nullptr) {
+					queue_outports.push_back(idx);
+					continue;
+				}
+
+				user.queued = false;
+				did_something = true;
+				if (user.child != nullptr) {
+					for (auto &it : user.copy)
+						user.child->set_port(it.second, get_port(it.first));
+					dirty_children.insert(user.child);
+				} else if (!user.memid.empty())
+					dirty_memories.insert(user.memid);
+				else
+					update_cell(user.cell);
+			}
+
+			if (did_something)
+				continue;
+
+			for (auto &memid : dirty_memories)
+				update_memory(memid);
+			dirty_memories.clear();
+
+			for (int idx : queue_outports) {
+				sim_user_t &user = users[idx];
+				user.queued = false;
+				parent->set_port(user.copy.back().second, get_port(user.copy.back().first));
+			}
+			queue_outports.clear();
+
+			for (auto child : dirty_children)
+				child->update_ph1();
+
+			dirty_children.clear();
+
+			if (user_queue.empty() && first_dirty == GetSize(program))
+				break;
 		}
 	}
 
 	void update_ph1()
 	{
+		if (compiled) {
+			update_ph1_compiled();
+			return;
+		}
+
 		pool<Cell*> queue_cells;
 		pool<Wire*> queue_outports;
 
@@ -677,11 +1357,11 @@ struct SimInstance
 			ff_state_t &ff = it.second;
 			FfData &ff_data = ff.data;
 
-			Const current_q = get_state(ff.data.sig_q);
+			Const current_q = get_state(ff.data.sig_q, ff.port_q);
 
 			if (ff_data.has_clk && !stable_past_update) {
 				// flip-flops
-				State current_clk = get_state(ff_data.sig_clk)[0];
+				State current_clk = get_state(ff_data.sig_clk, ff.port_clk)[0];
 				if (ff_data.pol_clk ? (ff.past_clk == State::S0 && current_clk != State::S0) :
 							(ff.past_clk == State::S1 && current_clk != State::S1)) {
 					bool ce = ff.past_ce == (ff_data.pol_ce ? State::S1 : State::S0);
@@ -698,22 +1378,22 @@ struct SimInstance
 			}
 			// async load
 			if (ff_data.has_aload) {
-				State current_aload = get_state(ff_data.sig_aload)[0];
+				State current_aload = get_state(ff_data.sig_aload, ff.port_aload)[0];
 				if (current_aload == (ff_data.pol_aload ? State::S1 : State::S0)) {
-					current_q = ff_data.has_clk && !stable_past_update ? ff.past_ad : get_state(ff.data.sig_ad);
+					current_q = ff_data.has_clk && !stable_past_update ? ff.past_ad : get_state(ff.data.sig_ad, ff.port_ad);
 				}
 			}
 			// async reset
 			if (ff_data.has_arst) {
-				State current_arst = get_state(ff_data.sig_arst)[0];
+				State current_arst = get_state(ff_data.sig_arst, ff.port_arst)[0];
 				if (current_arst == (ff_data.pol_arst ? State::S1 : State::S0)) {
 					current_q = ff_data.val_arst;
 				}
 			}
 			// handle set/reset
 			if (ff.data.has_sr) {
-				Const current_clr = get_state(ff.data.sig_clr);
-				Const current_set = get_state(ff.data.sig_set);
+				Const current_clr = get_state(ff.data.sig_clr, ff.port_clr);
+				Const current_set = get_state(ff.data.sig_set, ff.port_set);
 
 				for(int i=0;i<ff.past_d.size();i++) {
 					if (current_clr[i] == (ff_data.pol_clr ? State::S1 : State::S0)) {
@@ -729,7 +1409,7 @@ struct SimInstance
 				if (gclk)
 					current_q = ff.past_d;
 			}
-			if (set_state(ff_data.sig_q, current_q))
+			if (set_state(ff_data.sig_q, ff.port_q, current_q))
 				did_something = true;
 		}
 
@@ -745,17 +1425,17 @@ struct SimInstance
 
 				if (!port.clk_enable)
 				{
-					addr = get_state(port.addr);
-					data = get_state(port.data);
-					enable = get_state(port.en);
+					addr = get_state(port.addr, mdb.wr_addr[port_idx]);
+					data = get_state(port.data, mdb.wr_data[port_idx]);
+					enable = get_state(port.en, mdb.wr_en[port_idx]);
 				}
 				else
 				{
 					if (stable_past_update)
 						continue;
 					if (port.clk_polarity ?
-							(mdb.past_wr_clk[port_idx] == State::S1 || get_state(port.clk) != State::S1) :
-							(mdb.past_wr_clk[port_idx] == State::S0 || get_state(port.clk) != State::S0))
+							(mdb.past_wr_clk[port_idx] == State::S1 || get_state(port.clk, mdb.wr_clk[port_idx]) != State::S1) :
+							(mdb.past_wr_clk[port_idx] == State::S0 || get_state(port.clk, mdb.wr_clk[port_idx]) != State::S0))
 						continue;
 
 					addr = mdb.past_wr_addr[port_idx];
@@ -821,19 +1501,19 @@ struct SimInstance
 			ff_state_t &ff = it.second;
 
 			if (ff.data.has_aload)
-				ff.past_ad = get_state(ff.data.sig_ad);
+				ff.past_ad = get_state(ff.data.sig_ad, ff.port_ad);
 
 			if (ff.data.has_clk || ff.data.has_gclk)
-				ff.past_d = get_state(ff.data.sig_d);
+				ff.past_d = get_state(ff.data.sig_d, ff.port_d);
 
 			if (ff.data.has_clk)
-				ff.past_clk = get_state(ff.data.sig_clk)[0];
+				ff.past_clk = get_state(ff.data.sig_clk, ff.port_clk)[0];
 
 			if (ff.data.has_ce)
-				ff.past_ce = get_state(ff.data.sig_ce)[0];
+				ff.past_ce = get_state(ff.data.sig_ce, ff.port_ce)[0];
 
 			if (ff.data.has_srst)
-				ff.past_srst = get_state(ff.data.sig_srst)[0];
+				ff.past_srst = get_state(ff.data.sig_srst, ff.port_srst)[0];
 		}
 
 		for (auto &it : mem_database)
@@ -842,10 +1522,10 @@ struct SimInstance
 
 			for (int i = 0; i < GetSize(mem.mem->wr_ports); i++) {
 				auto &port = mem.mem->wr_ports[i];
-				mem.past_wr_clk[i]  = get_state(port.clk);
-				mem.past_wr_en[i]   = get_state(port.en);
-				mem.past_wr_addr[i] = get_state(port.addr);
-				mem.past_wr_data[i] = get_state(port.data);
+				mem.past_wr_clk[i]  = get_state(port.clk, mem.wr_clk[i]);
+				mem.past_wr_en[i]   = get_state(port.en, mem.wr_en[i]);
+				mem.past_wr_addr[i] = get_state(port.addr, mem.wr_addr[i]);
+				mem.past_wr_data[i] = get_state(port.data, mem.wr_data[i]);
 			}
 		}
 
@@ -854,10 +1534,10 @@ struct SimInstance
 			Cell *cell = print.cell;
 			bool triggered = false;
 
-			Const trg = get_state(cell->getPort(ID::TRG));
+			Const trg = get_state(cell->getPort(ID::TRG), print.port_trg);
 			bool trg_en = cell->getParam(ID::TRG_ENABLE).as_bool();
-			Const en = get_state(cell->getPort(ID::EN));
-			Const args = get_state(cell->getPort(ID::ARGS));
+			Const en = get_state(cell->getPort(ID::EN), print.port_en);
+			Const args = get_state(cell->getPort(ID::ARGS), print.port_args);
 
 			bool sampled = trg_en && trg.size() > 0;
 
@@ -907,14 +1587,16 @@ struct SimInstance
 
 		if (gclk_trigger)
 		{
+			int formal_idx = 0;
 			for (auto cell : formal_database)
 			{
 				string label = log_id(cell);
 				if (cell->attributes.count(ID::src))
 					label = cell->attributes.at(ID::src).decode_string();
 
-				State a = get_state(cell->getPort(ID::A))[0];
-				State en = get_state(cell->getPort(ID::EN))[0];
+				auto &ports = formal_ports[formal_idx++];
+				State a = get_state(cell->getPort(ID::A), ports.first)[0];
+				State en = get_state(cell->getPort(ID::EN), ports.second)[0];
 
 				if (en == State::S1 && (cell->type == ID($cover) ? a == State::S1 : a != State::S1)) {
 					shared->triggered_assertions.emplace_back(shared->step, this, cell);
@@ -1113,10 +1795,14 @@ struct SimInstance
 
 	void register_output_step_values(std::map<int,Const> *data)
 	{
+		if (compiled)
+			wire_ports(signal_database, signal_ports);
+
+		int signal_idx = 0;
 		for (auto &it : signal_database)
 		{
 			Wire *wire = it.first;
-			Const value = get_state(wire);
+			Const value = compiled ? get_port(signal_ports[signal_idx++]) : get_state(wire);
 			int id = it.second.first;
 
 			if (it.second.second == value)
@@ -1203,9 +1889,16 @@ struct SimInstance
 	bool setInputs()
 	{
 		bool did_something = false;
+		if (compiled)
+			wire_ports(fst_inputs, fst_input_ports);
+
+		int input_idx = 0;
 		for(auto &item : fst_inputs) {
 			std::string v = shared->fst->valueOf(item.second);
-			did_something |= set_state(item.first, Const::from_string(v));
+			if (compiled)
+				did_something |= set_port(fst_input_ports[input_idx++], Const::from_string(v));
+			else
+				did_something |= set_state(item.first, Const::from_string(v));
 		}
 
 		for (auto child : children)
@@ -1243,10 +1936,15 @@ struct SimInstance
 	bool checkSignals()
 	{
 		bool retVal = false;
+		if (compiled)
+			wire_ports(fst_handles, fst_handle_ports);
+
+		int handle_idx = 0;
 		for(auto &item : fst_handles) {
+			const sim_port_t *handle_port = compiled ? &fst_handle_ports[handle_idx++] : nullptr;
 			if (item.second==0) continue; // Ignore signals not found
 			Const fst_val = Const::from_string(shared->fst->valueOf(item.second));
-			Const sim_val = get_state(item.first);
+			Const sim_val = handle_port ? get_port(*handle_port) : get_state(item.first);
 			if (sim_val.size()!=fst_val.size()) {
 				log_warning("Signal '%s.%s' size is different in gold and gate.\n", scope.c_str(), log_id(item.first));
 				continue;
@@ -2248,6 +2946,7 @@ struct SimWorker : SimShared
 		log("Writing data to `%s`\n", (tb_filename+".txt").c_str());
 		std::ofstream data_file(tb_filename+".txt");
 		std::stringstream initstate;
+		fst->watchScope(scope);
 		try {
 			fst->reconstructAllAtTimes(fst_clock, startCount, stopCount, [&](uint64_t time) {
 				for(auto &item : clocks)
@@ -2335,6 +3034,102 @@ std::string form_vcd_name(const char *name, int size, Wire *w)
 	return full_name;
 }
 
+struct OutputStep
+{
+	int time;
+	std::vector<std::pair<int, std::string>> changes;
+};
+
+static std::string format_output_value(const Const &value)
+{
+	std::string str(GetSize(value), 'z');
+	for (int i = 0; i < GetSize(value); i++)
+		switch (value[i]) {
+			case State::S0: str[GetSize(value)-1-i] = '0'; break;
+			case State::S1: str[GetSize(value)-1-i] = '1'; break;
+			case State::Sx: str[GetSize(value)-1-i] = 'x'; break;
+			default: break;
+		}
+	return str;
+}
+
+static void format_output_step(const std::pair<int,std::map<int,Const>> &data, std::map<int, bool> &use_signal, OutputStep &step)
+{
+	step.time = data.first;
+	step.changes.clear();
+	for (auto &it : data.second)
+		if (use_signal.at(it.first))
+			step.changes.emplace_back(it.first, format_output_value(it.second));
+}
+
+// Formats the recorded output steps into value change strings and passes them
+// to emit() in order. With more than one job the formatting runs on a
+// separate thread, handing batches of steps to the calling thread through a
+// bounded queue, so that it overlaps with the writer emitting the steps.
+static void format_output_steps(const std::vector<std::pair<int,std::map<int,Const>>> &output_data, std::map<int, bool> &use_signal,
+		const std::function<void(const OutputStep&)> &emit)
+{
+#ifdef YOSYS_ENABLE_THREADS
+	if (yosys_jobs > 1 && GetSize(output_data) > 1)
+	{
+		const int batch_size = 1024, max_batches = 4;
+		std::deque<std::vector<OutputStep>> queue;
+		std::mutex mutex;
+		std::condition_variable cond;
+		bool done = false, abort = false;
+
+		std::thread producer([&]() {
+			for (int first = 0; first < GetSize(output_data); first += batch_size) {
+				std::vector<OutputStep> batch(std::min(batch_size, GetSize(output_data) - first));
+				for (int i = 0; i < GetSize(batch); i++)
+					format_output_step(output_data[first + i], use_signal, batch[i]);
+				std::unique_lock<std::mutex> lock(mutex);
+				cond.wait(lock, [&]() { return GetSize(queue) < max_batches || abort; });
+				if (abort)
+					return;
+				queue.push_back(std::move(batch));
+				cond.notify_all();
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			cond.notify_all();
+		});
+
+		try {
+			while (1) {
+				std::vector<OutputStep> batch;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cond.wait(lock, [&]() { return !queue.empty() || done; });
+					if (queue.empty())
+						break;
+					batch = std::move(queue.front());
+					queue.pop_front();
+					cond.notify_all();
+				}
+				for (auto &step : batch)
+					emit(step);
+			}
+		} catch (...) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				abort = true;
+				cond.notify_all();
+			}
+			producer.join();
+			throw;
+		}
+		producer.join();
+		return;
+	}
+#endif
+	OutputStep step;
+	for (auto &data : output_data) {
+		format_output_step(data, use_signal, step);
+		emit(step);
+	}
+}
+
 struct VCDWriter : public OutputWriter
 {
 	VCDWriter(SimWorker *worker, std::string filename) : OutputWriter(worker) {
@@ -2373,25 +3168,11 @@ struct VCDWriter : public OutputWriter
 
 		vcdfile << stringf("$enddefinitions $end\n");
 
-		for(auto& d : worker->output_data)
-		{
-			vcdfile << stringf("#%d\n", d.first);
-			for (auto &data : d.second)
-			{
-				if (!use_signal.at(data.first)) continue;
-				Const value = data.second;
-				vcdfile << "b";
-				for (int i = GetSize(value)-1; i >= 0; i--) {
-					switch (value[i]) {
-						case State::S0: vcdfile << "0"; break;
-						case State::S1: vcdfile << "1"; break;
-						case State::Sx: vcdfile << "x"; break;
-						default: vcdfile << "z";
-					}
-				}
-				vcdfile << stringf(" n%d\n", data.first);
-			}
-		}
+		format_output_steps(worker->output_data, use_signal, [this](const OutputStep &step) {
+			vcdfile << stringf("#%d\n", step.time);
+			for (auto &change : step.changes)
+				vcdfile << "b" << change.second << stringf(" n%d\n", change.first);
+		});
 	}
 
 	std::ofstream vcdfile;
@@ -2422,6 +3203,12 @@ struct FSTWriter : public OutputWriter
 
 		fstWriterSetPackType(fstfile, FST_WR_PT_FASTLZ);
 		fstWriterSetRepackOnClose(fstfile, 1);
+#if defined(YOSYS_ENABLE_THREADS) && !defined(_MSC_VER)
+		// same condition as FST_WRITER_PARALLEL in libs/fst/config.h
+		// compress and write out value change blocks on a background thread
+		if (yosys_jobs > 1)
+			fstWriterSetParallelMode(fstfile, 1);
+#endif
 	   
 	   	worker->top->write_output_header(
 			[this](IdString name) { fstWriterSetScope(fstfile, FST_ST_VCD_MODULE, stringf("%s",log_id(name)).c_str(), nullptr); },
@@ -2435,25 +3222,11 @@ struct FSTWriter : public OutputWriter
 			}
 		);
 
-		for(auto& d : worker->output_data)
-		{
-			fstWriterEmitTimeChange(fstfile, d.first);
-			for (auto &data : d.second)
-			{
-				if (!use_signal.at(data.first)) continue;
-				Const value = data.second;
-				std::stringstream ss;
-				for (int i = GetSize(value)-1; i >= 0; i--) {
-					switch (value[i]) {
-						case State::S0: ss << "0"; break;
-						case State::S1: ss << "1"; break;
-						case State::Sx: ss << "x"; break;
-						default: ss << "z";
-					}
-				}
-				fstWriterEmitValueChange(fstfile, mapping[data.first], ss.str().c_str());
-			}
-		}
+		format_output_steps(worker->output_data, use_signal, [this](const OutputStep &step) {
+			fstWriterEmitTimeChange(fstfile, step.time);
+			for (auto &change : step.changes)
+				fstWriterEmitValueChange(fstfile, mapping[change.first], change.second.c_str());
+		});
 	}
 
 	struct fstContext *fstfile = nullptr;
@@ -2632,6 +3405,12 @@ struct SimPass : public Pass {
 		log("    -zinit\n");
 		log("        zero-initialize all uninitialized regs and memories\n");
 		log("\n");
+		log("    -compiled\n");
+		log("        compile the combinational cells of each module into a topologically\n");
+		log("        sorted program over a dense, word-packed array of nets before\n");
+		log("        simulating. this speeds up long simulations (e.g. replaying traces\n");
+		log("        with -r) at the cost of a longer setup.\n");
+		log("\n");
 		log("    -timescale <string>\n");
 		log("        include the specified timescale declaration in the vcd\n");
 		log("\n");
@@ -2793,6 +3572,10 @@ struct SimPass : public Pass {
 				worker.zinit = true;
 				continue;
 			}
+			if (args[argidx] == "-compiled") {
+				worker.compiled = true;
+				continue;
+			}
 			if (args[argidx] == "-r" && argidx+1 < args.size()) {
 				std::string sim_filename = args[++argidx];
 				rewrite_filename(sim_filename);
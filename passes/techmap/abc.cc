@@ -48,6 +48,7 @@
 #include "kernel/ff.h"
 #include "kernel/cost.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -63,12 +64,8 @@
 #endif
 
 #include "frontends/blif/blifparse.h"
+#include "passes/techmap/abc_link.h"
 
-#ifdef YOSYS_LINK_ABC
-namespace abc {
-	int Abc_RealMain(int argc, char *argv[]);
-}
-#endif
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -113,23 +110,79 @@ bool map_mux8;
 bool map_mux16;
 
 bool markgroups;
-int map_autoidx;
-SigMap assign_map;
-RTLIL::Module *module;
-std::vector<gate_t> signal_list;
-dict<RTLIL::SigBit, int> signal_map;
-FfInitVals initvals;
 pool<std::string> enabled_gates;
 bool cmos_cost;
-bool had_init;
 
-bool clk_polarity, en_polarity, arst_polarity, srst_polarity;
-RTLIL::SigSpec clk_sig, en_sig, arst_sig, srst_sig;
-dict<int, std::string> pi_map, po_map;
+struct AbcConfig
+{
+	std::string script_file, exe_file, constr_file;
+	std::vector<std::string> liberty_files, genlib_files, dont_use_cells;
+	std::string delay_target, sop_inputs, sop_products, lutin_shared;
+	vector<int> lut_costs;
+	bool cleanup = true, keepff = false, fast_mode = false;
+	bool show_tempdir = false, sop_mode = false, abc_dress = false;
+	bool linked_abc = false;
+};
 
-int undef_bits_lost;
+struct AbcModuleSigs
+{
+	SigMap assign_map;
+	FfInitVals initvals;
 
-int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1, int in2 = -1, int in3 = -1, int in4 = -1)
+	AbcModuleSigs(RTLIL::Module *module) : assign_map(module), initvals(&assign_map, module) { }
+};
+
+// The state of one ABC run, i.e. of one module or one clock domain of a module.
+// Only run_abc() may be called from a worker thread: it touches nothing but
+// the files in the temp dir and the members of this struct. All other steps
+// modify the module and must run on the main thread.
+struct AbcModuleState
+{
+	const AbcConfig &config;
+	RTLIL::Design *design;
+	RTLIL::Module *module;
+	SigMap &assign_map;
+	FfInitVals &initvals;
+
+	int map_autoidx = 0;
+	std::vector<gate_t> signal_list;
+	dict<RTLIL::SigBit, int> signal_map;
+	pool<RTLIL::Cell*> extracted_cells;
+	bool had_init = false;
+
+	bool clk_polarity = true, en_polarity = true, arst_polarity = true, srst_polarity = true;
+	RTLIL::SigSpec clk_sig, en_sig, arst_sig, srst_sig;
+	dict<int, std::string> pi_map, po_map;
+
+	int undef_bits_lost = 0;
+
+	std::string tempdir_name;
+	std::string abc_command;
+	int count_output = 0;
+	int abc_ret = 0;
+
+	AbcModuleState(const AbcConfig &config, RTLIL::Design *design, RTLIL::Module *module, AbcModuleSigs &sigs) :
+			config(config), design(design), module(module), assign_map(sigs.assign_map), initvals(sigs.initvals) { }
+
+	int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1, int in2 = -1, int in3 = -1, int in4 = -1);
+	void mark_port(RTLIL::SigSpec sig);
+	void extract_cell(RTLIL::Cell *cell, bool keepff);
+	std::string remap_name(RTLIL::IdString abc_name, RTLIL::Wire **orig_wire = nullptr);
+	void dump_loop_graph(FILE *f, int &nr, dict<int, pool<int>> &edges, pool<int> &workpool, std::vector<int> &in_counts);
+	void handle_loops();
+
+	// Creates the temp dir and maps the given cells to the gate netlist. The
+	// cells are left in the module until remove_extracted_cells() is called.
+	void extract(bool dff_mode, std::string clk_str, const std::vector<RTLIL::Cell*> &cells);
+	// Writes input.blif and the cell library for ABC.
+	void prepare_abc();
+	void remove_extracted_cells();
+	void run_abc();
+	// Reads back output.blif, connects it to the module and removes the temp dir.
+	void reintegrate();
+};
+
+int AbcModuleState::map_signal(RTLIL::SigBit bit, gate_type_t gate_type, int in1, int in2, int in3, int in4)
 {
 	assign_map.apply(bit);
 
@@ -167,14 +220,14 @@ int map_signal(RTLIL::SigBit bit, gate_type_t gate_type = G(NONE), int in1 = -1,
 	return gate.id;
 }
 
-void mark_port(RTLIL::SigSpec sig)
+void AbcModuleState::mark_port(RTLIL::SigSpec sig)
 {
 	for (auto &bit : assign_map(sig))
 		if (bit.wire != nullptr && signal_map.count(bit) > 0)
 			signal_list[signal_map[bit]].is_port = true;
 }
 
-void extract_cell(RTLIL::Cell *cell, bool keepff)
+void AbcModuleState::extract_cell(RTLIL::Cell *cell, bool keepff)
 {
 	if (RTLIL::builtin_ff_cell_types().count(cell->type)) {
 		FfData ff(&initvals, cell);
@@ -253,7 +306,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(ff.sig_q, type, map_signal(ff.sig_d));
 
-		ff.remove();
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -267,7 +320,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_BUF_) ? G(BUF) : G(NOT), map_signal(sig_a));
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -303,7 +356,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 		else
 			log_abort();
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -325,7 +378,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_MUX_) ? G(MUX) : G(NMUX), mapped_a, mapped_b, mapped_s);
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -347,7 +400,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI3_) ? G(AOI3) : G(OAI3), mapped_a, mapped_b, mapped_c);
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 
@@ -372,12 +425,12 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI4_) ? G(AOI4) : G(OAI4), mapped_a, mapped_b, mapped_c, mapped_d);
 
-		module->remove(cell);
+		extracted_cells.insert(cell);
 		return;
 	}
 }
 
-std::string remap_name(RTLIL::IdString abc_name, RTLIL::Wire **orig_wire = nullptr)
+std::string AbcModuleState::remap_name(RTLIL::IdString abc_name, RTLIL::Wire **orig_wire)
 {
 	std::string abc_sname = abc_name.substr(1);
 	bool isnew = false;
@@ -416,7 +469,7 @@ std::string remap_name(RTLIL::IdString abc_name, RTLIL::Wire **orig_wire = nullp
 	return stringf("$abc$%d$%s", map_autoidx, abc_name.c_str()+1);
 }
 
-void dump_loop_graph(FILE *f, int &nr, dict<int, pool<int>> &edges, pool<int> &workpool, std::vector<int> &in_counts)
+void AbcModuleState::dump_loop_graph(FILE *f, int &nr, dict<int, pool<int>> &edges, pool<int> &workpool, std::vector<int> &in_counts)
 {
 	if (f == nullptr)
 		return;
@@ -445,7 +498,7 @@ void dump_loop_graph(FILE *f, int &nr, dict<int, pool<int>> &edges, pool<int> &w
 	fprintf(f, "}\n");
 }
 
-void handle_loops()
+void AbcModuleState::handle_loops()
 {
 	// http://en.wikipedia.org/wiki/Topological_sorting
 	// (Kahn, Arthur B. (1962), "Topological sorting of large networks")
@@ -646,13 +699,15 @@ std::string replace_tempdir(std::string text, std::string tempdir_name, bool sho
 
 struct abc_output_filter
 {
+	const AbcModuleState &state;
 	bool got_cr;
 	int escape_seq_state;
 	std::string linebuf;
 	std::string tempdir_name;
 	bool show_tempdir;
 
-	abc_output_filter(std::string tempdir_name, bool show_tempdir) : tempdir_name(tempdir_name), show_tempdir(show_tempdir)
+	abc_output_filter(const AbcModuleState &state, std::string tempdir_name, bool show_tempdir) :
+			state(state), tempdir_name(tempdir_name), show_tempdir(show_tempdir)
 	{
 		got_cr = false;
 		escape_seq_state = 0;
@@ -693,8 +748,8 @@ struct abc_output_filter
 		int pi, po;
 		if (sscanf(line.c_str(), "Start-point = pi%d.  End-point = po%d.", &pi, &po) == 2) {
 			log("ABC: Start-point = pi%d (%s).  End-point = po%d (%s).\n",
-					pi, pi_map.count(pi) ? pi_map.at(pi).c_str() : "???",
-					po, po_map.count(po) ? po_map.at(po).c_str() : "???");
+					pi, state.pi_map.count(pi) ? state.pi_map.at(pi).c_str() : "???",
+					po, state.po_map.count(po) ? state.po_map.at(po).c_str() : "???");
 			return;
 		}
 
@@ -703,20 +758,10 @@ struct abc_output_filter
 	}
 };
 
-void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
-		std::vector<std::string> &liberty_files, std::vector<std::string> &genlib_files, std::string constr_file,
-		bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str, bool keepff, std::string delay_target,
-		std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
-		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress, std::vector<std::string> &dont_use_cells)
+void AbcModuleState::extract(bool dff_mode, std::string clk_str, const std::vector<RTLIL::Cell*> &cells)
 {
-	module = current_module;
 	map_autoidx = autoidx++;
 
-	signal_map.clear();
-	signal_list.clear();
-	pi_map.clear();
-	po_map.clear();
-
 	if (clk_str != "$")
 	{
 		clk_polarity = true;
@@ -787,80 +832,79 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	if (dff_mode && clk_sig.empty())
 		log_cmd_error("Clock domain %s not found.\n", clk_str.c_str());
 
-	std::string tempdir_name;
-	if (cleanup) 
+	if (config.cleanup) 
 		tempdir_name = get_base_tmpdir() + "/";
 	else
 		tempdir_name = "_tmp_";
 	tempdir_name += proc_program_prefix() + "yosys-abc-XXXXXX";
 	tempdir_name = make_temp_dir(tempdir_name);
 	log_header(design, "Extracting gate netlist of module `%s' to `%s/input.blif'..\n",
-			module->name.c_str(), replace_tempdir(tempdir_name, tempdir_name, show_tempdir).c_str());
+			module->name.c_str(), replace_tempdir(tempdir_name, tempdir_name, config.show_tempdir).c_str());
 
 	std::string abc_script = stringf("read_blif \"%s/input.blif\"; ", tempdir_name.c_str());
 
-	if (!liberty_files.empty() || !genlib_files.empty()) {
+	if (!config.liberty_files.empty() || !config.genlib_files.empty()) {
 		std::string dont_use_args;
-		for (std::string dont_use_cell : dont_use_cells) {
+		for (std::string dont_use_cell : config.dont_use_cells) {
 			dont_use_args += stringf("-X \"%s\" ", dont_use_cell.c_str());
 		}
 		bool first_lib = true;
-		for (std::string liberty_file : liberty_files) {
+		for (std::string liberty_file : config.liberty_files) {
 			abc_script += stringf("read_lib %s %s -w \"%s\" ; ", dont_use_args.c_str(), first_lib ? "" : "-m", liberty_file.c_str());
 			first_lib = false;
 		}
-		for (std::string liberty_file : genlib_files)
+		for (std::string liberty_file : config.genlib_files)
 			abc_script += stringf("read_library \"%s\"; ", liberty_file.c_str());
-		if (!constr_file.empty())
-			abc_script += stringf("read_constr -v \"%s\"; ", constr_file.c_str());
+		if (!config.constr_file.empty())
+			abc_script += stringf("read_constr -v \"%s\"; ", config.constr_file.c_str());
 	} else
-	if (!lut_costs.empty())
+	if (!config.lut_costs.empty())
 		abc_script += stringf("read_lut %s/lutdefs.txt; ", tempdir_name.c_str());
 	else
 		abc_script += stringf("read_library %s/stdcells.genlib; ", tempdir_name.c_str());
 
-	if (!script_file.empty()) {
-		if (script_file[0] == '+') {
-			for (size_t i = 1; i < script_file.size(); i++)
-				if (script_file[i] == '\'')
+	if (!config.script_file.empty()) {
+		if (config.script_file[0] == '+') {
+			for (size_t i = 1; i < config.script_file.size(); i++)
+				if (config.script_file[i] == '\'')
 					abc_script += "'\\''";
-				else if (script_file[i] == ',')
+				else if (config.script_file[i] == ',')
 					abc_script += " ";
 				else
-					abc_script += script_file[i];
+					abc_script += config.script_file[i];
 		} else
-			abc_script += stringf("source %s", script_file.c_str());
-	} else if (!lut_costs.empty()) {
+			abc_script += stringf("source %s", config.script_file.c_str());
+	} else if (!config.lut_costs.empty()) {
 		bool all_luts_cost_same = true;
-		for (int this_cost : lut_costs)
-			if (this_cost != lut_costs.front())
+		for (int this_cost : config.lut_costs)
+			if (this_cost != config.lut_costs.front())
 				all_luts_cost_same = false;
-		abc_script += fast_mode ? ABC_FAST_COMMAND_LUT : ABC_COMMAND_LUT;
-		if (all_luts_cost_same && !fast_mode)
+		abc_script += config.fast_mode ? ABC_FAST_COMMAND_LUT : ABC_COMMAND_LUT;
+		if (all_luts_cost_same && !config.fast_mode)
 			abc_script += "; lutpack {S}";
-	} else if (!liberty_files.empty() || !genlib_files.empty())
-		abc_script += constr_file.empty() ? (fast_mode ? ABC_FAST_COMMAND_LIB : ABC_COMMAND_LIB) : (fast_mode ? ABC_FAST_COMMAND_CTR : ABC_COMMAND_CTR);
-	else if (sop_mode)
-		abc_script += fast_mode ? ABC_FAST_COMMAND_SOP : ABC_COMMAND_SOP;
+	} else if (!config.liberty_files.empty() || !config.genlib_files.empty())
+		abc_script += config.constr_file.empty() ? (config.fast_mode ? ABC_FAST_COMMAND_LIB : ABC_COMMAND_LIB) : (config.fast_mode ? ABC_FAST_COMMAND_CTR : ABC_COMMAND_CTR);
+	else if (config.sop_mode)
+		abc_script += config.fast_mode ? ABC_FAST_COMMAND_SOP : ABC_COMMAND_SOP;
 	else
-		abc_script += fast_mode ? ABC_FAST_COMMAND_DFL : ABC_COMMAND_DFL;
+		abc_script += config.fast_mode ? ABC_FAST_COMMAND_DFL : ABC_COMMAND_DFL;
 
-	if (script_file.empty() && !delay_target.empty())
+	if (config.script_file.empty() && !config.delay_target.empty())
 		for (size_t pos = abc_script.find("dretime;"); pos != std::string::npos; pos = abc_script.find("dretime;", pos+1))
 			abc_script = abc_script.substr(0, pos) + "dretime; retime -o {D};" + abc_script.substr(pos+8);
 
 	for (size_t pos = abc_script.find("{D}"); pos != std::string::npos; pos = abc_script.find("{D}", pos))
-		abc_script = abc_script.substr(0, pos) + delay_target + abc_script.substr(pos+3);
+		abc_script = abc_script.substr(0, pos) + config.delay_target + abc_script.substr(pos+3);
 
 	for (size_t pos = abc_script.find("{I}"); pos != std::string::npos; pos = abc_script.find("{I}", pos))
-		abc_script = abc_script.substr(0, pos) + sop_inputs + abc_script.substr(pos+3);
+		abc_script = abc_script.substr(0, pos) + config.sop_inputs + abc_script.substr(pos+3);
 
 	for (size_t pos = abc_script.find("{P}"); pos != std::string::npos; pos = abc_script.find("{P}", pos))
-		abc_script = abc_script.substr(0, pos) + sop_products + abc_script.substr(pos+3);
+		abc_script = abc_script.substr(0, pos) + config.sop_products + abc_script.substr(pos+3);
 
 	for (size_t pos = abc_script.find("{S}"); pos != std::string::npos; pos = abc_script.find("{S}", pos))
-		abc_script = abc_script.substr(0, pos) + lutin_shared + abc_script.substr(pos+3);
-	if (abc_dress)
+		abc_script = abc_script.substr(0, pos) + config.lutin_shared + abc_script.substr(pos+3);
+	if (config.abc_dress)
 		abc_script += stringf("; dress \"%s/input.blif\"", tempdir_name.c_str());
 	abc_script += stringf("; write_blif %s/output.blif", tempdir_name.c_str());
 	abc_script = add_echos_to_abc_cmd(abc_script);
@@ -896,19 +940,25 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 
 	had_init = false;
 	for (auto c : cells)
-		extract_cell(c, keepff);
+		extract_cell(c, config.keepff);
 
 	if (undef_bits_lost)
 		log("Replacing %d occurrences of constant undef bits with constant zero bits\n", undef_bits_lost);
+}
 
+void AbcModuleState::prepare_abc()
+{
 	for (auto wire : module->wires()) {
 		if (wire->port_id > 0 || wire->get_bool_attribute(ID::keep))
 			mark_port(wire);
 	}
 
-	for (auto cell : module->cells())
-	for (auto &port_it : cell->connections())
-		mark_port(port_it.second);
+	for (auto cell : module->cells()) {
+		if (extracted_cells.count(cell))
+			continue;
+		for (auto &port_it : cell->connections())
+			mark_port(port_it.second);
+	}
 
 	if (clk_sig.size() != 0)
 		mark_port(clk_sig);
@@ -924,8 +974,16 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 
 	handle_loops();
 
-	buffer = stringf("%s/input.blif", tempdir_name.c_str());
-	f = fopen(buffer.c_str(), "wt");
+	std::string buffer = stringf("%s/input.blif", tempdir_name.c_str());
+#if defined(YOSYS_LINK_ABC) && !defined(_WIN32)
+	// the linked ABC reads the netlist from memory and writes its result there
+	bool blif_in_memory = config.linked_abc && config.cleanup;
+	char *blif_data = nullptr;
+	size_t blif_size = 0;
+	FILE *f = blif_in_memory ? open_memstream(&blif_data, &blif_size) : fopen(buffer.c_str(), "wt");
+#else
+	FILE *f = fopen(buffer.c_str(), "wt");
+#endif
 	if (f == nullptr)
 		log_error("Opening %s for writing failed: %s\n", buffer.c_str(), strerror(errno));
 
@@ -943,7 +1001,7 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		fprintf(f, " dummy_input\n");
 	fprintf(f, "\n");
 
-	int count_output = 0;
+	count_output = 0;
 	fprintf(f, ".outputs");
 	for (auto &si : signal_list) {
 		if (!si.is_port || si.type == G(NONE))
@@ -1041,6 +1099,13 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 
 	fprintf(f, ".end\n");
 	fclose(f);
+#if defined(YOSYS_LINK_ABC) && !defined(_WIN32)
+	if (blif_in_memory) {
+		abc_link_provide_file(buffer, std::string(blif_data, blif_size));
+		abc_link_collect_file(stringf("%s/output.blif", tempdir_name.c_str()));
+		free(blif_data);
+	}
+#endif
 
 	log("Extracted %d gates and %d wires to a netlist network with %d inputs and %d outputs.\n",
 			count_gates, GetSize(signal_list), count_input, count_output);
@@ -1095,78 +1160,74 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			fprintf(f, "GATE MUX16  %d Y=(!S*!T*!U*!V*A)+(S*!T*!U*!V*B)+(!S*T*!U*!V*C)+(S*T*!U*!V*D)+(!S*!T*U*!V*E)+(S*!T*U*!V*F)+(!S*T*U*!V*G)+(S*T*U*!V*H)+(!S*!T*!U*V*I)+(S*!T*!U*V*J)+(!S*T*!U*V*K)+(S*T*!U*V*L)+(!S*!T*U*V*M)+(S*!T*U*V*N)+(!S*T*U*V*O)+(S*T*U*V*P); PIN * UNKNOWN 1 999 1 0 1 0\n", 8*cell_cost.at(ID($_MUX_)));
 		fclose(f);
 
-		if (!lut_costs.empty()) {
+		if (!config.lut_costs.empty()) {
 			buffer = stringf("%s/lutdefs.txt", tempdir_name.c_str());
 			f = fopen(buffer.c_str(), "wt");
 			if (f == nullptr)
 				log_error("Opening %s for writing failed: %s\n", buffer.c_str(), strerror(errno));
-			for (int i = 0; i < GetSize(lut_costs); i++)
-				fprintf(f, "%d %d.00 1.00\n", i+1, lut_costs.at(i));
+			for (int i = 0; i < GetSize(config.lut_costs); i++)
+				fprintf(f, "%d %d.00 1.00\n", i+1, config.lut_costs.at(i));
 			fclose(f);
 		}
 
-		buffer = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
-		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+		abc_command = stringf("\"%s\" -s -f %s/abc.script 2>&1", config.exe_file.c_str(), tempdir_name.c_str());
+	}
+}
 
-#ifndef YOSYS_LINK_ABC
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
-#else
-		string temp_stdouterr_name = stringf("%s/stdouterr.txt", tempdir_name.c_str());
-		FILE *temp_stdouterr_w = fopen(temp_stdouterr_name.c_str(), "w");
-		if (temp_stdouterr_w == NULL)
-			log_error("ABC: cannot open a temporary file for output redirection");
-		fflush(stdout);
-		fflush(stderr);
-		FILE *old_stdout = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
-		FILE *old_stderr = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
-#if defined(__wasm)
-#define fd_renumber(from, to) (void)__wasi_fd_renumber(from, to)
-#else
-#define fd_renumber(from, to) dup2(from, to)
-#endif
-		fd_renumber(fileno(stdout), fileno(old_stdout));
-		fd_renumber(fileno(stderr), fileno(old_stderr));
-		fd_renumber(fileno(temp_stdouterr_w), fileno(stdout));
-		fd_renumber(fileno(temp_stdouterr_w), fileno(stderr));
-		fclose(temp_stdouterr_w);
-		// These needs to be mutable, supposedly due to getopt
-		char *abc_argv[5];
-		string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
-		abc_argv[0] = strdup(exe_file.c_str());
-		abc_argv[1] = strdup("-s");
-		abc_argv[2] = strdup("-f");
-		abc_argv[3] = strdup(tmp_script_name.c_str());
-		abc_argv[4] = 0;
-		int ret = abc::Abc_RealMain(4, abc_argv);
-		free(abc_argv[0]);
-		free(abc_argv[1]);
-		free(abc_argv[2]);
-		free(abc_argv[3]);
-		fflush(stdout);
-		fflush(stderr);
-		fd_renumber(fileno(old_stdout), fileno(stdout));
-		fd_renumber(fileno(old_stderr), fileno(stderr));
-		fclose(old_stdout);
-		fclose(old_stderr);
-		std::ifstream temp_stdouterr_r(temp_stdouterr_name);
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		for (std::string line; std::getline(temp_stdouterr_r, line); )
-			filt.next_line(line + "\n");
-		temp_stdouterr_r.close();
+void AbcModuleState::remove_extracted_cells()
+{
+	for (auto cell : extracted_cells) {
+		if (RTLIL::builtin_ff_cell_types().count(cell->type))
+			initvals.remove_init(cell->getPort(ID::Q));
+		module->remove(cell);
+	}
+	extracted_cells.clear();
+}
+
+void AbcModuleState::run_abc()
+{
+	if (count_output == 0)
+		return;
+
+	log("Running ABC command: %s\n", replace_tempdir(abc_command, tempdir_name, config.show_tempdir).c_str());
+
+	abc_output_filter filt(*this, tempdir_name, config.show_tempdir);
+#ifdef YOSYS_LINK_ABC
+	if (config.linked_abc) {
+		abc_ret = abc_link_run_script(tempdir_name, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+		return;
+	}
 #endif
-		if (ret != 0)
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+	abc_ret = run_command(abc_command, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+}
+
+void AbcModuleState::reintegrate()
+{
+	if (count_output > 0)
+	{
+		if (abc_ret != 0)
+			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", abc_command.c_str(), abc_ret);
 
-		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
+		std::string buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
 		std::ifstream ifs;
-		ifs.open(buffer);
-		if (ifs.fail())
-			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
+		std::istringstream blif_stream;
+		std::istream *blif = &ifs;
+#ifdef YOSYS_LINK_ABC
+		std::string blif_data;
+		if (abc_link_take_file(buffer, blif_data)) {
+			blif_stream.str(blif_data);
+			blif = &blif_stream;
+		} else
+#endif
+		{
+			ifs.open(buffer);
+			if (ifs.fail())
+				log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
+		}
 
-		bool builtin_lib = liberty_files.empty() && genlib_files.empty();
+		bool builtin_lib = config.liberty_files.empty() && config.genlib_files.empty();
 		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+		parse_blif(mapped_design, *blif, builtin_lib ? ID(DFF) : ID(_dff_), false, config.sop_mode);
 
 		ifs.close();
 
@@ -1441,7 +1502,7 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		log("Don't call ABC as there is nothing to map.\n");
 	}
 
-	if (cleanup)
+	if (config.cleanup)
 	{
 		log("Removing temp directory.\n");
 		remove_directory(tempdir_name);
@@ -1632,6 +1693,16 @@ struct AbcPass : public Pass {
 		log("        run the 'dress' command after all other ABC commands. This aims to\n");
 		log("        preserve naming by an equivalence check between the original and\n");
 		log("        post-ABC netlists (experimental).\n");
+		log("\n");
+		log("    -j <N>\n");
+		log("        run up to N ABC processes at the same time. all modules and clock\n");
+		log("        domains are extracted first, then ABC is run on them in parallel and\n");
+		log("        the results are merged back in the order of extraction. the default\n");
+		log("        is the number of jobs given to 'yosys -j' or 'synth -j'.\n");
+#ifdef YOSYS_LINK_ABC
+		log("        the ABC linked into yosys maps one netlist at a time, so more than one\n");
+		log("        job runs the ABC executable (see -exe) in separate processes instead.\n");
+#endif
 		log("\n");
 		log("When no target cell library is specified the Yosys standard cell library is\n");
 		log("loaded into ABC before the ABC script is executed.\n");
@@ -1651,13 +1722,6 @@ struct AbcPass : public Pass {
 		log_header(design, "Executing ABC pass (technology mapping using ABC).\n");
 		log_push();
 
-		assign_map.clear();
-		signal_list.clear();
-		signal_map.clear();
-		initvals.clear();
-		pi_map.clear();
-		po_map.clear();
-
 		std::string exe_file = yosys_abc_executable;
 		std::string script_file, default_liberty_file, constr_file, clk_str;
 		std::vector<std::string> liberty_files, genlib_files, dont_use_cells;
@@ -1666,6 +1730,7 @@ struct AbcPass : public Pass {
 		bool show_tempdir = false, sop_mode = false;
 		bool abc_dress = false;
 		vector<int> lut_costs;
+		int jobs = yosys_jobs;
 		markgroups = false;
 
 		map_mux4 = false;
@@ -1836,6 +1901,10 @@ struct AbcPass : public Pass {
 				markgroups = true;
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -2041,6 +2110,41 @@ struct AbcPass : public Pass {
 			// enabled_gates.insert("NMUX");
 		}
 
+		AbcConfig config;
+		config.script_file = script_file;
+		config.exe_file = exe_file;
+		config.constr_file = constr_file;
+		config.liberty_files = liberty_files;
+		config.genlib_files = genlib_files;
+		config.dont_use_cells = dont_use_cells;
+		config.delay_target = delay_target;
+		config.sop_inputs = sop_inputs;
+		config.sop_products = sop_products;
+		config.lutin_shared = lutin_shared;
+		config.lut_costs = lut_costs;
+		config.cleanup = cleanup;
+		config.keepff = keepff;
+		config.fast_mode = fast_mode;
+		config.show_tempdir = show_tempdir;
+		config.sop_mode = sop_mode;
+		config.abc_dress = abc_dress;
+
+#ifdef YOSYS_LINK_ABC
+		// The linked ABC redirects the process-wide stdout/stderr and is not
+		// reentrant. Several jobs therefore run external ABC processes, and
+		// without an ABC executable the runs are mapped one at a time.
+		config.linked_abc = jobs <= 1 || !check_file_exists(exe_file);
+		if (config.linked_abc)
+			jobs = 1;
+#endif
+
+		// With a single job every run is mapped and merged back before the next
+		// one is extracted. Otherwise all runs are extracted first, the ABC
+		// processes are started in parallel and the results are merged back in
+		// the order in which the runs were extracted.
+		std::vector<std::unique_ptr<AbcModuleSigs>> module_sigs;
+		std::vector<std::unique_ptr<AbcModuleState>> pending_runs;
+
 		for (auto mod : design->selected_modules())
 		{
 			if (mod->processes.size() > 0) {
@@ -2048,12 +2152,42 @@ struct AbcPass : public Pass {
 				continue;
 			}
 
-			assign_map.set(mod);
-			initvals.set(&assign_map, mod);
+			module_sigs.emplace_back(new AbcModuleSigs(mod));
+			AbcModuleSigs &sigs = *module_sigs.back();
+			SigMap &assign_map = sigs.assign_map;
+			FfInitVals &initvals = sigs.initvals;
+			int first_pending_run = GetSize(pending_runs);
+
+			auto add_run = [&](AbcModuleState *state) {
+				if (jobs > 1) {
+					pending_runs.emplace_back(state);
+					return;
+				}
+				state->prepare_abc();
+				state->remove_extracted_cells();
+				state->run_abc();
+				state->reintegrate();
+				delete state;
+				assign_map.set(mod);
+			};
+
+			// The extracted cells of all clock domains stay in the module until
+			// every domain has marked its ports, so that signals connecting two
+			// domains are kept as ports in both of them.
+			auto finish_module = [&]() {
+				for (int i = first_pending_run; i < GetSize(pending_runs); i++) {
+					pending_runs[i]->prepare_abc();
+					log_pop();
+				}
+				for (int i = first_pending_run; i < GetSize(pending_runs); i++)
+					pending_runs[i]->remove_extracted_cells();
+			};
 
 			if (!dff_mode || !clk_str.empty()) {
-				abc_module(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
-						delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, mod->selected_cells(), show_tempdir, sop_mode, abc_dress, dont_use_cells);
+				AbcModuleState *state = new AbcModuleState(config, design, mod, sigs);
+				state->extract(dff_mode, clk_str, mod->selected_cells());
+				add_run(state);
+				finish_module();
 				continue;
 			}
 
@@ -2206,26 +2340,30 @@ struct AbcPass : public Pass {
 						std::get<6>(it.first) ? "" : "!", log_signal(std::get<7>(it.first)));
 
 			for (auto &it : assigned_cells) {
-				clk_polarity = std::get<0>(it.first);
-				clk_sig = assign_map(std::get<1>(it.first));
-				en_polarity = std::get<2>(it.first);
-				en_sig = assign_map(std::get<3>(it.first));
-				arst_polarity = std::get<4>(it.first);
-				arst_sig = assign_map(std::get<5>(it.first));
-				srst_polarity = std::get<6>(it.first);
-				srst_sig = assign_map(std::get<7>(it.first));
-				abc_module(design, mod, script_file, exe_file, liberty_files, genlib_files, constr_file, cleanup, lut_costs, !clk_sig.empty(), "$",
-						keepff, delay_target, sop_inputs, sop_products, lutin_shared, fast_mode, it.second, show_tempdir, sop_mode, abc_dress, dont_use_cells);
-				assign_map.set(mod);
+				AbcModuleState *state = new AbcModuleState(config, design, mod, sigs);
+				state->clk_polarity = std::get<0>(it.first);
+				state->clk_sig = assign_map(std::get<1>(it.first));
+				state->en_polarity = std::get<2>(it.first);
+				state->en_sig = assign_map(std::get<3>(it.first));
+				state->arst_polarity = std::get<4>(it.first);
+				state->arst_sig = assign_map(std::get<5>(it.first));
+				state->srst_polarity = std::get<6>(it.first);
+				state->srst_sig = assign_map(std::get<7>(it.first));
+				state->extract(!state->clk_sig.empty(), "$", it.second);
+				add_run(state);
 			}
+
+			finish_module();
 		}
 
-		assign_map.clear();
-		signal_list.clear();
-		signal_map.clear();
-		initvals.clear();
-		pi_map.clear();
-		po_map.clear();
+		parallel_for(GetSize(pending_runs), [&](int i) {
+			pending_runs[i]->run_abc();
+		}, jobs);
+
+		for (auto &state : pending_runs) {
+			log_push();
+			state->reintegrate();
+		}
 
 		log_pop();
 	}
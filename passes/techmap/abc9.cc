@@ -26,6 +26,8 @@
 #include "kernel/celltypes.h"
 #include "kernel/rtlil.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
+#include "passes/techmap/abc_link.h"
 
 // abc9_exe.cc
 std::string fold_abc9_cmd(std::string str);
@@ -171,6 +173,12 @@ struct Abc9Pass : public ScriptPass
 		log("    -box <file>\n");
 		log("        pass this file with box library to ABC.\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        run up to N ABC processes at the same time. all modules are extracted\n");
+		log("        first, then ABC is run on them in parallel and the results are merged\n");
+		log("        back in the original module order. the default is the number of jobs\n");
+		log("        given to 'yosys -j' or 'synth -j'.\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -188,6 +196,7 @@ struct Abc9Pass : public ScriptPass
 	bool dff_mode, cleanup;
 	bool lut_mode;
 	int maxlut;
+	int jobs;
 	std::string box_file;
 
 	void clear_flags() override
@@ -198,6 +207,7 @@ struct Abc9Pass : public ScriptPass
 		cleanup = true;
 		lut_mode = false;
 		maxlut = 0;
+		jobs = 0;
 		box_file = "";
 	}
 
@@ -250,6 +260,11 @@ struct Abc9Pass : public ScriptPass
 				maxlut = atoi(args[++argidx].c_str());
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				exe_cmd << " -j " << jobs;
+				continue;
+			}
 			if (arg == "-run" && argidx+1 < args.size()) {
 				size_t pos = args[argidx+1].find(':');
 				if (pos == std::string::npos)
@@ -393,6 +408,49 @@ struct Abc9Pass : public ScriptPass
 				auto selected_modules = active_design->selected_modules();
 				active_design->selection_stack.emplace_back(false);
 
+				// With more than one job, abc9_exe is only called once all modules
+				// have been extracted, and then maps them all in parallel.
+				int exe_jobs = jobs > 0 ? jobs : yosys_jobs;
+				std::vector<std::pair<RTLIL::Module*, std::string>> pending;
+
+				auto run_abc9_exe = [&]() {
+					// the lut and box libraries are the same for all modules
+					// (see abc9_ops -write_lut/-write_box), so the files of the
+					// first module are used for all of them
+					const std::string &first_tempdir_name = pending.front().second;
+					std::string abc9_exe_cmd = exe_cmd.str();
+					for (auto &it : pending)
+						abc9_exe_cmd += stringf(" -cwd %s", it.second.c_str());
+					if (!lut_mode)
+						abc9_exe_cmd += stringf(" -lut %s/input.lut", first_tempdir_name.c_str());
+					if (box_file.empty())
+						abc9_exe_cmd += stringf(" -box %s/input.box", first_tempdir_name.c_str());
+					else
+						abc9_exe_cmd += stringf(" -box %s", box_file.c_str());
+					run_nocheck(abc9_exe_cmd);
+				};
+
+				auto reintegrate = [&](RTLIL::Module *mod, const std::string &tempdir_name) {
+#ifdef YOSYS_LINK_ABC
+					std::string aig;
+					if (abc_link_take_file(tempdir_name + "/output.aig", aig)) {
+						// the linked ABC has handed the mapped netlist over in memory
+						std::istringstream aig_stream(aig);
+						Frontend::frontend_call(active_design, &aig_stream, tempdir_name + "/output.aig",
+								stringf("aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym", log_id(mod), tempdir_name.c_str()));
+					} else
+#endif
+					run_nocheck(stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym %s/output.aig", log_id(mod), tempdir_name.c_str(), tempdir_name.c_str()));
+					run_nocheck(stringf("abc9_ops -reintegrate %s", dff_mode ? "-dff" : ""));
+				};
+
+				auto remove_tempdir = [&](const std::string &tempdir_name) {
+					if (cleanup) {
+						log("Removing temp directory.\n");
+						remove_directory(tempdir_name);
+					}
+				};
+
 				for (auto mod : selected_modules) {
 					if (mod->processes.size() > 0) {
 						log("Skipping module %s as it contains processes.\n", log_id(mod));
@@ -417,6 +475,16 @@ struct Abc9Pass : public ScriptPass
 						run_nocheck(stringf("abc9_ops -write_lut %s/input.lut", tempdir_name.c_str()));
 					if (box_file.empty())
 						run_nocheck(stringf("abc9_ops -write_box %s/input.box", tempdir_name.c_str()));
+#ifdef YOSYS_LINK_ABC
+					if (cleanup) {
+						// hand the XAIGER to the linked ABC in memory instead of going through input.xaig
+						std::stringstream xaig;
+						Backend::backend_call(active_design, &xaig, tempdir_name + "/input.xaig",
+								stringf("xaiger -map %s/input.sym %s", tempdir_name.c_str(), dff_mode ? "-dff" : ""));
+						abc_link_provide_file(tempdir_name + "/input.xaig", xaig.str());
+						abc_link_collect_file(tempdir_name + "/output.aig");
+					} else
+#endif
 					run_nocheck(stringf("write_xaiger -map %s/input.sym %s %s/input.xaig", tempdir_name.c_str(), dff_mode ? "-dff" : "", tempdir_name.c_str()));
 
 					int num_outputs = active_design->scratchpad_get_int("write_xaiger.num_outputs");
@@ -428,30 +496,38 @@ struct Abc9Pass : public ScriptPass
 							active_design->scratchpad_get_int("write_xaiger.num_inputs"),
 							num_outputs);
 					if (num_outputs) {
-						std::string abc9_exe_cmd;
-						abc9_exe_cmd += stringf("%s -cwd %s", exe_cmd.str().c_str(), tempdir_name.c_str());
-						if (!lut_mode)
-							abc9_exe_cmd += stringf(" -lut %s/input.lut", tempdir_name.c_str());
-						if (box_file.empty())
-							abc9_exe_cmd += stringf(" -box %s/input.box", tempdir_name.c_str());
-						else
-							abc9_exe_cmd += stringf(" -box %s", box_file.c_str());
-						run_nocheck(abc9_exe_cmd);
-						run_nocheck(stringf("read_aiger -xaiger -wideports -module_name %s$abc9 -map %s/input.sym %s/output.aig", log_id(mod), tempdir_name.c_str(), tempdir_name.c_str()));
-						run_nocheck(stringf("abc9_ops -reintegrate %s", dff_mode ? "-dff" : ""));
+						pending.emplace_back(mod, tempdir_name);
+						if (exe_jobs <= 1) {
+							run_abc9_exe();
+							reintegrate(mod, tempdir_name);
+							pending.clear();
+							remove_tempdir(tempdir_name);
+							mod->check();
+						}
 					}
-					else
+					else {
 						log("Don't call ABC as there is nothing to map.\n");
-
-					if (cleanup) {
-						log("Removing temp directory.\n");
-						remove_directory(tempdir_name);
+						remove_tempdir(tempdir_name);
+						mod->check();
 					}
-					mod->check();
+
 					active_design->selection().selected_modules.clear();
 					log_pop();
 				}
 
+				if (!pending.empty()) {
+					run_abc9_exe();
+					for (auto &it : pending) {
+						log_push();
+						active_design->selection().select(it.first);
+						reintegrate(it.first, it.second);
+						remove_tempdir(it.second);
+						it.first->check();
+						active_design->selection().selected_modules.clear();
+						log_pop();
+					}
+				}
+
 				active_design->selection_stack.pop_back();
 			}
 		}
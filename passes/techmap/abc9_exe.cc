@@ -24,17 +24,14 @@
 
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "kernel/threading.h"
+#include "passes/techmap/abc_link.h"
 
 #ifndef _WIN32
 #  include <unistd.h>
 #  include <dirent.h>
 #endif
 
-#ifdef YOSYS_LINK_ABC
-namespace abc {
-	int Abc_RealMain(int argc, char *argv[]);
-}
-#endif
 
 std::string fold_abc9_cmd(std::string str)
 {
@@ -164,9 +161,11 @@ struct abc9_output_filter
 	}
 };
 
-void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe_file,
+// Writes the ABC script for the netlist in tempdir_name and returns the command
+// that runs it.
+std::string abc9_module(RTLIL::Design *design, std::string script_file, std::string exe_file,
 		vector<int> lut_costs, bool dff_mode, std::string delay_target, std::string /*lutin_shared*/, bool fast_mode,
-		bool show_tempdir, std::string box_file, std::string lut_file,
+		std::string box_file, std::string lut_file,
 		std::vector<std::string> liberty_files, std::string wire_delay, std::string tempdir_name,
 		std::string constr_file, std::vector<std::string> dont_use_cells)
 {
@@ -273,62 +272,22 @@ void abc9_module(RTLIL::Design *design, std::string script_file, std::string exe
 		fclose(f);
 	}
 
-	buffer = stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
-	log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+	return stringf("\"%s\" -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+}
+
+// Runs the command returned by abc9_module() and returns its exit code. This
+// only writes to the log and to files in tempdir_name, so that several calls
+// for different temp dirs can run at the same time, unless linked_abc is set.
+int run_abc9(std::string tempdir_name, std::string command, bool show_tempdir, bool linked_abc YS_MAYBE_UNUSED)
+{
+	log("Running ABC command: %s\n", replace_tempdir(command, tempdir_name, show_tempdir).c_str());
 
-#ifndef YOSYS_LINK_ABC
-	abc9_output_filter filt(tempdir_name, show_tempdir);
-	int ret = run_command(buffer, std::bind(&abc9_output_filter::next_line, filt, std::placeholders::_1));
-#else
-	string temp_stdouterr_name = stringf("%s/stdouterr.txt", tempdir_name.c_str());
-	FILE *temp_stdouterr_w = fopen(temp_stdouterr_name.c_str(), "w");
-	if (temp_stdouterr_w == NULL)
-		log_error("ABC: cannot open a temporary file for output redirection");
-	fflush(stdout);
-	fflush(stderr);
-	FILE *old_stdout = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
-	FILE *old_stderr = fopen(temp_stdouterr_name.c_str(), "r"); // need any fd for renumbering
-#if defined(__wasm)
-#define fd_renumber(from, to) (void)__wasi_fd_renumber(from, to)
-#else
-#define fd_renumber(from, to) dup2(from, to)
-#endif
-	fd_renumber(fileno(stdout), fileno(old_stdout));
-	fd_renumber(fileno(stderr), fileno(old_stderr));
-	fd_renumber(fileno(temp_stdouterr_w), fileno(stdout));
-	fd_renumber(fileno(temp_stdouterr_w), fileno(stderr));
-	fclose(temp_stdouterr_w);
-	// These needs to be mutable, supposedly due to getopt
-	char *abc9_argv[5];
-	string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
-	abc9_argv[0] = strdup(exe_file.c_str());
-	abc9_argv[1] = strdup("-s");
-	abc9_argv[2] = strdup("-f");
-	abc9_argv[3] = strdup(tmp_script_name.c_str());
-	abc9_argv[4] = 0;
-	int ret = abc::Abc_RealMain(4, abc9_argv);
-	free(abc9_argv[0]);
-	free(abc9_argv[1]);
-	free(abc9_argv[2]);
-	free(abc9_argv[3]);
-	fflush(stdout);
-	fflush(stderr);
-	fd_renumber(fileno(old_stdout), fileno(stdout));
-	fd_renumber(fileno(old_stderr), fileno(stderr));
-	fclose(old_stdout);
-	fclose(old_stderr);
-	std::ifstream temp_stdouterr_r(temp_stdouterr_name);
 	abc9_output_filter filt(tempdir_name, show_tempdir);
-	for (std::string line; std::getline(temp_stdouterr_r, line); )
-		filt.next_line(line + "\n");
-	temp_stdouterr_r.close();
+#ifdef YOSYS_LINK_ABC
+	if (linked_abc)
+		return abc_link_run_script(tempdir_name, std::bind(&abc9_output_filter::next_line, filt, std::placeholders::_1));
 #endif
-	if (ret != 0) {
-		if (check_file_exists(stringf("%s/output.aig", tempdir_name.c_str())))
-			log_warning("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
-		else
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
-	}
+	return run_command(command, std::bind(&abc9_output_filter::next_line, filt, std::placeholders::_1));
 }
 
 struct Abc9ExePass : public Pass {
@@ -423,7 +382,16 @@ struct Abc9ExePass : public Pass {
 		log("    -cwd <dir>\n");
 		log("        use this as the current working directory, inside which the 'input.xaig'\n");
 		log("        file is expected. temporary files will be created in this directory, and\n");
-		log("        the mapped result will be written to 'output.aig'.\n");
+		log("        the mapped result will be written to 'output.aig'. this option can be\n");
+		log("        used multiple times to map several netlists with the same options.\n");
+		log("\n");
+		log("    -j <N>\n");
+		log("        when more than one -cwd is given, run up to N ABC processes at the same\n");
+		log("        time. the default is the number of jobs given to 'yosys -j'.\n");
+#ifdef YOSYS_LINK_ABC
+		log("        the ABC linked into yosys maps one netlist at a time, so more than one\n");
+		log("        job runs the ABC executable (see -exe) in separate processes instead.\n");
+#endif
 		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
@@ -443,10 +411,11 @@ struct Abc9ExePass : public Pass {
 		std::string script_file, clk_str, box_file, lut_file, constr_file;
 		std::vector<std::string> liberty_files, dont_use_cells;
 		std::string delay_target, lutin_shared = "-S 1", wire_delay;
-		std::string tempdir_name;
+		std::vector<std::string> tempdir_names;
 		bool fast_mode = false, dff_mode = false;
 		bool show_tempdir = false;
 		vector<int> lut_costs;
+		int jobs = yosys_jobs;
 
 #if 0
 		cleanup = false;
@@ -526,7 +495,11 @@ struct Abc9ExePass : public Pass {
 				continue;
 			}
 			if (arg == "-cwd" && argidx+1 < args.size()) {
-				tempdir_name = args[++argidx];
+				tempdir_names.push_back(args[++argidx]);
+				continue;
+			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
 				continue;
 			}
 			if (arg == "-liberty" && argidx+1 < args.size()) {
@@ -598,14 +571,47 @@ struct Abc9ExePass : public Pass {
 		if (!box_file.empty() && !is_absolute_path(box_file) && box_file[0] != '+')
 			box_file = std::string(pwd) + "/" + box_file;
 
-		if (tempdir_name.empty())
+		if (tempdir_names.empty())
 			log_cmd_error("abc9_exe '-cwd' option is mandatory.\n");
 
+		bool linked_abc = false;
+#ifdef YOSYS_LINK_ABC
+		// The linked ABC redirects the process-wide stdout/stderr and is not
+		// reentrant. Several jobs therefore run external ABC processes, and
+		// without an ABC executable the netlists are mapped one at a time.
+		linked_abc = std::min(jobs, GetSize(tempdir_names)) <= 1 || !check_file_exists(exe_file);
+		if (linked_abc)
+			jobs = 1;
+		else
+			for (auto &tempdir_name : tempdir_names)
+				abc_link_spill_files(tempdir_name);
+#endif
+
+		std::vector<std::string> commands;
+		for (auto &tempdir_name : tempdir_names)
+			commands.push_back(abc9_module(design, script_file, exe_file, lut_costs, dff_mode,
+					delay_target, lutin_shared, fast_mode,
+					box_file, lut_file, liberty_files, wire_delay, tempdir_name,
+					constr_file, dont_use_cells));
 
-		abc9_module(design, script_file, exe_file, lut_costs, dff_mode,
-				delay_target, lutin_shared, fast_mode, show_tempdir,
-				box_file, lut_file, liberty_files, wire_delay, tempdir_name,
-				constr_file, dont_use_cells);
+		std::vector<int> rets(GetSize(commands));
+		parallel_for(GetSize(commands), [&](int i) {
+			rets[i] = run_abc9(tempdir_names[i], commands[i], show_tempdir, linked_abc);
+		}, jobs);
+
+		for (int i = 0; i < GetSize(commands); i++) {
+			if (rets[i] == 0)
+				continue;
+			std::string output_name = stringf("%s/output.aig", tempdir_names[i].c_str());
+			bool has_output = check_file_exists(output_name);
+#ifdef YOSYS_LINK_ABC
+			has_output = has_output || abc_link_has_file(output_name);
+#endif
+			if (has_output)
+				log_warning("ABC: execution of command \"%s\" failed: return code %d.\n", commands[i].c_str(), rets[i]);
+			else
+				log_error("ABC: execution of command \"%s\" failed: return code %d.\n", commands[i].c_str(), rets[i]);
+		}
 	}
 } Abc9ExePass;
 
@@ -0,0 +1,276 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] ABC
+// Berkeley Logic Synthesis and Verification Group, ABC: A System for Sequential Synthesis and Verification
+// http://www.eecs.berkeley.edu/~alanmi/abc/
+
+#include "passes/techmap/abc_link.h"
+
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
+#ifdef __linux__
+#  include <sys/mman.h>
+#endif
+
+#ifdef YOSYS_LINK_ABC
+
+namespace abc {
+	typedef struct Abc_Frame_t_ Abc_Frame_t;
+	typedef struct Gia_Man_t_ Gia_Man_t;
+	void Abc_Start();
+	void Abc_Stop();
+	Abc_Frame_t *Abc_FrameGetGlobalFrame();
+	void Abc_FrameUpdateGia(Abc_Frame_t *pAbc, Gia_Man_t *pNew);
+	int Cmd_CommandExecute(Abc_Frame_t *pAbc, const char *sCommand);
+	Gia_Man_t *Gia_AigerReadFromMemory(char *pContents, int nFileSize, int fGiaSimple, int fSkipStrash, int fCheck);
+}
+
+YOSYS_NAMESPACE_BEGIN
+
+struct ProvidedFile
+{
+	std::string contents;
+	bool read = false;
+};
+
+static dict<std::string, ProvidedFile> provided_files;
+static pool<std::string> collected_files;
+static dict<std::string, std::string> written_files;
+
+// A file that ABC reads or writes by name. On Linux this is an anonymous file
+// in memory that ABC opens as /proc/self/fd/<n>, so the data never touches
+// the disk. Elsewhere it is the file <fallback_name> itself.
+struct MemoryFile
+{
+	FILE *f = nullptr;
+	std::string name;
+
+	MemoryFile(const std::string &fallback_name)
+	{
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+		int fd = memfd_create("yosys-abc", MFD_CLOEXEC);
+		if (fd >= 0) {
+			name = stringf("/proc/self/fd/%d", fd);
+			if (access(name.c_str(), R_OK | W_OK) == 0 && (f = fdopen(fd, "w+b")) != nullptr)
+				return;
+			close(fd);
+		}
+#endif
+		name = fallback_name;
+		f = fopen(name.c_str(), "w+b");
+	}
+
+	~MemoryFile()
+	{
+		if (f != nullptr)
+			fclose(f);
+	}
+
+	void write(const std::string &contents)
+	{
+		fwrite(contents.data(), 1, contents.size(), f);
+		fflush(f);
+	}
+
+	std::string read() const
+	{
+		std::ifstream ifs(name, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	}
+};
+
+void abc_link_provide_file(const std::string &filename, std::string contents)
+{
+	provided_files[filename].contents = std::move(contents);
+}
+
+void abc_link_collect_file(const std::string &filename)
+{
+	collected_files.insert(filename);
+}
+
+bool abc_link_take_file(const std::string &filename, std::string &contents)
+{
+	auto it = written_files.find(filename);
+	if (it == written_files.end())
+		return false;
+	contents = std::move(it->second);
+	written_files.erase(it);
+	return true;
+}
+
+bool abc_link_has_file(const std::string &filename)
+{
+	return written_files.count(filename) != 0;
+}
+
+static bool in_tempdir(const std::string &filename, const std::string &tempdir_name)
+{
+	return filename.compare(0, tempdir_name.size() + 1, tempdir_name + "/") == 0;
+}
+
+void abc_link_spill_files(const std::string &tempdir_name)
+{
+	for (auto it = provided_files.begin(); it != provided_files.end(); ) {
+		if (!in_tempdir(it->first, tempdir_name)) {
+			++it;
+			continue;
+		}
+		std::ofstream f(it->first, std::ios::binary);
+		f << it->second.contents;
+		if (f.fail())
+			log_error("Opening %s for writing failed: %s\n", it->first.c_str(), strerror(errno));
+		it = provided_files.erase(it);
+	}
+	for (auto it = collected_files.begin(); it != collected_files.end(); )
+		if (in_tempdir(*it, tempdir_name))
+			it = collected_files.erase(it);
+		else
+			++it;
+}
+
+// executes a single line of an ABC script. Inputs that were handed over with
+// abc_link_provide_file() are read from memory and outputs registered with
+// abc_link_collect_file() are written to memory.
+static int abc_execute_line(abc::Abc_Frame_t *frame, const std::string &line, dict<std::string, std::unique_ptr<MemoryFile>> &input_files)
+{
+	std::string cmd = line;
+	while (!cmd.empty() && (cmd.back() == ';' || isspace(cmd.back())))
+		cmd.pop_back();
+
+	if (!provided_files.empty() && (cmd == "&read" || cmd.compare(0, 6, "&read ") == 0)) {
+		auto it = provided_files.find(cmd.substr(std::min<size_t>(6, cmd.size())));
+		if (it == provided_files.end()) {
+			// the input only exists in memory, so ABC must not try to read it from disk
+			printf("Input provided in memory must be read with \"&read <filename>\", got \"%s\".\n", cmd.c_str());
+			return 1;
+		}
+		std::string contents = std::move(it->second.contents);
+		it->second.read = true;
+		abc::Gia_Man_t *gia = abc::Gia_AigerReadFromMemory(&contents[0], GetSize(contents), 0, 0, 0);
+		if (gia == nullptr) {
+			printf("Reading AIGER from memory has failed.\n");
+			return 1;
+		}
+		abc::Abc_FrameUpdateGia(frame, gia);
+		return 0;
+	}
+
+	// the commands that read or write a file take its name as the last argument
+	size_t pos = cmd.find_last_of(" \t");
+	if (pos == std::string::npos || cmd.compare(0, 5, "echo ") == 0)
+		return abc::Cmd_CommandExecute(frame, line.c_str());
+	std::string filename = cmd.substr(pos + 1);
+	bool quoted = GetSize(filename) >= 2 && filename.front() == '"' && filename.back() == '"';
+	if (quoted)
+		filename = filename.substr(1, GetSize(filename) - 2);
+	auto with_filename = [&](const std::string &name) {
+		return cmd.substr(0, pos + 1) + (quoted ? "\"" + name + "\"" : name);
+	};
+
+	auto it = provided_files.find(filename);
+	if (it != provided_files.end()) {
+		auto &file = input_files[filename];
+		if (file == nullptr) {
+			file.reset(new MemoryFile(filename));
+			file->write(it->second.contents);
+		}
+		it->second.read = true;
+		return abc::Cmd_CommandExecute(frame, with_filename(file->name).c_str());
+	}
+
+	if (collected_files.count(filename)) {
+		MemoryFile file(filename);
+		int ret = abc::Cmd_CommandExecute(frame, with_filename(file.name).c_str());
+		written_files[filename] = file.read();
+		return ret;
+	}
+
+	return abc::Cmd_CommandExecute(frame, line.c_str());
+}
+
+int abc_link_run_script(const std::string &tempdir_name, const std::function<void(const std::string&)> &line_handler)
+{
+	MemoryFile temp_stdouterr(stringf("%s/stdouterr.txt", tempdir_name.c_str()));
+	if (temp_stdouterr.f == NULL)
+		log_error("ABC: cannot open a temporary file for output redirection");
+	fflush(stdout);
+	fflush(stderr);
+	FILE *old_stdout = fopen(temp_stdouterr.name.c_str(), "r"); // need any fd for renumbering
+	FILE *old_stderr = fopen(temp_stdouterr.name.c_str(), "r"); // need any fd for renumbering
+#if defined(__wasm)
+#define fd_renumber(from, to) (void)__wasi_fd_renumber(from, to)
+#else
+#define fd_renumber(from, to) dup2(from, to)
+#endif
+	fd_renumber(fileno(stdout), fileno(old_stdout));
+	fd_renumber(fileno(stderr), fileno(old_stderr));
+	fd_renumber(fileno(temp_stdouterr.f), fileno(stdout));
+	fd_renumber(fileno(temp_stdouterr.f), fileno(stderr));
+
+	// like "yosys-abc -s": a fresh frame that has not sourced abc.rc
+	abc::Abc_Start();
+	abc::Abc_Frame_t *frame = abc::Abc_FrameGetGlobalFrame();
+	int ret = 0;
+	dict<std::string, std::unique_ptr<MemoryFile>> input_files;
+	std::ifstream script(stringf("%s/abc.script", tempdir_name.c_str()));
+	for (std::string line; ret == 0 && std::getline(script, line); )
+		if (!line.empty())
+			ret = abc_execute_line(frame, line, input_files);
+	script.close();
+	abc::Abc_Stop();
+	input_files.clear();
+
+	// inputs for this script that it did not read would be handed to the next one
+	for (auto it = provided_files.begin(); it != provided_files.end(); ) {
+		if (!in_tempdir(it->first, tempdir_name)) {
+			++it;
+			continue;
+		}
+		if (ret == 0 && !it->second.read) {
+			printf("Input \"%s\" provided in memory was never read.\n", it->first.c_str());
+			ret = 1;
+		}
+		it = provided_files.erase(it);
+	}
+	for (auto it = collected_files.begin(); it != collected_files.end(); )
+		if (in_tempdir(*it, tempdir_name))
+			it = collected_files.erase(it);
+		else
+			++it;
+
+	fflush(stdout);
+	fflush(stderr);
+	fd_renumber(fileno(old_stdout), fileno(stdout));
+	fd_renumber(fileno(old_stderr), fileno(stderr));
+	fclose(old_stdout);
+	fclose(old_stderr);
+#undef fd_renumber
+
+	std::istringstream temp_stdouterr_r(temp_stdouterr.read());
+	for (std::string line; std::getline(temp_stdouterr_r, line); )
+		line_handler(line + "\n");
+	return ret;
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Claire Xenia Wolf <claire@yosyshq.com>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef ABC_LINK_H
+#define ABC_LINK_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+#ifdef YOSYS_LINK_ABC
+
+// Runs <tempdir_name>/abc.script on the ABC library linked into yosys and
+// returns zero on success. Every call runs on a freshly started ABC frame, so
+// no state is carried over from one script to the next, without the cost of
+// starting a separate yosys-abc process for each of them.
+//
+// Everything ABC prints while running the script is passed to line_handler,
+// one line at a time.
+//
+// Not reentrant: ABC keeps global state and its output is captured by
+// redirecting the process-wide stdout and stderr. Callers that want to run
+// several scripts at the same time start external yosys-abc processes, see
+// abc_link_spill_files().
+int abc_link_run_script(const std::string &tempdir_name, const std::function<void(const std::string&)> &line_handler);
+
+// Makes the file contents available to the next script in the same temp dir,
+// so that <filename> need not exist. "&read <filename>" loads AIGER (or
+// XAIGER) contents straight from memory, other commands that take <filename>
+// as their last argument read it from an in-memory file. While such contents
+// are pending, any other form of "&read" fails the script, as does a script
+// in the same temp dir that finishes without reading them.
+void abc_link_provide_file(const std::string &filename, std::string contents);
+
+// Keeps what the next script in the same temp dir writes to <filename> in
+// memory instead of writing the file. The contents are fetched with
+// abc_link_take_file().
+void abc_link_collect_file(const std::string &filename);
+
+// Moves the contents a script wrote to a file that was registered with
+// abc_link_collect_file() to <contents>. Returns false, leaving <contents>
+// alone, if the script did not write that file.
+bool abc_link_take_file(const std::string &filename, std::string &contents);
+
+// Returns true if a script wrote a file registered with
+// abc_link_collect_file() and its contents were not taken yet.
+bool abc_link_has_file(const std::string &filename);
+
+// Writes the contents provided for <tempdir_name> to their files and stops
+// collecting the outputs written there, so that the script can be run by an
+// external yosys-abc process instead.
+void abc_link_spill_files(const std::string &tempdir_name);
+
+#endif
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
+#include "passes/techmap/abc_link.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -132,8 +133,27 @@ struct AbcNewPass : public ScriptPass {
 				}
 
 				run(stringf("  abc9_ops -write_box %s/input.box", tmpdir.c_str()));
+#ifdef YOSYS_LINK_ABC
+				if (!help_mode && cleanup) {
+					// hand the XAIGER to the linked ABC in memory instead of going through input.xaig
+					std::stringstream xaig;
+					Backend::backend_call(active_design, &xaig, tmpdir + "/input.xaig",
+							stringf("xaiger2 -mapping_prep -map2 %s/input.map2", tmpdir.c_str()));
+					abc_link_provide_file(tmpdir + "/input.xaig", xaig.str());
+					abc_link_collect_file(tmpdir + "/output.aig");
+				} else
+#endif
 				run(stringf("  write_xaiger2 -mapping_prep -map2 %s/input.map2 %s/input.xaig", tmpdir.c_str(), tmpdir.c_str()));
 				run(stringf("  abc9_exe %s -cwd %s -box %s/input.box", exe_options.c_str(), tmpdir.c_str(), tmpdir.c_str()));
+#ifdef YOSYS_LINK_ABC
+				std::string aig;
+				if (!help_mode && abc_link_take_file(tmpdir + "/output.aig", aig)) {
+					// the linked ABC has handed the mapped netlist over in memory
+					std::istringstream aig_stream(aig);
+					Frontend::frontend_call(active_design, &aig_stream, tmpdir + "/output.aig",
+							stringf("xaiger2 -sc_mapping -module_name %s -map2 %s/input.map2", modname.c_str(), tmpdir.c_str()));
+				} else
+#endif
 				run(stringf("  read_xaiger2 -sc_mapping -module_name %s -map2 %s/input.map2 %s/output.aig",
 							modname.c_str(), tmpdir.c_str(), tmpdir.c_str()));
 
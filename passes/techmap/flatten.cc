@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/utils.h"
 #include "kernel/sigtools.h"
+#include "kernel/threading.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -46,21 +47,108 @@ IdString map_name(RTLIL::Cell *cell, T *object)
 	return cell->module->uniquify(concat_name(cell, object->name));
 }
 
-void map_sigspec(const dict<RTLIL::Wire*, RTLIL::Wire*> &map, RTLIL::SigSpec &sig, RTLIL::Module *into = nullptr)
+void map_sigspec(const dict<RTLIL::Wire*, RTLIL::Wire*> &map, RTLIL::SigSpec &sig)
 {
 	vector<SigChunk> chunks = sig;
 	for (auto &chunk : chunks)
-		if (chunk.wire != nullptr && chunk.wire->module != into)
+		if (chunk.wire != nullptr)
 			chunk.wire = map.at(chunk.wire);
 	sig = chunks;
 }
 
+// The contents of a module, prepared once for being copied into all of its
+// instances. Signals refer to the template wires by their index, so that
+// copying a signal into an instance only takes an array lookup per chunk.
+struct FlattenTemplate
+{
+	struct TemplateSig {
+		std::vector<RTLIL::SigChunk> chunks;
+		std::vector<int> wire_index;
+	};
+
+	RTLIL::Module *module = nullptr;
+	std::vector<RTLIL::Wire*> wires;
+	dict<RTLIL::Wire*, int> wire_index;
+	dict<IdString, IdString> positional_ports;
+	pool<RTLIL::SigBit> driven;
+	std::vector<RTLIL::Cell*> cells;
+	std::vector<std::vector<TemplateSig>> cell_sigs;
+	std::vector<std::pair<TemplateSig, TemplateSig>> connections;
+
+	void prepare(RTLIL::Module *tpl)
+	{
+		module = tpl;
+
+		for (auto tpl_wire : tpl->wires()) {
+			if (tpl_wire->port_id > 0)
+				positional_ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire->name);
+			wire_index[tpl_wire] = GetSize(wires);
+			wires.push_back(tpl_wire);
+		}
+
+		for (auto tpl_cell : tpl->cells()) {
+			cells.push_back(tpl_cell);
+			cell_sigs.emplace_back();
+			for (auto &tpl_conn : tpl_cell->connections()) {
+				cell_sigs.back().push_back(prepare_sig(tpl_conn.second));
+				if (tpl_cell->output(tpl_conn.first))
+					for (auto bit : tpl_conn.second)
+						driven.insert(bit);
+			}
+		}
+
+		for (auto &tpl_conn : tpl->connections()) {
+			connections.emplace_back(prepare_sig(tpl_conn.first), prepare_sig(tpl_conn.second));
+			for (auto bit : tpl_conn.first)
+				driven.insert(bit);
+		}
+	}
+
+	TemplateSig prepare_sig(const RTLIL::SigSpec &sig) const
+	{
+		TemplateSig result;
+		result.chunks = sig.chunks();
+		for (auto &chunk : result.chunks)
+			result.wire_index.push_back(chunk.wire ? wire_index.at(chunk.wire) : -1);
+		return result;
+	}
+
+	static RTLIL::SigSpec instantiate(const TemplateSig &sig, const std::vector<RTLIL::Wire*> &new_wires)
+	{
+		std::vector<RTLIL::SigChunk> chunks = sig.chunks;
+		for (int i = 0; i < GetSize(chunks); i++)
+			if (sig.wire_index[i] >= 0)
+				chunks[i].wire = new_wires[sig.wire_index[i]];
+		return chunks;
+	}
+};
+
 struct FlattenWorker
 {
 	bool ignore_wb = false;
 	bool create_scopeinfo = true;
 	bool create_scopename = false;
 
+	// Templates of modules that are already flattened themselves. While modules
+	// are flattened in parallel no templates are added, all modules that can be
+	// instantiated at that point are prepared beforehand.
+	dict<RTLIL::Module*, FlattenTemplate> templates;
+	bool templates_frozen = false;
+
+	const FlattenTemplate &get_template(RTLIL::Module *tpl, FlattenTemplate &scratch)
+	{
+		auto it = templates.find(tpl);
+		if (it != templates.end())
+			return it->second;
+		if (templates_frozen) {
+			scratch.prepare(tpl);
+			return scratch;
+		}
+		FlattenTemplate &result = templates[tpl];
+		result.prepare(tpl);
+		return result;
+	}
+
 	template<class T>
 	void map_attributes(RTLIL::Cell *cell, T *object, IdString orig_object_name)
 	{
@@ -107,8 +195,10 @@ struct FlattenWorker
 		}
 	}
 
-	void flatten_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, SigMap &sigmap, std::vector<RTLIL::Cell*> &new_cells)
+	void flatten_cell(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, const FlattenTemplate &tpl_data, SigMap &sigmap, std::vector<RTLIL::Cell*> &new_cells)
 	{
+		RTLIL::Module *tpl = tpl_data.module;
+
 		// Copy the contents of the flattened cell
 
 		dict<IdString, IdString> memory_map;
@@ -119,12 +209,9 @@ struct FlattenWorker
 			design->select(module, new_memory);
 		}
 
-		dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
-		dict<IdString, IdString> positional_ports;
-		for (auto tpl_wire : tpl->wires()) {
-			if (tpl_wire->port_id > 0)
-				positional_ports.emplace(stringf("$%d", tpl_wire->port_id), tpl_wire->name);
-
+		std::vector<RTLIL::Wire*> new_wires;
+		new_wires.reserve(tpl_data.wires.size());
+		for (auto tpl_wire : tpl_data.wires) {
 			RTLIL::Wire *new_wire = nullptr;
 			if (tpl_wire->name[0] == '\\') {
 				RTLIL::Wire *hier_wire = module->wire(concat_name(cell, tpl_wire->name));
@@ -145,22 +232,28 @@ struct FlattenWorker
 			}
 
 			map_attributes(cell, new_wire, tpl_wire->name);
-			wire_map[tpl_wire] = new_wire;
+			new_wires.push_back(new_wire);
 			design->select(module, new_wire);
 		}
 
-		for (auto &tpl_proc_it : tpl->processes) {
-			RTLIL::Process *new_proc = module->addProcess(map_name(cell, tpl_proc_it.second), tpl_proc_it.second);
-			map_attributes(cell, new_proc, tpl_proc_it.second->name);
-			for (auto new_proc_sync : new_proc->syncs)
-				for (auto &memwr_action : new_proc_sync->mem_write_actions)
-					memwr_action.memid = memory_map.at(memwr_action.memid).str();
-			auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
-			new_proc->rewrite_sigspecs(rewriter);
-			design->select(module, new_proc);
+		if (!tpl->processes.empty()) {
+			dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
+			for (int i = 0; i < GetSize(new_wires); i++)
+				wire_map[tpl_data.wires[i]] = new_wires[i];
+			for (auto &tpl_proc_it : tpl->processes) {
+				RTLIL::Process *new_proc = module->addProcess(map_name(cell, tpl_proc_it.second), tpl_proc_it.second);
+				map_attributes(cell, new_proc, tpl_proc_it.second->name);
+				for (auto new_proc_sync : new_proc->syncs)
+					for (auto &memwr_action : new_proc_sync->mem_write_actions)
+						memwr_action.memid = memory_map.at(memwr_action.memid).str();
+				auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
+				new_proc->rewrite_sigspecs(rewriter);
+				design->select(module, new_proc);
+			}
 		}
 
-		for (auto tpl_cell : tpl->cells()) {
+		for (int i = 0; i < GetSize(tpl_data.cells); i++) {
+			RTLIL::Cell *tpl_cell = tpl_data.cells[i];
 			RTLIL::Cell *new_cell = module->addCell(map_name(cell, tpl_cell), tpl_cell);
 			map_attributes(cell, new_cell, tpl_cell->name);
 			if (new_cell->has_memid()) {
@@ -170,37 +263,27 @@ struct FlattenWorker
 				IdString memid = new_cell->getParam(ID::MEMID).decode_string();
 				new_cell->setParam(ID::MEMID, Const(concat_name(cell, memid).str()));
 			}
-			auto rewriter = [&](RTLIL::SigSpec &sig) { map_sigspec(wire_map, sig); };
-			new_cell->rewrite_sigspecs(rewriter);
+			// The copied connections are in the same order as those of the template cell
+			auto sig_it = tpl_data.cell_sigs[i].begin();
+			for (auto &conn : new_cell->connections_)
+				conn.second = FlattenTemplate::instantiate(*sig_it++, new_wires);
 			design->select(module, new_cell);
 			new_cells.push_back(new_cell);
 		}
 
-		for (auto &tpl_conn_it : tpl->connections()) {
-			RTLIL::SigSig new_conn = tpl_conn_it;
-			map_sigspec(wire_map, new_conn.first);
-			map_sigspec(wire_map, new_conn.second);
-			module->connect(new_conn);
-		}
+		for (auto &tpl_conn : tpl_data.connections)
+			module->connect(FlattenTemplate::instantiate(tpl_conn.first, new_wires),
+					FlattenTemplate::instantiate(tpl_conn.second, new_wires));
 
 		// Attach port connections of the flattened cell
 
-		pool<SigBit> tpl_driven;
-		for (auto tpl_cell : tpl->cells())
-			for (auto &tpl_conn : tpl_cell->connections())
-				if (tpl_cell->output(tpl_conn.first))
-					for (auto bit : tpl_conn.second)
-						tpl_driven.insert(bit);
-		for (auto &tpl_conn : tpl->connections())
-			for (auto bit : tpl_conn.first)
-				tpl_driven.insert(bit);
-
 		for (auto &port_it : cell->connections())
 		{
 			IdString port_name = port_it.first;
-			if (positional_ports.count(port_name) > 0)
-				port_name = positional_ports.at(port_name);
-			if (tpl->wire(port_name) == nullptr || tpl->wire(port_name)->port_id == 0) {
+			if (tpl_data.positional_ports.count(port_name) > 0)
+				port_name = tpl_data.positional_ports.at(port_name);
+			RTLIL::Wire *tpl_wire = tpl->wire(port_name);
+			if (tpl_wire == nullptr || tpl_wire->port_id == 0) {
 				if (port_name.begins_with("$"))
 					log_error("Can't map port `%s' of cell `%s' to template `%s'!\n",
 						port_name.c_str(), cell->name.c_str(), tpl->name.c_str());
@@ -210,31 +293,29 @@ struct FlattenWorker
 			if (GetSize(port_it.second) == 0)
 				continue;
 
-			RTLIL::Wire *tpl_wire = tpl->wire(port_name);
+			RTLIL::Wire *new_wire = new_wires[tpl_data.wire_index.at(tpl_wire)];
 			RTLIL::SigSig new_conn;
 			bool is_signed = false;
 			if (tpl_wire->port_output && !tpl_wire->port_input) {
 				new_conn.first = port_it.second;
-				new_conn.second = tpl_wire;
+				new_conn.second = RTLIL::SigSpec(new_wire, 0, GetSize(tpl_wire));
 				is_signed = tpl_wire->is_signed;
 			} else if (!tpl_wire->port_output && tpl_wire->port_input) {
-				new_conn.first = tpl_wire;
+				new_conn.first = RTLIL::SigSpec(new_wire, 0, GetSize(tpl_wire));
 				new_conn.second = port_it.second;
 				is_signed = new_conn.second.is_wire() && new_conn.second.as_wire()->is_signed;
 			} else {
-				SigSpec sig_tpl = tpl_wire, sig_mod = port_it.second;
-				for (int i = 0; i < GetSize(sig_tpl) && i < GetSize(sig_mod); i++) {
-					if (tpl_driven.count(sig_tpl[i])) {
+				SigSpec sig_mod = port_it.second;
+				for (int i = 0; i < GetSize(tpl_wire) && i < GetSize(sig_mod); i++) {
+					if (tpl_data.driven.count(SigBit(tpl_wire, i))) {
 						new_conn.first.append(sig_mod[i]);
-						new_conn.second.append(sig_tpl[i]);
+						new_conn.second.append(SigBit(new_wire, i));
 					} else {
-						new_conn.first.append(sig_tpl[i]);
+						new_conn.first.append(SigBit(new_wire, i));
 						new_conn.second.append(sig_mod[i]);
 					}
 				}
 			}
-			map_sigspec(wire_map, new_conn.first, module);
-			map_sigspec(wire_map, new_conn.second, module);
 
 			if (new_conn.second.size() > new_conn.first.size())
 				new_conn.second.remove(new_conn.first.size(), new_conn.second.size() - new_conn.first.size());
@@ -308,7 +389,8 @@ struct FlattenWorker
 			// If a design is fully selected and has a top module defined, topological sorting ensures that all cells
 			// added during flattening are black boxes, and flattening is finished in one pass. However, when flattening
 			// individual modules, this isn't the case, and the newly added cells might have to be flattened further.
-			flatten_cell(design, module, cell, tpl, sigmap, worklist);
+			FlattenTemplate scratch;
+			flatten_cell(design, module, cell, get_template(tpl, scratch), sigmap, worklist);
 		}
 	}
 };
@@ -345,6 +427,13 @@ struct FlattenPass : public Pass {
 		log("        with a public name the enclosing scope can be found via their\n");
 		log("        'hdlname' attribute.\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        flatten up to N modules at the same time. modules are flattened in\n");
+		log("        parallel only when all of them are selected as a whole. with more\n");
+		log("        than one job, the numbers in the names of new objects depend on the\n");
+		log("        order in which the modules are done. the default is the number of\n");
+		log("        jobs given to 'yosys -j'.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) override
 	{
@@ -352,6 +441,7 @@ struct FlattenPass : public Pass {
 		log_push();
 
 		FlattenWorker worker;
+		int jobs = yosys_jobs;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -367,6 +457,10 @@ struct FlattenPass : public Pass {
 				worker.create_scopename = true;
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx+1 < args.size()) {
+				jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -384,6 +478,8 @@ struct FlattenPass : public Pass {
 			used_modules.insert(top);
 
 		TopoSort<RTLIL::Module*, IdString::compare_ptr_by_name<RTLIL::Module>> topo_modules;
+		dict<RTLIL::Module*, pool<RTLIL::Module*>> submodules;
+		pool<RTLIL::Module*> instantiated;
 		pool<RTLIL::Module*> worklist = used_modules;
 		while (!worklist.empty()) {
 			RTLIL::Module *module = worklist.pop();
@@ -393,6 +489,8 @@ struct FlattenPass : public Pass {
                                         if (!topo_modules.has_node(tpl))
 						worklist.insert(tpl);
 					topo_modules.edge(tpl, module);
+					submodules[module].insert(tpl);
+					instantiated.insert(tpl);
 				}
 			}
 		}
@@ -400,8 +498,61 @@ struct FlattenPass : public Pass {
 		if (!topo_modules.sort())
 			log_error("Cannot flatten a design containing recursive instantiations.\n");
 
+		// Flattening a module only reads the modules it instantiates, so all modules
+		// at the same depth of the hierarchy can be flattened at the same time. With
+		// a partial selection cells added by flattening may still need flattening
+		// and selections would be modified concurrently, so that case stays serial.
+		// Otherwise the levels are used even with a single job, so that modules
+		// are flattened in the same order for any number of jobs.
+		bool by_level = true;
 		for (auto module : topo_modules.sorted)
-			worker.flatten_module(design, module, used_modules);
+			if (!design->selected_whole_module(module))
+				by_level = false;
+
+		if (!by_level) {
+			for (auto module : topo_modules.sorted) {
+				worker.templates.erase(module);
+				worker.flatten_module(design, module, used_modules);
+			}
+		} else {
+			dict<RTLIL::Module*, int> depth;
+			std::vector<std::vector<RTLIL::Module*>> levels;
+			for (auto module : topo_modules.sorted) {
+				int d = 0;
+				for (auto tpl : submodules[module])
+					d = std::max(d, depth.at(tpl) + 1);
+				depth[module] = d;
+				if (d >= GetSize(levels))
+					levels.resize(d + 1);
+				levels[d].push_back(module);
+			}
+
+			for (auto &level : levels) {
+				std::vector<pool<RTLIL::Module*>> level_used(level.size());
+				worker.templates_frozen = true;
+				parallel_for(GetSize(level), [&](int i) {
+					worker.flatten_module(design, level[i], level_used[i]);
+				}, jobs);
+				worker.templates_frozen = false;
+				for (auto &used : level_used)
+					used_modules.insert(used.begin(), used.end());
+
+				// Prepare the templates of the modules just flattened for the next levels
+				std::vector<FlattenTemplate*> prepare;
+				std::vector<RTLIL::Module*> prepare_modules;
+				for (auto module : level)
+					if (instantiated.count(module) && !module->get_blackbox_attribute(worker.ignore_wb) &&
+							!module->get_bool_attribute(ID::keep_hierarchy))
+						prepare_modules.push_back(module);
+				for (auto module : prepare_modules)
+					worker.templates[module];
+				for (auto module : prepare_modules)
+					prepare.push_back(&worker.templates.at(module));
+				parallel_for(GetSize(prepare), [&](int i) {
+					prepare[i]->prepare(prepare_modules[i]);
+				}, jobs);
+			}
+		}
 
 		if (top != nullptr)
 			for (auto module : design->modules().to_vector())
@@ -471,7 +471,9 @@ YOSYS_NAMESPACE_END
 PRIVATE_NAMESPACE_BEGIN
 
 struct SimplemapPass : public Pass {
-	SimplemapPass() : Pass("simplemap", "mapping simple coarse-grain cells") { }
+	SimplemapPass() : Pass("simplemap", "mapping simple coarse-grain cells") {
+		module_local();
+	}
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -496,9 +498,12 @@ struct SimplemapPass : public Pass {
 		dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> mappers;
 		simplemap_get_mappers(mappers);
 
-		for (auto mod : design->modules()) {
-			if (!design->selected(mod) || mod->get_blackbox_attribute())
-				continue;
+		std::vector<RTLIL::Module*> modules;
+		for (auto mod : design->modules())
+			if (design->selected(mod) && !mod->get_blackbox_attribute())
+				modules.push_back(mod);
+
+		parallel_for_modules(modules, [&](RTLIL::Module *mod) {
 			std::vector<RTLIL::Cell*> cells = mod->cells();
 			for (auto cell : cells) {
 				if (mappers.count(cell->type) == 0)
@@ -509,7 +514,7 @@ struct SimplemapPass : public Pass {
 				mappers.at(cell->type)(mod, cell);
 				mod->remove(cell);
 			}
-		}
+		});
 	}
 } SimplemapPass;
 
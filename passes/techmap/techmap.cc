@@ -21,6 +21,7 @@
 #include "kernel/utils.h"
 #include "kernel/sigtools.h"
 #include "kernel/ffinit.h"
+#include "kernel/rtlil_bin.h"
 #include "libs/sha1/sha1.h"
 
 #include <stdlib.h>
@@ -60,6 +61,150 @@ void apply_prefix(IdString prefix, RTLIL::SigSpec &sig, RTLIL::Module *module)
 	sig = chunks;
 }
 
+// Map libraries and derived templates that outlive a single techmap call.
+// Parsed map files are kept by the content of the files and the frontend
+// options, templates derived from them by that and the template parameters.
+// With the techmap.cache_dir scratchpad variable set, derived templates are
+// also written to that directory and picked up again by later runs.
+struct TechmapCache
+{
+	dict<std::string, RTLIL::Design*> map_designs;
+	dict<std::string, RTLIL::Module*> templates;
+
+	void clear()
+	{
+		for (auto &it : map_designs)
+			delete it.second;
+		for (auto &it : templates)
+			delete it.second;
+		map_designs.clear();
+		templates.clear();
+	}
+
+	static std::string template_filename(const std::string &dir, const std::string &key)
+	{
+		return dir + "/" + key + ".bin";
+	}
+
+	RTLIL::Module *lookup_template(const std::string &key, const std::string &dir)
+	{
+		auto it = templates.find(key);
+		if (it != templates.end())
+			return it->second;
+		if (dir.empty())
+			return nullptr;
+
+		std::string filename = template_filename(dir, key);
+		std::ifstream f(filename, std::ifstream::binary);
+		if (f.fail())
+			return nullptr;
+
+		RTLIL::Design cache_design;
+		RTLIL_BIN::read_design(f, filename, &cache_design);
+		if (GetSize(cache_design.modules()) != 1) {
+			log_warning("Ignoring techmap cache file `%s' with %d modules.\n", filename.c_str(), GetSize(cache_design.modules()));
+			return nullptr;
+		}
+
+		RTLIL::Module *mod = cache_design.release(*cache_design.modules().begin());
+		log("Loaded template %s from techmap cache.\n", log_id(mod));
+		templates[key] = mod;
+		return mod;
+	}
+
+	void store_template(const std::string &key, RTLIL::Module *tpl, const std::string &dir)
+	{
+		if (templates.count(key))
+			delete templates.at(key);
+		RTLIL::Module *mod = new RTLIL::Module;
+		mod->name = tpl->name;
+		tpl->cloneInto(mod);
+		templates[key] = mod;
+
+		if (dir.empty())
+			return;
+
+		// write to a temporary file first, so that concurrent runs sharing the
+		// cache directory never see a partially written template
+		std::string filename = template_filename(dir, key);
+		std::string temp_filename = make_temp_file(filename + ".XXXXXX");
+		std::ofstream f(temp_filename, std::ofstream::trunc | std::ofstream::binary);
+		if (!f.fail()) {
+			RTLIL::Design cache_design;
+			cache_design.add(mod->clone());
+			RTLIL_BIN::write_design(f, &cache_design);
+			f.close();
+		}
+		if (f.fail() || rename(temp_filename.c_str(), filename.c_str()) != 0) {
+			log_warning("Failed to write techmap cache file `%s'.\n", filename.c_str());
+			remove(temp_filename.c_str());
+		}
+	}
+};
+
+TechmapCache techmap_persistent_cache;
+
+// Returns the content of the file and appends the files it includes to the
+// queue. Only literal `include directives are followed, that is all the map
+// libraries in techlibs/ use.
+std::string techmap_read_map_file(const std::string &filename, const std::vector<std::string> &include_dirs, std::vector<std::string> &queue)
+{
+	std::ifstream f(filename, std::ifstream::binary);
+	if (f.fail())
+		return std::string();
+	std::stringstream buf;
+	buf << f.rdbuf();
+	std::string content = buf.str();
+
+	std::string dirname = filename.substr(0, filename.find_last_of("/\\") + 1);
+	for (size_t pos = content.find("`include"); pos != std::string::npos; pos = content.find("`include", pos + 1)) {
+		size_t begin = content.find_first_of("\"\n", pos);
+		if (begin == std::string::npos || content[begin] != '"')
+			continue;
+		size_t end = content.find_first_of("\"\n", begin + 1);
+		if (end == std::string::npos || content[end] != '"')
+			continue;
+		std::string name = content.substr(begin + 1, end - begin - 1);
+		std::string path = dirname + name;
+		for (auto &dir : include_dirs)
+			if (!check_file_exists(path))
+				path = dir + "/" + name;
+		queue.push_back(path);
+	}
+
+	return content;
+}
+
+// Content hash of the map files and everything they include, together with
+// the frontend options. Returns an empty string for maps that cannot be
+// cached, i.e. in-memory designs.
+std::string techmap_map_key(std::vector<std::string> map_files, const std::vector<std::string> &include_dirs, const std::string &verilog_frontend)
+{
+	if (map_files.empty())
+		map_files.push_back("+/techmap.v");
+
+	std::string key_data = stringf("%s\n%s\n", yosys_version_str, verilog_frontend.c_str());
+	for (auto fn : map_files) {
+		if (fn.compare(0, 1, "%") == 0)
+			return std::string();
+		key_data += fn + "\n";
+
+		std::vector<std::string> queue = {fn};
+		pool<std::string> seen;
+		while (!queue.empty()) {
+			std::string filename = queue.back();
+			queue.pop_back();
+			rewrite_filename(filename);
+			if (seen.count(filename))
+				continue;
+			seen.insert(filename);
+			key_data += filename + "\n" + sha1(techmap_read_map_file(filename, include_dirs, queue)) + "\n";
+		}
+	}
+
+	return sha1(key_data);
+}
+
 struct TechmapWorker
 {
 	dict<IdString, void(*)(RTLIL::Module*, RTLIL::Cell*)> simplemap_mappers;
@@ -83,6 +228,28 @@ struct TechmapWorker
 	bool autoproc_mode = false;
 	bool ignore_wb = false;
 
+	// key of the map files for the persistent cache, empty if not cached
+	std::string map_key;
+	std::string cache_dir;
+	// derived templates that are stored once they are fully processed
+	dict<RTLIL::Module*, std::string> template_keys;
+
+	std::string template_key(IdString tpl_name, const dict<IdString, RTLIL::Const> &parameters)
+	{
+		if (map_key.empty())
+			return std::string();
+
+		std::vector<std::pair<IdString, RTLIL::Const>> sorted_parameters(parameters.begin(), parameters.end());
+		std::sort(sorted_parameters.begin(), sorted_parameters.end(), [](const std::pair<IdString, RTLIL::Const> &a, const std::pair<IdString, RTLIL::Const> &b) {
+			return a.first.str() < b.first.str();
+		});
+
+		std::string key_data = stringf("%s\n%s\n%d\n", map_key.c_str(), tpl_name.c_str(), recursive_mode);
+		for (auto &it : sorted_parameters)
+			key_data += stringf("%s %d %s\n", it.first.c_str(), it.second.flags, it.second.as_string().c_str());
+		return sha1(key_data);
+	}
+
 	std::string constmap_tpl_name(SigMap &sigmap, RTLIL::Module *tpl, RTLIL::Cell *cell, bool verbose)
 	{
 		std::string constmap_info;
@@ -702,10 +869,21 @@ struct TechmapWorker
 						tpl = it->second;
 					} else {
 						if (parameters.size() != 0) {
-							mkdebug.on();
-							derived_name = tpl->derive(map, parameters);
-							tpl = map->module(derived_name);
-							log_continue = true;
+							std::string tpl_key = template_key(tpl_name, parameters);
+							RTLIL::Module *cached_tpl = tpl_key.empty() ? nullptr : techmap_persistent_cache.lookup_template(tpl_key, cache_dir);
+							if (cached_tpl != nullptr) {
+								derived_name = cached_tpl->name;
+								if (map->module(derived_name) == nullptr)
+									map->add(cached_tpl->clone());
+								tpl = map->module(derived_name);
+							} else {
+								mkdebug.on();
+								derived_name = tpl->derive(map, parameters);
+								tpl = map->module(derived_name);
+								log_continue = true;
+								if (!tpl_key.empty())
+									template_keys[tpl] = tpl_key;
+							}
 						}
 						techmap_cache.emplace(std::move(key), tpl);
 					}
@@ -897,6 +1075,14 @@ struct TechmapWorker
 						}
 						while (techmap_module(map, tpl, map, handled_cells, celltypeMap, true)) { }
 					}
+
+					// templates replaced by a CONSTMAP variant depend on the
+					// cell and are not in template_keys
+					auto key_it = template_keys.find(tpl);
+					if (key_it != template_keys.end()) {
+						techmap_persistent_cache.store_template(key_it->second, tpl, cache_dir);
+						template_keys.erase(key_it);
+					}
 				}
 
 				if (techmap_do_cache.at(tpl) == false)
@@ -980,6 +1166,10 @@ struct TechmapWorker
 
 struct TechmapPass : public Pass {
 	TechmapPass() : Pass("techmap", "generic technology mapper") { }
+	void on_shutdown() override
+	{
+		techmap_persistent_cache.clear();
+	}
 	void help() override
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -1144,6 +1334,13 @@ struct TechmapPass : public Pass {
 		log("changed to the content of the techmap_chtype attribute. This allows for choosing\n");
 		log("the cell type dynamically.\n");
 		log("\n");
+		log("Map files are parsed only once per session, and templates derived from modules\n");
+		log("with parameters are only derived and processed once for each set of parameter\n");
+		log("values. Later techmap calls with the same map files and -D/-I options reuse\n");
+		log("them. When the scratchpad variable techmap.cache_dir is set to a directory\n");
+		log("(see 'help scratchpad'), derived templates are also stored there and are reused\n");
+		log("by later runs of Yosys.\n");
+		log("\n");
 		log("See 'help extract' for a pass that does the opposite thing.\n");
 		log("\n");
 		log("See 'help flatten' for a pass that does flatten the design (which is\n");
@@ -1159,6 +1356,7 @@ struct TechmapPass : public Pass {
 		simplemap_get_mappers(worker.simplemap_mappers);
 
 		std::vector<std::string> map_files;
+		std::vector<std::string> include_dirs;
 		std::string verilog_frontend = "verilog -nooverwrite -noblackbox";
 		int max_iter = -1;
 
@@ -1177,7 +1375,8 @@ struct TechmapPass : public Pass {
 				continue;
 			}
 			if (args[argidx] == "-I" && argidx+1 < args.size()) {
-				verilog_frontend += " -I " + args[++argidx];
+				include_dirs.push_back(args[++argidx]);
+				verilog_frontend += " -I " + include_dirs.back();
 				continue;
 			}
 			if (args[argidx] == "-assert") {
@@ -1204,7 +1403,20 @@ struct TechmapPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
+		worker.map_key = techmap_map_key(map_files, include_dirs, verilog_frontend);
+		worker.cache_dir = design->scratchpad_get_string("techmap.cache_dir");
+		if (!worker.cache_dir.empty()) {
+			rewrite_filename(worker.cache_dir);
+			create_directory(worker.cache_dir);
+		}
+
 		RTLIL::Design *map = new RTLIL::Design;
+		RTLIL::Design *cached_map = worker.map_key.empty() ? nullptr : techmap_persistent_cache.map_designs.at(worker.map_key, nullptr);
+		if (cached_map != nullptr) {
+			log("Using map files parsed by an earlier techmap call.\n");
+			for (auto mod : cached_map->modules())
+				map->add(mod->clone());
+		} else
 		if (map_files.empty()) {
 			Frontend::frontend_call(map, nullptr, "+/techmap.v", verilog_frontend);
 		} else {
@@ -1222,6 +1434,13 @@ struct TechmapPass : public Pass {
 				}
 		}
 
+		if (!worker.map_key.empty() && cached_map == nullptr) {
+			cached_map = new RTLIL::Design;
+			for (auto mod : map->modules())
+				cached_map->add(mod->clone());
+			techmap_persistent_cache.map_designs[worker.map_key] = cached_map;
+		}
+
 		log_header(design, "Continuing TECHMAP pass.\n");
 
 		dict<IdString, pool<IdString>> celltypeMap;
@@ -77,6 +77,10 @@ struct SynthPass : public ScriptPass {
 		log("        from label is synonymous to 'begin', and empty to label is\n");
 		log("        synonymous to the end of the command list.\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        use up to N threads in passes that can process modules in parallel\n");
+		log("        (default: the value given to 'yosys -j', or 1)\n");
+		log("\n");
 		log("    -abc9\n");
 		log("        use new ABC9 flow (EXPERIMENTAL)\n");
 		log("\n");
@@ -148,6 +152,10 @@ struct SynthPass : public ScriptPass {
 				}
 				continue;
 			}
+			if (args[argidx] == "-j" && argidx + 1 < args.size()) {
+				script_jobs = std::max(1, atoi(args[++argidx].c_str()));
+				continue;
+			}
 			if (args[argidx] == "-auto-top") {
 				autotop = true;
 				continue;
@@ -4,14 +4,40 @@ set -ex
 
 run_subtest () {
     local subtest=$1; shift
+    local suffix=$1; shift
 
-    ${CC:-gcc} -std=c++11 -O2 -o cxxrtl-test-${subtest} -I../../backends/cxxrtl/runtime test_${subtest}.cc -lstdc++
-    ./cxxrtl-test-${subtest}
+    ${CC:-gcc} -std=c++11 -O2 "$@" -o cxxrtl-test-${subtest}${suffix} -I../../backends/cxxrtl/runtime test_${subtest}.cc -lstdc++
+    ./cxxrtl-test-${subtest}${suffix}
 }
 
-run_subtest value
-run_subtest value_fuzz
+run_subtest value ""
+run_subtest value_fuzz ""
+run_subtest value -chunk64 -DCXXRTL_CHUNK_BITS=64
+run_subtest value_fuzz -chunk64 -DCXXRTL_CHUNK_BITS=64
 
 # Compile-only test.
 ../../yosys -p "read_verilog test_unconnected_output.v; proc; clean; write_cxxrtl cxxrtl-test-unconnected_output.cc"
 ${CC:-gcc} -std=c++11 -c -o cxxrtl-test-unconnected_output -I../../backends/cxxrtl/runtime cxxrtl-test-unconnected_output.cc
+
+# Evaluating partitions in parallel must not change simulation results.
+../../yosys -p "read_verilog test_parallel.v; scratchpad -set cxxrtl.parallel_min_cost 1; write_cxxrtl -namespace serial cxxrtl-test-parallel-serial.cc; write_cxxrtl -parallel 4 -namespace parallel cxxrtl-test-parallel.cc"
+grep -q "thread_pool::global" cxxrtl-test-parallel.cc
+${CC:-gcc} -std=c++11 -O1 -pthread -o cxxrtl-test-parallel -I../../backends/cxxrtl/runtime test_parallel.cc -lstdc++
+CXXRTL_THREADS=4 ./cxxrtl-test-parallel
+
+# Waveforms of a design committed through the writer must match those of a design that is polled.
+../../yosys -p "read_verilog test_waveform.v; proc; write_cxxrtl cxxrtl-test-waveform.cc"
+${CC:-gcc} -std=c++11 -O1 -pthread -o cxxrtl-test-waveform -I../../backends/cxxrtl/runtime test_waveform.cc -lstdc++
+./cxxrtl-test-waveform
+
+# Signals wider than a chunk must be written to FST with all of their bits, at either chunk width.
+for chunk_bits in 32 64; do
+    ${CC:-gcc} -std=c++11 -O1 -DCXXRTL_CHUNK_BITS=${chunk_bits} -o cxxrtl-test-fst-chunk${chunk_bits} -I../../backends/cxxrtl/runtime -I../../libs/fst test_fst.cc ../../libs/fst/fstapi.cc ../../libs/fst/fastlz.cc ../../libs/fst/lz4.cc -lz -lstdc++
+    ./cxxrtl-test-fst-chunk${chunk_bits}
+done
+
+# Replaying must restore the recorded state, with and without compression.
+${CC:-gcc} -std=c++11 -O1 -o cxxrtl-test-replay -I../../backends/cxxrtl/runtime test_replay.cc -lstdc++
+./cxxrtl-test-replay
+${CC:-gcc} -std=c++11 -O1 -DCXXRTL_REPLAY_LZ4 -o cxxrtl-test-replay-lz4 -I../../backends/cxxrtl/runtime -I../../libs/fst test_replay.cc ../../libs/fst/lz4.cc -lstdc++
+./cxxrtl-test-replay-lz4
@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <cxxrtl/cxxrtl_fst.h>
+
+// Value changes as read back from the file, or as expected: time -> handle -> bits (most significant first).
+typedef std::map<uint64_t, std::map<fstHandle, std::string>> changes_t;
+
+template<size_t Bits>
+static std::string bits_of(const cxxrtl::value<Bits> &value)
+{
+    std::string bits;
+    for (size_t index = Bits; index > 0; index--)
+        bits += value.bit(index - 1) ? '1' : '0';
+    return bits;
+}
+
+template<size_t Bits>
+static void randomize(cxxrtl::value<Bits> &value, uint32_t &seed)
+{
+    for (size_t index = 0; index < Bits; index++) {
+        seed = seed * 1103515245u + 12345u;
+        value.set_bit(index, (seed >> 24) & 1);
+    }
+}
+
+static void read_change(void *data, uint64_t time, fstHandle handle, const unsigned char *value)
+{
+    (*(changes_t *)data)[time][handle] = (const char *)value;
+}
+
+int main()
+{
+    // Signals wider than a chunk must keep all their bits, at either chunk width.
+    cxxrtl::wire<1> narrow;
+    cxxrtl::wire<64> word;
+    cxxrtl::wire<100> wide;
+    cxxrtl::wire<128> double_word;
+
+    changes_t expected;
+    {
+        cxxrtl::fst_writer writer("cxxrtl-test-fst.fst");
+        writer.timescale(1, "ns");
+        writer.add("top narrow", cxxrtl::debug_item(narrow));
+        writer.add("top word", cxxrtl::debug_item(word));
+        writer.add("top wide", cxxrtl::debug_item(wide));
+        writer.add("top double_word", cxxrtl::debug_item(double_word));
+
+        std::vector<std::string> previous(5);
+        uint32_t seed = 1;
+        for (uint64_t time = 0; time < 200; time++) {
+            // change only some of the signals in each sample
+            if (time % 2 == 0) randomize(narrow.curr, seed);
+            if (time % 3 == 0) randomize(word.curr, seed);
+            if (time % 5 != 4) randomize(wide.curr, seed);
+            if (time % 7 == 0) randomize(double_word.curr, seed);
+            writer.sample(time);
+
+            std::string current[5] = { "", bits_of(narrow.curr), bits_of(word.curr), bits_of(wide.curr),
+                                       bits_of(double_word.curr) };
+            for (fstHandle handle = 1; handle <= 4; handle++)
+                if (time == 0 || current[handle] != previous[handle]) {
+                    expected[time][handle] = current[handle];
+                    previous[handle] = current[handle];
+                }
+        }
+    }
+
+    void *reader = fstReaderOpen("cxxrtl-test-fst.fst");
+    if (reader == nullptr) {
+        fprintf(stderr, "Cannot open the written waveform.\n");
+        return 1;
+    }
+    changes_t read;
+    fstReaderSetFacProcessMaskAll(reader);
+    fstReaderIterBlocks(reader, read_change, &read, nullptr);
+    fstReaderClose(reader);
+
+    if (read != expected) {
+        fprintf(stderr, "Value changes read from the waveform differ from the sampled values.\n");
+        return 1;
+    }
+    return 0;
+}
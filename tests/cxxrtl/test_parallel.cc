@@ -0,0 +1,40 @@
+#include <cstdio>
+#include <string>
+
+#include "cxxrtl-test-parallel-serial.cc"
+#include "cxxrtl-test-parallel.cc"
+
+struct capture : public cxxrtl::performer {
+    std::string output;
+
+    void on_print(const cxxrtl::lazy_fmt &formatter, const cxxrtl::metadata_map &attributes) override {
+        output += formatter();
+    }
+};
+
+int main()
+{
+    serial::p_parallel reference;
+    parallel::p_parallel dut;
+    capture reference_output, dut_output;
+
+    uint32_t seed = 1;
+    for (int cycle = 0; cycle < 10000; cycle++) {
+        seed = seed * 1103515245u + 12345u;
+        reference.p_clk.set<bool>(cycle & 1);
+        reference.p_in.set<uint8_t>(seed >> 24);
+        dut.p_clk.set<bool>(cycle & 1);
+        dut.p_in.set<uint8_t>(seed >> 24);
+        reference.step(&reference_output);
+        dut.step(&dut_output);
+        if (reference.p_out.get<uint8_t>() != dut.p_out.get<uint8_t>()) {
+            fprintf(stderr, "Output mismatch at cycle %d.\n", cycle);
+            return 1;
+        }
+    }
+    if (reference_output.output != dut_output.output) {
+        fprintf(stderr, "Printed output mismatch.\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+module lane #(parameter [7:0] STEP = 1) (
+    input            clk,
+    input      [7:0] in,
+    output reg [7:0] acc
+);
+    initial acc = STEP;
+    always @(posedge clk)
+        acc <= {acc[6:0], acc[7] ^ acc[5]} + in + STEP;
+endmodule
+
+module parallel(
+    input        clk,
+    input  [7:0] in,
+    output [7:0] out
+);
+    wire [7:0] acc [0:7];
+    genvar i;
+    generate
+        for (i = 0; i < 8; i = i + 1) begin : lanes
+            lane #(.STEP(2 * i + 1)) u (.clk(clk), .in(in ^ i), .acc(acc[i]));
+        end
+    endgenerate
+
+    reg [7:0] mem [0:15];
+    reg [7:0] rd;
+    always @(posedge clk) begin
+        mem[acc[0][3:0]] <= acc[1];
+        rd <= mem[acc[2][3:0]];
+        if (acc[3][2:0] == 3'b101)
+            $display("acc[4] = %h", acc[4]);
+    end
+
+    assign out = acc[5] ^ acc[6] ^ acc[7] ^ rd;
+endmodule
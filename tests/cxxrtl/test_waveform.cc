@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "cxxrtl-test-waveform.cc"
+#include <cxxrtl/cxxrtl_vcd.h>
+
+int main()
+{
+    cxxrtl_design::p_waveform polled, observed;
+    cxxrtl::debug_items polled_items, observed_items;
+    polled.debug_info(&polled_items, /*scopes=*/nullptr, "");
+    observed.debug_info(&observed_items, /*scopes=*/nullptr, "");
+
+    cxxrtl::vcd_writer polled_vcd, observed_vcd;
+    polled_vcd.timescale(1, "ns");
+    polled_vcd.add(polled_items);
+    observed_vcd.timescale(1, "ns");
+    observed_vcd.add(observed_items);
+
+    std::string observed_text = observed_vcd.buffer;
+    {
+        std::ofstream file("cxxrtl-test-waveform.vcd");
+        cxxrtl::background_writer output(file, /*threshold=*/256);
+
+        uint32_t seed = 1;
+        for (int cycle = 0; cycle < 2000; cycle++) {
+            seed = seed * 1103515245u + 12345u;
+            polled.p_clk.set<bool>(cycle & 1);
+            polled.p_in.set<uint8_t>(seed >> 24);
+            observed.p_clk.set<bool>(cycle & 1);
+            observed.p_in.set<uint8_t>(seed >> 24);
+            polled.step();
+            observed_vcd.step(observed);
+            polled_vcd.sample(cycle);
+            size_t sampled_from = observed_vcd.buffer.size();
+            observed_vcd.sample(cycle);
+            observed_text.append(observed_vcd.buffer, sampled_from, std::string::npos);
+            output.write(observed_vcd.buffer);
+        }
+        output.flush(observed_vcd.buffer);
+    }
+
+    if (polled_vcd.buffer != observed_text) {
+        fprintf(stderr, "Observed waveform differs from polled waveform.\n");
+        return 1;
+    }
+
+    std::ifstream file("cxxrtl-test-waveform.vcd");
+    std::stringstream written;
+    written << file.rdbuf();
+    if (written.str() != observed_text) {
+        fprintf(stderr, "Written waveform differs from sampled waveform.\n");
+        return 1;
+    }
+    return 0;
+}
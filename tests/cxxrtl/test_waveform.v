@@ -0,0 +1,22 @@
+module waveform(
+    input            clk,
+    input      [7:0] in,
+    output     [7:0] out
+);
+    reg [7:0] count = 0;
+    reg [7:0] acc = 0;
+    reg [7:0] mem [0:63];
+    reg [7:0] rd;
+
+    wire [7:0] mix = acc ^ {count[3:0], count[7:4]};
+
+    always @(posedge clk) begin
+        count <= count + 1;
+        if (in[0])
+            acc <= acc + in;
+        mem[count[5:0]] <= mix;
+        rd <= mem[in[5:0]];
+    end
+
+    assign out = rd ^ mix;
+endmodule
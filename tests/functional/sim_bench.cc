@@ -0,0 +1,139 @@
+// Benchmark for the runtime of the functional C++ backend (`backends/functional/cxx_runtime/sim.h`).
+//
+// The `eval()` function below has the shape of the code generated by `write_functional_cxx`: a straight-line sequence
+// of `Signal` operations covering every kind of node of the functional IR, on a datapath with narrow (8-bit), word
+// sized (32-bit, 64-bit) and wide (128-bit) signals. It is run for a number of steps on random inputs, and the time
+// taken and a checksum of the final state are printed, so that two runtimes can be compared (see `sim_bench.sh`).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "sim.h"
+
+struct bench {
+	struct Inputs {
+		Signal<8> op;
+		Signal<32> a;
+		Signal<32> b;
+		Signal<64> c;
+		Signal<128> d;
+	};
+	struct State {
+		Signal<32> acc;
+		Signal<64> mac;
+		Signal<128> wide;
+		Signal<8> flags;
+		Memory<4, 32> regs;
+	};
+	static void eval(Inputs const &input, State const &current_state, State &next_state);
+};
+
+void bench::eval(bench::Inputs const &input, bench::State const &current_state, bench::State &next_state)
+{
+	Signal<8> op = input.op;
+	Signal<32> a = input.a;
+	Signal<32> b = input.b;
+	Signal<64> c = input.c;
+	Signal<128> d = input.d;
+	Signal<32> acc = current_state.acc;
+	Signal<64> mac = current_state.mac;
+	Signal<128> wide = current_state.wide;
+	Signal<8> flags = current_state.flags;
+	Memory<4, 32> regs = current_state.regs;
+	// ALU
+	Signal<3> sel = op.slice<3>(0);
+	Signal<5> shamt = b.slice<5>(0);
+	Signal<32> sum = a + b;
+	Signal<32> diff = a - b;
+	Signal<32> prod = a * b;
+	Signal<32> quot = a / (b | Signal<32>(1));
+	Signal<32> rem = a % (b | Signal<32>(1));
+	Signal<32> shl = a << shamt;
+	Signal<32> shr = a >> shamt;
+	Signal<32> sra = a.arithmetic_shift_right(shamt);
+	Signal<32> logic = (a & b) ^ ~(a | acc);
+	Signal<32> neg = -a;
+	Signal<1> slt = Signal<1>(b.signed_greater_than(a));
+	Signal<1> sge = Signal<1>(a.signed_greater_equal(b));
+	Signal<1> ult = Signal<1>(b > a);
+	Signal<1> uge = Signal<1>(a >= b);
+	Signal<1> eq = Signal<1>(a == b);
+	Signal<1> ne = Signal<1>(a != acc);
+	Signal<32> m0 = sel.slice<1>(0).any() ? diff : sum;
+	Signal<32> m1 = sel.slice<1>(0).any() ? shr : shl;
+	Signal<32> m2 = sel.slice<1>(0).any() ? quot : prod;
+	Signal<32> m3 = sel.slice<1>(0).any() ? rem : sra;
+	Signal<32> m4 = sel.slice<1>(1).any() ? m1 : m0;
+	Signal<32> m5 = sel.slice<1>(1).any() ? m3 : m2;
+	Signal<32> m6 = sel.slice<1>(2).any() ? m5 : m4;
+	Signal<32> alu = op.slice<1>(3).any() ? logic : m6;
+	Signal<32> acc_next = op.slice<1>(4).any() ? neg : alu + acc;
+	// MAC
+	Signal<64> mac_prod = a.zero_extend<64>() * b.sign_extend<64>();
+	Signal<64> mac_next = mac + mac_prod ^ c;
+	// wide datapath
+	Signal<128> wide_cat = mac.concat(acc).concat(a);
+	Signal<128> wide_sum = wide + wide_cat;
+	Signal<128> wide_xor = wide_sum ^ (d >> op.slice<7>(0));
+	Signal<128> wide_rot = wide_xor.slice<127>(0).concat(wide_xor.slice<1>(127));
+	Signal<1> wide_gt = Signal<1>(wide_rot > d);
+	Signal<128> wide_next = wide_gt.any() ? wide_rot - d : wide_rot;
+	// flags and register file
+	Signal<1> zero = Signal<1>(!alu.any());
+	Signal<1> ones = Signal<1>(alu.all());
+	Signal<1> par = Signal<1>(alu.parity());
+	Signal<8> flags_next = zero.concat(ones).concat(par).concat(slt).concat(sge).concat(ult).concat(uge).concat(eq ^ ne);
+	Signal<4> addr = flags.slice<4>(0) ^ op.slice<4>(4);
+	Signal<32> rd = regs.read(addr);
+	Memory<4, 32> regs_next = regs.write(addr, rd + acc_next);
+	next_state.acc = acc_next;
+	next_state.mac = mac_next;
+	next_state.wide = wide_next;
+	next_state.flags = flags_next;
+	next_state.regs = regs_next;
+}
+
+template<size_t n> Signal<n> random_signal(std::mt19937 &gen)
+{
+	std::array<uint32_t, (n + 31) / 32> words;
+	for (auto &w : words)
+		w = gen();
+	return Signal<n>::from_array(words);
+}
+
+int main(int argc, char **argv)
+{
+	const int steps = argc > 1 ? atoi(argv[1]) : 100000;
+
+	std::mt19937 gen(1);
+	std::vector<bench::Inputs> inputs(1024);
+	for (auto &input : inputs) {
+		input.op = random_signal<8>(gen);
+		input.a = random_signal<32>(gen);
+		input.b = random_signal<32>(gen);
+		input.c = random_signal<64>(gen);
+		input.d = random_signal<128>(gen);
+	}
+
+	bench::State state, next_state;
+	state.acc = 0;
+	state.mac = 0;
+	state.wide = 0;
+	state.flags = 0;
+	state.regs = std::array<Signal<32>, 16>();
+
+	auto start = std::chrono::steady_clock::now();
+	for (int step = 0; step < steps; step++) {
+		bench::eval(inputs[step % inputs.size()], state, next_state);
+		state = next_state;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	printf("%d steps in %.3fs (%.0f ns/step), state %s %s %s\n", steps, seconds, seconds * 1e9 / steps,
+		state.acc.as_string().c_str(), state.mac.as_string().c_str(), state.wide.as_string().c_str());
+	return 0;
+}
@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+#
+# Compare the runtime of the functional C++ backend in the working tree
+# with the one at a git revision, on the design in sim_bench.cc.
+#
+# Usage: sim_bench.sh [revision] [steps]
+#
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+runtime=backends/functional/cxx_runtime
+rev=${1:-HEAD}
+steps=${2:-100000}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+mkdir "$tmp/rev"
+git -C "$here" show "$rev:$runtime/sim.h" > "$tmp/rev/sim.h"
+
+for side in "$rev:$tmp/rev" "working tree:$here/../../$runtime"; do
+	name=${side%%:*}
+	${CXX:-g++} -std=c++17 -O2 -I "${side#*:}" "$here/sim_bench.cc" -o "$tmp/bench"
+	echo "$name: $("$tmp/bench" "$steps")"
+done
@@ -0,0 +1,69 @@
+#!/usr/bin/env bash
+set -ex
+cat > sim_output_parallel.il <<'EOT'
+module \top
+  wire input 1 \clk
+  attribute \init 32'1
+  wire width 32 \lfsr
+  wire width 32 \lfsr_next
+  wire \fb
+  attribute \init 16'0
+  wire width 16 output 2 \cnt
+  wire width 16 \cnt_next
+  wire width 48 output 3 \mix
+  cell $reduce_xor $fb
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \Y_WIDTH 1
+    connect \A { \lfsr [31] \lfsr [21] \lfsr [1] \lfsr [0] }
+    connect \Y \fb
+  end
+  connect \lfsr_next { \lfsr [30:0] \fb }
+  cell $dff $lfsr_reg
+    parameter \CLK_POLARITY 1
+    parameter \WIDTH 32
+    connect \CLK \clk
+    connect \D \lfsr_next
+    connect \Q \lfsr
+  end
+  cell $add $cnt_add
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 16
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 1
+    parameter \Y_WIDTH 16
+    connect \A \cnt
+    connect \B 1'1
+    connect \Y \cnt_next
+  end
+  cell $dff $cnt_reg
+    parameter \CLK_POLARITY 1
+    parameter \WIDTH 16
+    connect \CLK \clk
+    connect \D \cnt_next
+    connect \Q \cnt
+  end
+  cell $xor $mix_xor
+    parameter \A_SIGNED 0
+    parameter \A_WIDTH 48
+    parameter \B_SIGNED 0
+    parameter \B_WIDTH 48
+    parameter \Y_WIDTH 48
+    connect \A { \lfsr \cnt }
+    connect \B { \cnt \lfsr }
+    connect \Y \mix
+  end
+end
+EOT
+
+# With -j the value changes are formatted on a separate thread and the FST
+# writer compresses in the background, the traces must not change. FST files
+# carry a creation date, so they are compared through a replay to VCD.
+for j in 1 4; do
+	../../yosys -q -j $j -p "read_rtlil sim_output_parallel.il
+sim -clock clk -n 3000 -timescale 1ns -vcd sim_output_parallel_$j.vcd -fst sim_output_parallel_$j.fst top"
+	../../yosys -q -j $j -p "read_rtlil sim_output_parallel.il
+sim -r sim_output_parallel_$j.fst -scope top -timescale 1ns -vcd sim_output_parallel_replay_$j.vcd top"
+done
+cmp sim_output_parallel_1.vcd sim_output_parallel_4.vcd
+cmp sim_output_parallel_replay_1.vcd sim_output_parallel_replay_4.vcd
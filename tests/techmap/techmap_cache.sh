@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+set -ex
+rm -rf techmap_cache.tmp
+cat > techmap_cache.v <<'EOT'
+module top(input [7:0] a, b, input [3:0] c, output [7:0] x, output [3:0] y, output z);
+	assign x = a + b;
+	assign y = c - a[3:0];
+	assign z = a < b;
+endmodule
+EOT
+
+# The second techmap call reuses the parsed map files and the templates
+# derived by the first one, the second run loads the templates from disk.
+../../yosys -l techmap_cache_1.log -p 'scratchpad -set techmap.cache_dir techmap_cache.tmp
+read_verilog techmap_cache.v; proc; alumacc; design -save orig
+equiv_opt -assert techmap; design -load orig; equiv_opt -assert techmap'
+../../yosys -l techmap_cache_2.log -p 'scratchpad -set techmap.cache_dir techmap_cache.tmp
+read_verilog techmap_cache.v; proc; alumacc; equiv_opt -assert techmap'
+
+grep -q "Using map files parsed by an earlier techmap call" techmap_cache_1.log
+ls techmap_cache.tmp/*.bin
+grep -q "Loaded template .* from techmap cache" techmap_cache_2.log
+! grep -q "Using map files parsed by an earlier techmap call" techmap_cache_2.log
@@ -0,0 +1,45 @@
+#!/usr/bin/env bash
+#
+# Compare the default and the legacy (flex/bison) read_rtlil frontends
+# on a generated gate-level design.
+#
+# Usage: rtlil_bench.sh [multipliers] [repeats]
+#
+set -eu
+
+yosys=${YOSYS:-$(dirname "$0")/../../yosys}
+n=${1:-64}
+rep=${2:-3}
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+cat > "$tmp/bench.v" <<EOT
+module bench #(parameter N = $n) (input clk, input [31:0] a, b, output reg [63:0] y);
+	wire [63:0] p [0:N-1];
+	genvar i;
+	generate for (i = 0; i < N; i = i+1) begin:g
+		assign p[i] = (a + i) * (b ^ i);
+	end endgenerate
+	integer k;
+	always @(posedge clk) begin
+		y = 0;
+		for (k = 0; k < N; k = k+1)
+			y = y ^ p[k];
+	end
+endmodule
+EOT
+
+"$yosys" -q -p "read_verilog $tmp/bench.v; synth -top bench -run begin:fine; techmap; opt_clean; write_rtlil $tmp/bench.il"
+echo "input: $(du -h "$tmp/bench.il" | cut -f1)"
+
+for mode in "" "-legacy"; do
+	best=
+	for ((r = 0; r < rep; r++)); do
+		start=$(date +%s.%N)
+		"$yosys" -q -p "read_rtlil $mode $tmp/bench.il"
+		end=$(date +%s.%N)
+		t=$(echo "$end - $start" | bc)
+		if [ -z "$best" ] || [ "$(echo "$t < $best" | bc)" = 1 ]; then best=$t; fi
+	done
+	echo "read_rtlil ${mode:-(default)}: ${best}s"
+done
@@ -74,6 +74,134 @@ namespace RTLIL {
 		}
 
 	}
+
+	TEST_F(KernelRtlilTest, ConstPacked) {
+		{
+			// A four-valued Const can be packed without changing its value
+			Const c1 = Const::from_string("10xz0110zx01");
+			Const c2 = c1;
+			c2.pack();
+			EXPECT_TRUE(c1.is_bits());
+			EXPECT_TRUE(c2.is_packed());
+			EXPECT_EQ(c2.size(), 12);
+			EXPECT_EQ(c2.as_string(), "10xz0110zx01");
+			EXPECT_TRUE(c1 == c2);
+			EXPECT_EQ(c1.hash(), c2.hash());
+			EXPECT_FALSE(c2.is_fully_def());
+
+			// Copies keep the packed backing, bits() unpacks
+			Const c3(c2);
+			EXPECT_TRUE(c3.is_packed());
+			c3.bits()[0] = State::S0;
+			EXPECT_TRUE(c3.is_bits());
+			EXPECT_EQ(c3.as_string(), "10xz0110zx00");
+		}
+
+		{
+			// A moved-from packed Const is empty, not a width without words
+			Const c1 = Const::from_string("10xz0110zx01");
+			c1.pack();
+			Const c2(std::move(c1));
+			EXPECT_TRUE(c2.is_packed());
+			EXPECT_EQ(c2.as_string(), "10xz0110zx01");
+			EXPECT_EQ(c1.size(), 0);
+			EXPECT_TRUE(c1.bits().empty());
+
+			Const c3 = Const::from_string("x1");
+			c3.pack();
+			Const c4 = Const::from_string("0110");
+			c4.pack();
+			c4 = std::move(c3);
+			EXPECT_EQ(c4.as_string(), "x1");
+			EXPECT_EQ(c3.size(), 0);
+			EXPECT_EQ(c3.as_string(), "");
+
+			Const c5(State::S0, 3);
+			c5 = std::move(c4);
+			EXPECT_TRUE(c5.is_packed());
+			EXPECT_EQ(c5.as_string(), "x1");
+		}
+
+		{
+			// Sa and Sm bits cannot be packed
+			Const c1 = Const::from_string("1-0");
+			c1.pack();
+			EXPECT_TRUE(c1.is_bits());
+		}
+
+		{
+			// Small operands are evaluated bit by bit and give a bits() result
+			Const sum = const_add(Const(State::S1, 100), Const(1, 100), false, false, 101);
+			EXPECT_TRUE(sum.is_bits());
+			EXPECT_EQ(sum.size(), 101);
+			EXPECT_TRUE(sum[100] == State::S1);
+			EXPECT_TRUE(sum.extract(0, 100).is_fully_zero());
+		}
+
+		{
+			// Word-parallel evaluation across word boundaries, used when an
+			// operand is packed already
+			Const a(State::S1, 100);
+			Const b(1, 100);
+			a.pack();
+			b.pack();
+			Const sum = const_add(a, b, false, false, 101);
+			EXPECT_TRUE(sum.is_packed());
+			EXPECT_EQ(sum.size(), 101);
+			EXPECT_TRUE(sum[100] == State::S1);
+			EXPECT_TRUE(sum.extract(0, 100).is_fully_zero());
+			EXPECT_TRUE(const_lt(b, a, false, false, 1).as_bool());
+			EXPECT_FALSE(const_lt(b, a, true, true, 1).as_bool());
+			EXPECT_EQ(const_shl(b, Const(70, 8), false, false, 100).as_string(), "000000000000000000000000000001" + std::string(70, '0'));
+			EXPECT_EQ(const_and(a, Const::from_string("x0"), false, false, 2).as_string(), "x0");
+		}
+	}
+
+	// Evaluated during static initialization, possibly before any name is interned.
+	static std::string empty_id_at_static_init = IdString().str();
+
+	TEST_F(KernelRtlilTest, IdStringEmpty) {
+		EXPECT_EQ(empty_id_at_static_init, "");
+
+		IdString empty;
+		EXPECT_EQ(empty.index_, 0);
+		EXPECT_STREQ(empty.c_str(), "");
+		EXPECT_EQ(empty.str(), "");
+		EXPECT_TRUE(empty.empty());
+		EXPECT_EQ(IdString(""), empty);
+		EXPECT_EQ(IdString(std::string()), empty);
+
+		IdString copy = empty;
+		EXPECT_EQ(copy.index_, 0);
+		EXPECT_STREQ(copy.c_str(), "");
+	}
+
+#ifdef YOSYS_ENABLE_THREADS
+	TEST_F(KernelRtlilTest, IdStringConcurrentInterning) {
+		// Threads create and drop overlapping sets of names, so that the
+		// same entries get looked up, freed and re-created concurrently
+		std::vector<std::thread> threads;
+		std::atomic<bool> mismatch(false);
+		for (int t = 0; t < 4; t++)
+			threads.emplace_back([t, &mismatch]() {
+				for (int round = 0; round < 100; round++) {
+					std::vector<IdString> ids;
+					for (int i = 0; i < 256; i++)
+						ids.push_back(IdString(stringf("\\concurrent_%d", (i * 7 + t + round) % 300)));
+					for (int i = 0; i < 256; i++)
+						if (ids[i] != IdString(stringf("\\concurrent_%d", (i * 7 + t + round) % 300)))
+							mismatch = true;
+				}
+			});
+		for (auto &thread : threads)
+			thread.join();
+		EXPECT_FALSE(mismatch);
+
+		IdString a("\\concurrent_0"), b("\\concurrent_0");
+		EXPECT_EQ(a, b);
+		EXPECT_EQ(a.str(), "\\concurrent_0");
+	}
+#endif
 }
 
 YOSYS_NAMESPACE_END
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelSigtoolsTest : public testing::Test {};
+
+TEST_F(KernelSigtoolsTest, SigMapChunks)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a), 4);
+	RTLIL::Wire *b = module->addWire(ID(b), 4);
+	RTLIL::Wire *c = module->addWire(ID(c), 4);
+	module->connect(SigSpec(a, 0, 2), SigSpec(b, 2, 2));
+	module->connect(SigSpec(a, 3), State::S1);
+
+	SigMap sigmap(module);
+
+	// wires without connections are passed through unchanged
+	EXPECT_EQ(sigmap(c), SigSpec(c));
+	EXPECT_EQ(sigmap(SigSpec({SigSpec(c, 1, 2), Const(2, 2)})), SigSpec({SigSpec(c, 1, 2), Const(2, 2)}));
+
+	SigSpec mapped_a = sigmap(a);
+	SigSpec mapped_b = sigmap(b);
+	EXPECT_EQ(mapped_a.extract(0, 2), mapped_b.extract(2, 2));
+	EXPECT_EQ(mapped_a[2], SigBit(a, 2));
+	EXPECT_EQ(mapped_a[3], SigBit(State::S1));
+
+	SigSpec sig = {SigSpec(c), SigSpec(a)};
+	std::vector<SigBit> bits;
+	sigmap.apply(sig, bits);
+	EXPECT_EQ(SigSpec(bits), sigmap(sig));
+}
+
+TEST_F(KernelSigtoolsTest, ModSigMap)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule(ID(top));
+	RTLIL::Wire *a = module->addWire(ID(a));
+	RTLIL::Wire *b = module->addWire(ID(b));
+	RTLIL::Wire *c = module->addWire(ID(c));
+
+	ModSigMap sigmap(module);
+	EXPECT_NE(sigmap(SigBit(a)), sigmap(SigBit(b)));
+
+	// new connections are merged in incrementally
+	module->connect(a, b);
+	EXPECT_EQ(sigmap(SigBit(a)), sigmap(SigBit(b)));
+	EXPECT_FALSE(sigmap.stale());
+
+	// replacing the connections triggers a rebuild
+	module->new_connections({RTLIL::SigSig(b, c)});
+	EXPECT_TRUE(sigmap.stale());
+	EXPECT_NE(sigmap(SigBit(a)), sigmap(SigBit(b)));
+	EXPECT_EQ(sigmap(SigBit(b)), sigmap(SigBit(c)));
+	EXPECT_FALSE(sigmap.stale());
+}
+
+YOSYS_NAMESPACE_END
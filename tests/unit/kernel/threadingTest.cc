@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "kernel/rtlil.h"
+#include "kernel/threading.h"
+#include "kernel/sigtools.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+class KernelThreadingTest : public testing::Test {};
+
+// Adds wires to one module per call, some calls taking more numbers than
+// fit into one block, and returns the names and hashidx_ of the wires.
+static std::vector<std::pair<std::string, unsigned int>> add_wires(int jobs, int &autoidx_used)
+{
+	autoidx = 1;
+	for (auto &pos : hashidx_pos)
+		pos = 0;
+
+	RTLIL::Design design;
+	std::vector<RTLIL::Module*> modules;
+	for (int i = 0; i < 8; i++)
+		modules.push_back(design.addModule(stringf("\\m%d", i)));
+
+	for (int round = 0; round < 3; round++)
+		parallel_for(GetSize(modules), [&](int i) {
+			int count = i == 3 ? 1000 : 10 * i;
+			for (int k = 0; k < count; k++)
+				modules[i]->addWire(NEW_ID);
+		}, jobs);
+	autoidx_used = autoidx - 1;
+
+	std::vector<std::pair<std::string, unsigned int>> result;
+	for (auto module : modules)
+		for (auto wire : module->wires())
+			result.emplace_back(wire->name.str(), wire->hashidx_);
+	return result;
+}
+
+TEST_F(KernelThreadingTest, ParallelForSerialNumbering)
+{
+	// with a single job the objects are numbered like in a plain loop
+	int autoidx_used;
+	auto serial = add_wires(1, autoidx_used);
+	EXPECT_EQ(autoidx_used, GetSize(serial));
+
+	unsigned int hashidx = 123456789;
+	pool<unsigned int> expected;
+	for (int i = 0; i < GetSize(serial); i++)
+		expected.insert(hashidx = mkhash_xorshift(hashidx));
+	pool<unsigned int> hashes;
+	for (auto &it : serial)
+		hashes.insert(it.second);
+	EXPECT_EQ(hashes, expected);
+}
+
+TEST_F(KernelThreadingTest, ParallelForNumbering)
+{
+	int autoidx_used;
+	auto parallel = add_wires(4, autoidx_used);
+
+	std::vector<std::string> names;
+	std::vector<unsigned int> hashes;
+	for (auto &it : parallel) {
+		names.push_back(it.first.substr(it.first.rfind('$')));
+		hashes.push_back(it.second);
+	}
+	EXPECT_EQ(pool<std::string>(names.begin(), names.end()).size(), names.size());
+	EXPECT_EQ(pool<unsigned int>(hashes.begin(), hashes.end()).size(), hashes.size());
+
+	// the hashidx_ are the values of the sequence of wires at the positions taken
+	pool<unsigned int> sequence;
+	unsigned int value = 123456789;
+	for (int64_t pos = 0; pos < hashidx_pos[HASHIDX_WIRE]; pos++)
+		sequence.insert(value = mkhash_xorshift(value));
+	for (auto hash : hashes)
+		EXPECT_TRUE(sequence.count(hash));
+
+	// the counter only moves on by the numbers taken and the unused rest of
+	// the last block of each call
+	EXPECT_LE(autoidx_used, 2 * GetSize(parallel) + 3 * 8 * int(IdSource::first_block_size));
+}
+
+TEST_F(KernelThreadingTest, ParallelForMonitors)
+{
+	// monitors created by the calls, as by passes that keep a ModSigMap, take
+	// their hashidx_ from the IdSource of the call
+	RTLIL::Design design;
+	std::vector<RTLIL::Module*> modules;
+	for (int i = 0; i < 8; i++)
+		modules.push_back(design.addModule(stringf("\\m%d", i)));
+
+	std::vector<std::vector<unsigned int>> hashes(GetSize(modules));
+	parallel_for(GetSize(modules), [&](int i) {
+		for (int k = 0; k < 100; k++) {
+			ModSigMap sigmap(modules[i]);
+			hashes[i].push_back(sigmap.hash());
+		}
+	}, 4);
+
+	pool<unsigned int> unique;
+	for (auto &it : hashes)
+		unique.insert(it.begin(), it.end());
+	EXPECT_EQ(GetSize(unique), 8 * 100);
+}
+
+#if defined(__linux__) && defined(YOSYS_ENABLE_THREADS)
+TEST_F(KernelThreadingTest, SingleThreaded)
+{
+	// the threads of parallel_for are gone once it returns
+	parallel_for(4, [](int) { }, 4);
+	EXPECT_TRUE(is_single_threaded());
+
+	std::mutex mutex;
+	mutex.lock();
+	std::thread other([&]() { std::lock_guard<std::mutex> lock(mutex); });
+	EXPECT_FALSE(is_single_threaded());
+	mutex.unlock();
+	other.join();
+	EXPECT_TRUE(is_single_threaded());
+}
+#endif
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+set -ex
+cat > flatten_parallel.v <<'EOT'
+module leaf(input a, b, output y);
+	wire t = a & b;
+	assign y = t ^ a;
+endmodule
+
+module mid1(input [3:0] a, output [3:0] y);
+	leaf l0 (.a(a[0]), .b(a[1]), .y(y[0]));
+	leaf l1 (.a(a[1]), .b(a[2]), .y(y[1]));
+	(* keep_hierarchy *) leaf l2 (.a(a[2]), .b(a[3]), .y(y[2]));
+	assign y[3] = ^a;
+endmodule
+
+module mid2(input clk, input [3:0] a, inout [3:0] io, output [3:0] y);
+	mid1 m (.a(a), .y(y));
+	reg [3:0] mem [0:1];
+	always @(posedge clk) mem[a[0]] <= a;
+	assign io = mem[a[1]];
+endmodule
+
+module top(input clk, input [3:0] a, b, output [3:0] y, z, inout [3:0] io);
+	mid1 u1 (.a(a), .y(y));
+	mid2 u2 (.clk(clk), .a(b), .io(io), .y(z));
+	leaf u3 (.a(a[0]), .b(b[0]), .y());
+endmodule
+EOT
+
+# Modules of the same depth are flattened in parallel with -j, the result
+# must not change. Only the autoidx the design is written with depends on the
+# thread schedule, as do the numbers in the names that the opt passes run by
+# prep create.
+same() {
+	cmp <(grep -v '^autoidx ' $1) <(grep -v '^autoidx ' $2)
+}
+same_but_numbers() {
+	cmp <(grep -v '^autoidx ' $1 | sed -E 's/\$[0-9]+/$N/g' | sort) <(grep -v '^autoidx ' $2 | sed -E 's/\$[0-9]+/$N/g' | sort)
+}
+../../yosys -q -p 'read_verilog flatten_parallel.v; hierarchy -top top; proc; memory_collect; design -save pre
+flatten -j 1; write_rtlil flatten_parallel_1.il; design -load pre
+flatten -j 4; write_rtlil flatten_parallel_4.il; design -load pre
+flatten -scopename -j 1; write_rtlil flatten_parallel_scopename_1.il; design -load pre
+flatten -scopename -j 4; write_rtlil flatten_parallel_scopename_4.il; design -load pre
+flatten -j 1 top; write_rtlil flatten_parallel_partial_1.il; design -load pre
+flatten -j 4 top; write_rtlil flatten_parallel_partial_4.il; design -load pre
+prep -flatten -top top -j 1; write_rtlil flatten_parallel_prep_1.il; design -load pre
+prep -flatten -top top -j 4; write_rtlil flatten_parallel_prep_4.il'
+same flatten_parallel_1.il flatten_parallel_4.il
+same flatten_parallel_scopename_1.il flatten_parallel_scopename_4.il
+same flatten_parallel_partial_1.il flatten_parallel_partial_4.il
+same_but_numbers flatten_parallel_prep_1.il flatten_parallel_prep_4.il
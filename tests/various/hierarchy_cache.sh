@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+set -ex
+rm -rf hierarchy_cache.tmp
+cat > hierarchy_cache.v <<'EOT'
+module sub #(parameter W = 4) (input [W-1:0] a, b, output [W-1:0] y);
+	assign y = a ^ (b + W);
+endmodule
+
+module top(input [7:0] a, b, output [7:0] x, output [3:0] y, z);
+	sub #(.W(8)) s8 (.a(a), .b(b), .y(x));
+	sub #(.W(4)) s4a (.a(a[3:0]), .b(b[3:0]), .y(y));
+	sub #(.W(4)) s4b (.a(a[7:4]), .b(b[7:4]), .y(z));
+endmodule
+EOT
+
+# The second run loads the derived modules from the cache instead of
+# elaborating them again, the result must be the same.
+for i in 1 2; do
+	../../yosys -l hierarchy_cache_$i.log -p 'scratchpad -set hierarchy.cache_dir hierarchy_cache.tmp
+	read_verilog hierarchy_cache.v; hierarchy -top top; proc; flatten
+	write_verilog -noattr hierarchy_cache_'$i'.out'
+done
+
+ls hierarchy_cache.tmp/*.bin
+! grep -q "from hierarchy cache" hierarchy_cache_1.log
+grep -q "Loaded RTLIL representation for module .* from hierarchy cache" hierarchy_cache_2.log
+../../yosys -p 'read_verilog hierarchy_cache_1.out; rename top gold
+read_verilog hierarchy_cache_2.out; rename top gate
+equiv_make gold gate equiv; equiv_simple; equiv_status -assert'
+
+# With -j the derivations run in worker processes first, the result must be
+# the same as deriving serially.
+../../yosys -j 4 -l hierarchy_cache_j.log -p 'read_verilog hierarchy_cache.v; hierarchy -top top; proc; flatten
+write_verilog -noattr hierarchy_cache_j.out'
+grep -q "Deriving 2 parameterized modules in 2 worker processes" hierarchy_cache_j.log
+../../yosys -p 'read_verilog hierarchy_cache_1.out; rename top gold
+read_verilog hierarchy_cache_j.out; rename top gate
+equiv_make gold gate equiv; equiv_simple; equiv_status -assert'
+
+# A derivation that fails in a worker fails again in the main process, which
+# reports the error. The temporary hierarchy cache must be removed anyway.
+cat > hierarchy_cache_err.v <<'EOT'
+module sub #(parameter W = 4) (input [W-1:0] a, output [W-1:0] y);
+	if (W == 3)
+		$error("unsupported width");
+	assign y = ~a;
+endmodule
+
+module top(input [7:0] a, output [7:0] x, output [2:0] y);
+	sub #(.W(8)) s8 (.a(a), .y(x));
+	sub #(.W(3)) s3 (.a(a[2:0]), .y(y));
+endmodule
+EOT
+rm -rf hierarchy_cache_err.tmp
+mkdir hierarchy_cache_err.tmp
+! TMPDIR=$PWD/hierarchy_cache_err.tmp ../../yosys -j 4 -l hierarchy_cache_err.log -p 'read_verilog hierarchy_cache_err.v; hierarchy -top top'
+grep -q "Hierarchy worker process .* failed" hierarchy_cache_err.log
+grep -q "unsupported width" hierarchy_cache_err.log
+test -z "$(ls -A hierarchy_cache_err.tmp)"
@@ -0,0 +1,97 @@
+#!/usr/bin/env bash
+set -ex
+cat > rtlil_reader.il <<'EOT'
+# comment line
+autoidx 42
+
+attribute \top 1
+attribute \src "a\tb\"c\\d\101"
+module \top
+  parameter \P
+  parameter \Q 8'00001111
+  attribute \keep 1
+  wire width 8 upto signed offset 4 input 1 \a   # trailing comment
+  wire width 8 output 2 \y
+  wire width 32 inout 3 \io
+  wire width 4 $tmp
+  wire \clk
+  memory width 8 size 16 offset 2 \mem
+  cell $add $add$1
+    parameter signed \A_SIGNED 1
+    parameter real \R "1.5"
+    parameter \A_WIDTH 8
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 8
+    connect \A \a
+    connect \B { 2'1x \a [7:6] }
+    connect \Y \y
+  end
+
+  attribute \src "p"
+  process $proc$1
+    assign $tmp 4'0000
+    attribute \parallel_case 1
+    switch \a [0]
+      attribute \full_case 1
+      case 1'1 , 1'-
+        assign $tmp [0] 1'1
+        switch { \a [1] \a [2] }
+          case 2'01
+          case
+            assign $tmp [3:2] 2'zz
+        end
+      attribute \x "y"
+      case
+    end
+    sync posedge \clk
+      update \y { $tmp $tmp }
+      attribute \mw 1
+      memwr \mem \a [3:0] \a 8'11111111 0
+    sync always
+    sync init
+      update \y 8'0
+    sync global
+    sync low \clk
+    sync edge \clk
+  end
+  connect \y [0] 1'm
+  connect \io -5
+end
+
+module \blk
+  attribute \blackbox 1
+  wire input 1 \i
+end
+EOT
+../../yosys -q -p 'read_rtlil rtlil_reader.il; write_rtlil rtlil_reader_new.il'
+../../yosys -q -p 'read_rtlil -legacy rtlil_reader.il; write_rtlil rtlil_reader_old.il'
+cmp rtlil_reader_new.il rtlil_reader_old.il
+../../yosys -q -p 'read_rtlil rtlil_reader_new.il; write_rtlil rtlil_reader_new2.il'
+../../yosys -q -p 'read_rtlil -legacy rtlil_reader_old.il; write_rtlil rtlil_reader_old2.il'
+cmp rtlil_reader_new2.il rtlil_reader_old2.il
+
+# compressed input is read in chunks of 64k, so tokens cross chunk boundaries here
+{
+	echo 'module \big'
+	for i in $(seq 4000); do
+		echo "  attribute \src \"rtlil_reader_big.v:$i.1-$i.20\""
+		echo "  wire width 8 \wire_with_a_long_name_$i"
+	done
+	for i in $(seq 2 4000); do
+		echo "  connect \wire_with_a_long_name_$i [3:0] { \wire_with_a_long_name_$((i-1)) [7:6] 2'1x }"
+	done
+	echo 'end'
+} > rtlil_reader_big.il
+gzip -c rtlil_reader_big.il > rtlil_reader_big.il.gz
+../../yosys -q -p 'read_rtlil rtlil_reader_big.il; write_rtlil rtlil_reader_big_mmap.il'
+../../yosys -q -p 'read_rtlil rtlil_reader_big.il.gz; write_rtlil rtlil_reader_big_gz.il'
+cmp rtlil_reader_big_mmap.il rtlil_reader_big_gz.il
+
+printf 'module \\m\n  wire \\a\n  connect \\a \\b\nend\n' > rtlil_reader_err.il
+if ../../yosys -q -p 'read_rtlil rtlil_reader_err.il' 2> rtlil_reader_err.log; then exit 1; fi
+grep -q "Parser error in line 3: RTLIL error: wire \\\\b not found" rtlil_reader_err.log
+printf 'module \\m\n  wire width \\a\nend\n' > rtlil_reader_err.il
+if ../../yosys -q -p 'read_rtlil rtlil_reader_err.il' 2> rtlil_reader_err.log; then exit 1; fi
+grep -q "Parser error in line 2: syntax error" rtlil_reader_err.log
+
+rm -f rtlil_reader*.il rtlil_reader_big.il.gz rtlil_reader_err.log
@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+set -ex
+cat > write_parallel.v <<'EOT'
+module sub1(input [3:0] a, b, output [3:0] y);
+	assign y = (a & b) | (a + b);
+endmodule
+
+module sub2(input [7:0] a, input s, output [7:0] y);
+	assign y = s ? a ^ 8'hff : ~a;
+endmodule
+
+module sub3(input clk, input [7:0] d, output reg [7:0] q);
+	(* keep *) reg [7:0] mem [0:3];
+	always @(posedge clk) begin
+		q <= mem[d[1:0]] - 8'd1;
+		mem[d[3:2]] <= d;
+	end
+endmodule
+
+module top(input clk, input [7:0] a, b, input s, output [7:0] y, q);
+	wire [3:0] t;
+	sub1 u1 (.a(a[3:0]), .b(b[3:0]), .y(t));
+	sub2 u2 (.a({t, a[7:4]}), .s(s), .y(y));
+	sub3 u3 (.clk(clk), .d(y), .q(q));
+endmodule
+EOT
+
+# Modules are formatted in parallel with -j, the output must not change.
+../../yosys -q -p 'read_verilog write_parallel.v; hierarchy -top top; proc; memory_collect
+write_rtlil -j 1 write_parallel_1.il; write_rtlil -j 4 write_parallel_4.il
+write_verilog -j 1 write_parallel_1.v; write_verilog -j 4 write_parallel_4.v
+write_verilog -noexpr -j 1 write_parallel_noexpr_1.v; write_verilog -noexpr -j 4 write_parallel_noexpr_4.v'
+cmp write_parallel_1.il write_parallel_4.il
+cmp write_parallel_1.v write_parallel_4.v
+cmp write_parallel_noexpr_1.v write_parallel_noexpr_4.v